@@ -294,4 +294,63 @@ const std::map<ESDOp, LDSOp> lds_ops = {
    {DS_OP_ATOMIC_ORDERED_ALLOC_RET , {3, "DS_ATOMIC_ORDERED_ALLOC_RET"}}
 };
 
+bool is_kill_op(EAluOp op)
+{
+   switch (op) {
+   case op2_kille:
+   case op2_killgt:
+   case op2_killge:
+   case op2_killne:
+   case op2_killgt_uint:
+   case op2_killge_uint:
+   case op2_kille_int:
+   case op2_killgt_int:
+   case op2_killge_int:
+   case op2_killne_int:
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool is_multi_slot_op(EAluOp op)
+{
+   switch (op) {
+   case op2_dot4:
+   case op2_dot4_ieee:
+   case op2_cube:
+   case op2_max4:
+   case op2_interp_xy:
+   case op2_interp_zw:
+   case op2_interp_x:
+   case op2_interp_z:
+   case op2_mul_64:
+   case OP2V_MUL_64:
+   case op2_add_64:
+   case op2_min_64:
+   case op2_max_64:
+   case op2_sete_64:
+   case op2_setne_64:
+   case op2_setgt_64:
+   case op2_setge_64:
+   case op2_fract_64:
+   case op2_frexp_64:
+   case op2_ldexp_64:
+   case op2_recip_64:
+   case op2_recip_clamped_64:
+   case op2_recipsqrt_64:
+   case op2_recipsqrt_clamped_64:
+   case op2_sqrt_64:
+   case op2_flt64_to_flt32:
+   case OP2V_FLT32_TO_FLT64:
+   case OP2V_FLT64_TO_FLT32:
+   case op2_flt32_to_flt64:
+   case op3_fma_64:
+   case op3_cndne_64:
+      return true;
+   default:
+      return false;
+   }
+}
+
 }
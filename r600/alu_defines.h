@@ -252,7 +252,6 @@ struct AluOp {
    }
 
    bool can_channel(unsigned flags) const {
-      std::cerr << "Can channel f:"<< flags << " mask:" << unit_mask << std::endl;
       return flags & unit_mask;
    }
 
@@ -264,6 +263,11 @@ struct AluOp {
 
 extern const std::map<EAluOp, AluOp> alu_ops;
 
+bool is_kill_op(EAluOp op);
+
+/* Instructions that occupy several slots of a group */
+bool is_multi_slot_op(EAluOp op);
+
 enum AluInlineConstants  {
    ALU_SRC_LDS_OQ_A = 219,
    ALU_SRC_LDS_OQ_B = 220,
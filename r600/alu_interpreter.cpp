@@ -0,0 +1,1040 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/alu_interpreter.h>
+#include <r600/local_data_share.h>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+namespace {
+
+const uint32_t one_f = 0x3f800000;
+const uint32_t sign_bit = 0x80000000;
+
+template <typename T> T as(uint32_t v);
+template <> float as<float>(uint32_t v) { return lane_float(v); }
+template <> int32_t as<int32_t>(uint32_t v) { return static_cast<int32_t>(v); }
+template <> uint32_t as<uint32_t>(uint32_t v) { return v; }
+
+inline uint32_t bits(float v) { return lane_bits(v); }
+inline uint32_t bits(int32_t v) { return static_cast<uint32_t>(v); }
+inline uint32_t bits(uint32_t v) { return v; }
+
+/* The lane kernels are cloned for AVX-512 and AVX2 when R600_ALU_SIMD
+ * is set, and the clone for the CPU is picked when the library is
+ * loaded. The result buffer never aliases a source, so the loops can
+ * be vectorized across the wavefront. */
+#if defined(R600_ALU_SIMD) && defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define LANE_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef LANE_KERNEL
+#define LANE_KERNEL
+#endif
+
+template <typename T, typename F>
+LANE_KERNEL
+void unary(const Lanes * const *s, Lanes& r, LaneMask&)
+{
+   const uint32_t * __restrict a = s[0]->data();
+   uint32_t * __restrict d = r.data();
+   F f;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      d[i] = bits(f(as<T>(a[i])));
+}
+
+template <typename T, typename F>
+LANE_KERNEL
+void binary(const Lanes * const *s, Lanes& r, LaneMask&)
+{
+   const uint32_t * __restrict a = s[0]->data();
+   const uint32_t * __restrict b = s[1]->data();
+   uint32_t * __restrict d = r.data();
+   F f;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      d[i] = bits(f(as<T>(a[i]), as<T>(b[i])));
+}
+
+template <typename T, typename F>
+LANE_KERNEL
+void ternary(const Lanes * const *s, Lanes& r, LaneMask&)
+{
+   const uint32_t * __restrict a = s[0]->data();
+   const uint32_t * __restrict b = s[1]->data();
+   const uint32_t * __restrict c = s[2]->data();
+   uint32_t * __restrict d = r.data();
+   F f;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      d[i] = bits(f(as<T>(a[i]), as<T>(b[i]), as<T>(c[i])));
+}
+
+/* Compare src0 and src1, write t or f and return the condition */
+template <typename T, typename C, uint32_t t, uint32_t f>
+LANE_KERNEL
+void compare(const Lanes * const *s, Lanes& r, LaneMask& cond)
+{
+   const uint32_t * __restrict a = s[0]->data();
+   const uint32_t * __restrict b = s[1]->data();
+   uint32_t * __restrict d = r.data();
+   C c;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      d[i] = c(as<T>(a[i]), as<T>(b[i])) ? t : f;
+   LaneMask m = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      m |= LaneMask(d[i] == t) << i;
+   cond = m;
+}
+
+/* Select src1 if the condition on src0 holds, src2 otherwise */
+template <typename T, typename C>
+LANE_KERNEL
+void select(const Lanes * const *s, Lanes& r, LaneMask&)
+{
+   const uint32_t * __restrict a = s[0]->data();
+   const uint32_t * __restrict b = s[1]->data();
+   const uint32_t * __restrict c = s[2]->data();
+   uint32_t * __restrict d = r.data();
+   C cmp;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      d[i] = cmp(as<T>(a[i]), T(0)) ? b[i] : c[i];
+}
+
+void nop(const Lanes * const *, Lanes& r, LaneMask&)
+{
+   r.fill(0);
+}
+
+void pred_set_inv(const Lanes * const *s, Lanes& r, LaneMask& cond)
+{
+   const Lanes& a = *s[0];
+   LaneMask m = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      bool v = lane_float(a[i]) == 1.0f;
+      r[i] = v ? 0 : a[i];
+      m |= LaneMask(v) << i;
+   }
+   cond = m;
+}
+
+void pred_set_pop(const Lanes * const *s, Lanes& r, LaneMask& cond)
+{
+   const Lanes& a = *s[0];
+   const Lanes& b = *s[1];
+   LaneMask m = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      float fa = lane_float(a[i]);
+      float fb = lane_float(b[i]);
+      bool v = fa <= fb;
+      r[i] = v ? 0 : lane_bits(fa - fb);
+      m |= LaneMask(v) << i;
+   }
+   cond = m;
+}
+
+void pred_set_clr(const Lanes * const *, Lanes& r, LaneMask& cond)
+{
+   r.fill(lane_bits(FLT_MAX));
+   cond = 0;
+}
+
+void pred_set_restore(const Lanes * const *s, Lanes& r, LaneMask& cond)
+{
+   const Lanes& a = *s[0];
+   LaneMask m = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      bool v = lane_float(a[i]) == 0.0f;
+      r[i] = v ? 0 : a[i];
+      m |= LaneMask(v) << i;
+   }
+   cond = m;
+}
+
+struct Identity {
+   uint32_t operator()(uint32_t a) const { return a; }
+};
+
+struct MulLegacy {
+   float operator()(float a, float b) const {
+      return (a == 0.0f || b == 0.0f) ? 0.0f : a * b;
+   }
+};
+
+struct MaxLegacy {
+   float operator()(float a, float b) const { return a >= b ? a : b; }
+};
+
+struct MinLegacy {
+   float operator()(float a, float b) const { return a < b ? a : b; }
+};
+
+/* A NaN operand is ignored, std::fmax and std::fmin would return NaN
+ * for signalling NaNs */
+struct MaxDX10 {
+   float operator()(float a, float b) const {
+      if (std::isnan(a))
+         return b;
+      if (std::isnan(b))
+         return a;
+      return a > b ? a : b;
+   }
+};
+
+struct MinDX10 {
+   float operator()(float a, float b) const {
+      if (std::isnan(a))
+         return b;
+      if (std::isnan(b))
+         return a;
+      return a < b ? a : b;
+   }
+};
+
+struct Fract {
+   float operator()(float a) const { return a - std::floor(a); }
+};
+
+struct Trunc {
+   float operator()(float a) const { return std::trunc(a); }
+};
+
+struct Ceil {
+   float operator()(float a) const { return std::ceil(a); }
+};
+
+struct Rndne {
+   float operator()(float a) const { return std::nearbyint(a); }
+};
+
+struct Floor {
+   float operator()(float a) const { return std::floor(a); }
+};
+
+struct Ashr {
+   int32_t operator()(int32_t a, int32_t b) const { return a >> (b & 31); }
+};
+
+struct Lshr {
+   uint32_t operator()(uint32_t a, uint32_t b) const { return a >> (b & 31); }
+};
+
+struct Lshl {
+   uint32_t operator()(uint32_t a, uint32_t b) const { return a << (b & 31); }
+};
+
+struct NotInt {
+   uint32_t operator()(uint32_t a) const { return ~a; }
+};
+
+template <typename T>
+struct Max {
+   T operator()(T a, T b) const { return a > b ? a : b; }
+};
+
+template <typename T>
+struct Min {
+   T operator()(T a, T b) const { return a < b ? a : b; }
+};
+
+struct FltToInt {
+   int32_t operator()(float a) const {
+      if (std::isnan(a))
+         return 0;
+      if (a >= 2147483648.0f)
+         return INT_MAX;
+      if (a <= -2147483648.0f)
+         return INT_MIN;
+      return static_cast<int32_t>(a);
+   }
+};
+
+struct FltToIntFloor {
+   int32_t operator()(float a) const { return FltToInt()(std::floor(a)); }
+};
+
+struct FltToIntRpi {
+   int32_t operator()(float a) const { return FltToInt()(std::floor(a + 0.5f)); }
+};
+
+struct FltToUint {
+   uint32_t operator()(float a) const {
+      if (std::isnan(a) || a <= 0.0f)
+         return 0;
+      if (a >= 4294967296.0f)
+         return UINT_MAX;
+      return static_cast<uint32_t>(a);
+   }
+};
+
+struct IntToFlt {
+   float operator()(int32_t a) const { return static_cast<float>(a); }
+};
+
+struct UintToFlt {
+   float operator()(uint32_t a) const { return static_cast<float>(a); }
+};
+
+template <int byte>
+struct UbyteToFlt {
+   float operator()(uint32_t a) const {
+      return static_cast<float>((a >> (8 * byte)) & 0xff);
+   }
+};
+
+struct Bfrev {
+   uint32_t operator()(uint32_t a) const {
+      uint32_t r = 0;
+      for (unsigned i = 0; i < 32; ++i)
+         r |= ((a >> i) & 1) << (31 - i);
+      return r;
+   }
+};
+
+struct Bcnt {
+   uint32_t operator()(uint32_t a) const { return __builtin_popcount(a); }
+};
+
+struct FfbhUint {
+   uint32_t operator()(uint32_t a) const {
+      return a ? __builtin_clz(a) : 0xffffffff;
+   }
+};
+
+struct FfblInt {
+   uint32_t operator()(uint32_t a) const {
+      return a ? __builtin_ctz(a) : 0xffffffff;
+   }
+};
+
+struct FfbhInt {
+   uint32_t operator()(int32_t a) const {
+      uint32_t v = a < 0 ? ~static_cast<uint32_t>(a) : a;
+      return v ? __builtin_clz(v) : 0xffffffff;
+   }
+};
+
+struct AddcUint {
+   uint32_t operator()(uint32_t a, uint32_t b) const {
+      return (uint64_t(a) + b) >> 32;
+   }
+};
+
+struct SubbUint {
+   uint32_t operator()(uint32_t a, uint32_t b) const { return a < b ? 1 : 0; }
+};
+
+struct Bfm {
+   uint32_t operator()(uint32_t a, uint32_t b) const {
+      return ((1u << (a & 31)) - 1) << (b & 31);
+   }
+};
+
+struct MulloInt {
+   uint32_t operator()(uint32_t a, uint32_t b) const { return a * b; }
+};
+
+struct MulhiInt {
+   int32_t operator()(int32_t a, int32_t b) const {
+      return static_cast<int32_t>((int64_t(a) * b) >> 32);
+   }
+};
+
+struct MulhiUint {
+   uint32_t operator()(uint32_t a, uint32_t b) const {
+      return (uint64_t(a) * b) >> 32;
+   }
+};
+
+struct MulUint24 {
+   uint32_t operator()(uint32_t a, uint32_t b) const {
+      return (a & 0xffffff) * (b & 0xffffff);
+   }
+};
+
+struct MulhiUint24 {
+   uint32_t operator()(uint32_t a, uint32_t b) const {
+      return (uint64_t(a & 0xffffff) * (b & 0xffffff)) >> 32;
+   }
+};
+
+struct Flt32ToFlt16 {
+   uint32_t operator()(float a) const { return float_to_half(a); }
+};
+
+struct Flt16ToFlt32 {
+   float operator()(uint32_t a) const { return half_to_float(a & 0xffff); }
+};
+
+struct ExpIEEE {
+   float operator()(float a) const { return std::exp2(a); }
+};
+
+struct LogIEEE {
+   float operator()(float a) const { return std::log2(a); }
+};
+
+struct LogClamped {
+   float operator()(float a) const {
+      float r = std::log2(a);
+      return std::isinf(r) && r < 0 ? -FLT_MAX : r;
+   }
+};
+
+struct RecipIEEE {
+   float operator()(float a) const { return 1.0f / a; }
+};
+
+struct RecipClamped {
+   float operator()(float a) const {
+      float r = 1.0f / a;
+      return std::isinf(r) ? std::copysign(FLT_MAX, r) : r;
+   }
+};
+
+struct RecipFF {
+   float operator()(float a) const {
+      float r = 1.0f / a;
+      return std::isinf(r) ? std::copysign(0.0f, r) : r;
+   }
+};
+
+struct RsqIEEE {
+   float operator()(float a) const { return 1.0f / std::sqrt(a); }
+};
+
+struct RsqClamped {
+   float operator()(float a) const {
+      float r = 1.0f / std::sqrt(a);
+      return std::isinf(r) ? std::copysign(FLT_MAX, r) : r;
+   }
+};
+
+struct RsqFF {
+   float operator()(float a) const {
+      float r = 1.0f / std::sqrt(a);
+      return std::isinf(r) ? std::copysign(0.0f, r) : r;
+   }
+};
+
+struct SqrtIEEE {
+   float operator()(float a) const { return std::sqrt(a); }
+};
+
+struct Sin {
+   float operator()(float a) const { return std::sin(a); }
+};
+
+struct Cos {
+   float operator()(float a) const { return std::cos(a); }
+};
+
+struct BfeUint {
+   uint32_t operator()(uint32_t a, uint32_t offset, uint32_t width) const {
+      offset &= 31;
+      width &= 31;
+      if (!width)
+         return 0;
+      if (offset + width < 32)
+         return (a << (32 - offset - width)) >> (32 - width);
+      return a >> offset;
+   }
+};
+
+struct BfeInt {
+   int32_t operator()(int32_t a, int32_t offset, int32_t width) const {
+      offset &= 31;
+      width &= 31;
+      if (!width)
+         return 0;
+      if (offset + width < 32)
+         return static_cast<int32_t>(static_cast<uint32_t>(a) <<
+                                     (32 - offset - width)) >> (32 - width);
+      return a >> offset;
+   }
+};
+
+struct BfiInt {
+   uint32_t operator()(uint32_t a, uint32_t b, uint32_t c) const {
+      return (a & b) | (~a & c);
+   }
+};
+
+struct BitAlign {
+   uint32_t operator()(uint32_t a, uint32_t b, uint32_t c) const {
+      return ((uint64_t(a) << 32) | b) >> (c & 31);
+   }
+};
+
+struct ByteAlign {
+   uint32_t operator()(uint32_t a, uint32_t b, uint32_t c) const {
+      return ((uint64_t(a) << 32) | b) >> (8 * (c & 3));
+   }
+};
+
+struct MuladdUint24 {
+   uint32_t operator()(uint32_t a, uint32_t b, uint32_t c) const {
+      return (a & 0xffffff) * (b & 0xffffff) + c;
+   }
+};
+
+struct SadAccum {
+   uint32_t operator()(uint32_t a, uint32_t b, uint32_t c) const {
+      for (unsigned i = 0; i < 32; i += 8) {
+         int d = static_cast<int>((a >> i) & 0xff) - ((b >> i) & 0xff);
+         c += d < 0 ? -d : d;
+      }
+      return c;
+   }
+};
+
+struct Fma {
+   float operator()(float a, float b, float c) const { return std::fma(a, b, c); }
+};
+
+template <int scale>
+struct Muladd {
+   float operator()(float a, float b, float c) const {
+      float r = MulLegacy()(a, b) + c;
+      return scale > 0 ? r * scale : r / -scale;
+   }
+};
+
+struct MuladdIEEE {
+   float operator()(float a, float b, float c) const { return a * b + c; }
+};
+
+template <typename T>
+using Eq = std::equal_to<T>;
+template <typename T>
+using Gt = std::greater<T>;
+template <typename T>
+using Ge = std::greater_equal<T>;
+template <typename T>
+using Ne = std::not_equal_to<T>;
+
+using Sem = AluInterpreter::Semantics;
+
+const std::map<EAluOp, Sem> semantics_table = {
+   {op2_add, {binary<float, std::plus<float>>, AluInterpreter::sk_value, true}},
+   {op2_mul, {binary<float, MulLegacy>, AluInterpreter::sk_value, true}},
+   {op2_mul_ieee, {binary<float, std::multiplies<float>>, AluInterpreter::sk_value, true}},
+   {op2_max, {binary<float, MaxLegacy>, AluInterpreter::sk_value, true}},
+   {op2_min, {binary<float, MinLegacy>, AluInterpreter::sk_value, true}},
+   {op2_max_dx10, {binary<float, MaxDX10>, AluInterpreter::sk_value, true}},
+   {op2_min_dx10, {binary<float, MinDX10>, AluInterpreter::sk_value, true}},
+   {op2_sete, {compare<float, Eq<float>, one_f, 0>, AluInterpreter::sk_value, true}},
+   {op2_setgt, {compare<float, Gt<float>, one_f, 0>, AluInterpreter::sk_value, true}},
+   {op2_setge, {compare<float, Ge<float>, one_f, 0>, AluInterpreter::sk_value, true}},
+   {op2_setne, {compare<float, Ne<float>, one_f, 0>, AluInterpreter::sk_value, true}},
+   {op2_sete_dx10, {compare<float, Eq<float>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setgt_dx10, {compare<float, Gt<float>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setge_dx10, {compare<float, Ge<float>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setne_dx10, {compare<float, Ne<float>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_fract, {unary<float, Fract>, AluInterpreter::sk_value, true}},
+   {op2_trunc, {unary<float, Trunc>, AluInterpreter::sk_value, true}},
+   {op2_ceil, {unary<float, Ceil>, AluInterpreter::sk_value, true}},
+   {op2_rndne, {unary<float, Rndne>, AluInterpreter::sk_value, true}},
+   {op2_floor, {unary<float, Floor>, AluInterpreter::sk_value, true}},
+   {op2_ashr_int, {binary<int32_t, Ashr>, AluInterpreter::sk_value, false}},
+   {op2_lshr_int, {binary<uint32_t, Lshr>, AluInterpreter::sk_value, false}},
+   {op2_lshl_int, {binary<uint32_t, Lshl>, AluInterpreter::sk_value, false}},
+   {op2_mov, {unary<uint32_t, Identity>, AluInterpreter::sk_value, false}},
+   {op2_nop, {nop, AluInterpreter::sk_value, false}},
+   {op2_pred_setgt_uint, {compare<uint32_t, Gt<uint32_t>, 0, 1>, AluInterpreter::sk_predicate, false}},
+   {op2_pred_setge_uint, {compare<uint32_t, Ge<uint32_t>, 0, 1>, AluInterpreter::sk_predicate, false}},
+   {op2_pred_sete, {compare<float, Eq<float>, 0, one_f>, AluInterpreter::sk_predicate, true}},
+   {op2_pred_setgt, {compare<float, Gt<float>, 0, one_f>, AluInterpreter::sk_predicate, true}},
+   {op2_pred_setge, {compare<float, Ge<float>, 0, one_f>, AluInterpreter::sk_predicate, true}},
+   {op2_pred_setne, {compare<float, Ne<float>, 0, one_f>, AluInterpreter::sk_predicate, true}},
+   {op2_pred_set_inv, {pred_set_inv, AluInterpreter::sk_predicate, true}},
+   {op2_pred_set_pop, {pred_set_pop, AluInterpreter::sk_predicate, true}},
+   {op2_pred_set_clr, {pred_set_clr, AluInterpreter::sk_predicate, true}},
+   {op2_pred_set_restore, {pred_set_restore, AluInterpreter::sk_predicate, true}},
+   {op2_kille, {compare<float, Eq<float>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killgt, {compare<float, Gt<float>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killge, {compare<float, Ge<float>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killne, {compare<float, Ne<float>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_and_int, {binary<uint32_t, std::bit_and<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_or_int, {binary<uint32_t, std::bit_or<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_xor_int, {binary<uint32_t, std::bit_xor<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_not_int, {unary<uint32_t, NotInt>, AluInterpreter::sk_value, false}},
+   {op2_add_int, {binary<uint32_t, std::plus<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_sub_int, {binary<uint32_t, std::minus<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_max_int, {binary<int32_t, Max<int32_t>>, AluInterpreter::sk_value, false}},
+   {op2_min_int, {binary<int32_t, Min<int32_t>>, AluInterpreter::sk_value, false}},
+   {op2_max_uint, {binary<uint32_t, Max<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_min_uint, {binary<uint32_t, Min<uint32_t>>, AluInterpreter::sk_value, false}},
+   {op2_sete_int, {compare<int32_t, Eq<int32_t>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setgt_int, {compare<int32_t, Gt<int32_t>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setge_int, {compare<int32_t, Ge<int32_t>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setne_int, {compare<int32_t, Ne<int32_t>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setgt_uint, {compare<uint32_t, Gt<uint32_t>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_setge_uint, {compare<uint32_t, Ge<uint32_t>, 0xffffffff, 0>, AluInterpreter::sk_value, false}},
+   {op2_killgt_uint, {compare<uint32_t, Gt<uint32_t>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killge_uint, {compare<uint32_t, Ge<uint32_t>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_prede_int, {compare<int32_t, Eq<int32_t>, 0, 1>, AluInterpreter::sk_predicate, false}},
+   {op2_pred_setgt_int, {compare<int32_t, Gt<int32_t>, 0, 1>, AluInterpreter::sk_predicate, false}},
+   {op2_pred_setge_int, {compare<int32_t, Ge<int32_t>, 0, 1>, AluInterpreter::sk_predicate, false}},
+   {op2_pred_setne_int, {compare<int32_t, Ne<int32_t>, 0, 1>, AluInterpreter::sk_predicate, false}},
+   {op2_kille_int, {compare<int32_t, Eq<int32_t>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killgt_int, {compare<int32_t, Gt<int32_t>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killge_int, {compare<int32_t, Ge<int32_t>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_killne_int, {compare<int32_t, Ne<int32_t>, one_f, 0>, AluInterpreter::sk_kill, true}},
+   {op2_flt_to_int, {unary<float, FltToInt>, AluInterpreter::sk_value, false}},
+   {op2_bfrev_int, {unary<uint32_t, Bfrev>, AluInterpreter::sk_value, false}},
+   {op2_addc_uint, {binary<uint32_t, AddcUint>, AluInterpreter::sk_value, false}},
+   {op2_subb_uint, {binary<uint32_t, SubbUint>, AluInterpreter::sk_value, false}},
+   {op2_exp_ieee, {unary<float, ExpIEEE>, AluInterpreter::sk_value, true}},
+   {op2_log_clamped, {unary<float, LogClamped>, AluInterpreter::sk_value, true}},
+   {op2_log_ieee, {unary<float, LogIEEE>, AluInterpreter::sk_value, true}},
+   {op2_recip_clamped, {unary<float, RecipClamped>, AluInterpreter::sk_value, true}},
+   {op2_recip_ff, {unary<float, RecipFF>, AluInterpreter::sk_value, true}},
+   {op2_recip_ieee, {unary<float, RecipIEEE>, AluInterpreter::sk_value, true}},
+   {op2_recipsqrt_clamped, {unary<float, RsqClamped>, AluInterpreter::sk_value, true}},
+   {op2_recipsqrt_ff, {unary<float, RsqFF>, AluInterpreter::sk_value, true}},
+   {op2_recipsqrt_ieee, {unary<float, RsqIEEE>, AluInterpreter::sk_value, true}},
+   {op2_sqrt_ieee, {unary<float, SqrtIEEE>, AluInterpreter::sk_value, true}},
+   {op2_sin, {unary<float, Sin>, AluInterpreter::sk_value, true}},
+   {op2_cos, {unary<float, Cos>, AluInterpreter::sk_value, true}},
+   {op2_mullo_int, {binary<uint32_t, MulloInt>, AluInterpreter::sk_value, false}},
+   {op2_mulhi_int, {binary<int32_t, MulhiInt>, AluInterpreter::sk_value, false}},
+   {op2_mullo_uint, {binary<uint32_t, MulloInt>, AluInterpreter::sk_value, false}},
+   {op2_mulhi_uint, {binary<uint32_t, MulhiUint>, AluInterpreter::sk_value, false}},
+   {op2_flt_to_uint, {unary<float, FltToUint>, AluInterpreter::sk_value, false}},
+   {op2_int_to_flt, {unary<int32_t, IntToFlt>, AluInterpreter::sk_value, true}},
+   {op2_uint_to_flt, {unary<uint32_t, UintToFlt>, AluInterpreter::sk_value, true}},
+   {op2_bfm_int, {binary<uint32_t, Bfm>, AluInterpreter::sk_value, false}},
+   {op2_flt32_to_flt16, {unary<float, Flt32ToFlt16>, AluInterpreter::sk_value, false}},
+   {op2_flt16_to_flt32, {unary<uint32_t, Flt16ToFlt32>, AluInterpreter::sk_value, true}},
+   {op2_ubyte0_flt, {unary<uint32_t, UbyteToFlt<0>>, AluInterpreter::sk_value, true}},
+   {op2_ubyte1_flt, {unary<uint32_t, UbyteToFlt<1>>, AluInterpreter::sk_value, true}},
+   {op2_ubyte2_flt, {unary<uint32_t, UbyteToFlt<2>>, AluInterpreter::sk_value, true}},
+   {op2_ubyte3_flt, {unary<uint32_t, UbyteToFlt<3>>, AluInterpreter::sk_value, true}},
+   {op2_bcnt_int, {unary<uint32_t, Bcnt>, AluInterpreter::sk_value, false}},
+   {op2_ffbh_uint, {unary<uint32_t, FfbhUint>, AluInterpreter::sk_value, false}},
+   {op2_ffbl_int, {unary<uint32_t, FfblInt>, AluInterpreter::sk_value, false}},
+   {op2_ffbh_int, {unary<int32_t, FfbhInt>, AluInterpreter::sk_value, false}},
+   {op2_flt_to_int_rpi, {unary<float, FltToIntRpi>, AluInterpreter::sk_value, false}},
+   {op2_flt_to_int_floor, {unary<float, FltToIntFloor>, AluInterpreter::sk_value, false}},
+   {op2_mulhi_uint24, {binary<uint32_t, MulhiUint24>, AluInterpreter::sk_value, false}},
+   {op2_mul_uint24, {binary<uint32_t, MulUint24>, AluInterpreter::sk_value, false}},
+   {op2_dot4, {binary<float, MulLegacy>, AluInterpreter::sk_dot, true}},
+   {op2_dot4_ieee, {binary<float, std::multiplies<float>>, AluInterpreter::sk_dot, true}},
+   {op2_max4, {unary<uint32_t, Identity>, AluInterpreter::sk_max4, true}},
+   {op2_mova_int, {unary<uint32_t, Identity>, AluInterpreter::sk_mova, false}},
+   {op3_bfe_uint, {ternary<uint32_t, BfeUint>, AluInterpreter::sk_value, false}},
+   {op3_bfe_int, {ternary<int32_t, BfeInt>, AluInterpreter::sk_value, false}},
+   {op3_bfi_int, {ternary<uint32_t, BfiInt>, AluInterpreter::sk_value, false}},
+   {op3_fma, {ternary<float, Fma>, AluInterpreter::sk_value, true}},
+   {op3_bit_align_int, {ternary<uint32_t, BitAlign>, AluInterpreter::sk_value, false}},
+   {op3_byte_align_int, {ternary<uint32_t, ByteAlign>, AluInterpreter::sk_value, false}},
+   {op3_sad_accum_uint, {ternary<uint32_t, SadAccum>, AluInterpreter::sk_value, false}},
+   {op3_muladd_uint24, {ternary<uint32_t, MuladdUint24>, AluInterpreter::sk_value, false}},
+   {op3_muladd, {ternary<float, Muladd<1>>, AluInterpreter::sk_value, true}},
+   {op3_muladd_m2, {ternary<float, Muladd<2>>, AluInterpreter::sk_value, true}},
+   {op3_muladd_m4, {ternary<float, Muladd<4>>, AluInterpreter::sk_value, true}},
+   {op3_muladd_d2, {ternary<float, Muladd<-2>>, AluInterpreter::sk_value, true}},
+   {op3_muladd_ieee, {ternary<float, MuladdIEEE>, AluInterpreter::sk_value, true}},
+   {op3_cnde, {select<float, Eq<float>>, AluInterpreter::sk_value, true}},
+   {op3_cndgt, {select<float, Gt<float>>, AluInterpreter::sk_value, true}},
+   {op3_cndge, {select<float, Ge<float>>, AluInterpreter::sk_value, true}},
+   {op3_cnde_int, {select<int32_t, Eq<int32_t>>, AluInterpreter::sk_value, false}},
+   {op3_cndgt_int, {select<int32_t, Gt<int32_t>>, AluInterpreter::sk_value, false}},
+   {op3_cndge_int, {select<int32_t, Ge<int32_t>>, AluInterpreter::sk_value, false}},
+};
+
+uint32_t inline_value(const Value& v, const Wavefront& wf)
+{
+   uint32_t value;
+   if (AluInterpreter::inline_constant(v.sel(), value))
+      return value;
+
+   switch (v.sel()) {
+   case ALU_SRC_LOOP_IDX: return wf.loop_index();
+   case ALU_SRC_MASK_LO: return wf.active() & 0xffffffff;
+   case ALU_SRC_MASK_HI: return wf.active() >> 32;
+   default: {
+      std::ostringstream msg;
+      msg << "AluInterpreter: unsupported source " << v;
+      throw runtime_error(msg.str());
+   }
+   }
+}
+
+}
+
+const AluInterpreter::Semantics *AluInterpreter::semantics(EAluOp op)
+{
+   auto i = semantics_table.find(op);
+   return i != semantics_table.end() ? &i->second : nullptr;
+}
+
+bool AluInterpreter::supported(EAluOp op)
+{
+   return semantics(op) != nullptr;
+}
+
+bool AluInterpreter::inline_constant(unsigned sel, uint32_t& value)
+{
+   switch (sel) {
+   case ALU_SRC_0: value = 0; break;
+   case ALU_SRC_1: value = one_f; break;
+   case ALU_SRC_1_INT: value = 1; break;
+   case ALU_SRC_M_1_INT: value = 0xffffffff; break;
+   case ALU_SRC_0_5: value = 0x3f000000; break;
+   case ALU_SRC_1_DBL_L: value = 0; break;
+   case ALU_SRC_1_DBL_M: value = 0x3ff00000; break;
+   case ALU_SRC_0_5_DBL_L: value = 0; break;
+   case ALU_SRC_0_5_DBL_M: value = 0x3fe00000; break;
+   default:
+      return false;
+   }
+   return true;
+}
+
+AluInterpreter::AluInterpreter(const CFAluNode& alu, Wavefront& wf):
+   m_alu(alu),
+   m_wf(wf),
+   m_exec(0),
+   m_exec_updated(false),
+   m_killed(0)
+{
+}
+
+void AluInterpreter::run(const CFAluNode& alu, Wavefront& wf)
+{
+   AluInterpreter interp(alu, wf);
+   for (const auto& g: alu.clause())
+      interp.execute(g);
+   interp.finish();
+}
+
+int AluInterpreter::index(const AluNode& n, unsigned lane) const
+{
+   if (n.index_mode() == AluNode::idx_loop)
+      return m_wf.loop_index();
+   return static_cast<int32_t>(m_wf.ar()[lane]);
+}
+
+void AluInterpreter::read_lds_queue(unsigned sel, Wavefront& wf,
+                                    Lanes& result)
+{
+   bool pop = sel == ALU_SRC_LDS_OQ_A_POP || sel == ALU_SRC_LDS_OQ_B_POP;
+   unsigned queue = (sel == ALU_SRC_LDS_OQ_B || sel == ALU_SRC_LDS_OQ_B_POP);
+   LaneMask active = wf.active();
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      auto& q = wf.lds_queue(queue, i);
+      result[i] = q.empty() ? 0 : q.front();
+      if (pop && !q.empty() && (active & (LaneMask(1) << i)))
+         q.erase(q.begin());
+   }
+}
+
+const Lanes& AluInterpreter::load(const AluNode& n, const Value& v,
+                                  Lanes& scratch)
+{
+   /* reading the registers must not count as a write */
+   const Wavefront& regs = m_wf;
+   const Lanes *result = &scratch;
+
+   switch (v.type()) {
+   case Value::gpr:
+      if (!v.rel()) {
+         result = &regs.gpr(v.sel(), v.chan());
+      } else {
+         for (unsigned i = 0; i < wavefront_size; ++i) {
+            int sel = v.sel() + index(n, i);
+            scratch[i] = (sel >= 0 && sel < static_cast<int>(Wavefront::ngprs)) ?
+                            regs.gpr(sel, v.chan())[i] : 0;
+         }
+      }
+      break;
+   case Value::kconst: {
+      auto& c = static_cast<const ConstValue&>(v);
+      unsigned buffer = m_alu.kcache_bank(c.kcache_bank());
+      int base = 16 * m_alu.kcache_addr(c.kcache_bank()) + c.index();
+      if (!v.rel()) {
+         scratch.fill(m_wf.constant(buffer, base, v.chan()));
+      } else {
+         for (unsigned i = 0; i < wavefront_size; ++i) {
+            int idx = base + index(n, i);
+            scratch[i] = idx >= 0 ? m_wf.constant(buffer, idx, v.chan()) : 0;
+         }
+      }
+      break;
+   }
+   case Value::literal:
+      scratch.fill(static_cast<const LiteralValue&>(v).value());
+      break;
+   case Value::cinline:
+      if (v.sel() == ALU_SRC_PV)
+         result = &m_wf.pv(v.chan());
+      else if (v.sel() == ALU_SRC_PS)
+         result = &m_wf.pv(4);
+      else if (v.sel() >= ALU_SRC_LDS_OQ_A && v.sel() <= ALU_SRC_LDS_OQ_B_POP)
+         read_lds_queue(v.sel(), m_wf, scratch);
+      else
+         scratch.fill(inline_value(v, m_wf));
+      break;
+   default: {
+      std::ostringstream msg;
+      msg << "AluInterpreter: unsupported source " << v;
+      throw runtime_error(msg.str());
+   }
+   }
+
+   if (v.abs() || v.neg()) {
+      uint32_t and_mask = v.abs() ? ~sign_bit : 0xffffffff;
+      uint32_t xor_mask = v.neg() ? sign_bit : 0;
+      const Lanes& in = *result;
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         scratch[i] = (in[i] & and_mask) ^ xor_mask;
+      result = &scratch;
+   }
+   return *result;
+}
+
+void AluInterpreter::combine_slots(const std::array<const Semantics *, 5>& sem,
+                                   std::array<Lanes, 5>& results)
+{
+   Lanes dot;
+   Lanes max4;
+   bool have_dot = false;
+   bool have_max4 = false;
+   for (unsigned s = 0; s < 4; ++s) {
+      if (!sem[s] || (sem[s]->kind != sk_dot && sem[s]->kind != sk_max4))
+         continue;
+      bool is_dot = sem[s]->kind == sk_dot;
+      bool first = is_dot ? !have_dot : !have_max4;
+      Lanes& combined = is_dot ? dot : max4;
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         float v = lane_float(results[s][i]);
+         if (!first) {
+            float c = lane_float(combined[i]);
+            v = is_dot ? c + v : MaxLegacy()(c, v);
+         }
+         combined[i] = lane_bits(v);
+      }
+      have_dot |= is_dot;
+      have_max4 |= !is_dot;
+   }
+   for (unsigned s = 0; s < 4; ++s) {
+      if (sem[s] && sem[s]->kind == sk_dot)
+         results[s] = dot;
+      else if (sem[s] && sem[s]->kind == sk_max4)
+         results[s] = max4;
+   }
+}
+
+void AluInterpreter::apply_omod_clamp(Lanes& value,
+                                      AluNode::EOutputModify omod, bool clamp)
+{
+   float scale = 1.0f;
+   switch (omod) {
+   case AluNode::omod_mul_2: scale = 2.0f; break;
+   case AluNode::omod_mul_4: scale = 4.0f; break;
+   case AluNode::omod_div_2: scale = 0.5f; break;
+   default:
+      ;
+   }
+
+   if (scale != 1.0f)
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         value[i] = lane_bits(lane_float(value[i]) * scale);
+
+   if (clamp)
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         float f = lane_float(value[i]);
+         /* NaN is clamped to zero */
+         f = f > 0.0f ? (f < 1.0f ? f : 1.0f) : 0.0f;
+         value[i] = lane_bits(f);
+      }
+}
+
+void AluInterpreter::store(const AluNodeWithDst& n, const Lanes& value,
+                           LaneMask mask)
+{
+   const GPRValue& dst = n.dst();
+   if (!dst.rel()) {
+      Lanes& r = m_wf.gpr(dst.sel(), dst.chan());
+      if (mask == ~LaneMask(0)) {
+         r = value;
+      } else {
+         for (unsigned i = 0; i < wavefront_size; ++i)
+            if (mask & (LaneMask(1) << i))
+               r[i] = value[i];
+      }
+      return;
+   }
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      if (!(mask & (LaneMask(1) << i)))
+         continue;
+      int sel = dst.sel() + index(n, i);
+      if (sel >= 0 && sel < static_cast<int>(Wavefront::ngprs))
+         m_wf.gpr(sel, dst.chan())[i] = value[i];
+   }
+}
+
+void AluInterpreter::execute(const AluGroup& group)
+{
+   std::array<Lanes, 5> results;
+   std::array<LaneMask, 5> conditions;
+   std::array<const Semantics *, 5> sem;
+   std::array<Lanes, 3> scratch;
+   std::array<Lanes, 3> lds_src[5];
+   const AluNodeLDSIdxOP *lds[5] = {};
+
+   for (unsigned s = 0; s < 5; ++s) {
+      sem[s] = nullptr;
+      auto node = group.slot(s);
+      if (!node)
+         continue;
+
+      if (node->opcode() == op3_lds_idx_op) {
+         lds[s] = static_cast<const AluNodeLDSIdxOP *>(node.get());
+         if (!m_wf.lds())
+            throw runtime_error("AluInterpreter: no LDS for LDS instruction");
+         if (!LocalDataShare::supported(lds[s]->lds_op())) {
+            std::ostringstream msg;
+            msg << "AluInterpreter: unsupported instruction " << *node;
+            throw runtime_error(msg.str());
+         }
+         for (unsigned k = 0; k < node->nsources() && k < 3; ++k) {
+            auto v = node->get_src(k);
+            if (v)
+               lds_src[s][k] = load(*node, *v, scratch[k]);
+            else
+               lds_src[s][k].fill(0);
+         }
+         continue;
+      }
+
+      /* The wavefronts are synchronized by the CFEmulator */
+      if (node->opcode() == op2_group_barrier)
+         continue;
+
+      sem[s] = semantics(node->opcode());
+      if (!sem[s]) {
+         std::ostringstream msg;
+         msg << "AluInterpreter: unsupported instruction " << *node;
+         throw runtime_error(msg.str());
+      }
+
+      const Lanes *src[3] = {nullptr, nullptr, nullptr};
+      for (unsigned k = 0; k < node->nsources() && k < 3; ++k) {
+         auto v = node->get_src(k);
+         if (v)
+            src[k] = &load(*node, *v, scratch[k]);
+      }
+      conditions[s] = 0;
+      sem[s]->function(src, results[s], conditions[s]);
+   }
+
+   combine_slots(sem, results);
+
+   LaneMask active = m_wf.active();
+   LaneMask pred = m_wf.predicate();
+   LaneMask new_pred = pred;
+
+   for (unsigned s = 0; s < 5; ++s) {
+      if (!sem[s])
+         continue;
+      auto node = group.slot(s);
+      auto dnode = dynamic_cast<const AluNodeWithDst *>(node.get());
+
+      if (sem[s]->float_result) {
+         auto op2 = dynamic_cast<const AluNodeOp2 *>(node.get());
+         apply_omod_clamp(results[s],
+                          op2 ? op2->output_modify() : AluNode::omod_off,
+                          node->test_flag(AluNode::do_clamp));
+      }
+
+      LaneMask mask = active;
+      if (dnode) {
+         if (dnode->pred_select() == AluNode::pred_sel_zero)
+            mask &= ~pred;
+         else if (dnode->pred_select() == AluNode::pred_sel_one)
+            mask &= pred;
+      }
+
+      switch (sem[s]->kind) {
+      case sk_predicate:
+         if (node->test_flag(AluNode::do_update_pred))
+            new_pred = (new_pred & ~active) | (conditions[s] & active);
+         if (node->test_flag(AluNode::do_update_exec_mask)) {
+            m_exec = conditions[s] & active;
+            m_exec_updated = true;
+         }
+         break;
+      case sk_kill:
+         m_killed |= conditions[s] & active;
+         break;
+      case sk_mova:
+         for (unsigned i = 0; i < wavefront_size; ++i)
+            if (mask & (LaneMask(1) << i))
+               m_wf.ar()[i] = results[s][i];
+         break;
+      default:
+         ;
+      }
+
+      if (dnode && dnode->writes_dst())
+         store(*dnode, results[s], mask);
+   }
+
+   for (unsigned s = 0; s < 5; ++s)
+      if (sem[s])
+         m_wf.pv(s) = results[s];
+   m_wf.set_predicate(new_pred);
+
+   for (unsigned s = 0; s < 5; ++s) {
+      if (!lds[s])
+         continue;
+      const Lanes *src[3] = {nullptr, nullptr, nullptr};
+      for (unsigned k = 0; k < lds[s]->nsources() && k < 3; ++k)
+         src[k] = &lds_src[s][k];
+      m_wf.lds()->execute(lds[s]->lds_op(), lds[s]->offset(), src, active,
+                          m_wf);
+   }
+}
+
+void AluInterpreter::finish()
+{
+   if (m_exec_updated)
+      m_wf.set_active(m_exec);
+   m_wf.kill(m_killed);
+   m_exec_updated = false;
+   m_killed = 0;
+}
+
+}
@@ -0,0 +1,132 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_alu_interpreter_h
+#define r600_alu_interpreter_h
+
+#include <r600/cf_node.h>
+#include <r600/wavefront.h>
+
+#include <array>
+
+namespace r600 {
+
+/* Executes ALU clauses for all threads of a wavefront.
+ *
+ * Each instruction is evaluated for the 64 threads at once on the
+ * structure-of-arrays register file of the Wavefront. All instructions
+ * of a group read their sources before any result is written, and the
+ * results are forwarded to the next group through PV and PS. Source
+ * abs and neg act on the sign bit, the output modifier and clamp are
+ * applied to float results only. Results are only written for the
+ * active threads that pass the predicate select of the instruction.
+ *
+ * MUL, DOT4, MULADD and MAX/MIN follow the legacy (DX9) rules, i.e.
+ * zero times anything is zero and MAX/MIN return the first operand
+ * for unordered inputs, the _IEEE and _DX10 variants use IEEE rules.
+ *
+ * Predicate updates are visible to the following groups, while
+ * execution mask updates and killed threads take effect at the end of
+ * the clause.
+ *
+ * LDS instructions are executed on the LocalDataShare bound to the
+ * wavefront after the other instructions of the group, so their
+ * results can be read from the output queues starting with the next
+ * group. Reading an empty queue gives zero, the _POP sources remove
+ * the value from the queues of the active threads.
+ *
+ * GROUP_BARRIER is skipped, the wavefronts of a workgroup are
+ * synchronized by the CFEmulator before the group is executed.
+ */
+class AluInterpreter {
+public:
+   enum EKind {
+      /* the result is written to the destination */
+      sk_value,
+      /* the result is written, the condition sets the predicate and
+       * possibly the execution mask */
+      sk_predicate,
+      /* the condition kills the thread */
+      sk_kill,
+      /* the results of all vector slots with this op are summed */
+      sk_dot,
+      /* the maximum of the results of all vector slots is taken */
+      sk_max4,
+      /* the result is moved into the address register */
+      sk_mova
+   };
+
+   using Function = void (*)(const Lanes * const *src, Lanes& result,
+                             LaneMask& condition);
+
+   struct Semantics {
+      Function function;
+      EKind kind;
+      bool float_result;
+   };
+
+   /* The semantics of an opcode or nullptr if it is not supported */
+   static const Semantics *semantics(EAluOp op);
+   static bool supported(EAluOp op);
+
+   /* Value of an inline constant that does not depend on the state of
+    * the wavefront, returns false for other inline sources */
+   static bool inline_constant(unsigned sel, uint32_t& value);
+
+   AluInterpreter(const CFAluNode& alu, Wavefront& wf);
+
+   /* Execute one group, throws std::runtime_error if an instruction or
+    * a source is not supported */
+   void execute(const AluGroup& group);
+
+   /* Apply the execution mask updates and the kills of the clause */
+   void finish();
+
+   /* Execute all groups of the clause */
+   static void run(const CFAluNode& alu, Wavefront& wf);
+
+   /* Replace the results of the DOT4 and MAX4 slots of a group by the
+    * combined result */
+   static void combine_slots(const std::array<const Semantics *, 5>& sem,
+                             std::array<Lanes, 5>& results);
+
+   /* Apply the output modifier and clamp to a float result */
+   static void apply_omod_clamp(Lanes& value, AluNode::EOutputModify omod,
+                                bool clamp);
+
+   /* Read one of the ALU_SRC_LDS_OQ_* sources of wf */
+   static void read_lds_queue(unsigned sel, Wavefront& wf, Lanes& result);
+
+private:
+   const Lanes& load(const AluNode& n, const Value& v, Lanes& scratch);
+   void store(const AluNodeWithDst& n, const Lanes& value, LaneMask mask);
+   int index(const AluNode& n, unsigned lane) const;
+
+   const CFAluNode& m_alu;
+   Wavefront& m_wf;
+   LaneMask m_exec;
+   bool m_exec_updated;
+   LaneMask m_killed;
+};
+
+}
+
+#endif
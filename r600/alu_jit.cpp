@@ -0,0 +1,467 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/alu_jit.h>
+
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define R600_X86_64_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace r600 {
+
+namespace {
+
+enum EConstant {
+   k_abs,
+   k_sign,
+   k_one,
+   k_ones,
+   k_two,
+   k_four,
+   k_half,
+   k_count
+};
+
+alignas(16) const uint32_t constants[k_count][4] = {
+   {0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff},
+   {0x80000000, 0x80000000, 0x80000000, 0x80000000},
+   {0x3f800000, 0x3f800000, 0x3f800000, 0x3f800000},
+   {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+   {0x40000000, 0x40000000, 0x40000000, 0x40000000},
+   {0x40800000, 0x40800000, 0x40800000, 0x40800000},
+   {0x3f000000, 0x3f000000, 0x3f000000, 0x3f000000},
+};
+
+/* The general purpose registers used by the generated code, all of
+ * them are caller saved in the System V ABI. The function arguments
+ * are passed in rdi (table) and rsi (results) */
+enum EReg {
+   rax = 0,
+   rcx = 1,
+   rdx = 2,
+   rsi = 6,
+   rdi = 7,
+   r8 = 8
+};
+
+/* SSE opcodes, the operand size prefix of the integer ops is kept in
+ * the high byte */
+enum ESSE {
+   movups_load = 0x10,
+   movups_store = 0x11,
+   movaps = 0x28,
+   andps = 0x54,
+   andnps = 0x55,
+   orps = 0x56,
+   xorps = 0x57,
+   addps = 0x58,
+   mulps = 0x59,
+   pcmpgtd = 0x6666,
+   pcmpeqd = 0x6676,
+   psubd = 0x66fa,
+   paddd = 0x66fe,
+   pxor = 0x66ef
+};
+
+/* cmpps predicates */
+enum ECmp {
+   cmp_eq = 0,
+   cmp_lt = 1,
+   cmp_le = 2,
+   cmp_neq = 4
+};
+
+/* The registers that hold src0, src1, and src2 of a chunk of four
+ * lanes, the result is returned in xmm0 */
+const int a = 0;
+const int b = 1;
+const int c = 2;
+
+class Emitter {
+public:
+   Emitter(std::vector<uint8_t>& code): m_code(code) {}
+
+   void sse(ESSE op, int dst, int src)
+   {
+      opcode(op, false);
+      byte(0xc0 | (dst << 3) | src);
+   }
+
+   void sse(ESSE op, int reg, EReg base, int32_t disp)
+   {
+      opcode(op, base >= r8);
+      byte(0x80 | (reg << 3) | (base & 7));
+      dword(disp);
+   }
+
+   void cmpps(int dst, int src, ECmp pred)
+   {
+      byte(0x0f);
+      byte(0xc2);
+      byte(0xc0 | (dst << 3) | src);
+      byte(pred);
+   }
+
+   /* mov dst, [base + disp] */
+   void load_pointer(EReg dst, EReg base, int32_t disp)
+   {
+      byte(0x48 | (dst >= r8 ? 4 : 0) | (base >= r8 ? 1 : 0));
+      byte(0x8b);
+      byte(0x80 | ((dst & 7) << 3) | (base & 7));
+      dword(disp);
+   }
+
+   /* mov dst, imm64 */
+   void load_address(EReg dst, const void *p)
+   {
+      byte(0x48 | (dst >= r8 ? 1 : 0));
+      byte(0xb8 | (dst & 7));
+      uint64_t v = reinterpret_cast<uintptr_t>(p);
+      dword(v & 0xffffffff);
+      dword(v >> 32);
+   }
+
+   void constant(ESSE op, int reg, EConstant k)
+   {
+      sse(op, reg, r8, 16 * k);
+   }
+
+   void ret()
+   {
+      byte(0xc3);
+   }
+
+private:
+   void opcode(ESSE op, bool rex_b)
+   {
+      if (op > 0xff)
+         byte(op >> 8);
+      if (rex_b)
+         byte(0x41);
+      byte(0x0f);
+      byte(op & 0xff);
+   }
+
+   void byte(uint8_t v)
+   {
+      m_code.push_back(v);
+   }
+
+   void dword(uint32_t v)
+   {
+      for (int i = 0; i < 4; ++i)
+         byte((v >> (8 * i)) & 0xff);
+   }
+
+   std::vector<uint8_t>& m_code;
+};
+
+/* a = mask(xmm3) ? a : b */
+void blend(Emitter& e)
+{
+   e.sse(andps, a, 3);
+   e.sse(andnps, 3, b);
+   e.sse(orps, a, 3);
+}
+
+/* a = (a == 0 || b == 0) ? 0 : a * b */
+void mul_legacy(Emitter& e)
+{
+   e.sse(movaps, 3, a);
+   e.sse(mulps, 3, b);
+   e.sse(xorps, 4, 4);
+   e.cmpps(a, 4, cmp_eq);
+   e.cmpps(b, 4, cmp_eq);
+   e.sse(orps, a, b);
+   e.sse(andnps, a, 3);
+}
+
+/* a = pred(b, a), i.e. the comparison with swapped operands */
+void compare_swapped(Emitter& e, ECmp pred)
+{
+   e.sse(movaps, 3, b);
+   e.cmpps(3, a, pred);
+   e.sse(movaps, a, 3);
+}
+
+/* xmm4 and xmm5 get a and b with the sign bit flipped so that the
+ * signed integer comparison orders them as unsigned values */
+void bias_unsigned(Emitter& e)
+{
+   e.sse(movaps, 4, a);
+   e.constant(pxor, 4, k_sign);
+   e.sse(movaps, 5, b);
+   e.constant(pxor, 5, k_sign);
+}
+
+/* Emit the evaluation of one chunk of four lanes with the sources in
+ * xmm0-xmm2, returns false if the op is not supported */
+bool emit_op(Emitter& e, EAluOp op)
+{
+   switch (op) {
+   case op2_mov:
+      return true;
+   case op2_add:
+      e.sse(addps, a, b);
+      return true;
+   case op2_mul_ieee:
+   case op2_dot4_ieee:
+      e.sse(mulps, a, b);
+      return true;
+   case op2_mul:
+   case op2_dot4:
+      mul_legacy(e);
+      return true;
+   case op3_muladd:
+   case op3_muladd_m2:
+   case op3_muladd_m4:
+   case op3_muladd_d2:
+      mul_legacy(e);
+      e.sse(addps, a, c);
+      if (op == op3_muladd_m2)
+         e.constant(mulps, a, k_two);
+      else if (op == op3_muladd_m4)
+         e.constant(mulps, a, k_four);
+      else if (op == op3_muladd_d2)
+         e.constant(mulps, a, k_half);
+      return true;
+   case op3_muladd_ieee:
+      e.sse(mulps, a, b);
+      e.sse(addps, a, c);
+      return true;
+   case op2_max:
+      /* a >= b ? a : b */
+      e.sse(movaps, 3, b);
+      e.cmpps(3, a, cmp_le);
+      blend(e);
+      return true;
+   case op2_min:
+      /* a < b ? a : b */
+      e.sse(movaps, 3, a);
+      e.cmpps(3, b, cmp_lt);
+      blend(e);
+      return true;
+   case op2_sete:
+   case op2_sete_dx10:
+      e.cmpps(a, b, cmp_eq);
+      break;
+   case op2_setne:
+   case op2_setne_dx10:
+      e.cmpps(a, b, cmp_neq);
+      break;
+   case op2_setgt:
+   case op2_setgt_dx10:
+      compare_swapped(e, cmp_lt);
+      break;
+   case op2_setge:
+   case op2_setge_dx10:
+      compare_swapped(e, cmp_le);
+      break;
+   case op2_add_int:
+      e.sse(paddd, a, b);
+      return true;
+   case op2_sub_int:
+      e.sse(psubd, a, b);
+      return true;
+   case op2_and_int:
+      e.sse(andps, a, b);
+      return true;
+   case op2_or_int:
+      e.sse(orps, a, b);
+      return true;
+   case op2_xor_int:
+      e.sse(xorps, a, b);
+      return true;
+   case op2_not_int:
+      e.constant(pxor, a, k_ones);
+      return true;
+   case op2_sete_int:
+      e.sse(pcmpeqd, a, b);
+      return true;
+   case op2_setne_int:
+      e.sse(pcmpeqd, a, b);
+      e.constant(pxor, a, k_ones);
+      return true;
+   case op2_setgt_int:
+      e.sse(pcmpgtd, a, b);
+      return true;
+   case op2_setge_int:
+      e.sse(pcmpgtd, b, a);
+      e.constant(pxor, b, k_ones);
+      e.sse(movaps, a, b);
+      return true;
+   case op2_setgt_uint:
+      bias_unsigned(e);
+      e.sse(pcmpgtd, 4, 5);
+      e.sse(movaps, a, 4);
+      return true;
+   case op2_setge_uint:
+      bias_unsigned(e);
+      e.sse(pcmpgtd, 5, 4);
+      e.constant(pxor, 5, k_ones);
+      e.sse(movaps, a, 5);
+      return true;
+   case op2_max_int:
+      e.sse(movaps, 3, a);
+      e.sse(pcmpgtd, 3, b);
+      blend(e);
+      return true;
+   case op2_min_int:
+      e.sse(movaps, 3, b);
+      e.sse(pcmpgtd, 3, a);
+      blend(e);
+      return true;
+   case op2_max_uint:
+      bias_unsigned(e);
+      e.sse(pcmpgtd, 4, 5);
+      e.sse(movaps, 3, 4);
+      blend(e);
+      return true;
+   case op2_min_uint:
+      bias_unsigned(e);
+      e.sse(pcmpgtd, 5, 4);
+      e.sse(movaps, 3, 5);
+      blend(e);
+      return true;
+   default:
+      return false;
+   }
+
+   /* float compares, the legacy variants return 1.0 */
+   if (op == op2_sete || op == op2_setne || op == op2_setgt ||
+       op == op2_setge)
+      e.constant(andps, a, k_one);
+   return true;
+}
+
+const EReg source_reg[3] = {rax, rcx, rdx};
+
+}
+
+bool AluJit::available()
+{
+#ifdef R600_X86_64_JIT
+   return true;
+#else
+   return false;
+#endif
+}
+
+bool AluJit::supported(EAluOp op)
+{
+   std::vector<uint8_t> scratch;
+   Emitter e(scratch);
+   return emit_op(e, op);
+}
+
+AluJit::AluJit():
+   m_memory(nullptr),
+   m_memory_size(0)
+{
+}
+
+AluJit::~AluJit()
+{
+#ifdef R600_X86_64_JIT
+   if (m_memory)
+      munmap(m_memory, m_memory_size);
+#endif
+}
+
+int AluJit::add(const std::vector<Instr>& group)
+{
+   if (!available() || m_memory)
+      return -1;
+
+   for (const auto& i: group)
+      if (!supported(i.op))
+         return -1;
+
+   size_t start = m_code.size();
+   Emitter e(m_code);
+   e.load_address(r8, constants);
+
+   for (const auto& i: group) {
+      for (unsigned k = 0; k < i.nsrc; ++k)
+         e.load_pointer(source_reg[k], rdi, 8 * i.src[k].index);
+
+      for (unsigned chunk = 0; chunk < wavefront_size / 4; ++chunk) {
+         int32_t offset = 16 * chunk;
+         for (unsigned k = 0; k < i.nsrc; ++k) {
+            e.sse(movups_load, k, source_reg[k], offset);
+            if (i.src[k].abs)
+               e.constant(andps, k, k_abs);
+            if (i.src[k].neg)
+               e.constant(xorps, k, k_sign);
+         }
+         emit_op(e, i.op);
+         e.sse(movups_store, a, rsi, i.slot * sizeof(Lanes) + offset);
+      }
+   }
+   e.ret();
+
+   m_entries.push_back(start);
+   return m_entries.size() - 1;
+}
+
+bool AluJit::finalize()
+{
+#ifdef R600_X86_64_JIT
+   if (m_memory || m_code.empty())
+      return m_memory != nullptr;
+
+   size_t page = sysconf(_SC_PAGESIZE);
+   m_memory_size = (m_code.size() + page - 1) / page * page;
+   void *p = mmap(nullptr, m_memory_size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (p == MAP_FAILED)
+      return false;
+
+   memcpy(p, m_code.data(), m_code.size());
+   if (mprotect(p, m_memory_size, PROT_READ | PROT_EXEC)) {
+      munmap(p, m_memory_size);
+      return false;
+   }
+   m_memory = p;
+   return true;
+#else
+   return false;
+#endif
+}
+
+AluJit::Function AluJit::function(int id) const
+{
+   if (!m_memory || id < 0 || static_cast<size_t>(id) >= m_entries.size())
+      return nullptr;
+   return reinterpret_cast<Function>(static_cast<uint8_t *>(m_memory) +
+                                     m_entries[id]);
+}
+
+size_t AluJit::code_size() const
+{
+   return m_code.size();
+}
+
+}
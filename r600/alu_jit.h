@@ -0,0 +1,98 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_alu_jit_h
+#define r600_alu_jit_h
+
+#include <r600/alu_defines.h>
+#include <r600/wavefront.h>
+
+#include <vector>
+
+namespace r600 {
+
+/* Translates ALU groups into native x86-64 code.
+ *
+ * The generated code evaluates the instructions of a group with SSE2
+ * for all threads of a wavefront, reads the sources through a table of
+ * lane pointers that is filled before the clause is run, and writes the
+ * raw results of the slots. Source abs and neg are applied in the
+ * generated code, while the output modifiers, the combining of DOT4
+ * slots, and the write back are left to the caller. The supported ops
+ * give the same results as the AluInterpreter, except that the NaN
+ * that is returned when both operands are NaN may differ, the
+ * interpreter leaves this choice to the compiler.
+ *
+ * The code is emitted into anonymous memory that is made executable
+ * once all groups have been added. Native code is only generated when
+ * building for x86-64 Linux, elsewhere available() returns false.
+ */
+class AluJit {
+public:
+   struct Source {
+      /* index into the lane pointer table */
+      unsigned index;
+      bool abs;
+      bool neg;
+   };
+
+   struct Instr {
+      EAluOp op;
+      unsigned slot;
+      unsigned nsrc;
+      Source src[3];
+   };
+
+   /* Evaluates a group, results points to the five slot results */
+   using Function = void (*)(const uint32_t * const *table, Lanes *results);
+
+   static bool available();
+   static bool supported(EAluOp op);
+
+   AluJit();
+   ~AluJit();
+
+   AluJit(const AluJit&) = delete;
+   AluJit& operator = (const AluJit&) = delete;
+
+   /* Add the code for a group and return its id, or -1 if an
+    * instruction is not supported */
+   int add(const std::vector<Instr>& group);
+
+   /* Make the code executable, no groups can be added afterwards.
+    * Returns false if no executable memory could be obtained */
+   bool finalize();
+
+   /* The entry point of a group, only valid after finalize() */
+   Function function(int id) const;
+
+   size_t code_size() const;
+
+private:
+   std::vector<uint8_t> m_code;
+   std::vector<size_t> m_entries;
+   void *m_memory;
+   size_t m_memory_size;
+};
+
+}
+
+#endif
@@ -49,7 +49,7 @@ AluNode *AluNode::decode(uint64_t bc, Value::LiteralFlags *literal_index)
    auto pred_sel = static_cast<EPredSelect>((bc >> 29) & 3);
 
    if (bc & clamp_bit)
-      flags.set(1 << do_clamp);
+      flags.set(do_clamp);
 
    if (bc & last_instr_bit)
       flags.set(is_last_instr);
@@ -131,14 +131,96 @@ bool AluNode::last_instr() const
    return m_flags.test(is_last_instr);
 }
 
+EAluOp AluNode::opcode() const
+{
+   return m_opcode;
+}
+
+AluNode::EBankSwizzle AluNode::bank_swizzle() const
+{
+   return m_bank_swizzle;
+}
+
+AluNode::EIndexMode AluNode::index_mode() const
+{
+   return m_index_mode;
+}
+
+void AluNode::set_bank_swizzle(EBankSwizzle bank_swizzle)
+{
+   m_bank_swizzle = bank_swizzle;
+}
+
+unsigned AluNode::nsources() const
+{
+   return nopsources();
+}
+
+PValue AluNode::get_src(unsigned idx) const
+{
+   assert(idx < m_src.size());
+   return m_src[idx];
+}
+
 bool AluNode::test_flag(FlagsShifts f) const
 {
    return m_flags.test(f);
 }
 
+bool AluNode::has_side_effects() const
+{
+   if (test_flag(AluNode::do_update_exec_mask) ||
+       test_flag(AluNode::do_update_pred))
+      return true;
+
+   if (is_kill_op(m_opcode))
+      return true;
+
+   switch (m_opcode) {
+   case op2_pred_setgt_uint:
+   case op2_pred_setge_uint:
+   case op2_pred_sete:
+   case op2_pred_setgt:
+   case op2_pred_setge:
+   case op2_pred_setne:
+   case op2_pred_set_inv:
+   case op2_pred_set_pop:
+   case op2_pred_set_clr:
+   case op2_pred_set_restore:
+   case op2_pred_sete_push:
+   case op2_pred_setgt_push:
+   case op2_pred_setge_push:
+   case op2_pred_setne_push:
+   case op2_prede_int:
+   case op2_pred_setgt_int:
+   case op2_pred_setge_int:
+   case op2_pred_setne_int:
+   case op2_pred_sete_push_int:
+   case op2_pred_setgt_push_int:
+   case op2_pred_setge_push_int:
+   case op2_pred_setne_push_int:
+   case op2_pred_setlt_push_int:
+   case op2_pred_setle_push_int:
+   case op2_pred_setgt_64:
+   case op2_pred_setge_64:
+   case op2_mova_int:
+   case op2_set_cf_idx0:
+   case op2_set_cf_idx1:
+   case op2_group_barrier:
+   case op2_group_seq_begin:
+   case op2_group_seq_end:
+   case op2_set_mode:
+   case op2_set_lds_size:
+   case op2_store_flags:
+   case op2_load_store_flags:
+      return true;
+   default:
+      return false;
+   }
+}
+
 bool AluNode::slot_supported(unsigned flag) const
 {
-   std::cerr << "flag:" << flag << "\n";
    auto op = alu_ops.find(m_opcode);
    if (op != alu_ops.end())
       return op->second.can_channel(flag);
@@ -325,6 +407,21 @@ AluNodeWithDst::AluNodeWithDst(uint16_t opcode, const GPRValue& dst, EIndexMode
 {
 }
 
+const GPRValue& AluNodeWithDst::dst() const
+{
+   return m_dst;
+}
+
+AluNode::EPredSelect AluNodeWithDst::pred_select() const
+{
+   return m_pred_select;
+}
+
+bool AluNodeWithDst::writes_dst() const
+{
+   return test_flag(do_write) || test_flag(is_op3);
+}
+
 void AluNodeWithDst::print_pred(std::ostream& os) const
 {
    switch (m_pred_select) {
@@ -339,7 +436,7 @@ void AluNodeWithDst::print_pred(std::ostream& os) const
 
 void AluNodeWithDst::print_dst(std::ostream& os) const
 {
-   if (test_flag(do_write) || test_flag(is_op3))
+   if (writes_dst())
       os << m_dst << ", ";
    else
       os << "__." << Value::component_names[m_dst.chan()] <<", ";
@@ -387,6 +484,11 @@ void AluNodeOp2::encode(uint64_t& bc) const
    bc |= static_cast<uint64_t>(m_output_modify) << 37;
 }
 
+AluNode::EOutputModify AluNodeOp2::output_modify() const
+{
+   return m_output_modify;
+}
+
 void AluNodeOp2::print_omod(std::ostream& os) const
 {
    switch (m_output_modify) {
@@ -441,6 +543,16 @@ AluNodeLDSIdxOP::AluNodeLDSIdxOP(uint16_t opcode, ESDOp lds_op,
    set_src(2, src2);
 }
 
+ESDOp AluNodeLDSIdxOP::lds_op() const
+{
+   return m_lds_op;
+}
+
+int AluNodeLDSIdxOP::offset() const
+{
+   return m_offset;
+}
+
 void AluNodeLDSIdxOP::encode(uint64_t& bc) const
 {
    /* needs to check actual numbers of ussed registers */
@@ -488,7 +600,8 @@ void AluNodeLDSIdxOP::set_spec_literal_info(uint64_t *literals)
 }
 
 AluGroup::AluGroup():
-   m_ops(5)
+   m_ops(5),
+   m_address(0)
 {
 }
 
@@ -498,6 +611,7 @@ size_t AluGroup::decode(const std::vector<uint64_t>& bc, size_t ofs, size_t end)
    Value::LiteralFlags lflags;
    bool group_should_finish = false;
    assert(bc.size() >= end);
+   m_address = ofs;
 
    do {
       if (group_should_finish)
@@ -558,6 +672,23 @@ std::string AluGroup::as_string(int indent) const
    return os.str();
 }
 
+size_t AluGroup::address() const
+{
+   return m_address;
+}
+
+PAluNode AluGroup::slot(unsigned i) const
+{
+   assert(i < m_ops.size());
+   return m_ops[i];
+}
+
+void AluGroup::set_slot(unsigned i, PAluNode node)
+{
+   assert(i < m_ops.size());
+   m_ops[i] = node;
+}
+
 bool AluGroup::encode(std::vector<uint64_t>& bc) const
 {
    vector<PValue> values;
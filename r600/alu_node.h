@@ -88,6 +88,18 @@ public:
    unsigned dst_chan() const;
    bool last_instr() const;
 
+   EAluOp opcode() const;
+   EBankSwizzle bank_swizzle() const;
+   EIndexMode index_mode() const;
+   void set_bank_swizzle(EBankSwizzle bank_swizzle);
+   unsigned nsources() const;
+   PValue get_src(unsigned idx) const;
+   bool test_flag(FlagsShifts f) const;
+
+   /* The instruction does more than writing its result, e.g. it updates
+    * the predicate or execution mask, kills threads, or sets AR */
+   bool has_side_effects() const;
+
    bool slot_supported(unsigned flag) const;
    uint64_t bytecode() const;
 
@@ -99,7 +111,6 @@ public:
    void print(std::ostream& os) const;
 
 protected:
-   bool test_flag(FlagsShifts f) const;
    const Value& src(unsigned idx) const;
    Value& src(unsigned idx);
    void set_src(unsigned idx, PValue v);
@@ -135,6 +146,13 @@ inline std::ostream& operator << (std::ostream& os, const AluNode& n)
 using PAluNode = std::shared_ptr<AluNode>;
 
 class AluNodeWithDst: public AluNode {
+public:
+   const GPRValue& dst() const;
+   EPredSelect pred_select() const;
+
+   /* true if the result is written to the destination register and not
+    * only to PV/PS */
+   bool writes_dst() const;
 protected:
    AluNodeWithDst(uint16_t opcode, const GPRValue& dst,
                   EIndexMode index_mode,
@@ -157,6 +175,8 @@ public:
               EBankSwizzle bank_swizzle = alu_vec_012,
               EOutputModify output_modify = omod_off,
               EPredSelect pred_select = pred_sel_off);
+
+   EOutputModify output_modify() const;
 private:
    void print_omod(std::ostream& os) const override;
    void encode(uint64_t& bc) const override;
@@ -185,6 +205,9 @@ public:
                    int offset = 0, unsigned dst_chan = 0,
                    EIndexMode index_mode = idx_ar_x,
                    EBankSwizzle bank_swizzle = alu_vec_012);
+
+   ESDOp lds_op() const;
+   int offset() const;
 protected:
    unsigned nopsources() const override;
 private:
@@ -203,8 +226,17 @@ public:
    bool encode(std::vector<uint64_t>& bc) const;
    std::string as_string(int indent=0) const;
 
+   /* Bytecode address of the first instruction, set by decode() */
+   size_t address() const;
+
+   /* Slots are indexed 0-3 for x-w and 4 for the trans unit,
+    * unused slots return an empty pointer */
+   PAluNode slot(unsigned i) const;
+   void set_slot(unsigned i, PAluNode node);
+
 private:
    std::vector<PAluNode> m_ops;
+   size_t m_address;
 };
 
 }
@@ -0,0 +1,630 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/alu_interpreter.h>
+#include <r600/alu_reference.h>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+namespace {
+
+const uint32_t one_f = 0x3f800000;
+
+uint32_t f2u(float f) { return lane_bits(f); }
+
+float mul_legacy(float a, float b)
+{
+   if (a == 0.0f || b == 0.0f)
+      return 0.0f;
+   return a * b;
+}
+
+float max_legacy(float a, float b)
+{
+   if (a >= b)
+      return a;
+   return b;
+}
+
+float min_legacy(float a, float b)
+{
+   if (a < b)
+      return a;
+   return b;
+}
+
+float max_dx10(float a, float b)
+{
+   if (std::isnan(a))
+      return b;
+   if (std::isnan(b))
+      return a;
+   return a > b ? a : b;
+}
+
+float min_dx10(float a, float b)
+{
+   if (std::isnan(a))
+      return b;
+   if (std::isnan(b))
+      return a;
+   return a < b ? a : b;
+}
+
+int32_t flt_to_int(float a)
+{
+   if (std::isnan(a))
+      return 0;
+   if (a >= 2147483648.0f)
+      return INT_MAX;
+   if (a <= -2147483648.0f)
+      return INT_MIN;
+   return static_cast<int32_t>(a);
+}
+
+uint32_t flt_to_uint(float a)
+{
+   if (std::isnan(a) || a <= 0.0f)
+      return 0;
+   if (a >= 4294967296.0f)
+      return UINT_MAX;
+   return static_cast<uint32_t>(a);
+}
+
+unsigned count_bits(uint32_t a)
+{
+   unsigned n = 0;
+   for (unsigned i = 0; i < 32; ++i)
+      n += (a >> i) & 1;
+   return n;
+}
+
+uint32_t first_bit_high(uint32_t a)
+{
+   for (unsigned i = 0; i < 32; ++i)
+      if (a & (0x80000000u >> i))
+         return i;
+   return 0xffffffff;
+}
+
+uint32_t first_bit_low(uint32_t a)
+{
+   for (unsigned i = 0; i < 32; ++i)
+      if (a & (1u << i))
+         return i;
+   return 0xffffffff;
+}
+
+/* Replace an infinite result by a signed limit */
+float clamp_inf(float r, float limit)
+{
+   return std::isinf(r) ? std::copysign(limit, r) : r;
+}
+
+uint32_t bitfield_extract(uint32_t a, uint32_t offset, uint32_t width,
+                          bool is_signed)
+{
+   offset &= 31;
+   width &= 31;
+   if (!width)
+      return 0;
+   uint32_t v = a >> offset;
+   if (offset + width >= 32)
+      return is_signed ? static_cast<uint32_t>(static_cast<int32_t>(a) >>
+                                               offset) : v;
+   v &= (1u << width) - 1;
+   if (is_signed && (v & (1u << (width - 1))))
+      v |= ~((1u << width) - 1);
+   return v;
+}
+
+}
+
+bool AluReference::evaluate(EAluOp op, const uint32_t src[3], Result& result)
+{
+   const float fa = lane_float(src[0]);
+   const float fb = lane_float(src[1]);
+   const float fc = lane_float(src[2]);
+   const int32_t ia = static_cast<int32_t>(src[0]);
+   const int32_t ib = static_cast<int32_t>(src[1]);
+   const uint32_t ua = src[0];
+   const uint32_t ub = src[1];
+   const uint32_t uc = src[2];
+
+   uint32_t r = 0;
+   bool cond = false;
+   bool is_float = true;
+   EEffect effect = re_none;
+
+   switch (op) {
+   /* float arithmetic */
+   case op2_add: r = f2u(fa + fb); break;
+   case op2_mul: r = f2u(mul_legacy(fa, fb)); break;
+   case op2_mul_ieee: r = f2u(fa * fb); break;
+   case op2_max: r = f2u(max_legacy(fa, fb)); break;
+   case op2_min: r = f2u(min_legacy(fa, fb)); break;
+   case op2_max_dx10: r = f2u(max_dx10(fa, fb)); break;
+   case op2_min_dx10: r = f2u(min_dx10(fa, fb)); break;
+   case op2_fract: r = f2u(fa - std::floor(fa)); break;
+   case op2_trunc: r = f2u(std::trunc(fa)); break;
+   case op2_ceil: r = f2u(std::ceil(fa)); break;
+   case op2_rndne: r = f2u(std::rint(fa)); break;
+   case op2_floor: r = f2u(std::floor(fa)); break;
+   case op2_exp_ieee: r = f2u(std::exp2(fa)); break;
+   case op2_log_ieee: r = f2u(std::log2(fa)); break;
+   case op2_log_clamped: {
+      float l = std::log2(fa);
+      r = f2u(l == -INFINITY ? -FLT_MAX : l);
+      break;
+   }
+   case op2_recip_ieee: r = f2u(1.0f / fa); break;
+   case op2_recip_clamped: r = f2u(clamp_inf(1.0f / fa, FLT_MAX)); break;
+   case op2_recip_ff: r = f2u(clamp_inf(1.0f / fa, 0.0f)); break;
+   case op2_recipsqrt_ieee: r = f2u(1.0f / std::sqrt(fa)); break;
+   case op2_recipsqrt_clamped:
+      r = f2u(clamp_inf(1.0f / std::sqrt(fa), FLT_MAX));
+      break;
+   case op2_recipsqrt_ff: r = f2u(clamp_inf(1.0f / std::sqrt(fa), 0.0f)); break;
+   case op2_sqrt_ieee: r = f2u(std::sqrt(fa)); break;
+   case op2_sin: r = f2u(std::sin(fa)); break;
+   case op2_cos: r = f2u(std::cos(fa)); break;
+   case op3_fma: r = f2u(std::fma(fa, fb, fc)); break;
+   case op3_muladd: r = f2u(mul_legacy(fa, fb) + fc); break;
+   case op3_muladd_m2: r = f2u((mul_legacy(fa, fb) + fc) * 2.0f); break;
+   case op3_muladd_m4: r = f2u((mul_legacy(fa, fb) + fc) * 4.0f); break;
+   case op3_muladd_d2: r = f2u((mul_legacy(fa, fb) + fc) / 2.0f); break;
+   case op3_muladd_ieee: r = f2u(fa * fb + fc); break;
+   case op3_cnde: r = fa == 0.0f ? ub : uc; break;
+   case op3_cndgt: r = fa > 0.0f ? ub : uc; break;
+   case op3_cndge: r = fa >= 0.0f ? ub : uc; break;
+
+   /* conversions */
+   case op2_int_to_flt: r = f2u(static_cast<float>(ia)); break;
+   case op2_uint_to_flt: r = f2u(static_cast<float>(ua)); break;
+   case op2_ubyte0_flt: r = f2u(static_cast<float>(ua & 0xff)); break;
+   case op2_ubyte1_flt: r = f2u(static_cast<float>((ua >> 8) & 0xff)); break;
+   case op2_ubyte2_flt: r = f2u(static_cast<float>((ua >> 16) & 0xff)); break;
+   case op2_ubyte3_flt: r = f2u(static_cast<float>(ua >> 24)); break;
+   case op2_flt16_to_flt32: r = f2u(half_to_float(ua & 0xffff)); break;
+   case op2_flt32_to_flt16: r = float_to_half(fa); is_float = false; break;
+   case op2_flt_to_int: r = flt_to_int(fa); is_float = false; break;
+   case op2_flt_to_int_floor:
+      r = flt_to_int(std::floor(fa));
+      is_float = false;
+      break;
+   case op2_flt_to_int_rpi:
+      r = flt_to_int(std::floor(fa + 0.5f));
+      is_float = false;
+      break;
+   case op2_flt_to_uint: r = flt_to_uint(fa); is_float = false; break;
+
+   /* float compares */
+   case op2_sete: r = fa == fb ? one_f : 0; break;
+   case op2_setgt: r = fa > fb ? one_f : 0; break;
+   case op2_setge: r = fa >= fb ? one_f : 0; break;
+   case op2_setne: r = fa != fb ? one_f : 0; break;
+   case op2_sete_dx10: r = fa == fb ? ~0u : 0; is_float = false; break;
+   case op2_setgt_dx10: r = fa > fb ? ~0u : 0; is_float = false; break;
+   case op2_setge_dx10: r = fa >= fb ? ~0u : 0; is_float = false; break;
+   case op2_setne_dx10: r = fa != fb ? ~0u : 0; is_float = false; break;
+
+   /* integer arithmetic */
+   case op2_mov: r = ua; is_float = false; break;
+   case op2_nop: r = 0; is_float = false; break;
+   case op2_add_int: r = ua + ub; is_float = false; break;
+   case op2_sub_int: r = ua - ub; is_float = false; break;
+   case op2_and_int: r = ua & ub; is_float = false; break;
+   case op2_or_int: r = ua | ub; is_float = false; break;
+   case op2_xor_int: r = ua ^ ub; is_float = false; break;
+   case op2_not_int: r = ~ua; is_float = false; break;
+   case op2_ashr_int: r = ia >> (ub & 31); is_float = false; break;
+   case op2_lshr_int: r = ua >> (ub & 31); is_float = false; break;
+   case op2_lshl_int: r = ua << (ub & 31); is_float = false; break;
+   case op2_max_int: r = ia > ib ? ua : ub; is_float = false; break;
+   case op2_min_int: r = ia < ib ? ua : ub; is_float = false; break;
+   case op2_max_uint: r = ua > ub ? ua : ub; is_float = false; break;
+   case op2_min_uint: r = ua < ub ? ua : ub; is_float = false; break;
+   case op2_sete_int: r = ia == ib ? ~0u : 0; is_float = false; break;
+   case op2_setgt_int: r = ia > ib ? ~0u : 0; is_float = false; break;
+   case op2_setge_int: r = ia >= ib ? ~0u : 0; is_float = false; break;
+   case op2_setne_int: r = ia != ib ? ~0u : 0; is_float = false; break;
+   case op2_setgt_uint: r = ua > ub ? ~0u : 0; is_float = false; break;
+   case op2_setge_uint: r = ua >= ub ? ~0u : 0; is_float = false; break;
+   case op2_bfrev_int:
+      for (unsigned i = 0; i < 32; ++i)
+         if (ua & (1u << i))
+            r |= 0x80000000u >> i;
+      is_float = false;
+      break;
+   case op2_bcnt_int: r = count_bits(ua); is_float = false; break;
+   case op2_ffbh_uint: r = first_bit_high(ua); is_float = false; break;
+   case op2_ffbl_int: r = first_bit_low(ua); is_float = false; break;
+   case op2_ffbh_int:
+      r = first_bit_high(ia < 0 ? ~ua : ua);
+      is_float = false;
+      break;
+   case op2_addc_uint:
+      r = uint64_t(ua) + ub > 0xffffffffu ? 1 : 0;
+      is_float = false;
+      break;
+   case op2_subb_uint: r = ua < ub ? 1 : 0; is_float = false; break;
+   case op2_bfm_int:
+      r = ((1u << (ua & 31)) - 1) << (ub & 31);
+      is_float = false;
+      break;
+   case op2_mullo_int:
+   case op2_mullo_uint:
+      r = ua * ub;
+      is_float = false;
+      break;
+   case op2_mulhi_int:
+      r = static_cast<uint32_t>((int64_t(ia) * int64_t(ib)) >> 32);
+      is_float = false;
+      break;
+   case op2_mulhi_uint:
+      r = (uint64_t(ua) * uint64_t(ub)) >> 32;
+      is_float = false;
+      break;
+   case op2_mul_uint24:
+      r = (ua & 0xffffff) * (ub & 0xffffff);
+      is_float = false;
+      break;
+   case op2_mulhi_uint24:
+      r = (uint64_t(ua & 0xffffff) * (ub & 0xffffff)) >> 32;
+      is_float = false;
+      break;
+   case op3_bfe_uint:
+      r = bitfield_extract(ua, ub, uc, false);
+      is_float = false;
+      break;
+   case op3_bfe_int:
+      r = bitfield_extract(ua, ub, uc, true);
+      is_float = false;
+      break;
+   case op3_bfi_int: r = (ua & ub) | (~ua & uc); is_float = false; break;
+   case op3_bit_align_int:
+      r = ((uint64_t(ua) << 32) | ub) >> (uc & 31);
+      is_float = false;
+      break;
+   case op3_byte_align_int:
+      r = ((uint64_t(ua) << 32) | ub) >> (8 * (uc & 3));
+      is_float = false;
+      break;
+   case op3_sad_accum_uint:
+      r = uc;
+      for (unsigned i = 0; i < 32; i += 8) {
+         uint32_t a = (ua >> i) & 0xff;
+         uint32_t b = (ub >> i) & 0xff;
+         r += a > b ? a - b : b - a;
+      }
+      is_float = false;
+      break;
+   case op3_muladd_uint24:
+      r = (ua & 0xffffff) * (ub & 0xffffff) + uc;
+      is_float = false;
+      break;
+   case op3_cnde_int: r = ia == 0 ? ub : uc; is_float = false; break;
+   case op3_cndgt_int: r = ia > 0 ? ub : uc; is_float = false; break;
+   case op3_cndge_int: r = ia >= 0 ? ub : uc; is_float = false; break;
+
+   /* predicates, a true condition writes 0 */
+   case op2_pred_sete: cond = fa == fb; break;
+   case op2_pred_setgt: cond = fa > fb; break;
+   case op2_pred_setge: cond = fa >= fb; break;
+   case op2_pred_setne: cond = fa != fb; break;
+   case op2_pred_set_inv: cond = fa == 1.0f; break;
+   case op2_pred_set_pop: cond = fa <= fb; break;
+   case op2_pred_set_clr: cond = false; break;
+   case op2_pred_set_restore: cond = fa == 0.0f; break;
+   case op2_pred_setgt_uint: cond = ua > ub; is_float = false; break;
+   case op2_pred_setge_uint: cond = ua >= ub; is_float = false; break;
+   case op2_prede_int: cond = ia == ib; is_float = false; break;
+   case op2_pred_setgt_int: cond = ia > ib; is_float = false; break;
+   case op2_pred_setge_int: cond = ia >= ib; is_float = false; break;
+   case op2_pred_setne_int: cond = ia != ib; is_float = false; break;
+
+   /* kills, a true condition writes 1.0 */
+   case op2_kille: cond = fa == fb; break;
+   case op2_killgt: cond = fa > fb; break;
+   case op2_killge: cond = fa >= fb; break;
+   case op2_killne: cond = fa != fb; break;
+   case op2_kille_int: cond = ia == ib; break;
+   case op2_killgt_int: cond = ia > ib; break;
+   case op2_killge_int: cond = ia >= ib; break;
+   case op2_killne_int: cond = ia != ib; break;
+   case op2_killgt_uint: cond = ua > ub; break;
+   case op2_killge_uint: cond = ua >= ub; break;
+
+   /* combined over the vector slots */
+   case op2_dot4: r = f2u(mul_legacy(fa, fb)); effect = re_dot; break;
+   case op2_dot4_ieee: r = f2u(fa * fb); effect = re_dot; break;
+   case op2_max4: r = ua; effect = re_max4; break;
+
+   case op2_mova_int: r = ua; is_float = false; effect = re_mova; break;
+
+   default:
+      return false;
+   }
+
+   switch (op) {
+   case op2_pred_sete: case op2_pred_setgt: case op2_pred_setge:
+   case op2_pred_setne: case op2_pred_setgt_uint: case op2_pred_setge_uint:
+   case op2_prede_int: case op2_pred_setgt_int: case op2_pred_setge_int:
+   case op2_pred_setne_int:
+      effect = re_predicate;
+      r = cond ? 0 : (is_float ? one_f : 1);
+      break;
+   case op2_pred_set_inv:
+   case op2_pred_set_restore:
+      effect = re_predicate;
+      r = cond ? 0 : ua;
+      break;
+   case op2_pred_set_pop:
+      effect = re_predicate;
+      r = cond ? 0 : f2u(fa - fb);
+      break;
+   case op2_pred_set_clr:
+      effect = re_predicate;
+      r = f2u(FLT_MAX);
+      break;
+   case op2_kille: case op2_killgt: case op2_killge: case op2_killne:
+   case op2_kille_int: case op2_killgt_int: case op2_killge_int:
+   case op2_killne_int: case op2_killgt_uint: case op2_killge_uint:
+      effect = re_kill;
+      r = cond ? one_f : 0;
+      break;
+   default:
+      ;
+   }
+
+   result.value = r;
+   result.condition = cond;
+   result.is_float = is_float;
+   result.effect = effect;
+   return true;
+}
+
+AluReference::AluReference(const CFAluNode& alu, Wavefront& wf):
+   m_alu(alu),
+   m_wf(wf),
+   m_exec(0),
+   m_exec_updated(false),
+   m_killed(0)
+{
+}
+
+void AluReference::run(const CFAluNode& alu, Wavefront& wf)
+{
+   AluReference ref(alu, wf);
+   for (const auto& g: alu.clause())
+      ref.execute(g);
+   ref.finish();
+}
+
+int AluReference::index(const AluNode& n, unsigned lane) const
+{
+   if (n.index_mode() == AluNode::idx_loop)
+      return m_wf.loop_index();
+   return static_cast<int32_t>(m_wf.ar()[lane]);
+}
+
+uint32_t AluReference::load(const AluNode& n, const Value& v,
+                            unsigned lane) const
+{
+   uint32_t value = 0;
+
+   switch (v.type()) {
+   case Value::gpr: {
+      int sel = v.sel() + (v.rel() ? index(n, lane) : 0);
+      if (sel >= 0 && sel < static_cast<int>(Wavefront::ngprs))
+         value = m_wf.gpr(sel, v.chan())[lane];
+      break;
+   }
+   case Value::kconst: {
+      auto& c = static_cast<const ConstValue&>(v);
+      unsigned buffer = m_alu.kcache_bank(c.kcache_bank());
+      int idx = 16 * m_alu.kcache_addr(c.kcache_bank()) + c.index() +
+                (v.rel() ? index(n, lane) : 0);
+      if (idx >= 0)
+         value = m_wf.constant(buffer, idx, v.chan());
+      break;
+   }
+   case Value::literal:
+      value = static_cast<const LiteralValue&>(v).value();
+      break;
+   case Value::cinline:
+      if (v.sel() == ALU_SRC_PV)
+         value = m_wf.pv(v.chan())[lane];
+      else if (v.sel() == ALU_SRC_PS)
+         value = m_wf.pv(4)[lane];
+      else if (v.sel() == ALU_SRC_LOOP_IDX)
+         value = m_wf.loop_index();
+      else if (v.sel() == ALU_SRC_MASK_LO)
+         value = m_wf.active() & 0xffffffff;
+      else if (v.sel() == ALU_SRC_MASK_HI)
+         value = m_wf.active() >> 32;
+      else if (!AluInterpreter::inline_constant(v.sel(), value)) {
+         std::ostringstream msg;
+         msg << "AluReference: unsupported source " << v;
+         throw runtime_error(msg.str());
+      }
+      break;
+   default: {
+      std::ostringstream msg;
+      msg << "AluReference: unsupported source " << v;
+      throw runtime_error(msg.str());
+   }
+   }
+
+   if (v.abs())
+      value &= 0x7fffffff;
+   if (v.neg())
+      value ^= 0x80000000;
+   return value;
+}
+
+void AluReference::execute(const AluGroup& group)
+{
+   const LaneMask active = m_wf.active();
+   const LaneMask pred = m_wf.predicate();
+   LaneMask new_pred = pred;
+
+   for (unsigned s = 0; s < 5; ++s) {
+      auto node = group.slot(s);
+      uint32_t dummy[3] = {0, 0, 0};
+      Result r;
+      if (node && !evaluate(node->opcode(), dummy, r)) {
+         std::ostringstream msg;
+         msg << "AluReference: unsupported instruction " << *node;
+         throw runtime_error(msg.str());
+      }
+   }
+
+   for (unsigned lane = 0; lane < wavefront_size; ++lane) {
+      const LaneMask bit = LaneMask(1) << lane;
+      Result results[5];
+
+      /* All sources are read before anything is written */
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = group.slot(s);
+         if (!node)
+            continue;
+         uint32_t src[3] = {0, 0, 0};
+         for (unsigned k = 0; k < node->nsources() && k < 3; ++k) {
+            auto v = node->get_src(k);
+            if (v)
+               src[k] = load(*node, *v, lane);
+         }
+         evaluate(node->opcode(), src, results[s]);
+      }
+
+      /* DOT4 sums and MAX4 takes the maximum of its vector slots */
+      bool have_dot = false;
+      bool have_max4 = false;
+      float dot = 0.0f;
+      float max4 = 0.0f;
+      for (unsigned s = 0; s < 4; ++s) {
+         if (!group.slot(s))
+            continue;
+         float v = lane_float(results[s].value);
+         if (results[s].effect == re_dot) {
+            dot = have_dot ? dot + v : v;
+            have_dot = true;
+         } else if (results[s].effect == re_max4) {
+            max4 = have_max4 ? max_legacy(max4, v) : v;
+            have_max4 = true;
+         }
+      }
+
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = group.slot(s);
+         if (!node)
+            continue;
+         Result& r = results[s];
+
+         if (s < 4 && r.effect == re_dot)
+            r.value = lane_bits(dot);
+         else if (s < 4 && r.effect == re_max4)
+            r.value = lane_bits(max4);
+
+         if (r.is_float) {
+            float f = lane_float(r.value);
+            auto op2 = dynamic_cast<const AluNodeOp2 *>(node.get());
+            switch (op2 ? op2->output_modify() : AluNode::omod_off) {
+            case AluNode::omod_mul_2: f *= 2.0f; break;
+            case AluNode::omod_mul_4: f *= 4.0f; break;
+            case AluNode::omod_div_2: f *= 0.5f; break;
+            default: ;
+            }
+            if (node->test_flag(AluNode::do_clamp)) {
+               if (!(f > 0.0f))
+                  f = 0.0f;
+               else if (f > 1.0f)
+                  f = 1.0f;
+            }
+            r.value = lane_bits(f);
+         }
+
+         bool write = (active & bit) != 0;
+         auto dnode = dynamic_cast<const AluNodeWithDst *>(node.get());
+         if (dnode) {
+            if (dnode->pred_select() == AluNode::pred_sel_zero)
+               write &= !(pred & bit);
+            else if (dnode->pred_select() == AluNode::pred_sel_one)
+               write &= (pred & bit) != 0;
+         }
+
+         switch (r.effect) {
+         case re_predicate:
+            if (node->test_flag(AluNode::do_update_pred) && (active & bit))
+               new_pred = r.condition ? new_pred | bit : new_pred & ~bit;
+            if (node->test_flag(AluNode::do_update_exec_mask)) {
+               m_exec = (r.condition && (active & bit)) ?
+                           m_exec | bit : m_exec & ~bit;
+               m_exec_updated = true;
+            }
+            break;
+         case re_kill:
+            if (r.condition && (active & bit))
+               m_killed |= bit;
+            break;
+         case re_mova:
+            if (write)
+               m_wf.ar()[lane] = r.value;
+            break;
+         default:
+            ;
+         }
+
+         if (dnode && dnode->writes_dst() && write) {
+            const GPRValue& dst = dnode->dst();
+            int sel = dst.sel() + (dst.rel() ? index(*node, lane) : 0);
+            if (sel >= 0 && sel < static_cast<int>(Wavefront::ngprs))
+               m_wf.gpr(sel, dst.chan())[lane] = r.value;
+         }
+      }
+
+      for (unsigned s = 0; s < 5; ++s)
+         if (group.slot(s))
+            m_wf.pv(s)[lane] = results[s].value;
+   }
+
+   m_wf.set_predicate(new_pred);
+}
+
+void AluReference::finish()
+{
+   if (m_exec_updated)
+      m_wf.set_active(m_exec);
+   m_wf.kill(m_killed);
+   m_exec_updated = false;
+   m_killed = 0;
+}
+
+}
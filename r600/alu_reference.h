@@ -0,0 +1,86 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_alu_reference_h
+#define r600_alu_reference_h
+
+#include <r600/cf_node.h>
+#include <r600/wavefront.h>
+
+namespace r600 {
+
+/* Scalar reference implementation of the ALU clause semantics.
+ *
+ * The instructions of a group are evaluated one thread at a time with
+ * a plain switch over the opcodes. This is slow, but it does not share
+ * any code with AluInterpreter, CompiledAluClause and AluJit, so these
+ * can be validated against it. It implements the rules described for
+ * AluInterpreter, including the legacy (DX9) versus IEEE handling of
+ * MUL, DOT4, MULADD and MAX/MIN, and supports the same instructions.
+ */
+class AluReference {
+public:
+   enum EEffect {
+      re_none,
+      re_predicate,
+      re_kill,
+      re_dot,
+      re_max4,
+      re_mova
+   };
+
+   struct Result {
+      uint32_t value;
+      bool condition;
+      /* output modifier and clamp apply */
+      bool is_float;
+      EEffect effect;
+   };
+
+   /* Evaluate an instruction for one thread, returns false if the
+    * opcode is not supported */
+   static bool evaluate(EAluOp op, const uint32_t src[3], Result& result);
+
+   AluReference(const CFAluNode& alu, Wavefront& wf);
+
+   /* Execute one group, throws std::runtime_error if an instruction or
+    * a source is not supported */
+   void execute(const AluGroup& group);
+
+   /* Apply the execution mask updates and the kills of the clause */
+   void finish();
+
+   static void run(const CFAluNode& alu, Wavefront& wf);
+
+private:
+   uint32_t load(const AluNode& n, const Value& v, unsigned lane) const;
+   int index(const AluNode& n, unsigned lane) const;
+
+   const CFAluNode& m_alu;
+   Wavefront& m_wf;
+   LaneMask m_exec;
+   bool m_exec_updated;
+   LaneMask m_killed;
+};
+
+}
+
+#endif
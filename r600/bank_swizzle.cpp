@@ -0,0 +1,357 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bank_swizzle.h>
+
+#include <iostream>
+#include <cassert>
+
+namespace r600 {
+
+namespace {
+
+/* Read cycle of each source operand for the vector swizzles */
+const int vector_cycle[6][3] = {
+   {0, 1, 2},
+   {0, 2, 1},
+   {1, 2, 0},
+   {1, 0, 2},
+   {2, 0, 1},
+   {2, 1, 0}
+};
+
+/* Read cycle of each source operand for the trans unit swizzles,
+ * the ISA docs name these SCL_210, SCL_122, SCL_212, and SCL_221 */
+const int scalar_cycle[4][3] = {
+   {2, 1, 0},
+   {1, 2, 2},
+   {2, 1, 2},
+   {2, 2, 1}
+};
+
+const char *vector_swizzle_name[6] = {
+   "VEC_012", "VEC_021", "VEC_120", "VEC_102", "VEC_201", "VEC_210"
+};
+
+const char *scalar_swizzle_name[4] = {
+   "SCL_210", "SCL_122", "SCL_212", "SCL_221"
+};
+
+const char slot_id[6] = "xyzwt";
+
+class ReadPorts {
+public:
+   ReadPorts();
+   bool reserve_gpr(int sel, int chan, int cycle);
+   bool reserve_cfile(int sel, int chan);
+private:
+   int m_gpr[3][4];
+   int m_cfile_addr[2];
+   int m_cfile_elem[2];
+};
+
+ReadPorts::ReadPorts()
+{
+   for (int c = 0; c < 3; ++c)
+      for (int i = 0; i < 4; ++i)
+         m_gpr[c][i] = -1;
+
+   for (int i = 0; i < 2; ++i) {
+      m_cfile_addr[i] = -1;
+      m_cfile_elem[i] = -1;
+   }
+}
+
+bool ReadPorts::reserve_gpr(int sel, int chan, int cycle)
+{
+   int& res = m_gpr[cycle][chan];
+   if (res == -1)
+      res = sel;
+   return res == sel;
+}
+
+/* Evergreen provides two constant read ports, each one reads a
+ * pair of channels (xy or zw) */
+bool ReadPorts::reserve_cfile(int sel, int chan)
+{
+   int elem = chan >> 1;
+   for (int i = 0; i < 2; ++i) {
+      if (m_cfile_addr[i] == -1) {
+         m_cfile_addr[i] = sel;
+         m_cfile_elem[i] = elem;
+         return true;
+      }
+      if (m_cfile_addr[i] == sel && m_cfile_elem[i] == elem)
+         return true;
+   }
+   return false;
+}
+
+bool is_trans_const(const Value& v)
+{
+   switch (v.type()) {
+   case Value::kconst:
+   case Value::literal:
+      return true;
+   case Value::cinline:
+      return v.sel() >= ALU_SRC_0 && v.sel() <= ALU_SRC_LITERAL;
+   default:
+      return false;
+   }
+}
+
+bool is_pv_or_ps(const Value& v)
+{
+   return v.type() == Value::cinline &&
+         (v.sel() == ALU_SRC_PV || v.sel() == ALU_SRC_PS);
+}
+
+BankSwizzleCheck::EStatus
+check_vector(const AluNode& node, AluNode::EBankSwizzle swz, ReadPorts& ports)
+{
+   if (swz > AluNode::alu_vec_210)
+      return BankSwizzleCheck::bs_invalid_swizzle;
+
+   PValue src0 = node.get_src(0);
+   for (unsigned i = 0; i < node.nsources(); ++i) {
+      PValue v = node.get_src(i);
+      switch (v->type()) {
+      case Value::gpr:
+         /* The second source can use the reservation of the first one */
+         if (i == 1 && src0->type() == Value::gpr &&
+             v->sel() == src0->sel() && v->chan() == src0->chan())
+            continue;
+         if (!ports.reserve_gpr(v->sel(), v->chan(), vector_cycle[swz][i]))
+            return BankSwizzleCheck::bs_gpr_conflict;
+         break;
+      case Value::kconst:
+         if (!ports.reserve_cfile(v->sel(), v->chan()))
+            return BankSwizzleCheck::bs_const_overuse;
+         break;
+      default:
+         /* PV, PS, literals, and inline constants don't use read ports */
+         ;
+      }
+   }
+   return BankSwizzleCheck::bs_legal;
+}
+
+BankSwizzleCheck::EStatus
+check_scalar(const AluNode& node, AluNode::EBankSwizzle swz, ReadPorts& ports)
+{
+   if (swz > AluNode::sq_alu_scl_221)
+      return BankSwizzleCheck::bs_invalid_swizzle;
+
+   int const_count = 0;
+   for (unsigned i = 0; i < node.nsources(); ++i) {
+      const Value& v = *node.get_src(i);
+      if (is_trans_const(v)) {
+         if (const_count >= 2)
+            return BankSwizzleCheck::bs_trans_const_overuse;
+         ++const_count;
+      }
+      if (v.type() == Value::kconst &&
+          !ports.reserve_cfile(v.sel(), v.chan()))
+         return BankSwizzleCheck::bs_const_overuse;
+   }
+
+   for (unsigned i = 0; i < node.nsources(); ++i) {
+      const Value& v = *node.get_src(i);
+      int cycle = scalar_cycle[swz][i];
+      if (v.type() == Value::gpr) {
+         if (cycle < const_count)
+            return BankSwizzleCheck::bs_trans_cycle_conflict;
+         if (!ports.reserve_gpr(v.sel(), v.chan(), cycle))
+            return BankSwizzleCheck::bs_gpr_conflict;
+      } else if (const_count && is_pv_or_ps(v) && cycle < const_count) {
+         return BankSwizzleCheck::bs_trans_cycle_conflict;
+      }
+   }
+   return BankSwizzleCheck::bs_legal;
+}
+
+void print_swizzle(std::ostream& os, int slot, AluNode::EBankSwizzle swz)
+{
+   os << slot_id[slot] << ':';
+   if (slot < 4 && swz <= AluNode::alu_vec_210)
+      os << vector_swizzle_name[swz];
+   else if (slot == 4 && swz <= AluNode::sq_alu_scl_221)
+      os << scalar_swizzle_name[swz];
+   else
+      os << "INVALID";
+}
+
+}
+
+BankSwizzleCheck::Result
+BankSwizzleCheck::check(const AluGroup& group)
+{
+   return check(group, current(group));
+}
+
+BankSwizzleCheck::Result
+BankSwizzleCheck::check(const AluGroup& group, const Swizzles& swz)
+{
+   ReadPorts ports;
+
+   for (int i = 0; i < 4; ++i) {
+      auto node = group.slot(i);
+      if (!node)
+         continue;
+      auto status = check_vector(*node, swz[i], ports);
+      if (status != bs_legal)
+         return Result(status, i);
+   }
+
+   auto trans = group.slot(4);
+   if (trans) {
+      auto status = check_scalar(*trans, swz[4], ports);
+      if (status != bs_legal)
+         return Result(status, 4);
+   }
+   return Result();
+}
+
+BankSwizzleCheck::Swizzles BankSwizzleCheck::current(const AluGroup& group)
+{
+   Swizzles swz;
+   for (int i = 0; i < 5; ++i) {
+      auto node = group.slot(i);
+      swz[i] = node ? node->bank_swizzle() : AluNode::alu_vec_012;
+   }
+   return swz;
+}
+
+bool BankSwizzleCheck::best_swizzle(const AluGroup& group, Swizzles& swz)
+{
+   const Swizzles cur = current(group);
+
+   int range[5];
+   for (int i = 0; i < 5; ++i) {
+      if (group.slot(i))
+         range[i] = i < 4 ? AluNode::alu_vec_210 + 1 :
+                            AluNode::sq_alu_scl_221 + 1;
+      else
+         range[i] = 1;
+   }
+
+   /* The search space is at most 6^4 * 4 combinations, so just try all of
+    * them and keep the one that changes the least instructions. */
+   bool found = false;
+   int best_changes = 6;
+   int idx[5] = {0, 0, 0, 0, 0};
+
+   while (true) {
+      Swizzles test;
+      int changes = 0;
+      for (int i = 0; i < 5; ++i) {
+         test[i] = group.slot(i) ? static_cast<AluNode::EBankSwizzle>(idx[i]) :
+                                   cur[i];
+         if (test[i] != cur[i])
+            ++changes;
+      }
+
+      if (changes < best_changes && check(group, test).legal()) {
+         swz = test;
+         best_changes = changes;
+         found = true;
+         if (!changes)
+            break;
+      }
+
+      /* Vary the later slots first, so that on a tie the earlier slots
+       * keep their swizzle */
+      int k = 4;
+      while (k >= 0 && ++idx[k] == range[k])
+         idx[k--] = 0;
+      if (k < 0)
+         break;
+   }
+   return found;
+}
+
+void BankSwizzleCheck::apply(const AluGroup& group, const Swizzles& swz)
+{
+   for (int i = 0; i < 5; ++i) {
+      auto node = group.slot(i);
+      if (node)
+         node->set_bank_swizzle(swz[i]);
+   }
+}
+
+unsigned BankSwizzleCheck::report(const CFAluNode& clause, std::ostream& os)
+{
+   unsigned nconflicts = 0;
+   unsigned gidx = 0;
+
+   for (const auto& g: clause.clause()) {
+      auto r = check(g);
+      if (!r.legal()) {
+         ++nconflicts;
+         os << "Group " << gidx << ": " << r;
+
+         Swizzles swz;
+         if (best_swizzle(g, swz)) {
+            auto cur = current(g);
+            os << ", fix:";
+            for (int i = 0; i < 5; ++i) {
+               if (g.slot(i) && swz[i] != cur[i]) {
+                  os << ' ';
+                  print_swizzle(os, i, swz[i]);
+               }
+            }
+         } else {
+            os << ", no legal swizzle, group must be split";
+         }
+         os << "\n";
+      }
+      ++gidx;
+   }
+   os << nconflicts << " of " << clause.clause().size()
+      << " groups with read port conflicts\n";
+   return nconflicts;
+}
+
+std::ostream& operator << (std::ostream& os, const BankSwizzleCheck::Result& r)
+{
+   switch (r.status) {
+   case BankSwizzleCheck::bs_legal:
+      return os << "legal";
+   case BankSwizzleCheck::bs_gpr_conflict:
+      os << "GPR read port conflict";
+      break;
+   case BankSwizzleCheck::bs_const_overuse:
+      os << "constant read port overuse";
+      break;
+   case BankSwizzleCheck::bs_trans_const_overuse:
+      os << "more than two constants in trans";
+      break;
+   case BankSwizzleCheck::bs_trans_cycle_conflict:
+      os << "trans GPR read collides with constant load";
+      break;
+   case BankSwizzleCheck::bs_invalid_swizzle:
+      os << "invalid bank swizzle";
+      break;
+   }
+   return os << " in slot " << slot_id[r.slot];
+}
+
+}
@@ -0,0 +1,88 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_bank_swizzle_h
+#define r600_bank_swizzle_h
+
+#include <r600/alu_node.h>
+#include <r600/cf_node.h>
+
+#include <array>
+#include <iosfwd>
+
+namespace r600 {
+
+/* Models the GPR and constant read ports of an Evergreen ALU group.
+ *
+ * Each group reads its GPR operands in three cycles, and in every cycle
+ * only one register can be read per channel. The bank swizzle of each
+ * instruction selects in which cycle its sources are read. In addition
+ * only two constant file pairs (xy or zw) can be read per group, and the
+ * trans unit loads its constant operands in the first cycles which then
+ * can not be used for GPR reads.
+ */
+class BankSwizzleCheck {
+public:
+   enum EStatus {
+      bs_legal,
+      bs_gpr_conflict,
+      bs_const_overuse,
+      bs_trans_const_overuse,
+      bs_trans_cycle_conflict,
+      bs_invalid_swizzle
+   };
+
+   struct Result {
+      Result(): status(bs_legal), slot(-1) {}
+      Result(EStatus s, int sl): status(s), slot(sl) {}
+      bool legal() const { return status == bs_legal; }
+
+      EStatus status;
+      int slot;
+   };
+
+   using Swizzles = std::array<AluNode::EBankSwizzle, 5>;
+
+   /* Check the group with the swizzles it currently uses */
+   static Result check(const AluGroup& group);
+
+   /* Check the group when using the given swizzles */
+   static Result check(const AluGroup& group, const Swizzles& swz);
+
+   /* Get the swizzles the group currently uses */
+   static Swizzles current(const AluGroup& group);
+
+   /* Search a legal swizzle assignment that changes as few of the current
+    * swizzles as possible. Returns false if no legal assignment exists. */
+   static bool best_swizzle(const AluGroup& group, Swizzles& swz);
+
+   static void apply(const AluGroup& group, const Swizzles& swz);
+
+   /* Print a lint report of all groups in the clause, returns the number
+    * of groups with read port conflicts. */
+   static unsigned report(const CFAluNode& clause, std::ostream& os);
+};
+
+std::ostream& operator << (std::ostream& os, const BankSwizzleCheck::Result& r);
+
+}
+
+#endif
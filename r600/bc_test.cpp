@@ -19,10 +19,8 @@
  */
 
 
-#ifndef r600_bc__test_h
-#define r600_bc__test_h
-
 #include <r600/bc_test.h>
+#include <r600/cf_node.h>
 
 #include <gtest/gtest.h>
 #include <cstdint>
@@ -65,8 +63,148 @@ namespace r600 {
   return ::testing::AssertionFailure() << msg.str();
 }
 
+uint64_t BytecodeTest::op2(EAluOp op, int dst_sel, int dst_chan,
+                           PValue src0, PValue src1, bool last,
+                           AluOpFlags extra, AluNode::EOutputModify omod,
+                           AluNode::EPredSelect pred, bool dst_rel) const
+{
+   AluOpFlags flags = extra;
+   flags.set(AluNode::do_write);
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return AluNodeOp2(op, GPRValue(dst_sel, dst_chan, 0, dst_rel, 0), src0,
+                     src1, flags, AluNode::idx_ar_x, AluNode::alu_vec_012,
+                     omod, pred).bytecode();
+}
+
+uint64_t BytecodeTest::op3(EAluOp op, int dst_sel, int dst_chan,
+                           PValue src0, PValue src1, PValue src2,
+                           bool last) const
+{
+   AluOpFlags flags;
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return AluNodeOp3(op, GPRValue(dst_sel, dst_chan, 0, 0, 0), src0, src1,
+                     src2, flags).bytecode();
+}
+
+uint64_t BytecodeTest::mov(int dst_sel, int dst_chan, PValue src,
+                           bool last) const
+{
+   return op2(op2_mov, dst_sel, dst_chan, src, PValue(), last);
+}
+
+uint64_t BytecodeTest::pred_setgt_int(PValue src0, PValue src1) const
+{
+   AluOpFlags flags;
+   flags.set(AluNode::do_update_pred);
+   flags.set(AluNode::do_update_exec_mask);
+   return op2(op2_pred_setgt_int, 127, 0, src0, src1, true, flags);
+}
+
+uint64_t BytecodeTest::group_barrier() const
+{
+   AluOpFlags flags;
+   flags.set(AluNode::is_last_instr);
+   return AluNodeOp2(op2_group_barrier, GPRValue(0, 0, 0, 0, 0), PValue(),
+                     PValue(), flags).bytecode();
+}
+
+uint64_t BytecodeTest::lds_op(ESDOp op, PValue src0, PValue src1,
+                              PValue src2, bool last, int offset) const
+{
+   AluOpFlags flags;
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return AluNodeLDSIdxOP(op3_lds_idx_op, op, src0,
+                          src1 ? src1 : gpr(0, 0),
+                          src2 ? src2 : gpr(0, 0), flags,
+                          offset).bytecode();
+}
+
+PValue BytecodeTest::gpr(int sel, int chan, bool abs, bool neg,
+                         bool rel) const
+{
+   return Value::create(sel, chan, abs, rel, neg, nullptr);
 }
 
+PValue BytecodeTest::inline_const(int sel, int chan) const
+{
+   return Value::create(sel, chan, false, false, false, nullptr);
+}
+
+PValue BytecodeTest::literal(int chan, bool abs, bool neg) const
+{
+   Value::LiteralFlags li;
+   return Value::create(ALU_SRC_LITERAL, chan, abs, false, neg, &li);
+}
+
+const unsigned BytecodeTest::swizzle_xyzw;
+
+void BytecodeTest::tex(std::vector<uint64_t>& bc, TexFetchNode::ETexInst op,
+                       unsigned dst, unsigned src, unsigned rid,
+                       unsigned sid, bool normalized, int offset_x) const
+{
+   uint64_t bc0 = op;
+   bc0 |= static_cast<uint64_t>(rid) << 8;
+   bc0 |= static_cast<uint64_t>(src) << 16;
+   bc0 |= static_cast<uint64_t>(dst) << 32;
+   bc0 |= static_cast<uint64_t>(swizzle_xyzw) << 41;
+   if (normalized)
+      bc0 |= 0xful << 28;
+
+   uint64_t bc1 = offset_x & 0x1f;
+   bc1 |= static_cast<uint64_t>(sid) << 15;
+   bc1 |= static_cast<uint64_t>(swizzle_xyzw) << 20;
+   bc.push_back(bc0);
+   bc.push_back(bc1);
+}
 
+void BytecodeTest::vtx(std::vector<uint64_t>& bc, unsigned buffer_id,
+                       unsigned dst, unsigned offset,
+                       VertexFetchNode::EVTXDataFormat format,
+                       VertexFetchNode::ENumFormat num_format,
+                       unsigned dst_swizzle, bool is_signed,
+                       unsigned endian_swap,
+                       VertexFetchNode::EFetchType type,
+                       int mega_fetch_count) const
+{
+   uint64_t bc0 = VertexFetchNode::vc_fetch;
+   bc0 |= static_cast<uint64_t>(type) << 5;
+   bc0 |= static_cast<uint64_t>(buffer_id) << 8;
+   bc0 |= static_cast<uint64_t>(dst) << 32;
+   bc0 |= static_cast<uint64_t>(dst_swizzle) << 41;
+   bc0 |= static_cast<uint64_t>(format) << 54;
+   bc0 |= static_cast<uint64_t>(num_format) << 60;
+   if (is_signed)
+      bc0 |= 1ul << 62;
 
-#endif // BC_TEST_H
+   uint64_t bc1 = offset;
+   bc1 |= static_cast<uint64_t>(endian_swap) << 16;
+   if (mega_fetch_count >= 0) {
+      bc0 |= static_cast<uint64_t>(mega_fetch_count) << 26;
+      bc1 |= VertexFetchNode::vtx_mega_fetch_bit;
+   }
+   bc.push_back(bc0);
+   bc.push_back(bc1);
+}
+
+std::vector<uint64_t> BytecodeTest::if_else_program(uint32_t threshold) const
+{
+   std::vector<uint64_t> bc;
+   CFAluNode(cf_alu_push_before, 0, 7, 2).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 3).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 9, 1).append_bytecode(bc);
+   CFNativeNode(cf_else, 0, 5).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 10, 1).append_bytecode(bc);
+   CFNativeNode(cf_pop, 0, 6, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(pred_setgt_int(gpr(0, 0), literal()));
+   bc.push_back(threshold);
+   bc.push_back(mov(1, 0, inline_const(ALU_SRC_1_INT)));
+   bc.push_back(mov(1, 0, inline_const(ALU_SRC_M_1_INT)));
+   return bc;
+}
+
+}
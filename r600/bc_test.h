@@ -22,6 +22,9 @@
 #ifndef r600_bc__test_h
 #define r600_bc__test_h
 
+#include <r600/alu_node.h>
+#include <r600/fetch_node.h>
+
 #include <gtest/gtest.h>
 #include <cstdint>
 #include <vector>
@@ -52,6 +55,63 @@ protected:
    void set_spacing(const std::vector<uint8_t>& s) {
       spacing = s;
    }
+
+   /* Bytecode of ALU instructions that write dst_sel.dst_chan */
+   uint64_t op2(EAluOp op, int dst_sel, int dst_chan, PValue src0,
+                PValue src1, bool last = true, AluOpFlags extra = AluOpFlags(),
+                AluNode::EOutputModify omod = AluNode::omod_off,
+                AluNode::EPredSelect pred = AluNode::pred_sel_off,
+                bool dst_rel = false) const;
+   uint64_t op3(EAluOp op, int dst_sel, int dst_chan, PValue src0,
+                PValue src1, PValue src2, bool last = true) const;
+   uint64_t mov(int dst_sel, int dst_chan, PValue src,
+                bool last = true) const;
+
+   /* PRED_SETGT_INT that also updates the execution mask */
+   uint64_t pred_setgt_int(PValue src0, PValue src1) const;
+
+   uint64_t group_barrier() const;
+
+   /* LDS_IDX_OP, unused sources read R0.x */
+   uint64_t lds_op(ESDOp op, PValue src0, PValue src1 = PValue(),
+                   PValue src2 = PValue(), bool last = true,
+                   int offset = 0) const;
+
+   PValue gpr(int sel, int chan, bool abs = false, bool neg = false,
+              bool rel = false) const;
+   PValue inline_const(int sel, int chan = 0) const;
+   PValue literal(int chan = 0, bool abs = false, bool neg = false) const;
+
+   /* Destination and source selects that keep the components in order */
+   static const unsigned swizzle_xyzw = 0x688;
+
+   /* dst.xyzw = op(src.xyzw) using resource rid and sampler sid */
+   void tex(std::vector<uint64_t>& bc, TexFetchNode::ETexInst op,
+            unsigned dst, unsigned src, unsigned rid = 0, unsigned sid = 0,
+            bool normalized = false, int offset_x = 0) const;
+
+   /* dst.<dst_swizzle> = fetch(buffer, R0.x * stride + offset), a
+    * negative mega-fetch count encodes a mini-fetch */
+   void vtx(std::vector<uint64_t>& bc, unsigned buffer_id, unsigned dst,
+            unsigned offset, VertexFetchNode::EVTXDataFormat format,
+            VertexFetchNode::ENumFormat num_format = VertexFetchNode::nf_norm,
+            unsigned dst_swizzle = swizzle_xyzw, bool is_signed = false,
+            unsigned endian_swap = 0,
+            VertexFetchNode::EFetchType type = VertexFetchNode::vertex_data,
+            int mega_fetch_count = -1) const;
+
+   /* CF program for: if (R0.x > threshold) R1.x = 1 else R1.x = -1
+    *
+    *   0 ALU_PUSH_BEFORE  7: PRED_SETGT_INT R0.x, threshold
+    *   1 JUMP @3          9: MOV R1.x, 1
+    *   2 ALU              10: MOV R1.x, -1
+    *   3 ELSE @5
+    *   4 ALU
+    *   5 POP @6
+    *   6 NOP EOP
+    */
+   std::vector<uint64_t> if_else_program(uint32_t threshold) const;
+
 private:
    std::vector<uint8_t> spacing;
 };
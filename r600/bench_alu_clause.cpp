@@ -0,0 +1,182 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Compares the time needed to execute an ALU clause by walking the
+ * decoded node objects with the AluInterpreter, by running the clause
+ * after lowering it to a CompiledAluClause, and by running it with the
+ * groups translated to native code where possible.
+ */
+
+#include <r600/compiled_alu_clause.h>
+#include <r600/disassembler.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+namespace {
+
+uint64_t op2(EAluOp op, int dst_sel, int dst_chan, PValue src0, PValue src1,
+             bool last)
+{
+   AluOpFlags flags;
+   flags.set(AluNode::do_write);
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return AluNodeOp2(op, GPRValue(dst_sel, dst_chan, 0, 0, 0), src0, src1,
+                     flags, AluNode::idx_ar_x, AluNode::alu_vec_012,
+                     AluNode::omod_off, AluNode::pred_sel_off).bytecode();
+}
+
+uint64_t op3(EAluOp op, int dst_sel, int dst_chan, PValue src0, PValue src1,
+             PValue src2, bool last)
+{
+   AluOpFlags flags;
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return AluNodeOp3(op, GPRValue(dst_sel, dst_chan, 0, 0, 0), src0, src1,
+                     src2, flags).bytecode();
+}
+
+PValue gpr(int sel, int chan, bool neg = false)
+{
+   return Value::create(sel, chan, false, false, neg, nullptr);
+}
+
+PValue src(int sel, int chan = 0)
+{
+   return Value::create(sel, chan, false, false, false, nullptr);
+}
+
+/* A clause that resembles the body of a shader: a matrix transform
+ * followed by some lighting math */
+vector<uint64_t> make_clause()
+{
+   vector<uint64_t> code;
+   for (int row = 0; row < 4; ++row) {
+      for (int c = 0; c < 4; ++c)
+         code.push_back(op2(op2_dot4_ieee, 2, c, gpr(0, c), src(128 + row, c),
+                            c == 3));
+   }
+   for (int i = 0; i < 8; ++i) {
+      code.push_back(op3(op3_muladd_ieee, 3, 0, gpr(2, 0), gpr(1, 0),
+                         src(ALU_SRC_PV, 0), false));
+      code.push_back(op2(op2_max_dx10, 3, 1, gpr(2, 1), src(ALU_SRC_0), false));
+      code.push_back(op2(op2_mul_ieee, 3, 2, gpr(2, 2, true), gpr(1, 2),
+                         false));
+      code.push_back(op2(op2_add, 3, 3, gpr(2, 3), src(ALU_SRC_PV, 2), false));
+      code.push_back(op2(op2_recipsqrt_ieee, 4, 0, src(ALU_SRC_PV, 1),
+                         PValue(), true));
+      code.push_back(op2(op2_setgt_dx10, 5, 0, gpr(3, 0), src(ALU_SRC_0_5),
+                         false));
+      code.push_back(op2(op2_and_int, 5, 1, src(ALU_SRC_PV, 0), gpr(1, 3),
+                         false));
+      code.push_back(op2(op2_add_int, 5, 2, gpr(1, 0), src(ALU_SRC_1_INT),
+                         false));
+      code.push_back(op2(op2_min, 5, 3, gpr(3, 3), src(ALU_SRC_1), true));
+   }
+   return code;
+}
+
+template <typename F>
+double measure(unsigned iterations, F f)
+{
+   auto start = std::chrono::steady_clock::now();
+   for (unsigned i = 0; i < iterations; ++i)
+      f();
+   std::chrono::duration<double, std::micro> d =
+         std::chrono::steady_clock::now() - start;
+   return d.count() / iterations;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+   unsigned iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+   vector<uint64_t> code = make_clause();
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, code.size(), std::make_tuple(0, 1, 0))
+         .append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.insert(bc.end(), code.begin(), code.end());
+
+   disassembler diss(bc);
+   auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+   if (!alu) {
+      std::cerr << "failed to decode the ALU clause\n";
+      return 1;
+   }
+
+   Wavefront init;
+   auto constants = std::make_shared<ConstantBuffer>(4 * 32);
+   for (unsigned i = 0; i < constants->size(); ++i)
+      (*constants)[i] = lane_bits(0.25f * i);
+   init.set_constant_buffer(0, constants);
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      for (unsigned c = 0; c < 4; ++c) {
+         init.gpr(0, c)[i] = lane_bits(0.5f * i + c);
+         init.gpr(1, c)[i] = lane_bits(1.0f - 0.125f * c);
+      }
+
+   Wavefront wf_interp(init);
+   double t_interp = measure(iterations, [&]() {
+      AluInterpreter::run(*alu, wf_interp);
+   });
+
+   CompiledAluClause compiled(*alu);
+   Wavefront wf_compiled(init);
+   double t_compiled = measure(iterations, [&]() {
+      compiled.run(wf_compiled);
+   });
+
+   CompiledAluClause native(*alu, true);
+   Wavefront wf_native(init);
+   double t_native = measure(iterations, [&]() {
+      native.run(wf_native);
+   });
+
+   bool same = true;
+   for (unsigned r = 0; r < 6; ++r)
+      for (unsigned c = 0; c < 4; ++c) {
+         same &= wf_interp.gpr(r, c) == wf_compiled.gpr(r, c);
+         same &= wf_interp.gpr(r, c) == wf_native.gpr(r, c);
+      }
+
+   std::cout << compiled.ngroups() << " groups, "
+             << compiled.ninstructions() << " instructions, "
+             << iterations << " iterations\n"
+             << "interpreter: " << t_interp << " us per clause\n"
+             << "compiled:    " << t_compiled << " us per clause\n"
+             << "native:      " << t_native << " us per clause, "
+             << native.nnative_groups() << " native groups\n"
+             << "speedup:     " << t_interp / t_compiled << " compiled, "
+             << t_interp / t_native << " native\n";
+   if (!same) {
+      std::cerr << "results differ\n";
+      return 1;
+   }
+   return 0;
+}
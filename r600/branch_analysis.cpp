@@ -0,0 +1,175 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/branch_analysis.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace r600 {
+
+BranchAnalysis::Parameters::Parameters():
+   expensive_cost(32),
+   predication_groups(4)
+{
+}
+
+unsigned BranchAnalysis::Side::cost() const
+{
+   return alu_groups + fetches;
+}
+
+unsigned BranchAnalysis::Region::divergent_cost() const
+{
+   return then_side.cost() + else_side.cost();
+}
+
+unsigned BranchAnalysis::Region::uniform_cost() const
+{
+   return std::max(then_side.cost(), else_side.cost());
+}
+
+BranchAnalysis::BranchAnalysis(const disassembler& program,
+                               const Parameters& params):
+   m_params(params)
+{
+   unsigned cf_addr = 0;
+   for (const auto& n: program.get_program()) {
+      m_nodes.push_back(n.get());
+      m_addr.push_back(cf_addr);
+      cf_addr += n->bytecode_size();
+   }
+
+   auto index_of = [this](unsigned addr) -> unsigned {
+      return std::lower_bound(m_addr.begin(), m_addr.end(), addr) -
+            m_addr.begin();
+   };
+
+   for (unsigned i = 0; i < m_nodes.size(); ++i) {
+      auto jump = dynamic_cast<const CFNativeNode *>(m_nodes[i]);
+      if (!jump || dynamic_cast<const CFFetchNode *>(jump) ||
+          jump->opcode() != cf_jump)
+         continue;
+
+      Region r;
+      r.jump_addr = m_addr[i];
+      r.else_addr = -1;
+      r.depth = jump->get_nesting_depth();
+
+      unsigned target = index_of(jump->address());
+      r.then_side = collect(i + 1, target);
+      r.else_side = {0, 0, 0, true};
+      r.end_addr = jump->address();
+
+      if (target < m_nodes.size()) {
+         auto else_node = dynamic_cast<const CFNativeNode *>(m_nodes[target]);
+         if (else_node && !dynamic_cast<const CFFetchNode *>(else_node) &&
+             else_node->opcode() == cf_else) {
+            r.else_addr = m_addr[target];
+            r.end_addr = else_node->address();
+            r.else_side = collect(target + 1, index_of(r.end_addr));
+         }
+      }
+      m_regions.push_back(r);
+   }
+}
+
+BranchAnalysis::Side BranchAnalysis::collect(unsigned begin,
+                                             unsigned end) const
+{
+   Side s = {0, 0, 0, true};
+   end = std::min<unsigned>(end, m_nodes.size());
+
+   for (unsigned i = begin; i < end; ++i) {
+      ++s.cf_instructions;
+      if (auto alu = dynamic_cast<const CFAluNode *>(m_nodes[i])) {
+         s.alu_groups += alu->clause().size();
+      } else if (auto fetch = dynamic_cast<const CFFetchNode *>(m_nodes[i])) {
+         s.fetches += fetch->clause().size();
+         s.simple = false;
+      } else {
+         s.simple = false;
+      }
+   }
+   return s;
+}
+
+const std::vector<BranchAnalysis::Region>& BranchAnalysis::regions() const
+{
+   return m_regions;
+}
+
+std::vector<unsigned> BranchAnalysis::expensive_regions() const
+{
+   std::vector<unsigned> result;
+   for (unsigned i = 0; i < m_regions.size(); ++i)
+      if (m_regions[i].divergent_cost() >= m_params.expensive_cost)
+         result.push_back(i);
+   return result;
+}
+
+std::vector<unsigned> BranchAnalysis::predication_candidates() const
+{
+   std::vector<unsigned> result;
+   for (unsigned i = 0; i < m_regions.size(); ++i) {
+      const auto& r = m_regions[i];
+      if (r.then_side.simple && r.else_side.simple &&
+          r.then_side.alu_groups + r.else_side.alu_groups <=
+          m_params.predication_groups)
+         result.push_back(i);
+   }
+   return result;
+}
+
+static void print_side(std::ostream& os, const BranchAnalysis::Side& s)
+{
+   os << s.alu_groups << " ALU groups";
+   if (s.fetches)
+      os << ", " << s.fetches << " fetches";
+}
+
+void BranchAnalysis::print(std::ostream& os) const
+{
+   for (const auto& r: m_regions) {
+      os << "CF " << r.jump_addr << "-" << r.end_addr << ": then ";
+      print_side(os, r.then_side);
+      if (r.else_addr >= 0) {
+         os << ", else ";
+         print_side(os, r.else_side);
+      }
+      os << ", cost " << r.uniform_cost() << " uniform, "
+         << r.divergent_cost() << " divergent\n";
+   }
+
+   for (auto i: expensive_regions())
+      os << "CF " << m_regions[i].jump_addr
+         << ": divergent execution costs "
+         << m_regions[i].divergent_cost() << "\n";
+
+   for (auto i: predication_candidates()) {
+      const auto& r = m_regions[i];
+      os << "CF " << r.jump_addr << ": branch over "
+         << r.then_side.alu_groups + r.else_side.alu_groups
+         << " ALU groups could be predicated\n";
+   }
+}
+
+}
@@ -0,0 +1,104 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_branch_analysis_h
+#define r600_branch_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Reports the cost of the predicated regions opened by JUMP and ELSE.
+ *
+ * For each JUMP the region up to the jump target, and, when the target
+ * is an ELSE, the region up to the ELSE target are collected together
+ * with the ALU groups and fetches inside of them. When the threads of a
+ * wavefront diverge both sides are executed, so the divergent cost is
+ * the sum of both sides, while a uniform branch only executes one.
+ *
+ * Branches whose sides only hold a few ALU groups and no fetches,
+ * exports or further control flow are reported as candidates for
+ * predication with PRED_SET* and PRED_SEL, since the JUMP, ELSE and POP
+ * instructions and the additional ALU clauses cost more than executing
+ * the predicated instructions.
+ */
+class BranchAnalysis {
+public:
+   struct Parameters {
+      Parameters();
+
+      /* Divergent cost from which a region is reported as expensive */
+      unsigned expensive_cost;
+
+      /* Largest number of ALU groups in both sides of a branch for which
+       * predication is proposed */
+      unsigned predication_groups;
+   };
+
+   struct Side {
+      unsigned alu_groups;
+      unsigned fetches;
+      unsigned cf_instructions;
+      bool simple;
+
+      unsigned cost() const;
+   };
+
+   struct Region {
+      unsigned jump_addr;
+      int else_addr;
+      unsigned end_addr;
+      unsigned depth;
+      Side then_side;
+      Side else_side;
+
+      unsigned divergent_cost() const;
+      unsigned uniform_cost() const;
+   };
+
+   BranchAnalysis(const disassembler& program,
+                  const Parameters& params = Parameters());
+
+   const std::vector<Region>& regions() const;
+
+   /* Regions whose divergent cost reaches the expensive threshold */
+   std::vector<unsigned> expensive_regions() const;
+
+   /* Regions that could be replaced by predicated ALU instructions */
+   std::vector<unsigned> predication_candidates() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   Side collect(unsigned begin, unsigned end) const;
+
+   std::vector<const CFNode *> m_nodes;
+   std::vector<unsigned> m_addr;
+   std::vector<Region> m_regions;
+   Parameters m_params;
+};
+
+}
+
+#endif
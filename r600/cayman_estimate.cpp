@@ -0,0 +1,134 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/cayman_estimate.h>
+
+#include <iomanip>
+#include <iostream>
+
+namespace r600 {
+
+CaymanEstimate::CaymanEstimate(const disassembler& program)
+{
+   unsigned cf_addr = 0;
+   for (const auto& n: program.get_program()) {
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      if (alu) {
+         ClauseResult c = {cf_addr, 0, 0, 0};
+         for (const auto& g: alu->clause()) {
+            ++c.groups;
+            c.cayman_groups += cayman_groups(g);
+            auto trans = g.slot(4);
+            if (trans && cayman_slots(trans->opcode()) > 1)
+               ++c.replicated;
+         }
+         m_clauses.push_back(c);
+      }
+      cf_addr += n->bytecode_size();
+   }
+}
+
+unsigned CaymanEstimate::cayman_slots(EAluOp op)
+{
+   switch (op) {
+   case op2_mullo_int:
+   case op2_mulhi_int:
+   case op2_mullo_uint:
+   case op2_mulhi_uint:
+      return 4;
+   case op2_flt_to_uint:
+   case op2_int_to_flt:
+   case op2_uint_to_flt:
+      return 1;
+   default:
+      ;
+   }
+
+   auto i = alu_ops.find(op);
+   if (i != alu_ops.end() && i->second.unit_mask == AluOp::t)
+      return 3;
+   return 1;
+}
+
+unsigned CaymanEstimate::cayman_groups(const AluGroup& group)
+{
+   auto trans = group.slot(4);
+   if (!trans)
+      return 1;
+
+   unsigned used = 0;
+   for (unsigned i = 0; i < 4; ++i)
+      if (group.slot(i))
+         used |= 1 << i;
+
+   unsigned need;
+   switch (cayman_slots(trans->opcode())) {
+   case 4: need = 0xf; break;
+   case 3: need = 0x7; break;
+   default:
+      need = 1 << trans->dst_chan();
+   }
+   return (used & need) ? 2 : 1;
+}
+
+const std::vector<CaymanEstimate::ClauseResult>&
+CaymanEstimate::clauses() const
+{
+   return m_clauses;
+}
+
+unsigned CaymanEstimate::groups() const
+{
+   unsigned result = 0;
+   for (const auto& c: m_clauses)
+      result += c.groups;
+   return result;
+}
+
+unsigned CaymanEstimate::cayman_groups() const
+{
+   unsigned result = 0;
+   for (const auto& c: m_clauses)
+      result += c.cayman_groups;
+   return result;
+}
+
+double CaymanEstimate::slowdown() const
+{
+   unsigned eg = groups();
+   return eg ? static_cast<double>(cayman_groups()) / eg : 1.0;
+}
+
+void CaymanEstimate::print(std::ostream& os) const
+{
+   for (const auto& c: m_clauses)
+      os << "CF " << c.cf_addr << ": " << c.groups << " groups, "
+         << c.cayman_groups << " on Cayman, "
+         << c.replicated << " replicated trans ops\n";
+
+   auto flags = os.flags();
+   os << "total: " << groups() << " groups, " << cayman_groups()
+      << " on Cayman, slowdown " << std::fixed << std::setprecision(2)
+      << slowdown() << "\n";
+   os.flags(flags);
+}
+
+}
@@ -0,0 +1,78 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_cayman_estimate_h
+#define r600_cayman_estimate_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Estimates how many instruction groups the ALU clauses of an Evergreen
+ * program need when the same code is compiled for Cayman.
+ *
+ * Cayman has no trans unit: transcendental instructions are replicated
+ * over the x, y, and z slots, the 32 bit integer multiplications use all
+ * four vector slots, and the conversions that were trans only become
+ * ordinary vector instructions. Each Evergreen group is mapped to one
+ * Cayman group if the instruction in its trans slot fits into the free
+ * vector slots, and to two groups otherwise. The groups are not
+ * re-scheduled, so the estimate assumes that the compiler does not find
+ * a better packing for Cayman than it did for Evergreen.
+ */
+class CaymanEstimate {
+public:
+   struct ClauseResult {
+      unsigned cf_addr;
+      unsigned groups;
+      unsigned cayman_groups;
+      /* trans instructions that occupy several vector slots on Cayman */
+      unsigned replicated;
+   };
+
+   CaymanEstimate(const disassembler& program);
+
+   /* Number of vector slots the instruction occupies on Cayman */
+   static unsigned cayman_slots(EAluOp op);
+
+   /* Number of Cayman groups needed for the Evergreen group */
+   static unsigned cayman_groups(const AluGroup& group);
+
+   const std::vector<ClauseResult>& clauses() const;
+
+   unsigned groups() const;
+   unsigned cayman_groups() const;
+
+   /* Ratio of Cayman to Evergreen groups */
+   double slowdown() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   std::vector<ClauseResult> m_clauses;
+};
+
+}
+
+#endif
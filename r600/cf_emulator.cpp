@@ -0,0 +1,487 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/cf_emulator.h>
+#include <r600/alu_interpreter.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+WaveSync::~WaveSync()
+{
+}
+
+CFEmulator::Parameters::Parameters():
+   bool_constants(0),
+   max_steps(1 << 20),
+   fetch(nullptr),
+   profile(nullptr),
+   sync(nullptr)
+{
+   loop_constants.fill(0);
+}
+
+CFEmulator::CFEmulator(const disassembler& program, Wavefront& wf,
+                       const Parameters& params):
+   m_program(program.get_program()),
+   m_wf(wf),
+   m_params(params),
+   m_pc(0),
+   m_finished(m_program.empty()),
+   m_steps(0),
+   m_max_stack_depth(0),
+   m_alu_node(nullptr),
+   m_alu_group(0),
+   m_alu_before(0),
+   m_waiting(false),
+   m_ticket(0)
+{
+   unsigned cf_addr = 0;
+   for (const auto& n: m_program) {
+      m_cf_addr.push_back(cf_addr);
+      cf_addr += n->bytecode_size();
+   }
+}
+
+CFEmulator::~CFEmulator()
+{
+}
+
+bool CFEmulator::finished() const
+{
+   return m_finished;
+}
+
+bool CFEmulator::waiting() const
+{
+   return m_waiting;
+}
+
+unsigned CFEmulator::pc() const
+{
+   return m_pc;
+}
+
+unsigned CFEmulator::steps() const
+{
+   return m_steps;
+}
+
+const std::vector<CFEmulator::StackEntry>& CFEmulator::stack() const
+{
+   return m_stack;
+}
+
+unsigned CFEmulator::max_stack_depth() const
+{
+   return m_max_stack_depth;
+}
+
+bool CFEmulator::at_clause_boundary() const
+{
+   return !m_alu && !m_ticket;
+}
+
+CFEmulator::State CFEmulator::state() const
+{
+   if (!at_clause_boundary())
+      throw runtime_error("CFEmulator: state requested inside a clause");
+   return State{m_pc, m_finished, m_steps, m_max_stack_depth, m_stack,
+                m_call_stack};
+}
+
+void CFEmulator::set_state(const State& state)
+{
+   m_alu.reset();
+   m_waiting = false;
+   m_ticket = 0;
+   m_pc = state.pc;
+   m_finished = state.finished;
+   m_steps = state.steps;
+   m_max_stack_depth = state.max_stack_depth;
+   m_stack = state.stack;
+   m_call_stack = state.call_stack;
+}
+
+unsigned CFEmulator::index_of(unsigned addr) const
+{
+   return std::lower_bound(m_cf_addr.begin(), m_cf_addr.end(), addr) -
+         m_cf_addr.begin();
+}
+
+void CFEmulator::run()
+{
+   while (step())
+      ;
+}
+
+bool CFEmulator::step()
+{
+   m_waiting = false;
+   if (m_finished)
+      return false;
+
+   if (m_alu) {
+      continue_alu();
+      return !m_finished;
+   }
+
+   if (m_pc >= m_program.size())
+      throw runtime_error("CFEmulator: program ends without EOP");
+   if (m_steps >= m_params.max_steps)
+      throw runtime_error("CFEmulator: step limit exceeded");
+
+   const CFNode *node = m_program[m_pc].get();
+   auto gws = dynamic_cast<const CFGwsNode *>(node);
+   if (gws && !global_wave_sync(*gws))
+      return true;
+
+   if (m_params.profile)
+      m_params.profile->record(m_cf_addr[m_pc], m_wf.active());
+   ++m_pc;
+   ++m_steps;
+
+   if (auto alu = dynamic_cast<const CFAluNode *>(node)) {
+      execute_alu(*alu);
+      return !m_finished;
+   } else if (auto fetch = dynamic_cast<const CFFetchNode *>(node)) {
+      if (!m_params.fetch)
+         throw runtime_error("CFEmulator: no resources given for fetch clause");
+      m_params.fetch->execute(*fetch, m_wf);
+   } else if (auto n = dynamic_cast<const CFNativeNode *>(node)) {
+      execute_native(*n);
+   } else if (!gws && !dynamic_cast<const CFMemNode *>(node)) {
+      std::ostringstream msg;
+      msg << "CFEmulator: unsupported instruction " << *node;
+      throw runtime_error(msg.str());
+   }
+
+   if (node->test_flag(CFNode::eop))
+      m_finished = true;
+   return !m_finished;
+}
+
+void CFEmulator::execute_alu(const CFAluNode& alu)
+{
+   m_alu_before = m_wf.active();
+   if ((alu.opcode() >> 4) == cf_alu_push_before)
+      push();
+
+   m_alu.reset(new AluInterpreter(alu, m_wf));
+   m_alu_node = &alu;
+   m_alu_group = 0;
+   continue_alu();
+}
+
+static bool has_group_barrier(const AluGroup& group)
+{
+   for (unsigned s = 0; s < 5; ++s) {
+      auto node = group.slot(s);
+      if (node && node->opcode() == op2_group_barrier)
+         return true;
+   }
+   return false;
+}
+
+void CFEmulator::continue_alu()
+{
+   const auto& clause = m_alu_node->clause();
+   while (m_alu_group < clause.size()) {
+      const auto& g = clause[m_alu_group];
+      if (has_group_barrier(g) && !group_barrier())
+         return;
+      if (m_params.profile)
+         m_params.profile->record(g.address(), m_wf.active());
+      m_alu->execute(g);
+      ++m_alu_group;
+   }
+   m_alu->finish();
+   m_alu.reset();
+   end_alu(*m_alu_node);
+
+   if (m_alu_node->test_flag(CFNode::eop))
+      m_finished = true;
+}
+
+void CFEmulator::end_alu(const CFAluNode& alu)
+{
+   switch (alu.opcode() >> 4) {
+   case cf_alu_pop_after:
+      pop(1);
+      break;
+   case cf_alu_pop2_after:
+      pop(2);
+      break;
+   case cf_alu_else_after:
+      do_else();
+      break;
+   case cf_alu_break:
+   case cf_alu_continue: {
+      /* The threads that stay active leave the iteration, the others
+       * continue with the following instructions */
+      LaneMask leaving = m_wf.active();
+      m_wf.set_active(m_alu_before & ~leaving);
+      exit_lanes(leaving, (alu.opcode() >> 4) == cf_alu_break);
+      break;
+   }
+   default:
+      ;
+   }
+}
+
+bool CFEmulator::group_barrier()
+{
+   m_waiting = m_params.sync && !m_params.sync->group_barrier(m_ticket);
+   if (!m_waiting)
+      m_ticket = 0;
+   return !m_waiting;
+}
+
+bool CFEmulator::global_wave_sync(const CFGwsNode& n)
+{
+   if (!m_params.sync)
+      throw runtime_error("CFEmulator: GLOBAL_WAVE_SYNC without WaveSync");
+   if (n.val_index_mode() || n.rsrc_index_mode())
+      throw runtime_error("CFEmulator: GLOBAL_WAVE_SYNC index modes "
+                          "are not supported");
+
+   m_waiting = !m_params.sync->global_wave_sync(n.gws_opcode(), n.resource(),
+                                                n.value(), m_ticket);
+   if (!m_waiting)
+      m_ticket = 0;
+   return !m_waiting;
+}
+
+void CFEmulator::execute_native(const CFNativeNode& n)
+{
+   switch (n.opcode()) {
+   case cf_nop:
+   case cf_call_fs:
+   case cf_wait_ack:
+      break;
+   case cf_jump:
+      if (!condition_mask(n))
+         jump(n.address(), n.pop_count());
+      break;
+   case cf_push:
+      push();
+      if (!condition_mask(n))
+         jump(n.address(), n.pop_count());
+      break;
+   case cf_else:
+      do_else();
+      if (!condition_mask(n))
+         jump(n.address(), n.pop_count());
+      break;
+   case cf_pop:
+      pop(n.pop_count());
+      break;
+   case cf_loop_start:
+   case cf_loop_start_dx10:
+   case cf_loop_start_no_al:
+      loop_start(n);
+      break;
+   case cf_loop_end:
+      loop_end(n);
+      break;
+   case cf_loop_break:
+   case cf_loop_continue: {
+      LaneMask leaving = condition_mask(n);
+      m_wf.set_active(m_wf.active() & ~leaving);
+      exit_lanes(leaving, n.opcode() == cf_loop_break);
+      break;
+   }
+   case cf_call:
+      if (condition_mask(n)) {
+         m_call_stack.push_back(m_pc);
+         m_pc = index_of(n.address());
+      }
+      break;
+   case cf_return:
+      if (m_call_stack.empty()) {
+         m_finished = true;
+      } else {
+         m_pc = m_call_stack.back();
+         m_call_stack.pop_back();
+      }
+      break;
+   case cf_kill:
+      m_wf.kill(condition_mask(n));
+      break;
+   case cf_halt:
+      m_finished = true;
+      break;
+   default: {
+      std::ostringstream msg;
+      msg << "CFEmulator: unsupported instruction " << n;
+      throw runtime_error(msg.str());
+   }
+   }
+}
+
+LaneMask CFEmulator::condition_mask(const CFNativeNode& n) const
+{
+   bool b = (m_params.bool_constants >> n.cf_const()) & 1;
+   switch (n.cond()) {
+   case 1: return 0;
+   case 2: return b ? m_wf.active() : 0;
+   case 3: return b ? 0 : m_wf.active();
+   default:
+      return m_wf.active();
+   }
+}
+
+void CFEmulator::push()
+{
+   StackEntry e = {se_push, m_wf.active(), 0, 0, 0, 0, 0, false, false, 0};
+   m_stack.push_back(e);
+   m_max_stack_depth = std::max<unsigned>(m_max_stack_depth, m_stack.size());
+}
+
+void CFEmulator::pop(unsigned count)
+{
+   for (unsigned i = 0; i < count; ++i) {
+      if (m_stack.empty())
+         throw runtime_error("CFEmulator: stack underflow");
+      const auto& e = m_stack.back();
+      if (e.type == se_loop)
+         m_wf.set_loop_index(e.outer_index);
+      m_wf.set_active(e.mask & ~disabled_in_loop(m_stack.size() - 1));
+      m_stack.pop_back();
+   }
+}
+
+void CFEmulator::jump(unsigned addr, unsigned pop_count)
+{
+   pop(pop_count);
+   m_pc = index_of(addr);
+}
+
+void CFEmulator::do_else()
+{
+   if (m_stack.empty())
+      throw runtime_error("CFEmulator: ELSE without PUSH");
+   const auto& top = m_stack.back();
+   m_wf.set_active(top.mask & ~m_wf.active() &
+                   ~disabled_in_loop(m_stack.size() - 1));
+}
+
+int CFEmulator::innermost_loop(size_t below) const
+{
+   for (size_t i = below; i > 0; --i)
+      if (m_stack[i - 1].type == se_loop)
+         return i - 1;
+   return -1;
+}
+
+LaneMask CFEmulator::disabled_in_loop(size_t below) const
+{
+   int loop = innermost_loop(below);
+   if (loop < 0)
+      return 0;
+   return m_stack[loop].broken | m_stack[loop].continued;
+}
+
+void CFEmulator::loop_start(const CFNativeNode& n)
+{
+   StackEntry e = {se_loop, m_wf.active(), 0, 0, m_wf.loop_index(), 0, 0,
+                   n.opcode() != cf_loop_start_dx10,
+                   n.opcode() == cf_loop_start,
+                   index_of(n.address()) - 1};
+
+   if (e.counted) {
+      uint32_t c = m_params.loop_constants[n.cf_const() & 31];
+      e.remaining = c & 0xfff;
+      e.increment = static_cast<int8_t>(c >> 24);
+      if (e.sets_index)
+         m_wf.set_loop_index((c >> 12) & 0xfff);
+   }
+
+   m_stack.push_back(e);
+   m_max_stack_depth = std::max<unsigned>(m_max_stack_depth, m_stack.size());
+
+   if (!m_wf.active() || (e.counted && !e.remaining))
+      leave_loop();
+}
+
+void CFEmulator::loop_end(const CFNativeNode& n)
+{
+   int loop = innermost_loop(m_stack.size());
+   if (loop < 0)
+      throw runtime_error("CFEmulator: LOOP_END outside of a loop");
+   m_stack.resize(loop + 1);
+
+   auto& e = m_stack.back();
+   m_wf.set_active((m_wf.active() | e.continued) & ~e.broken);
+   e.continued = 0;
+   if (e.counted)
+      --e.remaining;
+
+   if (m_wf.active() && (!e.counted || e.remaining)) {
+      if (e.sets_index)
+         m_wf.set_loop_index(m_wf.loop_index() + e.increment);
+      m_pc = index_of(n.address());
+   } else {
+      leave_loop();
+   }
+}
+
+void CFEmulator::leave_loop()
+{
+   auto& e = m_stack.back();
+   m_pc = e.end_cf + 1;
+   m_wf.set_active(e.mask & ~disabled_in_loop(m_stack.size() - 1));
+   m_wf.set_loop_index(e.outer_index);
+   m_stack.pop_back();
+}
+
+void CFEmulator::exit_lanes(LaneMask mask, bool is_break)
+{
+   int loop = innermost_loop(m_stack.size());
+   if (loop < 0)
+      throw runtime_error("CFEmulator: break or continue outside of a loop");
+
+   auto& e = m_stack[loop];
+   if (is_break)
+      e.broken |= mask;
+   else
+      e.continued |= mask;
+
+   /* When no thread of the loop will execute the rest of the body
+    * skip to the LOOP_END, or behind it if all threads left */
+   if (e.mask & m_wf.valid() & ~e.broken & ~e.continued)
+      return;
+
+   m_stack.resize(loop + 1);
+   if (e.continued) {
+      m_wf.set_active(0);
+      m_pc = e.end_cf;
+   } else {
+      leave_loop();
+   }
+}
+
+}
@@ -0,0 +1,226 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_cf_emulator_h
+#define r600_cf_emulator_h
+
+#include <r600/disassembler.h>
+#include <r600/execution_profile.h>
+#include <r600/fetch_emulator.h>
+#include <r600/wavefront.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace r600 {
+
+class AluInterpreter;
+
+/* Synchronization of a wavefront with the other wavefronts of a
+ * dispatch, implemented by the scheduler that runs them. A call that
+ * returns false makes the wavefront wait: the emulator doesn't advance
+ * and repeats the call with the same ticket on its next step. The
+ * ticket is zero on the first call and can be used by the
+ * implementation to recognize the waiting wavefront.
+ */
+class WaveSync {
+public:
+   virtual ~WaveSync();
+
+   /* GROUP_BARRIER, passes when all running wavefronts of the
+    * workgroup arrived */
+   virtual bool group_barrier(uint32_t& ticket) = 0;
+
+   /* GLOBAL_WAVE_SYNC with the resource and the value of the
+    * instruction */
+   virtual bool global_wave_sync(EGWSOpCode op, unsigned resource,
+                                 unsigned value, uint32_t& ticket) = 0;
+};
+
+/* Executes the CF program of a shader for one wavefront.
+ *
+ * Divergent control flow is handled with the active mask of the
+ * wavefront and an emulated stack of masks: PUSH and ALU_PUSH_BEFORE
+ * save the active mask, POP and the *_POP_AFTER clauses restore it,
+ * JUMP skips code when no thread is active, and ELSE activates the
+ * threads of the saved mask that were not active. JUMP targets the
+ * ELSE or POP that ends the branch, ELSE targets the POP.
+ *
+ * Loops keep the threads that left the loop with a break and those
+ * that wait for the next iteration after a continue in their stack
+ * entry. LOOP_END starts the next iteration while threads are active
+ * and, for LOOP_START and LOOP_START_NO_AL, the trip count taken from
+ * the loop constant is not exhausted. LOOP_START sets the loop index
+ * register from the loop constant and LOOP_END adds the increment.
+ *
+ * ALU clauses are executed by the AluInterpreter, fetch clauses by the
+ * FetchEmulator given in the parameters. Exports and memory writes are
+ * ignored, the remaining instructions make the emulator throw
+ * std::runtime_error.
+ *
+ * GROUP_BARRIER and GLOBAL_WAVE_SYNC are passed to the WaveSync of the
+ * parameters, when it lets the wavefront wait step() returns without
+ * executing anything, and an ALU clause is continued at the group with
+ * the barrier. Without a WaveSync the wavefront is considered to be
+ * alone in its workgroup, i.e. GROUP_BARRIER passes, and
+ * GLOBAL_WAVE_SYNC throws.
+ */
+class CFEmulator {
+public:
+   struct Parameters {
+      Parameters();
+
+      /* Loop constants, count in bits 0-11, initial value in bits
+       * 12-23, and the signed increment in bits 24-31 */
+      std::array<uint32_t, 32> loop_constants;
+
+      /* Boolean constants for the CF_COND_BOOL conditions */
+      uint32_t bool_constants;
+
+      /* Number of executed CF instructions after which the emulator
+       * gives up, catches endless loops */
+      unsigned max_steps;
+
+      /* Resources for the fetch clauses, may be null if the program
+       * doesn't fetch */
+      const FetchEmulator *fetch;
+
+      /* If given, the executions of the CF instructions and the ALU
+       * groups are recorded here */
+      ExecutionProfile *profile;
+
+      /* Synchronization with the other wavefronts of the dispatch */
+      WaveSync *sync;
+   };
+
+   enum EEntryType {
+      se_push,
+      se_loop
+   };
+
+   struct StackEntry {
+      EEntryType type;
+      /* active threads when the entry was pushed */
+      LaneMask mask;
+      /* loops: threads that left the loop, and threads that wait for
+       * the next iteration */
+      LaneMask broken;
+      LaneMask continued;
+      /* loops: loop index register of the enclosing loop */
+      int outer_index;
+      int increment;
+      unsigned remaining;
+      bool counted;
+      bool sets_index;
+      unsigned end_cf;
+   };
+
+   /* The control flow state between two CF instructions */
+   struct State {
+      unsigned pc;
+      bool finished;
+      unsigned steps;
+      unsigned max_stack_depth;
+      std::vector<StackEntry> stack;
+      std::vector<unsigned> call_stack;
+   };
+
+   CFEmulator(const disassembler& program, Wavefront& wf,
+              const Parameters& params = Parameters());
+   ~CFEmulator();
+
+   /* Execute one CF instruction, returns false when the program ended */
+   bool step();
+
+   /* True if the last step waited for other wavefronts */
+   bool waiting() const;
+
+   /* Execute until the end of the program */
+   void run();
+
+   bool finished() const;
+
+   /* Index of the next CF instruction in disassembler::get_program() */
+   unsigned pc() const;
+
+   unsigned steps() const;
+   const std::vector<StackEntry>& stack() const;
+   unsigned max_stack_depth() const;
+
+   /* True between two CF instructions, i.e. not inside an ALU clause
+    * and not waiting for other wavefronts */
+   bool at_clause_boundary() const;
+
+   /* Save and restore the control flow state, state() throws
+    * std::runtime_error if not at a clause boundary */
+   State state() const;
+   void set_state(const State& state);
+
+private:
+   void execute_alu(const CFAluNode& alu);
+   void continue_alu();
+   void end_alu(const CFAluNode& alu);
+   void execute_native(const CFNativeNode& n);
+   bool global_wave_sync(const CFGwsNode& n);
+   bool group_barrier();
+
+   LaneMask condition_mask(const CFNativeNode& n) const;
+   unsigned index_of(unsigned addr) const;
+
+   void push();
+   void pop(unsigned count);
+   void jump(unsigned addr, unsigned pop_count);
+   void do_else();
+
+   void loop_start(const CFNativeNode& n);
+   void loop_end(const CFNativeNode& n);
+   void leave_loop();
+   void exit_lanes(LaneMask mask, bool is_break);
+   int innermost_loop(size_t below) const;
+   LaneMask disabled_in_loop(size_t below) const;
+
+   const std::vector<CFNode::pointer>& m_program;
+   std::vector<unsigned> m_cf_addr;
+   Wavefront& m_wf;
+   Parameters m_params;
+
+   unsigned m_pc;
+   bool m_finished;
+   unsigned m_steps;
+   std::vector<StackEntry> m_stack;
+   std::vector<unsigned> m_call_stack;
+   unsigned m_max_stack_depth;
+
+   /* The ALU clause in execution and its next group, set while the
+    * clause waits at a GROUP_BARRIER */
+   std::unique_ptr<AluInterpreter> m_alu;
+   const CFAluNode *m_alu_node;
+   size_t m_alu_group;
+   LaneMask m_alu_before;
+
+   bool m_waiting;
+   uint32_t m_ticket;
+};
+
+}
+
+#endif
@@ -21,7 +21,9 @@
 #include "cf_node.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <cassert>
+#include <stdexcept>
 
 namespace r600 {
 
@@ -75,12 +77,44 @@ uint64_t CFNode::create_bytecode_byte(int i) const
 }
 
 void CFNode::print(std::ostream& os) const
+{
+   print_opname(os);
+   print_detail(os);
+}
+
+void CFNode::print_opname(std::ostream& os) const
 {
    if (m_nesting_depth > 0)
       os << std::setw(4  * m_nesting_depth) << " ";
    os  << std::setw(22)
        << std::left << op_from_opcode(m_opcode);
-   print_detail(os);
+}
+
+void CFNode::print_lines(std::ostream& os, unsigned address,
+                         const LinePrefix& prefix) const
+{
+   std::ostringstream text;
+   text.flags(os.flags());
+   print(text);
+   os.flags(text.flags());
+   print_prefixed(os, text.str(), address, prefix);
+}
+
+void CFNode::print_prefixed(std::ostream& os, const std::string& text,
+                            int address, const LinePrefix& prefix)
+{
+   size_t start = 0;
+   do {
+      size_t end = text.find('\n', start);
+      if (end == std::string::npos)
+         end = text.size();
+      if (prefix)
+         prefix(os, address);
+      os.write(text.data() + start, end - start);
+      os << "\n";
+      address = -1;
+      start = end + 1;
+   } while (start <= text.size());
 }
 
 std::string CFNode::op_from_opcode(uint32_t opcode) const
@@ -261,6 +295,7 @@ CFAluNode::CFAluNode(uint16_t opcode,
                      ):
    CFNodeWithAddress(1, opcode << 4, addr),
    CFNodeFlags(flags),
+   m_nkcache(opcode == cf_alu_extended ? 4 : 2),
    m_count(count)
 {
    assert(count > 0);
@@ -323,7 +358,70 @@ void CFAluNode::disassemble_clause(const std::vector<uint64_t>& bc)
    }
 }
 
+const std::vector<AluGroup>& CFAluNode::clause() const
+{
+   return m_clause_code;
+}
+
+uint16_t CFAluNode::count() const
+{
+   return m_count;
+}
+
+uint16_t CFAluNode::nkcache() const
+{
+   return m_nkcache;
+}
+
+uint16_t CFAluNode::kcache_bank(int i) const
+{
+   assert(i < m_nkcache);
+   return m_kcache_bank[i];
+}
+
+uint16_t CFAluNode::kcache_mode(int i) const
+{
+   assert(i < m_nkcache);
+   return m_kcache_mode[i];
+}
+
+uint16_t CFAluNode::kcache_addr(int i) const
+{
+   assert(i < m_nkcache);
+   return m_kcache_addr[i];
+}
+
 void CFAluNode::print_detail(std::ostream& os) const
+{
+   print_clause_header(os);
+   os << "\n";
+   for (const auto& g: m_clause_code)
+      os << "\n" << g.as_string(4 * get_nesting_depth() +4);
+}
+
+/* The clause is printed group by group, so that each group starts a line
+ * that is prefixed with its address */
+void CFAluNode::print_lines(std::ostream& os, unsigned address,
+                            const LinePrefix& prefix) const
+{
+   std::ostringstream header;
+   header.flags(os.flags());
+   print_opname(header);
+   print_clause_header(header);
+   os.flags(header.flags());
+   print_prefixed(os, header.str(), address, prefix);
+
+   for (const auto& g: m_clause_code) {
+      std::string text = g.as_string(4 * get_nesting_depth() +4);
+      if (!text.empty())
+         text.pop_back();
+      print_prefixed(os, "", -1, prefix);
+      print_prefixed(os, text, g.address(), prefix);
+   }
+   print_prefixed(os, "", -1, prefix);
+}
+
+void CFAluNode::print_clause_header(std::ostream& os) const
 {
    print_address(os);
    os << " COUNT:" << m_count;
@@ -350,9 +448,6 @@ void CFAluNode::print_detail(std::ostream& os) const
       }
    }
    print_flags(os);
-   os << "\n";
-   for (const auto& g: m_clause_code)
-      os << "\n" << g.as_string(4 * get_nesting_depth() +4);
 }
 
 CFNodeFlags::CFNodeFlags(uint64_t bc)
@@ -483,6 +578,26 @@ uint64_t CFNodeCFWord1::encode() const
    return bc;
 }
 
+uint16_t CFNodeCFWord1::pop_count() const
+{
+   return m_pop_count;
+}
+
+uint16_t CFNodeCFWord1::cf_const() const
+{
+   return m_cf_const;
+}
+
+uint16_t CFNodeCFWord1::cond() const
+{
+   return m_cond;
+}
+
+uint16_t CFNodeCFWord1::count() const
+{
+   return m_count;
+}
+
 CFNativeNode::CFNativeNode(uint64_t bc):
    CFNodeWithAddress(1, get_opcode(bc), get_address(bc)),
    m_jumptable_se((bc >> 24) & 0x7),
@@ -514,6 +629,26 @@ bool CFNativeNode::do_test_flag(int f) const
    return m_word1.has_flag(f);
 }
 
+uint16_t CFNativeNode::pop_count() const
+{
+   return m_word1.pop_count();
+}
+
+uint16_t CFNativeNode::cf_const() const
+{
+   return m_word1.cf_const();
+}
+
+uint16_t CFNativeNode::cond() const
+{
+   return m_word1.cond();
+}
+
+uint16_t CFNativeNode::count() const
+{
+   return m_word1.count();
+}
+
 uint32_t CFNode::get_address(uint64_t bc)
 {
    return bc  & 0xFFFFFF;
@@ -565,8 +700,43 @@ void CFNativeNode::print_detail(std::ostream& os) const
 }
 
 
+CFFetchNode::CFFetchNode(uint64_t bc):
+   CFNativeNode(bc)
+{
+}
+
+CFFetchNode::CFFetchNode(uint16_t opcode,
+                         const cf_flags &flags,
+                         uint32_t address,
+                         uint16_t count):
+   CFNativeNode(opcode, flags, address, 0, count)
+{
+}
+
+void CFFetchNode::disassemble_clause(const std::vector<uint64_t>& bc)
+{
+   size_t ofs = address();
+   size_t end = address() + 2 * nfetches();
+
+   if (end > bc.size())
+      throw std::runtime_error("Fetch clause exceeds byte code");
+
+   for (; ofs < end; ofs += 2)
+      m_clause_code.push_back(FetchNode::decode(bc[ofs], bc[ofs + 1]));
+}
+
+const std::vector<PFetchNode>& CFFetchNode::clause() const
+{
+   return m_clause_code;
+}
+
+unsigned CFFetchNode::nfetches() const
+{
+   return count() + 1u;
+}
+
 CFGwsNode::CFGwsNode(uint64_t bc):
-   CFNode(2, get_opcode(bc)),
+   CFNode(1, get_opcode(bc)),
    m_value(bc & 0x3FF),
    m_resource((bc >> 16) & 0x1F),
    m_val_index_mode((bc >> 26) & 0x3),
@@ -640,6 +810,31 @@ CFGwsNode::CFGwsNode(uint32_t opcode,
 {
 }
 
+EGWSOpCode CFGwsNode::gws_opcode() const
+{
+   return static_cast<EGWSOpCode>(m_gws_opcode);
+}
+
+uint16_t CFGwsNode::value() const
+{
+   return m_value;
+}
+
+uint16_t CFGwsNode::resource() const
+{
+   return m_resource;
+}
+
+uint16_t CFGwsNode::val_index_mode() const
+{
+   return m_val_index_mode;
+}
+
+uint16_t CFGwsNode::rsrc_index_mode() const
+{
+   return m_rsrc_index_mode;
+}
+
 void CFGwsNode::encode_parts(int i, uint64_t &bc) const
 {
    assert(i==0);
@@ -690,6 +885,11 @@ CFMemNode::CFMemNode(uint64_t bc):
       set_flag(CFNode::eop);
 }
 
+bool CFMemNode::do_test_flag(int f) const
+{
+   return has_flag(f);
+}
+
 void CFMemNode::encode_parts(int i, uint64_t& bc) const
 {
    assert(i == 0);
@@ -727,6 +927,21 @@ int CFMemNode::get_type() const
    return m_type;
 }
 
+uint16_t CFMemNode::rw_gpr() const
+{
+   return m_rw_gpr;
+}
+
+uint16_t CFMemNode::index_gpr() const
+{
+   return m_index_gpr;
+}
+
+bool CFMemNode::is_indexed() const
+{
+   return m_type & 1;
+}
+
 int CFMemNode::get_burst_count() const
 {
    return m_burst_count;
@@ -774,6 +989,16 @@ void CFMemCompNode::print_mem_detail(std::ostream& os) const
    print_export_detail(os);
 }
 
+uint32_t CFMemCompNode::array_size() const
+{
+   return m_array_size;
+}
+
+uint16_t CFMemCompNode::comp_mask() const
+{
+   return m_comp_mask;
+}
+
 void CFMemCompNode::encode_mem_parts(uint64_t& bc) const
 {
    bc |= static_cast<uint64_t>(m_array_size) << 32;
@@ -813,6 +1038,26 @@ const char *CFRatNode::m_type_string[4] = {
    "WRITE", "WRITE_IND", "WRITE_ACK", "WRITE_IND_ACK"
 };
 
+uint16_t CFRatNode::rat_inst() const
+{
+   return m_rat_inst;
+}
+
+uint16_t CFRatNode::rat_id() const
+{
+   return m_rat_id;
+}
+
+uint16_t CFRatNode::rat_index_mode() const
+{
+   return m_rat_index_mode;
+}
+
+bool CFRatNode::requests_ack() const
+{
+   return get_type() & 2;
+}
+
 void CFRatNode::encode_export_parts(uint64_t &bc) const
 {
    bc |= m_rat_id;
@@ -888,6 +1133,16 @@ CFMemExportNode::CFMemExportNode(uint16_t opcode,
 
 }
 
+uint16_t CFMemExportNode::array_base() const
+{
+   return m_array_base;
+}
+
+const std::vector<unsigned>& CFMemExportNode::sel() const
+{
+   return m_sel;
+}
+
 void CFMemExportNode::print_mem_detail(std::ostream& os) const
 {
    os << ".";
@@ -928,10 +1183,25 @@ CFExportNode::CFExportNode(uint16_t opcode,
 {
 }
 
+bool CFExportNode::is_indexed() const
+{
+   return false;
+}
+
 const char *CFExportNode::m_type_string[4] = {
    "PIXEL", "POS", "PARAM", "undefined"
 };
 
+uint16_t CFExportNode::array_base() const
+{
+   return m_array_base;
+}
+
+const std::vector<unsigned>& CFExportNode::sel() const
+{
+   return m_sel;
+}
+
 void CFExportNode::print_mem_detail(std::ostream& os) const
 {
    os << ".";
@@ -965,7 +1235,7 @@ void CFExportNode::print_elm_size(std::ostream& os) const
    (void)os;
 }
 
-const char *CFRatNode::rat_inst_string(int opcode) const
+const char *CFRatNode::rat_inst_string(int opcode)
 {
    switch (opcode) {
    case 0: return "NOP";
@@ -22,6 +22,7 @@
 #define CF_NODE_H
 
 #include <r600/alu_node.h>
+#include <r600/fetch_node.h>
 #include <r600/defines.h>
 
 #include <memory>
@@ -29,6 +30,7 @@
 #include <vector>
 #include <tuple>
 #include <bitset>
+#include <functional>
 
 namespace r600 {
 
@@ -45,8 +47,18 @@ class CFNode : public node {
 public:
    using pointer = std::shared_ptr<CFNode>;
 
+   /* Called at the start of each printed line with the bytecode address
+    * of the CF instruction or ALU group that starts on the line, and -1
+    * for all other lines */
+   using LinePrefix = std::function<void (std::ostream& os, int address)>;
+
    CFNode(int bytecode_size, uint32_t opcode);
 
+   /* Print the instruction at the given address like operator << and
+    * terminate it with a newline */
+   virtual void print_lines(std::ostream& os, unsigned address,
+                            const LinePrefix& prefix) const;
+
    static const uint16_t vpm = 0;
    static const uint16_t eop = 1;
    static const uint16_t qmb = 2;
@@ -62,14 +74,17 @@ public:
    uint32_t opcode() const;
 
    void set_nesting_depth(int nd);
-
-protected:
    int get_nesting_depth() const;
 
+protected:
    static const char *m_index_mode_string;
    static uint32_t get_opcode(uint64_t bc);
    static uint32_t get_address(uint64_t bc);
 
+   void print_opname(std::ostream& os) const;
+   static void print_prefixed(std::ostream& os, const std::string& text,
+                              int address, const LinePrefix& prefix);
+
 private:
    void print(std::ostream& os) const override;
    uint64_t create_bytecode_byte(int i) const override;
@@ -112,6 +127,11 @@ public:
    void print(std::ostream& os) const;
    uint64_t encode() const;
 
+   uint16_t pop_count() const;
+   uint16_t cf_const() const;
+   uint16_t cond() const;
+   uint16_t count() const;
+
 private:
    static const char *m_condition;
    uint16_t m_pop_count;
@@ -171,6 +191,13 @@ public:
              const std::tuple<int,int,int>& kcache3);
 
    void disassemble_clause(const std::vector<uint64_t>& bc);
+   const std::vector<AluGroup>& clause() const;
+
+   uint16_t count() const;
+   uint16_t nkcache() const;
+   uint16_t kcache_bank(int i) const;
+   uint16_t kcache_mode(int i) const;
+   uint16_t kcache_addr(int i) const;
 
 private:
    CFAluNode(uint64_t bc, bool alu_ext);
@@ -179,6 +206,9 @@ private:
 
    std::string op_from_opcode(uint32_t m_opcode) const override final;
    void print_detail(std::ostream& os) const override;
+   void print_clause_header(std::ostream& os) const;
+   void print_lines(std::ostream& os, unsigned address,
+                    const LinePrefix& prefix) const override;
    void encode_parts(int i, uint64_t& bc) const override;
 
    uint16_t m_nkcache;
@@ -203,6 +233,11 @@ public:
                 uint16_t jts = 0,
                 uint16_t cf_const = 0,
                 uint16_t cond = 0);
+
+   uint16_t pop_count() const;
+   uint16_t cf_const() const;
+   uint16_t cond() const;
+   uint16_t count() const;
 private:
    bool do_test_flag(int f) const override;
 
@@ -215,6 +250,25 @@ private:
    static const char m_jts_names[6][3];
 };
 
+/* TEX, VTX, and GDS clauses, the clause holds COUNT + 1 instructions
+ * of two quad words each */
+class CFFetchNode : public CFNativeNode {
+public:
+   CFFetchNode(uint64_t bc);
+   CFFetchNode(uint16_t opcode,
+               const cf_flags &flags,
+               uint32_t address,
+               uint16_t count = 0);
+
+   void disassemble_clause(const std::vector<uint64_t>& bc);
+   const std::vector<PFetchNode>& clause() const;
+
+   unsigned nfetches() const;
+
+private:
+   std::vector<PFetchNode> m_clause_code;
+};
+
 class CFGwsNode : public CFNode {
 public:
    CFGwsNode(uint64_t bc);
@@ -230,6 +284,12 @@ public:
              short val_index_mode,
              short res_index_mode);
 
+   EGWSOpCode gws_opcode() const;
+   uint16_t value() const;
+   uint16_t resource() const;
+   uint16_t val_index_mode() const;
+   uint16_t rsrc_index_mode() const;
+
 private:
    void print_detail(std::ostream& os) const override;
    void encode_parts(int i, uint64_t &bc) const override;
@@ -255,7 +315,13 @@ public:
              uint16_t burst_count,
              const cf_flags &flags);
 
-protected:
+   /* The instruction reads the GPRs rw_gpr to rw_gpr + burst count,
+    * and the index GPR if the access is indexed */
+   uint16_t rw_gpr() const;
+   uint16_t index_gpr() const;
+   virtual bool is_indexed() const;
+   int get_burst_count() const;
+
    enum types {
       export_pixel,
       export_pos,
@@ -264,10 +330,10 @@ protected:
    };
 
    int get_type() const;
-   int get_burst_count() const;
    bool is_type(types t) const;
 
 private:
+   bool do_test_flag(int f) const override;
    void print_detail(std::ostream& os) const override final;
    void encode_parts(int i, uint64_t& bc) const override final;
    virtual void print_mem_detail(std::ostream& os) const = 0;
@@ -294,6 +360,9 @@ public:
                  uint16_t comp_mask,
                  uint16_t burst_count,
                  const cf_flags &flags);
+
+   uint32_t array_size() const;
+   uint16_t comp_mask() const;
 private:
    void print_mem_detail(std::ostream& os) const override final;
    void encode_mem_parts(uint64_t& bc) const override final;
@@ -319,13 +388,20 @@ public:
              uint16_t burst_count,
              const cf_flags &flags);
 
+   uint16_t rat_inst() const;
+   uint16_t rat_id() const;
+   uint16_t rat_index_mode() const;
+
+   /* The write requests an acknowledge that WAIT_ACK waits for */
+   bool requests_ack() const;
+
+   static const char *rat_inst_string(int opcode);
 
 private:
    static const char *m_type_string[4];
    void print_export_detail(std::ostream& os) const override;
    void encode_export_parts(uint64_t& bc) const override;
 
-   const char *rat_inst_string(int m_opcode) const;
    uint16_t m_rat_id;
    uint16_t m_rat_inst;
    uint16_t m_rat_index_mode;
@@ -365,6 +441,8 @@ public:
                    const std::vector<unsigned>& sel,
                    const cf_flags &flags);
 
+   uint16_t array_base() const;
+   const std::vector<unsigned>& sel() const;
 private:
    void print_mem_detail(std::ostream& os) const override;
    void encode_mem_parts(uint64_t& bc) const override;
@@ -383,6 +461,14 @@ public:
                 uint16_t burst_count,
                 const std::vector<unsigned>& sel,
                 const cf_flags &flags);
+
+   /* Component selects 0-3 pick x-w, 4 and 5 export the constants 0 and
+    * 1, and 7 masks the component */
+   uint16_t array_base() const;
+   const std::vector<unsigned>& sel() const;
+
+   /* the type field of exports doesn't encode indexing */
+   bool is_indexed() const override;
 private:
    static const char *m_type_string[4];
    void print_mem_detail(std::ostream& os) const override;
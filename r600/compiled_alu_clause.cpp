@@ -0,0 +1,455 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/compiled_alu_clause.h>
+#include <r600/local_data_share.h>
+
+#include <sstream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+namespace {
+const uint32_t sign_bit = 0x80000000;
+}
+
+CompiledAluClause::CompiledAluClause(const CFAluNode& alu, bool native):
+   m_nconst_table(0)
+{
+   if (native && AluJit::available())
+      m_jit.reset(new AluJit);
+
+   for (unsigned i = 0; i < 4; ++i) {
+      bool used = i < alu.nkcache();
+      m_kcache_bank[i] = used ? alu.kcache_bank(i) : 0;
+      m_kcache_addr[i] = used ? alu.kcache_addr(i) : 0;
+   }
+
+   for (const auto& g: alu.clause()) {
+      Group group = {static_cast<unsigned>(m_code.size()), 0, false, -1,
+                     nullptr};
+      std::vector<EAluOp> ops;
+
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = g.slot(s);
+         /* The wavefronts are synchronized by the caller */
+         if (!node || node->opcode() == op2_group_barrier)
+            continue;
+
+         Instr instr = {};
+         instr.sem = AluInterpreter::semantics(node->opcode());
+         if (node->opcode() == op3_lds_idx_op) {
+            auto lds = static_cast<const AluNodeLDSIdxOP *>(node.get());
+            if (!LocalDataShare::supported(lds->lds_op())) {
+               std::ostringstream msg;
+               msg << "CompiledAluClause: unsupported instruction " << *node;
+               throw runtime_error(msg.str());
+            }
+            instr.lds_op = lds->lds_op();
+            instr.lds_offset = lds->offset();
+         } else if (!instr.sem) {
+            std::ostringstream msg;
+            msg << "CompiledAluClause: unsupported instruction " << *node;
+            throw runtime_error(msg.str());
+         }
+         instr.slot = s;
+         instr.nsrc = 0;
+         for (unsigned k = 0; k < node->nsources() && k < 3; ++k) {
+            auto v = node->get_src(k);
+            if (!v)
+               break;
+            instr.src[k] = lower(*node, *v);
+            instr.nsrc = k + 1;
+         }
+
+         instr.loop_relative = node->index_mode() == AluNode::idx_loop;
+         instr.omod = AluNode::omod_off;
+         if (auto op2 = dynamic_cast<const AluNodeOp2 *>(node.get()))
+            instr.omod = op2->output_modify();
+         instr.clamp = node->test_flag(AluNode::do_clamp);
+         instr.update_pred = node->test_flag(AluNode::do_update_pred);
+         instr.update_exec = node->test_flag(AluNode::do_update_exec_mask);
+         instr.pred_select = AluNode::pred_sel_off;
+
+         if (auto d = dynamic_cast<const AluNodeWithDst *>(node.get())) {
+            instr.write = d->writes_dst();
+            instr.dst_sel = d->dst().sel();
+            instr.dst_chan = d->dst().chan();
+            instr.dst_rel = d->dst().rel();
+            instr.pred_select = d->pred_select();
+         }
+
+         group.multi_slot |= instr.sem &&
+                             (instr.sem->kind == AluInterpreter::sk_dot ||
+                              instr.sem->kind == AluInterpreter::sk_max4);
+         m_code.push_back(instr);
+         ops.push_back(node->opcode());
+      }
+      group.end = m_code.size();
+      if (m_jit)
+         group.jit_id = add_native(group, ops);
+      m_groups.push_back(group);
+   }
+
+   if (m_jit && m_jit->finalize()) {
+      for (auto& g: m_groups)
+         g.native = m_jit->function(g.jit_id);
+   }
+}
+
+int CompiledAluClause::add_native(const Group& g,
+                                  const std::vector<EAluOp>& ops)
+{
+   std::vector<AluJit::Instr> jit_group;
+   std::vector<Operand> table;
+
+   for (unsigned i = g.first; i < g.end; ++i) {
+      const Instr& in = m_code[i];
+      AluJit::Instr ji = {ops[i - g.first], in.slot, in.nsrc, {}};
+      if (!in.sem || (in.sem->kind != AluInterpreter::sk_value &&
+                      in.sem->kind != AluInterpreter::sk_dot))
+         return -1;
+
+      for (unsigned k = 0; k < in.nsrc; ++k) {
+         Operand op = in.src[k];
+         if (op.kind != ok_gpr && op.kind != ok_pv &&
+             op.kind != ok_uniform && op.kind != ok_const)
+            return -1;
+         /* the modifiers are already folded into the uniforms */
+         bool folded = op.kind == ok_uniform;
+         ji.src[k].index = m_table.size() + table.size();
+         ji.src[k].abs = !folded && op.and_mask != 0xffffffff;
+         ji.src[k].neg = !folded && op.xor_mask != 0;
+         op.modified = false;
+         table.push_back(op);
+      }
+      jit_group.push_back(ji);
+   }
+
+   int id = m_jit->add(jit_group);
+   if (id >= 0) {
+      for (const auto& op: table)
+         if (op.kind == ok_const)
+            ++m_nconst_table;
+      m_table.insert(m_table.end(), table.begin(), table.end());
+   }
+   return id;
+}
+
+unsigned CompiledAluClause::ngroups() const
+{
+   return m_groups.size();
+}
+
+unsigned CompiledAluClause::ninstructions() const
+{
+   return m_code.size();
+}
+
+unsigned CompiledAluClause::nnative_groups() const
+{
+   unsigned n = 0;
+   for (const auto& g: m_groups)
+      if (g.native)
+         ++n;
+   return n;
+}
+
+CompiledAluClause::Operand
+CompiledAluClause::lower(const AluNode& n, const Value& v)
+{
+   Operand op = {};
+   op.loop_relative = n.index_mode() == AluNode::idx_loop;
+   op.and_mask = v.abs() ? ~sign_bit : 0xffffffff;
+   op.xor_mask = v.neg() ? sign_bit : 0;
+   op.modified = v.abs() || v.neg();
+   op.chan = v.chan();
+
+   uint32_t value = 0;
+   bool uniform = false;
+
+   switch (v.type()) {
+   case Value::gpr:
+      op.kind = v.rel() ? ok_gpr_rel : ok_gpr;
+      op.index = v.sel();
+      break;
+   case Value::kconst: {
+      auto& c = static_cast<const ConstValue&>(v);
+      op.kind = v.rel() ? ok_const_rel : ok_const;
+      op.buffer = m_kcache_bank[c.kcache_bank()];
+      op.index = 16 * m_kcache_addr[c.kcache_bank()] + c.index();
+      break;
+   }
+   case Value::literal:
+      value = static_cast<const LiteralValue&>(v).value();
+      uniform = true;
+      break;
+   case Value::cinline:
+      if (AluInterpreter::inline_constant(v.sel(), value)) {
+         uniform = true;
+         break;
+      }
+      switch (v.sel()) {
+      case ALU_SRC_PV: op.kind = ok_pv; op.index = v.chan(); break;
+      case ALU_SRC_PS: op.kind = ok_pv; op.index = 4; break;
+      case ALU_SRC_LOOP_IDX: op.kind = ok_loop_index; break;
+      case ALU_SRC_MASK_LO: op.kind = ok_mask_lo; break;
+      case ALU_SRC_MASK_HI: op.kind = ok_mask_hi; break;
+      case ALU_SRC_LDS_OQ_A:
+      case ALU_SRC_LDS_OQ_B:
+      case ALU_SRC_LDS_OQ_A_POP:
+      case ALU_SRC_LDS_OQ_B_POP:
+         op.kind = ok_lds_queue;
+         op.index = v.sel();
+         break;
+      default: {
+         std::ostringstream msg;
+         msg << "CompiledAluClause: unsupported source " << v;
+         throw runtime_error(msg.str());
+      }
+      }
+      break;
+   default: {
+      std::ostringstream msg;
+      msg << "CompiledAluClause: unsupported source " << v;
+      throw runtime_error(msg.str());
+   }
+   }
+
+   if (uniform) {
+      /* fold the modifiers into the constant */
+      Lanes l;
+      l.fill((value & op.and_mask) ^ op.xor_mask);
+      op.kind = ok_uniform;
+      op.index = m_uniforms.size();
+      op.modified = false;
+      m_uniforms.push_back(l);
+   }
+   return op;
+}
+
+int CompiledAluClause::index(bool loop_relative, const Wavefront& wf,
+                             unsigned lane)
+{
+   return loop_relative ? wf.loop_index() :
+                          static_cast<int32_t>(wf.ar()[lane]);
+}
+
+const Lanes& CompiledAluClause::fetch(const Operand& op, Wavefront& wf,
+                                      Lanes& scratch) const
+{
+   /* reading the registers must not count as a write */
+   const Wavefront& regs = wf;
+   const Lanes *result = &scratch;
+
+   switch (op.kind) {
+   case ok_gpr:
+      result = &regs.gpr(op.index, op.chan);
+      break;
+   case ok_pv:
+      result = &wf.pv(op.index);
+      break;
+   case ok_uniform:
+      return m_uniforms[op.index];
+   case ok_gpr_rel:
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         int sel = op.index + index(op.loop_relative, wf, i);
+         scratch[i] = (sel >= 0 && sel < static_cast<int>(Wavefront::ngprs)) ?
+                         regs.gpr(sel, op.chan)[i] : 0;
+      }
+      break;
+   case ok_const:
+      scratch.fill(wf.constant(op.buffer, op.index, op.chan));
+      break;
+   case ok_const_rel:
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         int idx = op.index + index(op.loop_relative, wf, i);
+         scratch[i] = idx >= 0 ? wf.constant(op.buffer, idx, op.chan) : 0;
+      }
+      break;
+   case ok_loop_index:
+      scratch.fill(wf.loop_index());
+      break;
+   case ok_mask_lo:
+      scratch.fill(wf.active() & 0xffffffff);
+      break;
+   case ok_mask_hi:
+      scratch.fill(wf.active() >> 32);
+      break;
+   case ok_lds_queue:
+      AluInterpreter::read_lds_queue(op.index, wf, scratch);
+      break;
+   }
+
+   if (op.modified) {
+      const Lanes& in = *result;
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         scratch[i] = (in[i] & op.and_mask) ^ op.xor_mask;
+      result = &scratch;
+   }
+   return *result;
+}
+
+void CompiledAluClause::run(Wavefront& wf) const
+{
+   std::array<Lanes, 5> results;
+   std::array<LaneMask, 5> conditions;
+   std::array<Lanes, 3> scratch;
+   std::array<Lanes, 3> lds_src[5];
+   LaneMask exec = 0;
+   bool exec_updated = false;
+   LaneMask killed = 0;
+
+   /* The sources of the native groups are either registers that stay
+    * in place or constants that don't change within the clause */
+   std::vector<const uint32_t *> table(m_table.size());
+   std::vector<Lanes> fills;
+   fills.reserve(m_nconst_table);
+   for (unsigned i = 0; i < m_table.size(); ++i) {
+      if (m_table[i].kind == ok_const) {
+         fills.push_back(Lanes());
+         table[i] = fetch(m_table[i], wf, fills.back()).data();
+      } else {
+         table[i] = fetch(m_table[i], wf, scratch[0]).data();
+      }
+   }
+
+   for (const auto& g: m_groups) {
+      if (g.native) {
+         g.native(table.data(), results.data());
+      } else {
+         for (unsigned i = g.first; i < g.end; ++i) {
+            const Instr& in = m_code[i];
+            if (!in.sem) {
+               if (!wf.lds())
+                  throw runtime_error("CompiledAluClause: no LDS for LDS "
+                                      "instruction");
+               for (unsigned k = 0; k < 3; ++k) {
+                  if (k < in.nsrc)
+                     lds_src[in.slot][k] = fetch(in.src[k], wf, scratch[k]);
+                  else
+                     lds_src[in.slot][k].fill(0);
+               }
+               continue;
+            }
+            const Lanes *src[3] = {nullptr, nullptr, nullptr};
+            for (unsigned k = 0; k < in.nsrc; ++k)
+               src[k] = &fetch(in.src[k], wf, scratch[k]);
+            conditions[in.slot] = 0;
+            in.sem->function(src, results[in.slot], conditions[in.slot]);
+         }
+      }
+
+      if (g.multi_slot) {
+         std::array<const AluInterpreter::Semantics *, 5> sem = {};
+         for (unsigned i = g.first; i < g.end; ++i)
+            sem[m_code[i].slot] = m_code[i].sem;
+         AluInterpreter::combine_slots(sem, results);
+      }
+
+      LaneMask active = wf.active();
+      LaneMask pred = wf.predicate();
+      LaneMask new_pred = pred;
+
+      for (unsigned i = g.first; i < g.end; ++i) {
+         const Instr& in = m_code[i];
+         if (!in.sem)
+            continue;
+         Lanes& result = results[in.slot];
+
+         if (in.sem->float_result && (in.omod != AluNode::omod_off || in.clamp))
+            AluInterpreter::apply_omod_clamp(result, in.omod, in.clamp);
+
+         LaneMask mask = active;
+         if (in.pred_select == AluNode::pred_sel_zero)
+            mask &= ~pred;
+         else if (in.pred_select == AluNode::pred_sel_one)
+            mask &= pred;
+
+         switch (in.sem->kind) {
+         case AluInterpreter::sk_predicate:
+            if (in.update_pred)
+               new_pred = (new_pred & ~active) |
+                          (conditions[in.slot] & active);
+            if (in.update_exec) {
+               exec = conditions[in.slot] & active;
+               exec_updated = true;
+            }
+            break;
+         case AluInterpreter::sk_kill:
+            killed |= conditions[in.slot] & active;
+            break;
+         case AluInterpreter::sk_mova:
+            for (unsigned l = 0; l < wavefront_size; ++l)
+               if (mask & (LaneMask(1) << l))
+                  wf.ar()[l] = result[l];
+            break;
+         default:
+            ;
+         }
+
+         if (!in.write)
+            continue;
+
+         if (!in.dst_rel) {
+            Lanes& r = wf.gpr(in.dst_sel, in.dst_chan);
+            if (mask == ~LaneMask(0)) {
+               r = result;
+            } else {
+               for (unsigned l = 0; l < wavefront_size; ++l)
+                  if (mask & (LaneMask(1) << l))
+                     r[l] = result[l];
+            }
+         } else {
+            for (unsigned l = 0; l < wavefront_size; ++l) {
+               if (!(mask & (LaneMask(1) << l)))
+                  continue;
+               int sel = in.dst_sel + index(in.loop_relative, wf, l);
+               if (sel >= 0 && sel < static_cast<int>(Wavefront::ngprs))
+                  wf.gpr(sel, in.dst_chan)[l] = result[l];
+            }
+         }
+      }
+
+      for (unsigned i = g.first; i < g.end; ++i)
+         if (m_code[i].sem)
+            wf.pv(m_code[i].slot) = results[m_code[i].slot];
+      wf.set_predicate(new_pred);
+
+      for (unsigned i = g.first; i < g.end; ++i) {
+         const Instr& in = m_code[i];
+         if (in.sem)
+            continue;
+         const Lanes *src[3] = {nullptr, nullptr, nullptr};
+         for (unsigned k = 0; k < 3; ++k)
+            src[k] = &lds_src[in.slot][k];
+         wf.lds()->execute(in.lds_op, in.lds_offset, src, active, wf);
+      }
+   }
+
+   if (exec_updated)
+      wf.set_active(exec);
+   wf.kill(killed);
+}
+
+}
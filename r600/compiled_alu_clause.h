@@ -0,0 +1,141 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_compiled_alu_clause_h
+#define r600_compiled_alu_clause_h
+
+#include <r600/alu_interpreter.h>
+#include <r600/alu_jit.h>
+
+#include <memory>
+#include <vector>
+
+namespace r600 {
+
+/* An ALU clause lowered once for repeated execution.
+ *
+ * The instructions are translated into a flat array of records that
+ * hold the function that evaluates the opcode, the resolved register
+ * file indices of the operands, and the flags that the AluInterpreter
+ * looks up through the node objects on every execution. Literals and
+ * inline constants are expanded to lane arrays at compile time with
+ * their abs and neg modifiers already applied, the modifiers of the
+ * other operands are reduced to an and/xor mask.
+ *
+ * LDS instructions and reads from the LDS output queues are executed
+ * like in the AluInterpreter, GROUP_BARRIER is skipped.
+ *
+ * Optionally, the groups that only use ops and sources that the AluJit
+ * supports are translated to native code, the other groups are still
+ * executed through the instruction records.
+ *
+ * Running the compiled clause gives the same results as
+ * AluInterpreter::run.
+ */
+class CompiledAluClause {
+public:
+   /* Throws std::runtime_error if the clause holds an instruction or a
+    * source that the AluInterpreter does not support */
+   CompiledAluClause(const CFAluNode& alu, bool native = false);
+
+   void run(Wavefront& wf) const;
+
+   unsigned ngroups() const;
+   unsigned ninstructions() const;
+
+   /* Number of groups that are executed as native code */
+   unsigned nnative_groups() const;
+
+private:
+   enum EOperandKind {
+      ok_gpr,
+      ok_gpr_rel,
+      ok_pv,
+      ok_uniform,
+      ok_const,
+      ok_const_rel,
+      ok_loop_index,
+      ok_mask_lo,
+      ok_mask_hi,
+      ok_lds_queue
+   };
+
+   struct Operand {
+      EOperandKind kind;
+      /* register file index, PV slot, uniform index, constant index, or
+       * LDS output queue source */
+      unsigned index;
+      unsigned chan;
+      unsigned buffer;
+      bool loop_relative;
+      bool modified;
+      uint32_t and_mask;
+      uint32_t xor_mask;
+   };
+
+   struct Instr {
+      /* null for LDS instructions */
+      const AluInterpreter::Semantics *sem;
+      ESDOp lds_op;
+      int lds_offset;
+      unsigned slot;
+      unsigned nsrc;
+      Operand src[3];
+      bool write;
+      unsigned dst_sel;
+      unsigned dst_chan;
+      bool dst_rel;
+      bool loop_relative;
+      AluNode::EPredSelect pred_select;
+      AluNode::EOutputModify omod;
+      bool clamp;
+      bool update_pred;
+      bool update_exec;
+   };
+
+   struct Group {
+      unsigned first;
+      unsigned end;
+      bool multi_slot;
+      int jit_id;
+      AluJit::Function native;
+   };
+
+   Operand lower(const AluNode& n, const Value& v);
+   int add_native(const Group& g, const std::vector<EAluOp>& ops);
+   const Lanes& fetch(const Operand& op, Wavefront& wf,
+                      Lanes& scratch) const;
+   static int index(bool loop_relative, const Wavefront& wf, unsigned lane);
+
+   std::vector<Instr> m_code;
+   std::vector<Group> m_groups;
+   std::vector<Lanes> m_uniforms;
+   std::unique_ptr<AluJit> m_jit;
+   /* the sources of the native groups, resolved before each run */
+   std::vector<Operand> m_table;
+   unsigned m_nconst_table;
+   unsigned m_kcache_bank[4];
+   unsigned m_kcache_addr[4];
+};
+
+}
+
+#endif
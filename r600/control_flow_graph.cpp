@@ -0,0 +1,528 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/control_flow_graph.h>
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace r600 {
+
+static const CFNativeNode *as_native(const CFNode *n)
+{
+   if (dynamic_cast<const CFFetchNode *>(n))
+      return nullptr;
+   return dynamic_cast<const CFNativeNode *>(n);
+}
+
+ControlFlowGraph::ControlFlowGraph(const disassembler& program)
+{
+   const auto& prog = program.get_program();
+
+   unsigned cf_addr = 0;
+   for (const auto& n: prog) {
+      m_cf_addr.push_back(cf_addr);
+      cf_addr += n->bytecode_size();
+   }
+
+   /* Branch targets are looked up by address in a dense table */
+   m_index_of.resize(cf_addr + 1);
+   unsigned index = 0;
+   for (unsigned a = 0; a <= cf_addr; ++a) {
+      while (index < m_cf_addr.size() && m_cf_addr[index] < a)
+         ++index;
+      m_index_of[a] = index;
+   }
+
+   std::vector<int> innermost(prog.size(), -1);
+   find_loops(prog, innermost);
+
+   EdgeList edges;
+   std::vector<bool> leader(prog.size(), false);
+   add_edges(prog, innermost, edges, leader);
+
+   build_blocks(leader, innermost);
+   build_edges(edges);
+   compute_dominators();
+}
+
+unsigned ControlFlowGraph::index_of(unsigned addr) const
+{
+   return addr < m_index_of.size() ? m_index_of[addr] : m_cf_addr.size();
+}
+
+void ControlFlowGraph::find_loops(const std::vector<CFNode::pointer>& program,
+                                  std::vector<int>& innermost)
+{
+   std::vector<unsigned> open;
+
+   for (unsigned i = 0; i < program.size(); ++i) {
+      auto n = as_native(program[i].get());
+      innermost[i] = open.empty() ? -1 : open.back();
+      if (!n)
+         continue;
+
+      switch (n->opcode()) {
+      case cf_loop_start:
+      case cf_loop_start_dx10:
+      case cf_loop_start_no_al: {
+         int parent = open.empty() ? -1 : open.back();
+         open.push_back(m_loops.size());
+         m_loops.push_back({i, i, 0, parent,
+                            static_cast<unsigned>(open.size())});
+         break;
+      }
+      case cf_loop_end:
+         if (open.empty())
+            throw std::runtime_error("LOOP_END without LOOP_START");
+         m_loops[open.back()].end_cf = i;
+         open.pop_back();
+         break;
+      default:
+         ;
+      }
+   }
+   if (!open.empty())
+      throw std::runtime_error("LOOP_START without LOOP_END");
+}
+
+void ControlFlowGraph::add_edges(const std::vector<CFNode::pointer>& program,
+                                 const std::vector<int>& innermost,
+                                 EdgeList& edges,
+                                 std::vector<bool>& leader) const
+{
+   std::vector<std::pair<unsigned, unsigned>> calls;
+   std::vector<unsigned> returns;
+   const unsigned size = program.size();
+
+   auto branch = [&](unsigned from, unsigned to) {
+      if (to < size) {
+         edges.push_back({from, to});
+         leader[to] = true;
+      }
+      if (from + 1 < size)
+         leader[from + 1] = true;
+   };
+
+   if (size)
+      leader[0] = true;
+
+   for (unsigned i = 0; i < size; ++i) {
+      const CFNode *node = program[i].get();
+      bool falls_through = !node->test_flag(CFNode::eop);
+      int loop = innermost[i];
+
+      if (auto alu = dynamic_cast<const CFAluNode *>(node)) {
+         switch (alu->opcode() >> 4) {
+         case cf_alu_break:
+            if (loop >= 0)
+               branch(i, m_loops[loop].end_cf + 1);
+            break;
+         case cf_alu_continue:
+            if (loop >= 0)
+               branch(i, m_loops[loop].end_cf);
+            break;
+         default:
+            ;
+         }
+      } else if (auto n = as_native(node)) {
+         switch (n->opcode()) {
+         case cf_jump:
+         case cf_push:
+         case cf_else:
+            branch(i, index_of(n->address()));
+            break;
+         case cf_loop_start:
+         case cf_loop_start_dx10:
+         case cf_loop_start_no_al:
+            /* skips the loop, the address points behind LOOP_END */
+         case cf_loop_end:
+            /* back edge, the address points at the loop body */
+            branch(i, index_of(n->address()));
+            break;
+         case cf_loop_break:
+            if (loop >= 0)
+               branch(i, m_loops[loop].end_cf + 1);
+            break;
+         case cf_loop_continue:
+            if (loop >= 0)
+               branch(i, m_loops[loop].end_cf);
+            break;
+         case cf_call:
+         case cf_call_fs: {
+            unsigned target = index_of(n->address());
+            if (target < size) {
+               branch(i, target);
+               calls.push_back({i, target});
+               falls_through = false;
+            }
+            break;
+         }
+         case cf_return:
+            returns.push_back(i);
+            falls_through = false;
+            if (i + 1 < size)
+               leader[i + 1] = true;
+            break;
+         case cf_halt:
+            falls_through = false;
+            if (i + 1 < size)
+               leader[i + 1] = true;
+            break;
+         default:
+            ;
+         }
+      }
+
+      if (falls_through && i + 1 < size)
+         edges.push_back({i, i + 1});
+   }
+
+   /* A RETURN belongs to the subroutine with the closest preceding call
+    * target and goes back to the call sites of that subroutine only. The
+    * call sites are kept per target in compressed row form, so every
+    * RETURN edge is added exactly once. */
+   std::vector<unsigned> call_start(size + 1, 0);
+   for (const auto& c: calls)
+      ++call_start[c.second + 1];
+   for (unsigned i = 0; i < size; ++i)
+      call_start[i + 1] += call_start[i];
+   std::vector<unsigned> call_sites(calls.size());
+   std::vector<unsigned> fill(call_start.begin(), call_start.end() - 1);
+   for (const auto& c: calls)
+      call_sites[fill[c.second]++] = c.first;
+
+   int subroutine = -1;
+   auto r = returns.begin();
+   for (unsigned i = 0; i < size && r != returns.end(); ++i) {
+      if (call_start[i + 1] > call_start[i])
+         subroutine = i;
+      if (*r != i)
+         continue;
+      ++r;
+      if (subroutine < 0)
+         continue;
+      for (unsigned k = call_start[subroutine];
+           k < call_start[subroutine + 1]; ++k) {
+         unsigned site = call_sites[k] + 1;
+         if (site < size) {
+            edges.push_back({i, site});
+            leader[site] = true;
+         }
+      }
+   }
+}
+
+void ControlFlowGraph::build_blocks(const std::vector<bool>& leader,
+                                    const std::vector<int>& innermost)
+{
+   m_block_of.resize(leader.size());
+   for (unsigned i = 0; i < leader.size(); ++i) {
+      if (leader[i]) {
+         if (!m_blocks.empty())
+            m_blocks.back().end = i;
+         m_blocks.push_back({i, i});
+         m_block_loop.push_back(innermost[i]);
+      }
+      m_block_of[i] = m_blocks.size() - 1;
+   }
+   if (!m_blocks.empty())
+      m_blocks.back().end = leader.size();
+
+   for (auto& l: m_loops)
+      l.header = l.start_cf + 1 < m_block_of.size() ?
+                    m_block_of[l.start_cf + 1] : m_block_of[l.start_cf];
+}
+
+void ControlFlowGraph::build_edges(const EdgeList& edges)
+{
+   const unsigned n = m_blocks.size();
+   EdgeList block_edges;
+
+   for (const auto& e: edges) {
+      unsigned to = m_block_of[e.second];
+      /* fall through inside of a block */
+      if (m_blocks[to].first != e.second)
+         continue;
+      block_edges.push_back({m_block_of[e.first], to});
+   }
+
+   /* The edges are bucketed by source block, and duplicates, e.g. from a
+    * branch to the next instruction, are dropped in the same pass by
+    * marking the targets already seen for the current block */
+   m_succ_start.assign(n + 1, 0);
+   for (const auto& e: block_edges)
+      ++m_succ_start[e.first + 1];
+   for (unsigned b = 0; b < n; ++b)
+      m_succ_start[b + 1] += m_succ_start[b];
+
+   std::vector<unsigned> succ(block_edges.size());
+   std::vector<unsigned> fill(m_succ_start.begin(), m_succ_start.end() - 1);
+   for (const auto& e: block_edges)
+      succ[fill[e.first]++] = e.second;
+
+   std::vector<unsigned> mark(n, n);
+   unsigned out = 0;
+   unsigned begin = 0;
+   for (unsigned b = 0; b < n; ++b) {
+      unsigned end = m_succ_start[b + 1];
+      m_succ_start[b] = out;
+      for (unsigned i = begin; i < end; ++i)
+         if (mark[succ[i]] != b) {
+            mark[succ[i]] = b;
+            succ[out++] = succ[i];
+         }
+      begin = end;
+   }
+   m_succ_start[n] = out;
+   succ.resize(out);
+
+   /* Transposing visits the source blocks in ascending order, so the
+    * predecessor lists come out sorted, and transposing them back sorts
+    * the successor lists */
+   auto transpose = [n](const std::vector<unsigned>& start,
+                        const std::vector<unsigned>& list,
+                        std::vector<unsigned>& tstart,
+                        std::vector<unsigned>& tlist) {
+      tstart.assign(n + 1, 0);
+      for (auto t: list)
+         ++tstart[t + 1];
+      for (unsigned b = 0; b < n; ++b)
+         tstart[b + 1] += tstart[b];
+      tlist.resize(list.size());
+      std::vector<unsigned> tfill(tstart.begin(), tstart.end() - 1);
+      for (unsigned b = 0; b < n; ++b)
+         for (unsigned i = start[b]; i < start[b + 1]; ++i)
+            tlist[tfill[list[i]]++] = b;
+   };
+   transpose(m_succ_start, succ, m_pred_start, m_pred);
+   transpose(m_pred_start, m_pred, m_succ_start, m_succ);
+}
+
+void ControlFlowGraph::compute_dominators()
+{
+   const unsigned n = m_blocks.size();
+   m_idom.assign(n, -1);
+   m_dom_pre.assign(n, 0);
+   m_dom_post.assign(n, 0);
+   if (!n)
+      return;
+
+   /* Iterative depth first search for the post order */
+   std::vector<unsigned> post;
+   std::vector<bool> visited(n, false);
+   std::vector<std::pair<unsigned, unsigned>> stack;
+   stack.push_back({0, 0});
+   visited[0] = true;
+   while (!stack.empty()) {
+      auto& top = stack.back();
+      if (top.second < nsuccessors(top.first)) {
+         unsigned s = successor(top.first, top.second++);
+         if (!visited[s]) {
+            visited[s] = true;
+            stack.push_back({s, 0});
+         }
+      } else {
+         post.push_back(top.first);
+         stack.pop_back();
+      }
+   }
+   m_rpo.assign(post.rbegin(), post.rend());
+
+   std::vector<unsigned> po_number(n, 0);
+   for (unsigned i = 0; i < post.size(); ++i)
+      po_number[post[i]] = i;
+
+   auto intersect = [&](unsigned a, unsigned b) {
+      while (a != b) {
+         while (po_number[a] < po_number[b])
+            a = m_idom[a];
+         while (po_number[b] < po_number[a])
+            b = m_idom[b];
+      }
+      return a;
+   };
+
+   /* The entry temporarily dominates itself to terminate intersect */
+   m_idom[0] = 0;
+   bool changed = true;
+   while (changed) {
+      changed = false;
+      for (auto b: m_rpo) {
+         if (b == 0)
+            continue;
+         int new_idom = -1;
+         for (unsigned i = 0; i < npredecessors(b); ++i) {
+            unsigned p = predecessor(b, i);
+            if (m_idom[p] < 0)
+               continue;
+            new_idom = new_idom < 0 ? p : intersect(p, new_idom);
+         }
+         if (new_idom != m_idom[b]) {
+            m_idom[b] = new_idom;
+            changed = true;
+         }
+      }
+   }
+   m_idom[0] = -1;
+
+   /* Number the dominator tree so that dominance queries are constant
+    * time; the tree children are kept in compressed row form */
+   std::vector<unsigned> child_start(n + 1, 0);
+   for (unsigned b = 0; b < n; ++b)
+      if (m_idom[b] >= 0)
+         ++child_start[m_idom[b] + 1];
+   for (unsigned b = 0; b < n; ++b)
+      child_start[b + 1] += child_start[b];
+   std::vector<unsigned> children(child_start[n]);
+   std::vector<unsigned> fill(child_start.begin(), child_start.end() - 1);
+   for (unsigned b = 0; b < n; ++b)
+      if (m_idom[b] >= 0)
+         children[fill[m_idom[b]]++] = b;
+
+   unsigned counter = 0;
+   stack.clear();
+   stack.push_back({0, child_start[0]});
+   m_dom_pre[0] = counter++;
+   while (!stack.empty()) {
+      auto& top = stack.back();
+      if (top.second < child_start[top.first + 1]) {
+         unsigned c = children[top.second++];
+         m_dom_pre[c] = counter++;
+         stack.push_back({c, child_start[c]});
+      } else {
+         m_dom_post[top.first] = counter++;
+         stack.pop_back();
+      }
+   }
+}
+
+unsigned ControlFlowGraph::nblocks() const
+{
+   return m_blocks.size();
+}
+
+const ControlFlowGraph::Block& ControlFlowGraph::block(unsigned b) const
+{
+   assert(b < m_blocks.size());
+   return m_blocks[b];
+}
+
+unsigned ControlFlowGraph::block_of(unsigned cf_index) const
+{
+   assert(cf_index < m_block_of.size());
+   return m_block_of[cf_index];
+}
+
+unsigned ControlFlowGraph::cf_address(unsigned cf_index) const
+{
+   assert(cf_index < m_cf_addr.size());
+   return m_cf_addr[cf_index];
+}
+
+unsigned ControlFlowGraph::nsuccessors(unsigned b) const
+{
+   return m_succ_start[b + 1] - m_succ_start[b];
+}
+
+unsigned ControlFlowGraph::successor(unsigned b, unsigned i) const
+{
+   assert(i < nsuccessors(b));
+   return m_succ[m_succ_start[b] + i];
+}
+
+unsigned ControlFlowGraph::npredecessors(unsigned b) const
+{
+   return m_pred_start[b + 1] - m_pred_start[b];
+}
+
+unsigned ControlFlowGraph::predecessor(unsigned b, unsigned i) const
+{
+   assert(i < npredecessors(b));
+   return m_pred[m_pred_start[b] + i];
+}
+
+int ControlFlowGraph::idom(unsigned b) const
+{
+   return m_idom[b];
+}
+
+bool ControlFlowGraph::reachable(unsigned b) const
+{
+   return b == 0 || m_idom[b] >= 0;
+}
+
+bool ControlFlowGraph::dominates(unsigned a, unsigned b) const
+{
+   if (!reachable(a) || !reachable(b))
+      return false;
+   return m_dom_pre[a] <= m_dom_pre[b] && m_dom_post[b] <= m_dom_post[a];
+}
+
+const std::vector<unsigned>& ControlFlowGraph::reverse_post_order() const
+{
+   return m_rpo;
+}
+
+const std::vector<ControlFlowGraph::Loop>& ControlFlowGraph::loops() const
+{
+   return m_loops;
+}
+
+int ControlFlowGraph::loop_of(unsigned b) const
+{
+   return m_block_loop[b];
+}
+
+unsigned ControlFlowGraph::loop_depth(unsigned b) const
+{
+   return m_block_loop[b] < 0 ? 0 : m_loops[m_block_loop[b]].depth;
+}
+
+void ControlFlowGraph::print(std::ostream& os) const
+{
+   for (unsigned b = 0; b < m_blocks.size(); ++b) {
+      os << "BB" << b << ": CF " << m_cf_addr[m_blocks[b].first];
+      if (m_blocks[b].end - m_blocks[b].first > 1)
+         os << "-" << m_cf_addr[m_blocks[b].end - 1];
+      os << " ->";
+      for (unsigned i = 0; i < nsuccessors(b); ++i)
+         os << " BB" << successor(b, i);
+      os << " idom ";
+      if (m_idom[b] < 0)
+         os << "-";
+      else
+         os << "BB" << m_idom[b];
+      os << " loop depth " << loop_depth(b) << "\n";
+   }
+
+   for (unsigned l = 0; l < m_loops.size(); ++l) {
+      os << "loop " << l << ": CF " << m_cf_addr[m_loops[l].start_cf]
+         << "-" << m_cf_addr[m_loops[l].end_cf] << " header BB"
+         << m_loops[l].header;
+      if (m_loops[l].parent >= 0)
+         os << " in loop " << m_loops[l].parent;
+      os << "\n";
+   }
+}
+
+}
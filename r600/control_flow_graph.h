@@ -0,0 +1,130 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_control_flow_graph_h
+#define r600_control_flow_graph_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Control flow graph of the CF program.
+ *
+ * Basic blocks are ranges of CF instructions, identified by their index
+ * in disassembler::get_program(). Edges are added for JUMP, PUSH, ELSE,
+ * the loop instructions including ALU_BREAK and ALU_CONTINUE, CALL, and
+ * RETURN; a RETURN has an edge to every instruction that follows a CALL
+ * of its subroutine. Instructions with the EOP flag and HALT end the
+ * program.
+ *
+ * All data is kept in flat arrays, edges in compressed row form sorted
+ * by block, and the graph is built in time linear in the number of CF
+ * instructions and edges. The dominators are computed with the iterative
+ * algorithm by Cooper, Harvey and Kennedy, which converges after two
+ * passes over the reducible graphs the structured CF code creates.
+ */
+class ControlFlowGraph {
+public:
+   struct Block {
+      /* CF instruction index range [first, end) */
+      unsigned first;
+      unsigned end;
+   };
+
+   struct Loop {
+      unsigned start_cf;
+      unsigned end_cf;
+      unsigned header;
+      int parent;
+      unsigned depth;
+   };
+
+   ControlFlowGraph(const disassembler& program);
+
+   unsigned nblocks() const;
+   const Block& block(unsigned b) const;
+   unsigned block_of(unsigned cf_index) const;
+   unsigned cf_address(unsigned cf_index) const;
+
+   /* Index of the first CF instruction at or after the address */
+   unsigned index_of(unsigned addr) const;
+
+   unsigned nsuccessors(unsigned b) const;
+   unsigned successor(unsigned b, unsigned i) const;
+   unsigned npredecessors(unsigned b) const;
+   unsigned predecessor(unsigned b, unsigned i) const;
+
+   /* Immediate dominator, -1 for the entry and unreachable blocks */
+   int idom(unsigned b) const;
+   bool dominates(unsigned a, unsigned b) const;
+   bool reachable(unsigned b) const;
+
+   /* Reverse post order of the reachable blocks */
+   const std::vector<unsigned>& reverse_post_order() const;
+
+   /* Loops in program order, i.e. outer loops come before the loops
+    * they contain */
+   const std::vector<Loop>& loops() const;
+
+   /* Innermost loop containing the block, -1 if it is not in a loop */
+   int loop_of(unsigned b) const;
+   unsigned loop_depth(unsigned b) const;
+
+   void print(std::ostream& os) const;
+
+private:
+   using EdgeList = std::vector<std::pair<unsigned, unsigned>>;
+
+   void find_loops(const std::vector<CFNode::pointer>& program,
+                   std::vector<int>& innermost);
+   void add_edges(const std::vector<CFNode::pointer>& program,
+                  const std::vector<int>& innermost,
+                  EdgeList& edges, std::vector<bool>& leader) const;
+   void build_blocks(const std::vector<bool>& leader,
+                     const std::vector<int>& innermost);
+   void build_edges(const EdgeList& edges);
+   void compute_dominators();
+
+   std::vector<unsigned> m_cf_addr;
+   std::vector<unsigned> m_index_of;
+   std::vector<Block> m_blocks;
+   std::vector<unsigned> m_block_of;
+
+   std::vector<unsigned> m_succ_start;
+   std::vector<unsigned> m_succ;
+   std::vector<unsigned> m_pred_start;
+   std::vector<unsigned> m_pred;
+
+   std::vector<unsigned> m_rpo;
+   std::vector<int> m_idom;
+   std::vector<unsigned> m_dom_pre;
+   std::vector<unsigned> m_dom_post;
+
+   std::vector<Loop> m_loops;
+   std::vector<int> m_block_loop;
+};
+
+}
+
+#endif
@@ -0,0 +1,365 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/dead_write_analysis.h>
+
+#include <iostream>
+#include <cassert>
+
+namespace r600 {
+
+/* GPRs 124-127 are clause temporaries, they don't survive the clause */
+static const unsigned first_clause_temp = 124;
+
+static unsigned gpr_key(unsigned sel, unsigned chan)
+{
+   return sel * 4 + chan;
+}
+
+/* ALU clauses that change the execution mask or leave the clause
+ * flow after the last instruction */
+static bool alu_clause_ends_block(uint32_t alu_opcode)
+{
+   switch (alu_opcode) {
+   case cf_alu_pop_after:
+   case cf_alu_pop2_after:
+   case cf_alu_continue:
+   case cf_alu_break:
+   case cf_alu_else_after:
+      return true;
+   default:
+      return false;
+   }
+}
+
+DeadWriteAnalysis::DeadWriteAnalysis(const disassembler& program):
+   m_ps(-1),
+   m_total_slots(0)
+{
+   m_pending.fill(-1);
+   m_pv.fill(-1);
+
+   unsigned cf_addr = 0;
+   bool end_of_program = false;
+
+   for (const auto& n: program.get_program()) {
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      if (alu) {
+         analyse_clause(cf_addr, *alu);
+         if (alu_clause_ends_block(alu->opcode() >> 4))
+            escape_all();
+      } else {
+         auto mem = dynamic_cast<const CFMemNode *>(n.get());
+         auto rat = dynamic_cast<const CFRatNode *>(n.get());
+         auto native = dynamic_cast<const CFNativeNode *>(n.get());
+
+         /* Control flow may leave the block, fetch clauses and RAT
+          * instructions with return values read and write GPRs that
+          * are not tracked */
+         if (mem && !rat && !mem->test_flag(CFNode::rw_rel))
+            read_exported(*mem);
+         else if (!native || native->opcode() != cf_nop)
+            escape_all();
+      }
+
+      if (n->test_flag(CFNode::eop)) {
+         end_of_program = true;
+         break;
+      }
+      cf_addr += n->bytecode_size();
+   }
+
+   for (unsigned key = 0; key < nkeys; ++key) {
+      if (end_of_program)
+         discard(key);
+      else
+         escape(key);
+   }
+
+   for (const auto& w: m_writes) {
+      if (!w.removable)
+         continue;
+
+      if (w.identity)
+         m_findings.push_back({w.cf_addr, w.group, w.slot, w.sel, w.chan,
+                               dw_identity_mov, false});
+      else if (!w.read)
+         m_findings.push_back({w.cf_addr, w.group, w.slot, w.sel, w.chan,
+                               dw_dead_write, false});
+      else if (w.is_mov && w.copy_ok)
+         m_findings.push_back({w.cf_addr, w.group, w.slot, w.sel, w.chan,
+                               dw_redundant_mov, w.chain});
+   }
+}
+
+const std::vector<DeadWriteAnalysis::Finding>&
+DeadWriteAnalysis::findings() const
+{
+   return m_findings;
+}
+
+unsigned DeadWriteAnalysis::total_slots() const
+{
+   return m_total_slots;
+}
+
+unsigned DeadWriteAnalysis::wasted_slots() const
+{
+   return m_findings.size();
+}
+
+void DeadWriteAnalysis::analyse_clause(unsigned cf_addr, const CFAluNode& alu)
+{
+   unsigned gidx = 0;
+   for (const auto& g: alu.clause())
+      analyse_group(cf_addr, gidx++, g);
+
+   for (unsigned sel = first_clause_temp; sel < 128; ++sel)
+      for (unsigned chan = 0; chan < 4; ++chan)
+         discard(gpr_key(sel, chan));
+
+   m_pv.fill(-1);
+   m_ps = -1;
+}
+
+void DeadWriteAnalysis::analyse_group(unsigned cf_addr, unsigned gidx,
+                                      const AluGroup& group)
+{
+   /* All sources of a group are read before any result is written */
+   for (unsigned s = 0; s < 5; ++s) {
+      auto node = group.slot(s);
+      if (!node)
+         continue;
+
+      ++m_total_slots;
+
+      for (unsigned i = 0; i < node->nsources(); ++i) {
+         auto v = node->get_src(i);
+         if (!v)
+            continue;
+
+         if (v->type() == Value::gpr) {
+            if (v->rel())
+               read_relative(v->chan());
+            else
+               read(gpr_key(v->sel(), v->chan()));
+         } else if (v->type() == Value::cinline) {
+            if (v->sel() == ALU_SRC_PV)
+               use(m_pv[v->chan()]);
+            else if (v->sel() == ALU_SRC_PS)
+               use(m_ps);
+         }
+      }
+   }
+
+   std::array<int, 5> results;
+   results.fill(-1);
+   struct PendingWrite {
+      int idx;
+      bool conditional;
+   };
+   std::vector<PendingWrite> writes;
+   bool mask_changed = false;
+
+   for (unsigned s = 0; s < 5; ++s) {
+      auto node = group.slot(s);
+      if (!node)
+         continue;
+
+      if (node->test_flag(AluNode::do_update_exec_mask) ||
+          is_kill_op(node->opcode()))
+         mask_changed = true;
+
+      auto n = dynamic_cast<const AluNodeWithDst *>(node.get());
+      if (!n)
+         continue;
+
+      const auto& dst = n->dst();
+      Write w = {cf_addr, gidx, s,
+                 static_cast<unsigned>(dst.sel()),
+                 static_cast<unsigned>(dst.chan()),
+                 dst.rel(), false, false, false, false, false, false, false, 0};
+
+      bool conditional = n->pred_select() != AluNode::pred_sel_off;
+      bool plain = !conditional && !dst.rel() && !n->test_flag(AluNode::do_clamp);
+
+      w.removable = plain && n->writes_dst() && !n->has_side_effects() &&
+                    !is_multi_slot_op(n->opcode());
+
+      if (w.removable && n->opcode() == op2_mov) {
+         auto op2 = static_cast<const AluNodeOp2 *>(n);
+         auto src = n->get_src(0);
+         if (op2->output_modify() == AluNode::omod_off &&
+             src->type() == Value::gpr && !src->rel() &&
+             !src->abs() && !src->neg()) {
+            w.is_mov = true;
+            w.copy_ok = true;
+            w.src_key = gpr_key(src->sel(), src->chan());
+            w.identity = w.src_key == gpr_key(w.sel, w.chan);
+            int src_def = m_pending[w.src_key];
+            w.chain = src_def >= 0 && m_writes[src_def].is_mov;
+         }
+      }
+
+      int idx = m_writes.size();
+      m_writes.push_back(w);
+      results[s] = idx;
+
+      if (n->writes_dst())
+         writes.push_back(PendingWrite{idx, conditional});
+   }
+
+   for (const auto& pw: writes) {
+      const auto& w = m_writes[pw.idx];
+      if (!w.relative)
+         write(gpr_key(w.sel, w.chan), pw.idx, pw.conditional);
+   }
+
+   for (const auto& pw: writes) {
+      const auto& w = m_writes[pw.idx];
+      if (w.relative)
+         write_relative(w.chan);
+      else
+         clobber(gpr_key(w.sel, w.chan));
+   }
+
+   for (unsigned i = 0; i < 4; ++i)
+      m_pv[i] = results[i];
+   m_ps = results[4];
+
+   /* Lanes that are switched off keep their old values */
+   if (mask_changed)
+      escape_all();
+}
+
+void DeadWriteAnalysis::use(int idx)
+{
+   if (idx < 0)
+      return;
+
+   auto& w = m_writes[idx];
+   w.read = true;
+   if (w.is_mov && w.src_clobbered)
+      w.copy_ok = false;
+}
+
+void DeadWriteAnalysis::read(unsigned key)
+{
+   use(m_pending[key]);
+}
+
+void DeadWriteAnalysis::read_fixed(unsigned key)
+{
+   int idx = m_pending[key];
+   if (idx >= 0) {
+      use(idx);
+      m_writes[idx].copy_ok = false;
+   }
+}
+
+void DeadWriteAnalysis::read_exported(const CFMemNode& mem)
+{
+   for (int i = 0; i <= mem.get_burst_count(); ++i)
+      for (unsigned chan = 0; chan < 4; ++chan)
+         read_fixed(gpr_key((mem.rw_gpr() + i) & 0x7f, chan));
+
+   if (mem.is_indexed())
+      for (unsigned chan = 0; chan < 4; ++chan)
+         read_fixed(gpr_key(mem.index_gpr(), chan));
+}
+
+void DeadWriteAnalysis::read_relative(unsigned chan)
+{
+   for (unsigned sel = 0; sel < 128; ++sel)
+      read_fixed(gpr_key(sel, chan));
+}
+
+void DeadWriteAnalysis::write(unsigned key, int idx, bool conditional)
+{
+   /* With a predicated write the old value may survive */
+   if (conditional)
+      escape(key);
+
+   m_pending[key] = idx;
+}
+
+void DeadWriteAnalysis::write_relative(unsigned chan)
+{
+   for (unsigned sel = 0; sel < 128; ++sel) {
+      unsigned key = gpr_key(sel, chan);
+      escape(key);
+      clobber(key);
+   }
+}
+
+void DeadWriteAnalysis::clobber(unsigned key)
+{
+   for (auto idx: m_pending) {
+      if (idx < 0)
+         continue;
+      auto& w = m_writes[idx];
+      if (w.is_mov && w.src_key == key)
+         w.src_clobbered = true;
+   }
+}
+
+void DeadWriteAnalysis::escape(unsigned key)
+{
+   read_fixed(key);
+   m_pending[key] = -1;
+}
+
+void DeadWriteAnalysis::escape_all()
+{
+   for (unsigned key = 0; key < nkeys; ++key)
+      escape(key);
+
+   m_pv.fill(-1);
+   m_ps = -1;
+}
+
+void DeadWriteAnalysis::discard(unsigned key)
+{
+   m_pending[key] = -1;
+}
+
+void DeadWriteAnalysis::print(std::ostream& os) const
+{
+   static const char slot_names[] = "xyzwt";
+
+   for (const auto& f: m_findings) {
+      os << "CF " << f.cf_addr << " group " << f.group
+         << " slot " << slot_names[f.slot] << ": ";
+      switch (f.kind) {
+      case dw_dead_write: os << "dead write "; break;
+      case dw_redundant_mov: os << "redundant MOV "; break;
+      case dw_identity_mov: os << "identity MOV "; break;
+      }
+      os << GPRValue(f.sel, f.chan, false, false, false);
+      if (f.chain)
+         os << " (chain)";
+      os << "\n";
+   }
+   os << wasted_slots() << " of " << m_total_slots
+      << " ALU slots wasted\n";
+}
+
+}
@@ -0,0 +1,129 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_dead_write_analysis_h
+#define r600_dead_write_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <array>
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Finds ALU instructions that waste an instruction slot because their
+ * result is never used.
+ *
+ * The analysis follows the register writes in program order and reports
+ * results that are overwritten or discarded before they are read, as well
+ * as MOVs whose readers could read the source register directly, i.e.
+ * that copy propagation would remove.
+ *
+ * Only straight-line code is tracked: at control flow instructions, at
+ * changes of the execution mask, at fetch clauses, and at RAT
+ * instructions all pending results are considered to be read. Exports
+ * and memory writes read their GPR burst. Clause temporaries die at the
+ * end of their clause, and nothing is live after the end of the program.
+ */
+class DeadWriteAnalysis {
+public:
+   enum EKind {
+      /* result written to a GPR is overwritten or discarded unread */
+      dw_dead_write,
+      /* readers of the MOV result could read the source instead */
+      dw_redundant_mov,
+      /* MOV copies a register onto itself */
+      dw_identity_mov
+   };
+
+   struct Finding {
+      unsigned cf_addr;
+      unsigned group;
+      unsigned slot;
+      unsigned sel;
+      unsigned chan;
+      EKind kind;
+      /* the MOV source is itself the result of a MOV */
+      bool chain;
+   };
+
+   DeadWriteAnalysis(const disassembler& program);
+
+   const std::vector<Finding>& findings() const;
+
+   /* Number of ALU instruction slots used by the program */
+   unsigned total_slots() const;
+
+   /* Number of instruction slots that could be freed */
+   unsigned wasted_slots() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   struct Write {
+      unsigned cf_addr;
+      unsigned group;
+      unsigned slot;
+      unsigned sel;
+      unsigned chan;
+      bool relative;
+      /* the instruction can be removed if its result is unused */
+      bool removable;
+      bool read;
+      bool is_mov;
+      bool identity;
+      bool chain;
+      /* the readers of the MOV result could use the source */
+      bool copy_ok;
+      bool src_clobbered;
+      unsigned src_key;
+   };
+
+   static const unsigned nkeys = 128 * 4;
+
+   void analyse_clause(unsigned cf_addr, const CFAluNode& alu);
+   void analyse_group(unsigned cf_addr, unsigned gidx, const AluGroup& group);
+
+   void use(int idx);
+   void read(unsigned key);
+   void read_fixed(unsigned key);
+   void read_exported(const CFMemNode& mem);
+   void read_relative(unsigned chan);
+   void write(unsigned key, int idx, bool conditional);
+   void write_relative(unsigned chan);
+   void clobber(unsigned key);
+   void escape(unsigned key);
+   void escape_all();
+   void discard(unsigned key);
+
+   std::vector<Write> m_writes;
+   std::array<int, nkeys> m_pending;
+   std::array<int, 4> m_pv;
+   int m_ps;
+
+   std::vector<Finding> m_findings;
+   unsigned m_total_slots;
+};
+
+}
+
+#endif
@@ -74,6 +74,15 @@ disassembler::disassembler(const vector<uint64_t>& bc)
          cf_instr = CFNode::pointer(new CFNativeNode(*i));
          break;
       }
+      case nt_cf_gws:
+         cf_instr = CFNode::pointer(new CFGwsNode(*i));
+         break;
+      case nt_cf_fetch: {
+         auto fetch_node = new CFFetchNode(*i);
+         cf_instr = CFNode::pointer(fetch_node);
+         fetch_node->disassemble_clause(bc);
+         break;
+      }
       case nt_cf_mem_scratch:
       case nt_cf_mem_stream:
       case nt_cf_mem_ring:
@@ -141,6 +150,12 @@ disassembler::get_cf_node_type(uint64_t bc)
 
    int opcode = (bc >> 54) & 0xFF;
 
+   if (opcode == cf_tc || opcode == cf_vc || opcode == cf_gds)
+      return nt_cf_fetch;
+
+   if (opcode == cf_global_wave_sync)
+      return nt_cf_gws;
+
    if (opcode < 32)
       return nt_cf_native;
 
@@ -171,13 +186,26 @@ disassembler::get_cf_node_type(uint64_t bc)
    }
 }
 
+const std::vector<CFNode::pointer>& disassembler::get_program() const
+{
+   return program;
+}
+
 std::string disassembler::as_string() const
 {
    ostringstream os;
+   print(os, CFNode::LinePrefix());
+   return os.str();
+}
+
+void disassembler::print(std::ostream& os,
+                         const CFNode::LinePrefix& prefix) const
+{
+   unsigned address = 0;
    for (auto i: program) {
-      os << *i << "\n";
+      i->print_lines(os, address, prefix);
+      address += i->bytecode_size();
    }
-   return os.str();
 }
 
 } // ns r600
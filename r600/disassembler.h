@@ -36,9 +36,17 @@ public:
    disassembler(const std::vector<uint64_t> &bc);
 
    std::string as_string() const;
+
+   /* Print the program like as_string(), the prefix is called at the
+    * start of each line, see CFNode::LinePrefix */
+   void print(std::ostream& os, const CFNode::LinePrefix& prefix) const;
+
+   const std::vector<CFNode::pointer>& get_program() const;
 private:
    enum ECFNodeType {
       nt_cf_native,
+      nt_cf_fetch,
+      nt_cf_gws,
       nt_cf_alu,
       nt_cf_export,
       nt_cf_mem_export,
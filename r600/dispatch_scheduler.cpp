@@ -0,0 +1,529 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/dispatch_scheduler.h>
+#include <r600/local_data_share.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace r600 {
+
+using std::runtime_error;
+
+namespace {
+
+class Dispatcher;
+
+/* A workgroup of the dispatch, the wavefronts are created when the
+ * workgroup runs for the first time */
+class Workgroup : public WaveSync {
+public:
+   Workgroup(Dispatcher& dispatcher, unsigned index);
+
+   /* Run the wavefronts on the given worker, returns true when all of
+    * them ended, and false when they wait for GLOBAL_WAVE_SYNC */
+   bool run(unsigned worker);
+
+   bool group_barrier(uint32_t& ticket) override;
+   bool global_wave_sync(EGWSOpCode op, unsigned resource,
+                         unsigned value, uint32_t& ticket) override;
+
+private:
+   struct Wave {
+      std::unique_ptr<Wavefront> wf;
+      std::unique_ptr<CFEmulator> emulator;
+      DispatchScheduler::WaveInfo info;
+   };
+
+   void start();
+   void end_wave(Wave& wave);
+
+   Dispatcher& m_dispatcher;
+   unsigned m_index;
+   unsigned m_worker;
+   std::vector<Wave> m_waves;
+   std::unique_ptr<ExecutionProfile> m_profile;
+
+   /* GROUP_BARRIER: waves that arrived, and the number of barriers
+    * passed */
+   unsigned m_running;
+   unsigned m_arrived;
+   uint32_t m_generation;
+};
+
+class Dispatcher {
+public:
+   Dispatcher(const disassembler& program,
+              const DispatchScheduler::Parameters& params,
+              const DispatchScheduler::Dispatch& dispatch);
+
+   void run(unsigned nworkers, DispatchScheduler::Statistics& statistics);
+
+   bool global_wave_sync(unsigned worker, EGWSOpCode op, unsigned resource,
+                         unsigned value, uint32_t& ticket);
+
+   void merge_profile(const ExecutionProfile& profile);
+
+   const disassembler& program;
+   const DispatchScheduler::Parameters& params;
+   const DispatchScheduler::Dispatch& dispatch;
+
+private:
+   struct Task {
+      unsigned index;
+      std::unique_ptr<Workgroup> group;
+   };
+
+   struct Queue {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+   };
+
+   struct Resource {
+      int32_t counter;
+      unsigned arrived;
+      uint32_t generation;
+   };
+
+   void worker(unsigned id);
+   bool next_task(unsigned id, Task& task);
+   bool take(unsigned queue, bool steal, Task& task);
+   void push(unsigned queue, Task task);
+   void execute(unsigned id, Task& task);
+   void put_aside(unsigned id, Task task, unsigned events);
+   void changed(unsigned worker);
+   void check_deadlock();
+   void fail(std::exception_ptr error);
+   void wake_all();
+
+   std::vector<std::unique_ptr<Queue>> m_queues;
+   std::atomic<unsigned> m_queued;
+   std::mutex m_idle_mutex;
+   std::condition_variable m_idle;
+
+   /* Guards the wave sync resources, the workgroups that wait for
+    * them, and the count of workgroups that didn't end yet */
+   std::mutex m_sync_mutex;
+   std::array<Resource, 32> m_resources;
+   std::vector<Task> m_waiting;
+   std::atomic<unsigned> m_live;
+   std::atomic<unsigned> m_events;
+
+   std::atomic<unsigned> m_steals;
+   std::atomic<unsigned> m_waits;
+
+   std::mutex m_error_mutex;
+   std::atomic<bool> m_failed;
+   std::exception_ptr m_error;
+
+   std::mutex m_profile_mutex;
+};
+
+Workgroup::Workgroup(Dispatcher& dispatcher, unsigned index):
+   m_dispatcher(dispatcher),
+   m_index(index),
+   m_worker(0),
+   m_running(0),
+   m_arrived(0),
+   m_generation(0)
+{
+}
+
+void Workgroup::start()
+{
+   const auto& params = m_dispatcher.params;
+   const auto& grid = m_dispatcher.dispatch.grid;
+   const auto& size = m_dispatcher.dispatch.workgroup;
+
+   std::array<unsigned, 3> group_id = {
+      m_index % grid[0],
+      (m_index / grid[0]) % grid[1],
+      m_index / (grid[0] * grid[1])
+   };
+   unsigned nthreads = size[0] * size[1] * size[2];
+
+   auto lds = std::make_shared<LocalDataShare>(params.lds_size);
+   CFEmulator::Parameters emulator = params.emulator;
+   emulator.sync = this;
+   if (emulator.profile) {
+      m_profile.reset(new ExecutionProfile);
+      emulator.profile = m_profile.get();
+   }
+
+   for (unsigned first = 0; first < nthreads; first += wavefront_size) {
+      Wave wave;
+      unsigned n = std::min(wavefront_size, nthreads - first);
+      wave.wf.reset(new Wavefront(n));
+      wave.wf->set_lds(lds);
+      for (unsigned i = 0; i < n; ++i) {
+         unsigned t = first + i;
+         wave.wf->gpr(0, 0)[i] = t % size[0];
+         wave.wf->gpr(0, 1)[i] = (t / size[0]) % size[1];
+         wave.wf->gpr(0, 2)[i] = t / (size[0] * size[1]);
+         for (unsigned c = 0; c < 3; ++c)
+            wave.wf->gpr(1, c)[i] = group_id[c];
+      }
+      wave.info = {group_id, first / wavefront_size};
+      if (params.setup)
+         params.setup(*wave.wf, wave.info);
+      wave.emulator.reset(new CFEmulator(m_dispatcher.program, *wave.wf,
+                                         emulator));
+      m_waves.push_back(std::move(wave));
+   }
+   m_running = m_waves.size();
+}
+
+bool Workgroup::run(unsigned worker)
+{
+   m_worker = worker;
+   if (m_waves.empty())
+      start();
+
+   /* Run each wavefront as far as it gets, and repeat as long as one of
+    * them makes progress, i.e. passed a barrier another one arrived at */
+   bool progress = true;
+   while (m_running && progress) {
+      progress = false;
+      for (auto& wave: m_waves) {
+         if (!wave.emulator)
+            continue;
+         bool more;
+         do {
+            more = wave.emulator->step();
+            progress |= !wave.emulator->waiting();
+         } while (more && !wave.emulator->waiting());
+         if (!more)
+            end_wave(wave);
+      }
+   }
+
+   if (m_running)
+      return false;
+   if (m_profile)
+      m_dispatcher.merge_profile(*m_profile);
+   return true;
+}
+
+void Workgroup::end_wave(Wave& wave)
+{
+   if (m_dispatcher.params.finish)
+      m_dispatcher.params.finish(*wave.wf, wave.info);
+   wave.emulator.reset();
+   wave.wf.reset();
+
+   /* The wavefronts at a barrier don't wait for an ended one */
+   --m_running;
+   if (m_arrived && m_arrived == m_running) {
+      m_arrived = 0;
+      ++m_generation;
+   }
+}
+
+bool Workgroup::group_barrier(uint32_t& ticket)
+{
+   if (ticket)
+      return m_generation >= ticket;
+   if (++m_arrived < m_running) {
+      ticket = m_generation + 1;
+      return false;
+   }
+   m_arrived = 0;
+   ++m_generation;
+   return true;
+}
+
+bool Workgroup::global_wave_sync(EGWSOpCode op, unsigned resource,
+                                 unsigned value, uint32_t& ticket)
+{
+   return m_dispatcher.global_wave_sync(m_worker, op, resource, value,
+                                        ticket);
+}
+
+Dispatcher::Dispatcher(const disassembler& program,
+                       const DispatchScheduler::Parameters& params,
+                       const DispatchScheduler::Dispatch& dispatch):
+   program(program),
+   params(params),
+   dispatch(dispatch),
+   m_queued(0),
+   m_live(0),
+   m_events(0),
+   m_steals(0),
+   m_waits(0),
+   m_failed(false)
+{
+   m_resources.fill(Resource{0, 0, 0});
+}
+
+void Dispatcher::run(unsigned nworkers,
+                     DispatchScheduler::Statistics& statistics)
+{
+   unsigned ngroups = dispatch.grid[0] * dispatch.grid[1] * dispatch.grid[2];
+   nworkers = std::max(1u, std::min(nworkers, ngroups));
+
+   /* Each worker gets a contiguous range of workgroups, queued so that
+    * it starts with the first one and thieves take the last ones */
+   for (unsigned w = 0; w < nworkers; ++w) {
+      m_queues.emplace_back(new Queue);
+      unsigned begin = static_cast<uint64_t>(ngroups) * w / nworkers;
+      unsigned end = static_cast<uint64_t>(ngroups) * (w + 1) / nworkers;
+      for (unsigned i = end; i > begin; --i)
+         m_queues[w]->tasks.push_back(Task{i - 1, nullptr});
+   }
+   m_queued = ngroups;
+   m_live = ngroups;
+
+   std::vector<std::thread> threads;
+   for (unsigned w = 1; w < nworkers; ++w)
+      threads.emplace_back(&Dispatcher::worker, this, w);
+   worker(0);
+   for (auto& t: threads)
+      t.join();
+
+   statistics.workgroups = ngroups;
+   statistics.steals = m_steals;
+   statistics.waits = m_waits;
+
+   if (m_error)
+      std::rethrow_exception(m_error);
+}
+
+void Dispatcher::worker(unsigned id)
+{
+   Task task;
+   while (next_task(id, task)) {
+      try {
+         execute(id, task);
+      } catch (...) {
+         fail(std::current_exception());
+      }
+   }
+}
+
+bool Dispatcher::next_task(unsigned id, Task& task)
+{
+   for (;;) {
+      if (m_failed)
+         return false;
+      if (take(id, false, task))
+         return true;
+      for (unsigned k = 1; k < m_queues.size(); ++k) {
+         if (take((id + k) % m_queues.size(), true, task)) {
+            ++m_steals;
+            return true;
+         }
+      }
+
+      std::unique_lock<std::mutex> lock(m_idle_mutex);
+      m_idle.wait(lock, [this]() {
+         return m_queued > 0 || m_live == 0 || m_failed;
+      });
+      if (m_live == 0)
+         return false;
+   }
+}
+
+bool Dispatcher::take(unsigned queue, bool steal, Task& task)
+{
+   auto& q = *m_queues[queue];
+   std::lock_guard<std::mutex> lock(q.mutex);
+   if (q.tasks.empty())
+      return false;
+   if (steal) {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+   } else {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+   }
+   --m_queued;
+   return true;
+}
+
+void Dispatcher::push(unsigned queue, Task task)
+{
+   {
+      auto& q = *m_queues[queue];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(std::move(task));
+      ++m_queued;
+   }
+   std::lock_guard<std::mutex> lock(m_idle_mutex);
+   m_idle.notify_one();
+}
+
+void Dispatcher::execute(unsigned id, Task& task)
+{
+   if (!task.group)
+      task.group.reset(new Workgroup(*this, task.index));
+
+   unsigned events = m_events;
+   if (!task.group->run(id)) {
+      put_aside(id, std::move(task), events);
+      return;
+   }
+   task.group.reset();
+
+   std::lock_guard<std::mutex> lock(m_sync_mutex);
+   if (--m_live == 0)
+      wake_all();
+   else
+      check_deadlock();
+}
+
+void Dispatcher::put_aside(unsigned id, Task task, unsigned events)
+{
+   std::unique_lock<std::mutex> lock(m_sync_mutex);
+   /* The resources changed while the workgroup ran, try again */
+   if (m_events != events) {
+      lock.unlock();
+      push(id, std::move(task));
+      return;
+   }
+   ++m_waits;
+   m_waiting.push_back(std::move(task));
+   check_deadlock();
+}
+
+bool Dispatcher::global_wave_sync(unsigned worker, EGWSOpCode op,
+                                  unsigned resource, unsigned value,
+                                  uint32_t& ticket)
+{
+   std::lock_guard<std::mutex> lock(m_sync_mutex);
+   auto& r = m_resources[resource % m_resources.size()];
+
+   switch (op) {
+   case cf_sema_v:
+      ++r.counter;
+      changed(worker);
+      return true;
+   case cf_sema_p:
+      if (r.counter <= 0)
+         return false;
+      --r.counter;
+      return true;
+   case cf_gws_init:
+      r.counter = value;
+      changed(worker);
+      return true;
+   case cf_gws_barrier:
+      if (ticket)
+         return r.generation >= ticket;
+      if (r.arrived++ < value) {
+         ticket = r.generation + 1;
+         return false;
+      }
+      r.arrived = 0;
+      ++r.generation;
+      changed(worker);
+      return true;
+   }
+   return true;
+}
+
+/* Called with m_sync_mutex held, the waiting workgroups get another
+ * chance on the worker that changed the resources */
+void Dispatcher::changed(unsigned worker)
+{
+   ++m_events;
+   for (auto& task: m_waiting)
+      push(worker, std::move(task));
+   m_waiting.clear();
+}
+
+/* Called with m_sync_mutex held */
+void Dispatcher::check_deadlock()
+{
+   if (m_live && m_waiting.size() == m_live)
+      fail(std::make_exception_ptr(
+              runtime_error("DispatchScheduler: all workgroups wait for "
+                            "GLOBAL_WAVE_SYNC")));
+}
+
+void Dispatcher::fail(std::exception_ptr error)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_error_mutex);
+      if (!m_error)
+         m_error = error;
+      m_failed = true;
+   }
+   wake_all();
+}
+
+void Dispatcher::wake_all()
+{
+   std::lock_guard<std::mutex> lock(m_idle_mutex);
+   m_idle.notify_all();
+}
+
+void Dispatcher::merge_profile(const ExecutionProfile& profile)
+{
+   std::lock_guard<std::mutex> lock(m_profile_mutex);
+   params.emulator.profile->merge(profile);
+}
+
+}
+
+DispatchScheduler::Parameters::Parameters():
+   nthreads(0),
+   lds_size(LocalDataShare::default_size)
+{
+}
+
+DispatchScheduler::DispatchScheduler(const disassembler& program,
+                                     const Parameters& params):
+   m_program(program),
+   m_params(params),
+   m_statistics{0, 0, 0}
+{
+}
+
+void DispatchScheduler::run(const Dispatch& dispatch)
+{
+   for (unsigned i = 0; i < 3; ++i) {
+      if (!dispatch.workgroup[i])
+         throw runtime_error("DispatchScheduler: empty workgroup");
+      if (!dispatch.grid[i])
+         throw runtime_error("DispatchScheduler: empty grid");
+   }
+
+   unsigned nthreads = m_params.nthreads;
+   if (!nthreads)
+      nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+   Dispatcher dispatcher(m_program, m_params, dispatch);
+   dispatcher.run(nthreads, m_statistics);
+}
+
+const DispatchScheduler::Statistics& DispatchScheduler::statistics() const
+{
+   return m_statistics;
+}
+
+}
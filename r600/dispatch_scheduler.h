@@ -0,0 +1,127 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_dispatch_scheduler_h
+#define r600_dispatch_scheduler_h
+
+#include <r600/cf_emulator.h>
+
+#include <array>
+#include <functional>
+
+namespace r600 {
+
+/* Emulates a compute dispatch on a pool of worker threads.
+ *
+ * The workgroups of the grid are the tasks of the workers: each worker
+ * takes the workgroups from its own queue, newest first, and when the
+ * queue is empty it steals the oldest workgroup from another worker.
+ * All wavefronts of a workgroup run on the worker that holds the
+ * workgroup and share its LocalDataShare. They are executed one after
+ * the other, each until it ends or waits at a GROUP_BARRIER or a
+ * GLOBAL_WAVE_SYNC, and the workgroup is resumed until all of its
+ * wavefronts wait. A workgroup that waits for GLOBAL_WAVE_SYNC is put
+ * aside until another workgroup changes the state of the wave sync
+ * resources, so that any number of workgroups can meet at a global
+ * barrier. When all remaining workgroups wait the dispatch can't end,
+ * and run() throws std::runtime_error.
+ *
+ * The wave sync resources work like this:
+ *
+ *   SEMA_V   increments the counter of the resource
+ *   SEMA_P   waits until the counter is positive, then decrements it
+ *   INIT     sets the counter to the value of the instruction
+ *   BARRIER  waits until value + 1 wavefronts arrived at the resource
+ *
+ * Before a wavefront starts R0.xyz is set to the local thread id and
+ * R1.xyz to the workgroup id, like the driver does for compute
+ * shaders.
+ */
+class DispatchScheduler {
+public:
+   struct Dispatch {
+      /* Number of workgroups in x, y, and z */
+      std::array<unsigned, 3> grid;
+      /* Number of threads of a workgroup in x, y, and z */
+      std::array<unsigned, 3> workgroup;
+   };
+
+   struct WaveInfo {
+      std::array<unsigned, 3> group_id;
+      /* Index of the wavefront in the workgroup, it runs the threads
+       * 64 * wave to 64 * wave + 63 of the workgroup */
+      unsigned wave;
+   };
+
+   /* Called from the worker threads, the callbacks must be safe to be
+    * called concurrently for different wavefronts */
+   using WaveCallback = std::function<void (Wavefront&, const WaveInfo&)>;
+
+   struct Parameters {
+      Parameters();
+
+      /* Number of worker threads, 0 uses one per hardware thread */
+      unsigned nthreads;
+
+      /* LDS size of a workgroup in bytes */
+      unsigned lds_size;
+
+      /* Parameters of the wavefronts, the sync is provided by the
+       * scheduler, a profile collects the counts of all wavefronts */
+      CFEmulator::Parameters emulator;
+
+      /* Called after the thread ids were set, e.g. to bind constant
+       * buffers, may be empty */
+      WaveCallback setup;
+
+      /* Called when a wavefront ended, e.g. to read the results, may
+       * be empty */
+      WaveCallback finish;
+   };
+
+   struct Statistics {
+      unsigned workgroups;
+      /* Workgroups taken from the queue of another worker */
+      unsigned steals;
+      /* Times a workgroup was put aside to wait for GLOBAL_WAVE_SYNC */
+      unsigned waits;
+   };
+
+   DispatchScheduler(const disassembler& program,
+                     const Parameters& params = Parameters());
+
+   /* Run all workgroups of the dispatch, throws std::runtime_error
+    * if the dispatch is invalid, or rethrows the first error of a
+    * wavefront */
+   void run(const Dispatch& dispatch);
+
+   /* Statistics of the last run */
+   const Statistics& statistics() const;
+
+private:
+   const disassembler& m_program;
+   Parameters m_params;
+   Statistics m_statistics;
+};
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/dynamic_count_analysis.h>
+
+#include <iostream>
+#include <stack>
+
+namespace r600 {
+
+DynamicCountAnalysis::Parameters::Parameters():
+   default_trip_count(16),
+   default_branch_probability(0.5)
+{
+}
+
+DynamicCountAnalysis::DynamicCountAnalysis(const disassembler& program,
+                                           const Parameters& params):
+   m_static({0, 0, 0, 0}),
+   m_dynamic({0, 0, 0, 0})
+{
+   struct BranchScope {
+      unsigned end_addr;
+      double parent_weight;
+      double probability;
+   };
+
+   std::stack<double> loop_weight;
+   std::stack<BranchScope> branch_scope;
+   double weight = 1.0;
+   double else_probability = 0.5;
+   unsigned cf_addr = 0;
+
+   for (const auto& n: program.get_program()) {
+      while (!branch_scope.empty() &&
+             cf_addr >= branch_scope.top().end_addr) {
+         weight = branch_scope.top().parent_weight;
+         else_probability = 1.0 - branch_scope.top().probability;
+         branch_scope.pop();
+      }
+
+      auto native = dynamic_cast<const CFNativeNode *>(n.get());
+      auto fetch = dynamic_cast<const CFFetchNode *>(n.get());
+
+      if (native && !fetch) {
+         switch (native->opcode()) {
+         case cf_loop_start:
+         case cf_loop_start_no_al:
+         case cf_loop_start_dx10: {
+            unsigned trip_count = params.default_trip_count;
+            if (native->opcode() != cf_loop_start_dx10) {
+               auto tc = params.loop_trip_counts.find(native->cf_const());
+               if (tc != params.loop_trip_counts.end())
+                  trip_count = tc->second;
+            }
+            /* The LOOP_START itself is executed once per loop entry */
+            m_weights.push_back(weight);
+            add_counts(*n, weight);
+            m_loops.push_back({cf_addr, trip_count});
+            loop_weight.push(weight);
+            weight *= trip_count;
+            cf_addr += n->bytecode_size();
+            continue;
+         }
+         case cf_loop_end:
+            m_weights.push_back(weight);
+            add_counts(*n, weight);
+            if (!loop_weight.empty()) {
+               weight = loop_weight.top();
+               loop_weight.pop();
+            }
+            cf_addr += n->bytecode_size();
+            continue;
+         case cf_jump: {
+            double p = params.default_branch_probability;
+            auto bp = params.branch_probabilities.find(cf_addr);
+            if (bp != params.branch_probabilities.end())
+               p = bp->second;
+            m_weights.push_back(weight);
+            add_counts(*n, weight);
+            branch_scope.push({native->address(), weight, p});
+            weight *= p;
+            cf_addr += n->bytecode_size();
+            continue;
+         }
+         case cf_else:
+            m_weights.push_back(weight);
+            add_counts(*n, weight);
+            branch_scope.push({native->address(), weight,
+                               1.0 - else_probability});
+            weight *= else_probability;
+            else_probability = params.default_branch_probability;
+            cf_addr += n->bytecode_size();
+            continue;
+         default:
+            ;
+         }
+      }
+
+      m_weights.push_back(weight);
+      add_counts(*n, weight);
+      cf_addr += n->bytecode_size();
+   }
+}
+
+void DynamicCountAnalysis::add_counts(const CFNode& n, double weight)
+{
+   Counts c = {0, 0, 0, 0};
+
+   if (auto alu = dynamic_cast<const CFAluNode *>(&n)) {
+      for (const auto& g: alu->clause()) {
+         ++c.alu_groups;
+         for (unsigned s = 0; s < 5; ++s)
+            if (g.slot(s))
+               ++c.alu_instructions;
+      }
+   } else if (auto fetch = dynamic_cast<const CFFetchNode *>(&n)) {
+      c.fetches = fetch->clause().size();
+   } else if (dynamic_cast<const CFMemNode *>(&n)) {
+      c.exports = 1;
+   }
+
+   m_static.alu_groups += c.alu_groups;
+   m_static.alu_instructions += c.alu_instructions;
+   m_static.fetches += c.fetches;
+   m_static.exports += c.exports;
+
+   m_dynamic.alu_groups += weight * c.alu_groups;
+   m_dynamic.alu_instructions += weight * c.alu_instructions;
+   m_dynamic.fetches += weight * c.fetches;
+   m_dynamic.exports += weight * c.exports;
+}
+
+const std::vector<double>& DynamicCountAnalysis::weights() const
+{
+   return m_weights;
+}
+
+const DynamicCountAnalysis::Counts& DynamicCountAnalysis::static_counts() const
+{
+   return m_static;
+}
+
+const DynamicCountAnalysis::Counts& DynamicCountAnalysis::dynamic_counts() const
+{
+   return m_dynamic;
+}
+
+void DynamicCountAnalysis::print(std::ostream& os) const
+{
+   for (const auto& l: m_loops)
+      os << "CF " << l.cf_addr << ": loop with " << l.trip_count
+         << " iterations\n";
+
+   os << "ALU groups: " << m_static.alu_groups << " static, "
+      << m_dynamic.alu_groups << " dynamic\n";
+   os << "ALU instructions: " << m_static.alu_instructions << " static, "
+      << m_dynamic.alu_instructions << " dynamic\n";
+   os << "fetches: " << m_static.fetches << " static, "
+      << m_dynamic.fetches << " dynamic\n";
+   os << "exports: " << m_static.exports << " static, "
+      << m_dynamic.exports << " dynamic\n";
+}
+
+}
@@ -0,0 +1,93 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_dynamic_count_analysis_h
+#define r600_dynamic_count_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+namespace r600 {
+
+/* Estimates the number of instructions executed per invocation.
+ *
+ * Each CF instruction gets a weight, the expected number of times it is
+ * executed. Instructions inside a loop are weighted with the trip count
+ * of the loop: LOOP_START and LOOP_START_NO_AL take it from the loop
+ * constant selected by CF_CONST, LOOP_START_DX10 and loops whose
+ * constant is not given use the default trip count. The two sides of a
+ * JUMP/ELSE pair are weighted with the probability that the branch is
+ * taken. Breaks and continues inside loops are not modelled.
+ */
+class DynamicCountAnalysis {
+public:
+   struct Parameters {
+      Parameters();
+
+      /* Trip counts indexed by the loop constant */
+      std::map<unsigned, unsigned> loop_trip_counts;
+      unsigned default_trip_count;
+
+      /* Probability that the code following a JUMP is executed,
+       * indexed by the CF address of the JUMP */
+      std::map<unsigned, double> branch_probabilities;
+      double default_branch_probability;
+   };
+
+   struct Counts {
+      double alu_groups;
+      double alu_instructions;
+      double fetches;
+      double exports;
+   };
+
+   DynamicCountAnalysis(const disassembler& program,
+                        const Parameters& params = Parameters());
+
+   /* Expected execution count for each CF instruction, indexed like
+    * the program */
+   const std::vector<double>& weights() const;
+
+   const Counts& static_counts() const;
+   const Counts& dynamic_counts() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   struct Loop {
+      unsigned cf_addr;
+      unsigned trip_count;
+   };
+
+   void add_counts(const CFNode& n, double weight);
+
+   std::vector<double> m_weights;
+   std::vector<Loop> m_loops;
+   Counts m_static;
+   Counts m_dynamic;
+};
+
+}
+
+#endif
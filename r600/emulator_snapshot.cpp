@@ -0,0 +1,416 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/emulator_snapshot.h>
+#include <r600/local_data_share.h>
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+namespace {
+
+const char snapshot_magic[8] = {'R', '6', '0', '0', 'S', 'N', 'A', 'P'};
+const uint32_t snapshot_version = 1;
+
+void put32(std::ostream& os, uint32_t v)
+{
+   char b[4];
+   for (unsigned i = 0; i < 4; ++i)
+      b[i] = static_cast<char>(v >> (8 * i));
+   os.write(b, 4);
+}
+
+void put64(std::ostream& os, uint64_t v)
+{
+   put32(os, v);
+   put32(os, v >> 32);
+}
+
+void put_words(std::ostream& os, const uint32_t *v, unsigned n)
+{
+   for (unsigned i = 0; i < n; ++i)
+      put32(os, v[i]);
+}
+
+uint32_t get32(std::istream& is)
+{
+   unsigned char b[4];
+   if (!is.read(reinterpret_cast<char *>(b), 4))
+      throw runtime_error("EmulatorSnapshot: unexpected end of input");
+   return b[0] | b[1] << 8 | b[2] << 16 | static_cast<uint32_t>(b[3]) << 24;
+}
+
+uint64_t get64(std::istream& is)
+{
+   uint64_t lo = get32(is);
+   return lo | static_cast<uint64_t>(get32(is)) << 32;
+}
+
+void get_words(std::istream& is, uint32_t *v, unsigned n)
+{
+   for (unsigned i = 0; i < n; ++i)
+      v[i] = get32(is);
+}
+
+uint32_t get_index(std::istream& is, size_t end)
+{
+   uint32_t i = get32(is);
+   if (i >= end)
+      throw runtime_error("EmulatorSnapshot: index out of range");
+   return i;
+}
+
+bool same_entry(const CFEmulator::StackEntry& a,
+                const CFEmulator::StackEntry& b)
+{
+   return a.type == b.type && a.mask == b.mask && a.broken == b.broken &&
+         a.continued == b.continued && a.outer_index == b.outer_index &&
+         a.increment == b.increment && a.remaining == b.remaining &&
+         a.counted == b.counted && a.sets_index == b.sets_index &&
+         a.end_cf == b.end_cf;
+}
+
+}
+
+const unsigned EmulatorSnapshot::page_size;
+
+static_assert(4 * EmulatorSnapshot::page_size == LocalDataShare::page_bytes,
+              "LDS pages and write stamp pages must have the same size");
+
+EmulatorSnapshot::EmulatorSnapshot():
+   m_cf{0, false, 0, 0, {}, {}},
+   m_loop_index(0),
+   m_valid(0),
+   m_active(0),
+   m_predicate(0),
+   m_gpr(Wavefront::ngprs, zero_page()),
+   m_lds_size(0),
+   m_gpr_source(0),
+   m_lds_source(0),
+   m_lds_queues(2 * wavefront_size)
+{
+   m_ar.fill(0);
+   for (auto& pv: m_pv)
+      pv.fill(0);
+}
+
+EmulatorSnapshot::Page EmulatorSnapshot::zero_page()
+{
+   static const Page zero =
+         std::make_shared<const std::vector<uint32_t>>(page_size, 0);
+   return zero;
+}
+
+EmulatorSnapshot::Page
+EmulatorSnapshot::make_page(const uint32_t *data, unsigned n, const Page& base)
+{
+   if (base && std::equal(data, data + n, base->begin()))
+      return base;
+   if (std::all_of(data, data + n, [](uint32_t v) { return v == 0; }))
+      return zero_page();
+
+   auto page = std::make_shared<std::vector<uint32_t>>(page_size, 0);
+   std::copy(data, data + n, page->begin());
+   return page;
+}
+
+EmulatorSnapshot EmulatorSnapshot::take(const CFEmulator& emulator,
+                                        const Wavefront& wf,
+                                        const EmulatorSnapshot *base)
+{
+   EmulatorSnapshot s;
+   s.m_cf = emulator.state();
+   s.m_loop_index = wf.loop_index();
+   s.m_valid = wf.valid();
+   s.m_active = wf.active();
+   s.m_predicate = wf.predicate();
+   s.m_ar = wf.ar();
+   for (unsigned i = 0; i < 5; ++i)
+      s.m_pv[i] = wf.pv(i);
+
+   /* Only the pages that were written since the base was taken are
+    * read */
+   const PageStamps& gpr_stamps = wf.gpr_stamps();
+   bool gpr_base = base && base->m_gpr_source == gpr_stamps.id();
+   s.m_gpr_source = gpr_stamps.id();
+   s.m_gpr_stamps.resize(Wavefront::ngprs);
+
+   uint32_t buf[page_size];
+   for (unsigned r = 0; r < Wavefront::ngprs; ++r) {
+      s.m_gpr_stamps[r] = gpr_stamps.stamp(r);
+      if (gpr_base && base->m_gpr_stamps[r] == s.m_gpr_stamps[r]) {
+         s.m_gpr[r] = base->m_gpr[r];
+         continue;
+      }
+      for (unsigned c = 0; c < 4; ++c)
+         memcpy(buf + c * wavefront_size, wf.gpr(r, c).data(),
+                sizeof(Lanes));
+      s.m_gpr[r] = make_page(buf, page_size, base ? base->m_gpr[r] : Page());
+   }
+
+   if (auto lds = wf.lds()) {
+      const PageStamps& lds_stamps = lds->stamps();
+      s.m_lds_size = lds->size();
+      s.m_lds_source = lds_stamps.id();
+      bool same_size = base && base->m_lds_size == s.m_lds_size;
+      bool lds_base = same_size && base->m_lds_source == s.m_lds_source;
+      unsigned nwords = s.m_lds_size / 4;
+      for (unsigned first = 0, p = 0; first < nwords; first += page_size, ++p) {
+         s.m_lds_stamps.push_back(lds_stamps.stamp(p));
+         if (lds_base && base->m_lds_stamps[p] == s.m_lds_stamps[p]) {
+            s.m_lds.push_back(base->m_lds[p]);
+            continue;
+         }
+         unsigned n = std::min(page_size, nwords - first);
+         for (unsigned i = 0; i < n; ++i)
+            buf[i] = lds->read(4 * (first + i));
+         s.m_lds.push_back(make_page(buf, n,
+                                     same_size ? base->m_lds[p] : Page()));
+      }
+   }
+
+   for (unsigned q = 0; q < 2; ++q)
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         s.m_lds_queues[q * wavefront_size + i] = wf.lds_queue(q, i);
+   return s;
+}
+
+void EmulatorSnapshot::restore(CFEmulator& emulator, Wavefront& wf) const
+{
+   wf.set_valid(m_valid);
+   wf.set_active(m_active);
+   wf.set_predicate(m_predicate);
+   wf.set_loop_index(m_loop_index);
+   wf.ar() = m_ar;
+   for (unsigned i = 0; i < 5; ++i)
+      wf.pv(i) = m_pv[i];
+
+   for (unsigned r = 0; r < Wavefront::ngprs; ++r)
+      for (unsigned c = 0; c < 4; ++c)
+         memcpy(wf.gpr(r, c).data(), m_gpr[r]->data() + c * wavefront_size,
+                sizeof(Lanes));
+
+   if (m_lds_size) {
+      if (!wf.lds() || wf.lds()->size() != m_lds_size)
+         wf.set_lds(std::make_shared<LocalDataShare>(m_lds_size));
+      auto lds = wf.lds();
+      for (unsigned i = 0; i < m_lds_size / 4; ++i)
+         lds->write(4 * i, (*m_lds[i / page_size])[i % page_size]);
+   }
+
+   for (unsigned q = 0; q < 2; ++q)
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         wf.lds_queue(q, i) = m_lds_queues[q * wavefront_size + i];
+
+   emulator.set_state(m_cf);
+}
+
+const CFEmulator::State& EmulatorSnapshot::cf_state() const
+{
+   return m_cf;
+}
+
+unsigned EmulatorSnapshot::shared_pages(const EmulatorSnapshot& other) const
+{
+   unsigned n = 0;
+   for (unsigned i = 0; i < m_gpr.size() && i < other.m_gpr.size(); ++i)
+      n += m_gpr[i] == other.m_gpr[i];
+   for (unsigned i = 0; i < m_lds.size() && i < other.m_lds.size(); ++i)
+      n += m_lds[i] == other.m_lds[i];
+   return n;
+}
+
+bool EmulatorSnapshot::operator == (const EmulatorSnapshot& other) const
+{
+   auto same_pages = [](const std::vector<Page>& a,
+                        const std::vector<Page>& b) {
+      return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                        [](const Page& x, const Page& y) {
+                           return x == y || *x == *y;
+                        });
+   };
+
+   return m_cf.pc == other.m_cf.pc &&
+         m_cf.finished == other.m_cf.finished &&
+         m_cf.steps == other.m_cf.steps &&
+         m_cf.max_stack_depth == other.m_cf.max_stack_depth &&
+         std::equal(m_cf.stack.begin(), m_cf.stack.end(),
+                    other.m_cf.stack.begin(), other.m_cf.stack.end(),
+                    same_entry) &&
+         m_cf.call_stack == other.m_cf.call_stack &&
+         m_loop_index == other.m_loop_index &&
+         m_valid == other.m_valid &&
+         m_active == other.m_active &&
+         m_predicate == other.m_predicate &&
+         m_ar == other.m_ar &&
+         m_pv == other.m_pv &&
+         same_pages(m_gpr, other.m_gpr) &&
+         m_lds_size == other.m_lds_size &&
+         same_pages(m_lds, other.m_lds) &&
+         m_lds_queues == other.m_lds_queues;
+}
+
+bool EmulatorSnapshot::operator != (const EmulatorSnapshot& other) const
+{
+   return !(*this == other);
+}
+
+void EmulatorSnapshot::write(std::ostream& os) const
+{
+   os.write(snapshot_magic, sizeof(snapshot_magic));
+   put32(os, snapshot_version);
+
+   put32(os, m_cf.pc);
+   put32(os, m_cf.finished);
+   put32(os, m_cf.steps);
+   put32(os, m_cf.max_stack_depth);
+   put32(os, m_cf.stack.size());
+   for (const auto& e: m_cf.stack) {
+      put32(os, e.type);
+      put64(os, e.mask);
+      put64(os, e.broken);
+      put64(os, e.continued);
+      put32(os, e.outer_index);
+      put32(os, e.increment);
+      put32(os, e.remaining);
+      put32(os, e.counted | e.sets_index << 1);
+      put32(os, e.end_cf);
+   }
+   put32(os, m_cf.call_stack.size());
+   for (auto addr: m_cf.call_stack)
+      put32(os, addr);
+
+   put32(os, m_loop_index);
+   put64(os, m_valid);
+   put64(os, m_active);
+   put64(os, m_predicate);
+   put_words(os, m_ar.data(), wavefront_size);
+   for (const auto& pv: m_pv)
+      put_words(os, pv.data(), wavefront_size);
+
+   auto write_pages = [&os](const std::vector<Page>& pages) {
+      auto used = [](const Page& p) {
+         return std::any_of(p->begin(), p->end(),
+                            [](uint32_t v) { return v != 0; });
+      };
+      put32(os, std::count_if(pages.begin(), pages.end(), used));
+      for (unsigned i = 0; i < pages.size(); ++i) {
+         if (used(pages[i])) {
+            put32(os, i);
+            put_words(os, pages[i]->data(), page_size);
+         }
+      }
+   };
+
+   write_pages(m_gpr);
+   put32(os, m_lds_size);
+   write_pages(m_lds);
+
+   put32(os, std::count_if(m_lds_queues.begin(), m_lds_queues.end(),
+                           [](const std::vector<uint32_t>& q) {
+                              return !q.empty();
+                           }));
+   for (unsigned i = 0; i < m_lds_queues.size(); ++i) {
+      const auto& q = m_lds_queues[i];
+      if (q.empty())
+         continue;
+      put32(os, i);
+      put32(os, q.size());
+      put_words(os, q.data(), q.size());
+   }
+}
+
+EmulatorSnapshot EmulatorSnapshot::read(std::istream& is)
+{
+   char magic[sizeof(snapshot_magic)];
+   if (!is.read(magic, sizeof(magic)) ||
+       memcmp(magic, snapshot_magic, sizeof(magic)))
+      throw runtime_error("EmulatorSnapshot: not a snapshot");
+   if (get32(is) != snapshot_version)
+      throw runtime_error("EmulatorSnapshot: unsupported version");
+
+   EmulatorSnapshot s;
+   s.m_cf.pc = get32(is);
+   s.m_cf.finished = get32(is) != 0;
+   s.m_cf.steps = get32(is);
+   s.m_cf.max_stack_depth = get32(is);
+   for (uint32_t n = get32(is); n > 0; --n) {
+      CFEmulator::StackEntry e;
+      uint32_t type = get32(is);
+      if (type > CFEmulator::se_loop)
+         throw runtime_error("EmulatorSnapshot: bad stack entry");
+      e.type = static_cast<CFEmulator::EEntryType>(type);
+      e.mask = get64(is);
+      e.broken = get64(is);
+      e.continued = get64(is);
+      e.outer_index = static_cast<int32_t>(get32(is));
+      e.increment = static_cast<int32_t>(get32(is));
+      e.remaining = get32(is);
+      uint32_t flags = get32(is);
+      e.counted = flags & 1;
+      e.sets_index = (flags >> 1) & 1;
+      e.end_cf = get32(is);
+      s.m_cf.stack.push_back(e);
+   }
+   for (uint32_t n = get32(is); n > 0; --n)
+      s.m_cf.call_stack.push_back(get32(is));
+
+   s.m_loop_index = static_cast<int32_t>(get32(is));
+   s.m_valid = get64(is);
+   s.m_active = get64(is);
+   s.m_predicate = get64(is);
+   get_words(is, s.m_ar.data(), wavefront_size);
+   for (auto& pv: s.m_pv)
+      get_words(is, pv.data(), wavefront_size);
+
+   auto read_pages = [&is](std::vector<Page>& pages) {
+      for (uint32_t n = get32(is); n > 0; --n) {
+         uint32_t i = get_index(is, pages.size());
+         auto page = std::make_shared<std::vector<uint32_t>>(page_size);
+         get_words(is, page->data(), page_size);
+         pages[i] = page;
+      }
+   };
+
+   read_pages(s.m_gpr);
+   s.m_lds_size = get32(is);
+   if (s.m_lds_size % 4)
+      throw runtime_error("EmulatorSnapshot: bad LDS size");
+   s.m_lds.resize((s.m_lds_size / 4 + page_size - 1) / page_size,
+                  zero_page());
+   read_pages(s.m_lds);
+
+   for (uint32_t n = get32(is); n > 0; --n) {
+      auto& q = s.m_lds_queues[get_index(is, s.m_lds_queues.size())];
+      for (uint32_t k = get32(is); k > 0; --k)
+         q.push_back(get32(is));
+   }
+   return s;
+}
+
+}
@@ -0,0 +1,125 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_emulator_snapshot_h
+#define r600_emulator_snapshot_h
+
+#include <r600/cf_emulator.h>
+#include <r600/wavefront.h>
+
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+namespace r600 {
+
+/* The state of an emulated wavefront taken between two CF
+ * instructions.
+ *
+ * A snapshot holds the control flow state of the CFEmulator, the
+ * registers, masks and LDS output queues of the Wavefront, and the
+ * contents of its LocalDataShare. The register file and the LDS are
+ * kept in immutable pages of page_size dwords. A snapshot taken with a
+ * base that was taken from the same Wavefront and LocalDataShare takes
+ * the pages over from the base without reading them if their write
+ * stamps didn't change since, only the pages written in between are
+ * copied. These are still shared with the base if their contents are
+ * the same, and pages that only hold zeros share one page. So a series
+ * of snapshots of a run costs time and memory in proportion to the
+ * pages the run writes. Copying a snapshot only copies the page
+ * pointers.
+ *
+ * Restoring a snapshot into an emulator for the same program and a
+ * wavefront with the same constant buffers and fetch resources
+ * continues the run exactly as the original one continued, since the
+ * emulation of a wavefront doesn't depend on anything else. Note that
+ * the LDS belongs to the workgroup, restoring it affects all
+ * wavefronts that share it.
+ *
+ * Snapshots are written in a compact binary format, all values are
+ * little endian and only the pages and queues that are not empty are
+ * stored:
+ *
+ *   "R600SNAP" <version>
+ *   <pc> <finished> <steps> <max stack depth>
+ *   <stack entries> <call stack>
+ *   <loop index> <valid> <active> <predicate> <AR> <PV>
+ *   <GPR pages> <LDS size> <LDS pages> <LDS queues>
+ */
+class EmulatorSnapshot {
+public:
+   /* Dwords per page, a GPR page holds the four channels of one
+    * register */
+   static const unsigned page_size = 4 * wavefront_size;
+
+   EmulatorSnapshot();
+
+   /* Take the snapshot, throws std::runtime_error if the emulator is
+    * not at a clause boundary */
+   static EmulatorSnapshot take(const CFEmulator& emulator,
+                                const Wavefront& wf,
+                                const EmulatorSnapshot *base = nullptr);
+
+   /* Restore the state, if the snapshot has an LDS and wf has none
+    * or one of a different size a new one is bound to wf */
+   void restore(CFEmulator& emulator, Wavefront& wf) const;
+
+   const CFEmulator::State& cf_state() const;
+
+   /* Number of pages that are shared with the other snapshot */
+   unsigned shared_pages(const EmulatorSnapshot& other) const;
+
+   bool operator == (const EmulatorSnapshot& other) const;
+   bool operator != (const EmulatorSnapshot& other) const;
+
+   void write(std::ostream& os) const;
+
+   /* Read a snapshot, throws std::runtime_error on malformed input */
+   static EmulatorSnapshot read(std::istream& is);
+
+private:
+   using Page = std::shared_ptr<const std::vector<uint32_t>>;
+
+   static Page zero_page();
+   static Page make_page(const uint32_t *data, unsigned n, const Page& base);
+
+   CFEmulator::State m_cf;
+   int m_loop_index;
+   LaneMask m_valid;
+   LaneMask m_active;
+   LaneMask m_predicate;
+   Lanes m_ar;
+   std::array<Lanes, 5> m_pv;
+   std::vector<Page> m_gpr;
+   unsigned m_lds_size;
+   std::vector<Page> m_lds;
+   /* The ids and the write stamps of the register file and the LDS the
+    * pages were taken from */
+   uint64_t m_gpr_source;
+   std::vector<uint64_t> m_gpr_stamps;
+   uint64_t m_lds_source;
+   std::vector<uint64_t> m_lds_stamps;
+   std::vector<std::vector<uint32_t>> m_lds_queues;
+};
+
+}
+
+#endif
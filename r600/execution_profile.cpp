@@ -0,0 +1,181 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/execution_profile.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+namespace {
+
+const char profile_magic[8] = {'R', '6', '0', '0', 'P', 'R', 'O', 'F'};
+const unsigned profile_version = 2;
+
+void put_uleb(std::ostream& os, uint64_t v)
+{
+   do {
+      char b = v & 0x7f;
+      v >>= 7;
+      if (v)
+         b |= 0x80;
+      os.put(b);
+   } while (v);
+}
+
+uint64_t get_uleb(std::istream& is)
+{
+   uint64_t v = 0;
+   for (unsigned shift = 0; shift < 64; shift += 7) {
+      char b;
+      if (!is.get(b))
+         throw runtime_error("ExecutionProfile: unexpected end of input");
+      v |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80))
+         return v;
+   }
+   throw runtime_error("ExecutionProfile: number too large");
+}
+
+unsigned popcount(LaneMask m)
+{
+   unsigned n = 0;
+   for (; m; m &= m - 1)
+      ++n;
+   return n;
+}
+
+}
+
+ExecutionProfile::Entry::Entry():
+   count(0),
+   lanes(0)
+{
+   histogram.fill(0);
+}
+
+void ExecutionProfile::record(unsigned address, LaneMask active)
+{
+   unsigned n = popcount(active);
+   Entry& e = m_entries[address];
+   ++e.count;
+   e.lanes += n;
+   ++e.histogram[(n + 7) / 8];
+}
+
+const ExecutionProfile::Entry *ExecutionProfile::entry(unsigned address) const
+{
+   auto i = m_entries.find(address);
+   return i != m_entries.end() ? &i->second : nullptr;
+}
+
+const std::map<unsigned, ExecutionProfile::Entry>&
+ExecutionProfile::entries() const
+{
+   return m_entries;
+}
+
+void ExecutionProfile::merge(const ExecutionProfile& other)
+{
+   for (const auto& o: other.m_entries) {
+      Entry& e = m_entries[o.first];
+      e.count += o.second.count;
+      e.lanes += o.second.lanes;
+      for (unsigned i = 0; i < nbuckets; ++i)
+         e.histogram[i] += o.second.histogram[i];
+   }
+}
+
+void ExecutionProfile::write(std::ostream& os) const
+{
+   os.write(profile_magic, sizeof(profile_magic));
+   put_uleb(os, profile_version);
+   put_uleb(os, m_entries.size());
+   unsigned last = 0;
+   for (const auto& e: m_entries) {
+      put_uleb(os, e.first - last);
+      put_uleb(os, e.second.count);
+      put_uleb(os, e.second.lanes);
+      for (auto h: e.second.histogram)
+         put_uleb(os, h);
+      last = e.first;
+   }
+}
+
+ExecutionProfile ExecutionProfile::read(std::istream& is)
+{
+   char magic[sizeof(profile_magic)];
+   if (!is.read(magic, sizeof(magic)) ||
+       !std::equal(magic, magic + sizeof(magic), profile_magic) ||
+       get_uleb(is) != profile_version)
+      throw runtime_error("ExecutionProfile: not a profile");
+
+   ExecutionProfile profile;
+   uint64_t n = get_uleb(is);
+   uint64_t address = 0;
+   for (uint64_t i = 0; i < n; ++i) {
+      uint64_t delta = get_uleb(is);
+      if ((i > 0 && delta == 0) || address + delta > UINT32_MAX)
+         throw runtime_error("ExecutionProfile: bad address");
+      address += delta;
+      Entry e;
+      e.count = get_uleb(is);
+      e.lanes = get_uleb(is);
+      for (auto& h: e.histogram)
+         h = get_uleb(is);
+      profile.m_entries[address] = e;
+   }
+   return profile;
+}
+
+void ExecutionProfile::print_prefix(std::ostream& os, unsigned address) const
+{
+   auto e = entry(address);
+   os << std::right;
+   if (!e) {
+      os << std::setw(10) << "-" << "      | ";
+      return;
+   }
+   os << std::setw(10) << e->count << " ";
+   if (e->count)
+      os << std::setw(3) << (100 * e->lanes) / (wavefront_size * e->count)
+         << "% | ";
+   else
+      os << "     | ";
+}
+
+void ExecutionProfile::print_annotated(std::ostream& os,
+                                       const disassembler& program) const
+{
+   program.print(os, [this](std::ostream& out, int address) {
+      if (address < 0)
+         out << std::string(10 + 6, ' ') << "| ";
+      else
+         print_prefix(out, address);
+   });
+}
+
+}
@@ -0,0 +1,88 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_execution_profile_h
+#define r600_execution_profile_h
+
+#include <r600/disassembler.h>
+#include <r600/wavefront.h>
+
+#include <array>
+#include <iosfwd>
+#include <map>
+
+namespace r600 {
+
+/* Execution counts collected by emulating a program.
+ *
+ * The counts are keyed by bytecode address, which identifies the CF
+ * instructions as well as the ALU groups. Besides the number of
+ * executions each entry keeps the sum of the active threads and a
+ * histogram of the executions by the number of active threads, bucket
+ * 0 counts executions without active threads, bucket i those with
+ * 8i-7 to 8i active threads.
+ *
+ * Profiles are written in a compact binary format: the magic
+ * "R600PROF", followed by the format version and the number of entries,
+ * and for each executed address in ascending order the distance to the
+ * previous address, the count, the sum of active threads, and the
+ * histogram. All numbers are unsigned LEB128, so that the mostly small
+ * counts and the empty histogram buckets take a single byte.
+ */
+class ExecutionProfile {
+public:
+   static const unsigned nbuckets = 9;
+
+   struct Entry {
+      Entry();
+      uint64_t count;
+      uint64_t lanes;
+      std::array<uint64_t, nbuckets> histogram;
+   };
+
+   void record(unsigned address, LaneMask active);
+
+   /* The entry of an address, nullptr if it was never executed */
+   const Entry *entry(unsigned address) const;
+   const std::map<unsigned, Entry>& entries() const;
+
+   /* Add the counts of another run */
+   void merge(const ExecutionProfile& other);
+
+   void write(std::ostream& os) const;
+
+   /* Read a profile, throws std::runtime_error on malformed input */
+   static ExecutionProfile read(std::istream& is);
+
+   /* Print the disassembly with the execution count and the average
+    * share of active threads in front of each CF instruction and ALU
+    * group, see disassembler::print */
+   void print_annotated(std::ostream& os, const disassembler& program) const;
+
+private:
+   void print_prefix(std::ostream& os, unsigned address) const;
+
+   std::map<unsigned, Entry> m_entries;
+};
+
+}
+
+#endif
@@ -0,0 +1,202 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/export_analysis.h>
+
+#include <iostream>
+#include <cassert>
+
+namespace r600 {
+
+/* The burst count field has four bits */
+static const unsigned max_burst_gprs = 16;
+
+static const char *target_names[ExportAnalysis::et_count] = {
+   "PIXEL", "POS", "PARAM", "MEM"
+};
+
+unsigned ExportAnalysis::Bandwidth::bytes() const
+{
+   return 4 * (components + constant);
+}
+
+ExportAnalysis::ExportAnalysis(const disassembler& program)
+{
+   for (auto& b: m_bandwidth)
+      b = Bandwidth{0, 0, 0, 0, 0};
+
+   unsigned cf_addr = 0;
+   for (const auto& n: program.get_program()) {
+      auto exp = dynamic_cast<const CFExportNode *>(n.get());
+      auto mem = dynamic_cast<const CFMemExportNode *>(n.get());
+
+      if (exp || mem) {
+         const CFMemNode& node = exp ? static_cast<const CFMemNode&>(*exp) :
+                                       static_cast<const CFMemNode&>(*mem);
+         const auto& sel = exp ? exp->sel() : mem->sel();
+
+         Export e;
+         e.cf_addr = cf_addr;
+         e.opcode = node.opcode();
+         if (mem) {
+            e.target = et_memory;
+         } else {
+            switch (node.get_type()) {
+            case CFMemNode::export_pixel: e.target = et_pixel; break;
+            case CFMemNode::export_pos: e.target = et_pos; break;
+            default: e.target = et_param;
+            }
+         }
+         e.array_base = exp ? exp->array_base() : mem->array_base();
+         e.first_gpr = node.rw_gpr();
+         e.ngpr = node.get_burst_count() + 1;
+         e.fixed = node.is_indexed() || node.test_flag(CFNode::rw_rel);
+         e.masked = 0;
+         e.constant = 0;
+         for (unsigned i = 0; i < 4; ++i) {
+            e.sel[i] = sel[i];
+            if (sel[i] == 4 || sel[i] == 5)
+               e.constant += e.ngpr;
+            else if (sel[i] > 5)
+               e.masked += e.ngpr;
+         }
+         add_export(e);
+      }
+      cf_addr += n->bytecode_size();
+   }
+
+   find_bursts();
+}
+
+void ExportAnalysis::add_export(const Export& e)
+{
+   auto& bw = m_bandwidth[e.target];
+   ++bw.instructions;
+   bw.vec4s += e.ngpr;
+   bw.components += 4 * e.ngpr - e.masked - e.constant;
+   bw.masked += e.masked;
+   bw.constant += e.constant;
+   m_exports.push_back(e);
+}
+
+bool ExportAnalysis::can_merge(const Export& last, const Export& next,
+                               unsigned run_ngpr)
+{
+   if (last.cf_addr + 1 != next.cf_addr ||
+       last.target != next.target ||
+       last.fixed || next.fixed)
+      return false;
+
+   /* The last export of a run may signal that the exports are done */
+   if (last.opcode != next.opcode &&
+       !(last.opcode == cf_export && next.opcode == cf_export_done))
+      return false;
+
+   return last.sel == next.sel &&
+         last.first_gpr + last.ngpr == next.first_gpr &&
+         last.array_base + last.ngpr == next.array_base &&
+         run_ngpr + next.ngpr <= max_burst_gprs;
+}
+
+void ExportAnalysis::find_bursts()
+{
+   size_t i = 0;
+   while (i < m_exports.size()) {
+      size_t k = i + 1;
+      unsigned ngpr = m_exports[i].ngpr;
+      while (k < m_exports.size() &&
+             can_merge(m_exports[k - 1], m_exports[k], ngpr)) {
+         ngpr += m_exports[k].ngpr;
+         ++k;
+      }
+
+      if (k - i > 1)
+         m_burst_candidates.push_back({m_exports[i].cf_addr,
+                                       m_exports[k - 1].cf_addr,
+                                       static_cast<unsigned>(k - i), ngpr});
+      i = k;
+   }
+}
+
+const std::vector<ExportAnalysis::Export>& ExportAnalysis::exports() const
+{
+   return m_exports;
+}
+
+const std::vector<ExportAnalysis::BurstCandidate>&
+ExportAnalysis::burst_candidates() const
+{
+   return m_burst_candidates;
+}
+
+const ExportAnalysis::Bandwidth& ExportAnalysis::bandwidth(ETarget target) const
+{
+   assert(target < et_count);
+   return m_bandwidth[target];
+}
+
+unsigned ExportAnalysis::total_bytes() const
+{
+   unsigned result = 0;
+   for (const auto& b: m_bandwidth)
+      result += b.bytes();
+   return result;
+}
+
+void ExportAnalysis::print(std::ostream& os) const
+{
+   for (const auto& e: m_exports) {
+      os << "CF " << e.cf_addr << ": " << target_names[e.target]
+         << e.array_base;
+      if (e.ngpr > 1)
+         os << "-" << e.array_base + e.ngpr - 1;
+      os << " R" << e.first_gpr;
+      if (e.ngpr > 1)
+         os << "-R" << e.first_gpr + e.ngpr - 1;
+      os << ".";
+      for (auto s: e.sel)
+         os << Value::component_names[s];
+
+      if (e.masked && e.constant)
+         os << " (" << e.masked << " masked, " << e.constant << " constant)";
+      else if (e.masked)
+         os << " (" << e.masked << " masked)";
+      else if (e.constant)
+         os << " (" << e.constant << " constant)";
+      os << "\n";
+   }
+
+   for (const auto& b: m_burst_candidates)
+      os << "CF " << b.first_addr << "-" << b.last_addr << ": "
+         << b.nexports << " exports could use one burst of "
+         << b.ngpr << " GPRs\n";
+
+   for (unsigned t = 0; t < et_count; ++t) {
+      const auto& b = m_bandwidth[t];
+      if (!b.instructions)
+         continue;
+      os << target_names[t] << ": " << b.instructions << " instructions, "
+         << b.vec4s << " vec4, " << b.bytes() << " bytes\n";
+   }
+   os << "total: " << total_bytes() << " bytes per invocation\n";
+}
+
+}
@@ -0,0 +1,110 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_export_analysis_h
+#define r600_export_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <array>
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Summarizes the exports of a program.
+ *
+ * For each EXPORT and MEM_EXPORT instruction the exported GPR range and
+ * the component swizzle are recorded, masked components and components
+ * that only export the constants 0 or 1 are counted, and runs of adjacent
+ * exports that could have been written as one burst are reported.
+ *
+ * The bandwidth estimate counts 4 bytes for each exported component,
+ * i.e. it is an upper bound for color exports to narrower formats.
+ */
+class ExportAnalysis {
+public:
+   enum ETarget {
+      et_pixel,
+      et_pos,
+      et_param,
+      et_memory,
+      et_count
+   };
+
+   struct Export {
+      unsigned cf_addr;
+      uint32_t opcode;
+      ETarget target;
+      unsigned array_base;
+      unsigned first_gpr;
+      unsigned ngpr;
+      std::array<unsigned, 4> sel;
+      /* indexed or relative exports can't be merged into bursts */
+      bool fixed;
+      unsigned masked;
+      unsigned constant;
+   };
+
+   /* Adjacent exports that one instruction with a higher burst count
+    * could replace */
+   struct BurstCandidate {
+      unsigned first_addr;
+      unsigned last_addr;
+      unsigned nexports;
+      unsigned ngpr;
+   };
+
+   struct Bandwidth {
+      unsigned instructions;
+      unsigned vec4s;
+      unsigned components;
+      unsigned masked;
+      unsigned constant;
+
+      unsigned bytes() const;
+   };
+
+   ExportAnalysis(const disassembler& program);
+
+   const std::vector<Export>& exports() const;
+   const std::vector<BurstCandidate>& burst_candidates() const;
+   const Bandwidth& bandwidth(ETarget target) const;
+
+   /* Estimated bytes written by exports per invocation */
+   unsigned total_bytes() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   static bool can_merge(const Export& last, const Export& next,
+                         unsigned run_ngpr);
+   void add_export(const Export& e);
+   void find_bursts();
+
+   std::vector<Export> m_exports;
+   std::vector<BurstCandidate> m_burst_candidates;
+   std::array<Bandwidth, et_count> m_bandwidth;
+};
+
+}
+
+#endif
@@ -0,0 +1,571 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/fetch_emulator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+using V = VertexFetchNode;
+
+namespace {
+
+const uint32_t one_f = 0x3f800000;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const bool host_little_endian = false;
+#else
+const bool host_little_endian = true;
+#endif
+
+/* The component widths starting at the least significant bit */
+struct Layout {
+   unsigned ncomp;
+   unsigned width[4];
+   bool is_float;
+};
+
+const std::map<V::EVTXDataFormat, Layout> layouts = {
+   {V::fmt_8, {1, {8}, false}},
+   {V::fmt_4_4, {2, {4, 4}, false}},
+   {V::fmt_3_3_2, {3, {2, 3, 3}, false}},
+   {V::fmt_16, {1, {16}, false}},
+   {V::fmt_16_float, {1, {16}, true}},
+   {V::fmt_8_8, {2, {8, 8}, false}},
+   {V::fmt_5_6_5, {3, {5, 6, 5}, false}},
+   {V::fmt_6_5_5, {3, {5, 5, 6}, false}},
+   {V::fmt_1_5_5_5, {4, {5, 5, 5, 1}, false}},
+   {V::fmt_4_4_4_4, {4, {4, 4, 4, 4}, false}},
+   {V::fmt_5_5_5_1, {4, {1, 5, 5, 5}, false}},
+   {V::fmt_32, {1, {32}, false}},
+   {V::fmt_32_float, {1, {32}, true}},
+   {V::fmt_16_16, {2, {16, 16}, false}},
+   {V::fmt_16_16_float, {2, {16, 16}, true}},
+   {V::fmt_2_10_10_10, {4, {10, 10, 10, 2}, false}},
+   {V::fmt_8_8_8_8, {4, {8, 8, 8, 8}, false}},
+   {V::fmt_10_10_10_2, {4, {2, 10, 10, 10}, false}},
+   {V::fmt_32_32, {2, {32, 32}, false}},
+   {V::fmt_32_32_float, {2, {32, 32}, true}},
+   {V::fmt_16_16_16_16, {4, {16, 16, 16, 16}, false}},
+   {V::fmt_16_16_16_16_float, {4, {16, 16, 16, 16}, true}},
+   {V::fmt_32_32_32_32, {4, {32, 32, 32, 32}, false}},
+   {V::fmt_32_32_32_32_float, {4, {32, 32, 32, 32}, true}},
+   {V::fmt_8_8_8, {3, {8, 8, 8}, false}},
+   {V::fmt_16_16_16, {3, {16, 16, 16}, false}},
+   {V::fmt_16_16_16_float, {3, {16, 16, 16}, true}},
+   {V::fmt_32_32_32, {3, {32, 32, 32}, false}},
+   {V::fmt_32_32_32_float, {3, {32, 32, 32}, true}},
+};
+
+const Layout& layout_of(V::EVTXDataFormat format)
+{
+   auto i = layouts.find(format);
+   if (i == layouts.end()) {
+      std::ostringstream msg;
+      msg << "FetchEmulator: unsupported data format " << format;
+      throw runtime_error(msg.str());
+   }
+   return i->second;
+}
+
+unsigned element_size(const Layout& l)
+{
+   unsigned bits = 0;
+   for (unsigned c = 0; c < l.ncomp; ++c)
+      bits += l.width[c];
+   return bits / 8;
+}
+
+bool reads_int(const FetchEmulator::Format& f)
+{
+   return f.num_format == V::nf_int && !layout_of(f.format).is_float;
+}
+
+void swap_bytes(uint8_t *e, unsigned size, unsigned endian_swap)
+{
+   unsigned group = endian_swap == V::es_8in16 ? 2 :
+                    endian_swap == V::es_8in32 ? 4 : 1;
+   for (unsigned i = 0; i + group <= size; i += group)
+      std::reverse(e + i, e + i + group);
+}
+
+uint32_t extract(const uint8_t *e, unsigned bit, unsigned width)
+{
+   uint64_t v = 0;
+   unsigned first = bit / 8;
+   unsigned last = (bit + width - 1) / 8;
+   for (unsigned b = last + 1; b-- > first;)
+      v = (v << 8) | e[b];
+   v >>= bit % 8;
+   return width == 32 ? static_cast<uint32_t>(v) :
+                        static_cast<uint32_t>(v & ((1u << width) - 1));
+}
+
+/* Components of 8, 16 or 32 bits that all have the same width can be
+ * read directly if the data doesn't need an endian swap */
+unsigned direct_width(const Layout& l, unsigned endian_swap)
+{
+   if (endian_swap != V::es_none || !host_little_endian)
+      return 0;
+   for (unsigned c = 1; c < l.ncomp; ++c)
+      if (l.width[c] != l.width[0])
+         return 0;
+   return l.width[0] % 8 == 0 ? l.width[0] : 0;
+}
+
+template <typename T>
+LaneMask read_direct(unsigned ncomp, const std::vector<uint8_t>& data,
+                     const Lanes& offsets, LaneMask mask,
+                     std::array<Lanes, 4>& result)
+{
+   size_t size = ncomp * sizeof(T);
+   LaneMask valid = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      if (!(mask & (LaneMask(1) << i)) ||
+          static_cast<size_t>(offsets[i]) + size > data.size())
+         continue;
+
+      const uint8_t *e = &data[offsets[i]];
+      for (unsigned c = 0; c < ncomp; ++c) {
+         T v;
+         memcpy(&v, e + c * sizeof(T), sizeof(T));
+         result[c][i] = v;
+      }
+      valid |= LaneMask(1) << i;
+   }
+   return valid;
+}
+
+/* Read the elements byte wise and extract the bit fields */
+LaneMask read_packed(const Layout& l, unsigned endian_swap,
+                     const std::vector<uint8_t>& data, const Lanes& offsets,
+                     LaneMask mask, std::array<Lanes, 4>& result)
+{
+   unsigned size = element_size(l);
+   LaneMask valid = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      if (!(mask & (LaneMask(1) << i)) ||
+          static_cast<size_t>(offsets[i]) + size > data.size())
+         continue;
+
+      uint8_t e[16];
+      memcpy(e, &data[offsets[i]], size);
+      swap_bytes(e, size, endian_swap);
+
+      unsigned bit = 0;
+      for (unsigned c = 0; c < l.ncomp; ++c) {
+         result[c][i] = extract(e, bit, l.width[c]);
+         bit += l.width[c];
+      }
+      valid |= LaneMask(1) << i;
+   }
+   return valid;
+}
+
+int32_t sign_extend(uint32_t v, unsigned width)
+{
+   unsigned shift = 32 - width;
+   return static_cast<int32_t>(v << shift) >> shift;
+}
+
+/* Convert the raw bits of one component for all threads */
+void convert_component(Lanes& v, unsigned width, bool is_float,
+                       const FetchEmulator::Format& f)
+{
+   if (is_float) {
+      if (width == 16) {
+         for (auto& x: v)
+            x = lane_bits(half_to_float(x));
+      }
+      return;
+   }
+
+   switch (f.num_format) {
+   case V::nf_int:
+      if (f.is_signed) {
+         for (auto& x: v)
+            x = sign_extend(x, width);
+      }
+      break;
+   case V::nf_scaled:
+      if (f.is_signed) {
+         for (auto& x: v)
+            x = lane_bits(static_cast<float>(sign_extend(x, width)));
+      } else {
+         for (auto& x: v)
+            x = lane_bits(static_cast<float>(x));
+      }
+      break;
+   default:
+      if (f.is_signed) {
+         /* A one bit value can only be 0 or -1 */
+         float scale = width > 1 ?
+                          static_cast<float>((1ull << (width - 1)) - 1) : 1.0f;
+         for (auto& x: v)
+            x = lane_bits(std::max(sign_extend(x, width) / scale, -1.0f));
+      } else {
+         float scale = static_cast<float>((1ull << width) - 1);
+         for (auto& x: v)
+            x = lane_bits(x / scale);
+      }
+   }
+}
+
+/* Texel offsets are given in half texels as 5 bit signed values */
+float texel_offset(int raw)
+{
+   return sign_extend(raw, 5) * 0.5f;
+}
+
+int wrap(int i, int n, FetchEmulator::EWrap mode)
+{
+   if (mode == FetchEmulator::sw_repeat)
+      return ((i % n) + n) % n;
+   return std::min(std::max(i, 0), n - 1);
+}
+
+size_t image_offset(const FetchEmulator::Image& img, unsigned elem,
+                    int x, int y, int z)
+{
+   size_t pitch = img.row_pitch ? img.row_pitch : img.width * elem;
+   return (static_cast<size_t>(z) * img.height + y) * pitch +
+         static_cast<size_t>(x) * elem;
+}
+
+/* Source component c of a texture instruction after the swizzle */
+uint32_t tex_source(const TexFetchNode& fetch, const Wavefront& wf,
+                    int sel, unsigned c, unsigned lane, uint32_t one)
+{
+   int swz = fetch.src_swizzle()[c];
+   if (swz < 4)
+      return wf.gpr(sel, swz)[lane];
+   return swz == 5 ? one : 0;
+}
+
+int gpr_index(const GPRValue& v, const Wavefront& wf)
+{
+   int sel = v.sel() + (v.rel() ? wf.loop_index() : 0);
+   if (sel < 0 || sel >= static_cast<int>(Wavefront::ngprs))
+      throw runtime_error("FetchEmulator: register index out of range");
+   return sel;
+}
+
+}
+
+FetchEmulator::Format::Format(VertexFetchNode::EVTXDataFormat fmt,
+                              VertexFetchNode::ENumFormat nfmt,
+                              bool sign):
+   format(fmt),
+   num_format(nfmt),
+   is_signed(sign)
+{
+}
+
+void FetchEmulator::bind_buffer(unsigned resource_id, const Buffer& buffer)
+{
+   m_buffers[resource_id] = buffer;
+}
+
+void FetchEmulator::bind_image(unsigned resource_id, const Image& image)
+{
+   m_images[resource_id] = image;
+}
+
+void FetchEmulator::bind_sampler(unsigned sampler_id, const Sampler& sampler)
+{
+   m_samplers[sampler_id] = sampler;
+}
+
+bool FetchEmulator::supported(VertexFetchNode::EVTXDataFormat format)
+{
+   return layouts.find(format) != layouts.end();
+}
+
+void FetchEmulator::convert(const Format& format, unsigned endian_swap,
+                            const std::vector<uint8_t>& data,
+                            const Lanes& offsets, LaneMask mask,
+                            std::array<Lanes, 4>& result)
+{
+   const Layout& l = layout_of(format.format);
+
+   for (auto& r: result)
+      r.fill(0);
+
+   LaneMask valid;
+   switch (direct_width(l, endian_swap)) {
+   case 8:
+      valid = read_direct<uint8_t>(l.ncomp, data, offsets, mask, result);
+      break;
+   case 16:
+      valid = read_direct<uint16_t>(l.ncomp, data, offsets, mask, result);
+      break;
+   case 32:
+      valid = read_direct<uint32_t>(l.ncomp, data, offsets, mask, result);
+      break;
+   default:
+      valid = read_packed(l, endian_swap, data, offsets, mask, result);
+   }
+
+   for (unsigned c = 0; c < l.ncomp; ++c)
+      convert_component(result[c], l.width[c], l.is_float, format);
+
+   if (l.ncomp < 4) {
+      uint32_t one = reads_int(format) ? 1 : one_f;
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         if (valid & (LaneMask(1) << i))
+            result[3][i] = one;
+   }
+}
+
+void FetchEmulator::execute(const CFFetchNode& clause, Wavefront& wf) const
+{
+   for (const auto& f: clause.clause())
+      execute(*f, wf);
+}
+
+void FetchEmulator::execute(const FetchNode& fetch, Wavefront& wf) const
+{
+   if (auto vtx = dynamic_cast<const VertexFetchNode *>(&fetch)) {
+      vertex_fetch(*vtx, wf);
+   } else if (auto tex = dynamic_cast<const TexFetchNode *>(&fetch)) {
+      tex_fetch(*tex, wf);
+   } else {
+      std::ostringstream msg;
+      msg << "FetchEmulator: unsupported instruction " << fetch;
+      throw runtime_error(msg.str());
+   }
+}
+
+void FetchEmulator::vertex_fetch(const VertexFetchNode& fetch,
+                                 Wavefront& wf) const
+{
+   auto b = m_buffers.find(fetch.buffer_id());
+   if (b == m_buffers.end() || !b->second.data) {
+      std::ostringstream msg;
+      msg << "FetchEmulator: no buffer bound to resource "
+          << fetch.buffer_id();
+      throw runtime_error(msg.str());
+   }
+   const Buffer& buffer = b->second;
+   std::array<Lanes, 4> value;
+
+   switch (fetch.vc_opcode()) {
+   case V::vc_fetch: {
+      Format format = buffer.format;
+      if (!fetch.test_flag(V::vtx_use_const_field))
+         format = Format(fetch.data_format(), fetch.num_format(),
+                         fetch.test_flag(V::vtx_format_comp_signed));
+      uint64_t stride = fetch.test_flag(V::vtx_buf_no_stride) ? 0 :
+                                                                 buffer.stride;
+
+      const Wavefront& regs = wf;
+      const Lanes& index = regs.gpr(gpr_index(fetch.src(), wf),
+                                    fetch.src().chan());
+      Lanes offsets;
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         uint64_t offset = index[i] * stride + fetch.offset();
+         offsets[i] = std::min<uint64_t>(offset, 0xffffffff);
+      }
+      convert(format, fetch.endian_swap(), *buffer.data, offsets,
+              wf.active(), value);
+      store(fetch, value, reads_int(format), wf);
+      break;
+   }
+   case V::vc_get_buf_resinfo:
+      value[0].fill(buffer.data->size());
+      for (unsigned c = 1; c < 4; ++c)
+         value[c].fill(0);
+      store(fetch, value, true, wf);
+      break;
+   default: {
+      std::ostringstream msg;
+      msg << "FetchEmulator: unsupported instruction " << fetch;
+      throw runtime_error(msg.str());
+   }
+   }
+}
+
+void FetchEmulator::tex_fetch(const TexFetchNode& fetch, Wavefront& wf) const
+{
+   auto i = m_images.find(fetch.resource_id());
+   if (i == m_images.end() || !i->second.data) {
+      std::ostringstream msg;
+      msg << "FetchEmulator: no image bound to resource "
+          << fetch.resource_id();
+      throw runtime_error(msg.str());
+   }
+   const Image& img = i->second;
+   std::array<Lanes, 4> value;
+
+   switch (fetch.tex_opcode()) {
+   case TexFetchNode::tex_get_res_info:
+      value[0].fill(img.width);
+      value[1].fill(img.height);
+      value[2].fill(img.depth);
+      value[3].fill(1);
+      store(fetch, value, true, wf);
+      break;
+   case TexFetchNode::tex_ld: {
+      unsigned elem = V::data_format_size(img.format.format);
+      unsigned dims = img.depth > 1 ? 3 : (img.height > 1 ? 2 : 1);
+      int size[3] = {static_cast<int>(img.width), static_cast<int>(img.height),
+                     static_cast<int>(img.depth)};
+      int sel = gpr_index(fetch.src(), wf);
+      LaneMask mask = wf.active();
+      Lanes offsets;
+      for (unsigned l = 0; l < wavefront_size; ++l) {
+         int x[3] = {0, 0, 0};
+         for (unsigned d = 0; d < dims; ++d) {
+            x[d] = static_cast<int32_t>(tex_source(fetch, wf, sel, d, l, 1)) +
+                  (sign_extend(fetch.offset()[d], 5) >> 1);
+            if (x[d] < 0 || x[d] >= size[d])
+               mask &= ~(LaneMask(1) << l);
+         }
+         offsets[l] = (mask & (LaneMask(1) << l)) ?
+                         image_offset(img, elem, x[0], x[1], x[2]) : 0;
+      }
+      convert(img.format, 0, *img.data, offsets, mask, value);
+      store(fetch, value, reads_int(img.format), wf);
+      break;
+   }
+   case TexFetchNode::tex_sample:
+   case TexFetchNode::tex_sample_l:
+   case TexFetchNode::tex_sample_lb:
+   case TexFetchNode::tex_sample_lz:
+      sample(fetch, img, wf, value);
+      store(fetch, value, reads_int(img.format), wf);
+      break;
+   default: {
+      std::ostringstream msg;
+      msg << "FetchEmulator: unsupported instruction " << fetch;
+      throw runtime_error(msg.str());
+   }
+   }
+}
+
+void FetchEmulator::sample(const TexFetchNode& fetch, const Image& img,
+                           const Wavefront& wf,
+                           std::array<Lanes, 4>& result) const
+{
+   auto s = m_samplers.find(fetch.sampler_id());
+   if (s == m_samplers.end()) {
+      std::ostringstream msg;
+      msg << "FetchEmulator: no sampler bound to " << fetch.sampler_id();
+      throw runtime_error(msg.str());
+   }
+   const Sampler& sampler = s->second;
+
+   bool linear = sampler.filter == sf_linear && !reads_int(img.format);
+   unsigned dims = img.depth > 1 ? 3 : (img.height > 1 ? 2 : 1);
+   int size[3] = {static_cast<int>(img.width), static_cast<int>(img.height),
+                  static_cast<int>(img.depth)};
+   unsigned elem = V::data_format_size(img.format.format);
+   int sel = gpr_index(fetch.src(), wf);
+   LaneMask active = wf.active();
+
+   /* the two texels in each dimension and the weight of the second one */
+   std::array<std::array<int, wavefront_size>, 3> i0, i1;
+   std::array<std::array<float, wavefront_size>, 3> frac;
+   for (unsigned d = 0; d < 3; ++d) {
+      for (unsigned l = 0; l < wavefront_size; ++l) {
+         i0[d][l] = i1[d][l] = 0;
+         frac[d][l] = 0.0f;
+         if (d >= dims)
+            continue;
+
+         float t = lane_float(tex_source(fetch, wf, sel, d, l, one_f));
+         if (fetch.test_flag(static_cast<TexFetchNode::ETexFlags>(
+                                TexFetchNode::coord_type_x + d)))
+            t *= size[d];
+         t += texel_offset(fetch.offset()[d]);
+         if (linear)
+            t -= 0.5f;
+         if (!(std::fabs(t) < 16777216.0f))
+            t = 0.0f;
+
+         float base = std::floor(t);
+         if (linear)
+            frac[d][l] = t - base;
+         i0[d][l] = wrap(static_cast<int>(base), size[d], sampler.wrap);
+         i1[d][l] = wrap(static_cast<int>(base) + 1, size[d], sampler.wrap);
+      }
+   }
+
+   std::array<std::array<float, wavefront_size>, 4> sum = {};
+   unsigned ncorners = linear ? 1u << dims : 1u;
+   for (unsigned corner = 0; corner < ncorners; ++corner) {
+      Lanes offsets;
+      std::array<float, wavefront_size> weight;
+      for (unsigned l = 0; l < wavefront_size; ++l) {
+         int x[3];
+         weight[l] = 1.0f;
+         for (unsigned d = 0; d < 3; ++d) {
+            bool second = corner & (1 << d);
+            x[d] = second ? i1[d][l] : i0[d][l];
+            weight[l] *= second ? frac[d][l] : 1.0f - frac[d][l];
+         }
+         offsets[l] = image_offset(img, elem, x[0], x[1], x[2]);
+      }
+
+      std::array<Lanes, 4> texel;
+      convert(img.format, 0, *img.data, offsets, active, texel);
+      if (!linear) {
+         result = texel;
+         return;
+      }
+      for (unsigned c = 0; c < 4; ++c)
+         for (unsigned l = 0; l < wavefront_size; ++l)
+            sum[c][l] += weight[l] * lane_float(texel[c][l]);
+   }
+
+   for (unsigned c = 0; c < 4; ++c)
+      for (unsigned l = 0; l < wavefront_size; ++l)
+         result[c][l] = lane_bits(sum[c][l]);
+}
+
+void FetchEmulator::store(const FetchNode& fetch,
+                          const std::array<Lanes, 4>& value, bool int_one,
+                          Wavefront& wf) const
+{
+   int sel = gpr_index(fetch.dst(), wf);
+   LaneMask mask = wf.active();
+   uint32_t one = int_one ? 1 : one_f;
+
+   for (unsigned c = 0; c < 4; ++c) {
+      int swz = fetch.dst_swizzle()[c];
+      if (swz == 7)
+         continue;
+      Lanes& dst = wf.gpr(sel, c);
+      for (unsigned l = 0; l < wavefront_size; ++l) {
+         if (!(mask & (LaneMask(1) << l)))
+            continue;
+         dst[l] = swz < 4 ? value[swz][l] : (swz == 5 ? one : 0);
+      }
+   }
+}
+
+}
@@ -0,0 +1,133 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_fetch_emulator_h
+#define r600_fetch_emulator_h
+
+#include <r600/cf_node.h>
+#include <r600/fetch_node.h>
+#include <r600/wavefront.h>
+
+#include <map>
+
+namespace r600 {
+
+/* Executes fetch clauses for a wavefront against host memory.
+ *
+ * Vertex buffers and images are bound to resource ids, samplers to
+ * sampler ids. A vertex fetch reads the element at index * stride +
+ * offset, where the index is taken from the source register. Texture
+ * instructions read level 0 of the image with nearest or linear
+ * filtering, the coordinates are normalized if the COORD_TYPE flag of
+ * the component is set.
+ *
+ * The elements are converted for all threads at once: the raw bits of
+ * each component are gathered first, and each component is then
+ * converted in one loop according to its width and the number format.
+ * Formats whose components all have 8, 16, or 32 bits are gathered
+ * with direct loads if no endian swap is requested.
+ * Components that are not in the format read as 0, except W which
+ * reads as 1. Elements outside the bound memory read as 0.
+ *
+ * Unbound resources, MEM_RD, GDS, and the instructions that are not
+ * emulated make the emulator throw std::runtime_error.
+ */
+class FetchEmulator {
+public:
+   using Data = std::shared_ptr<const std::vector<uint8_t>>;
+
+   struct Format {
+      Format(VertexFetchNode::EVTXDataFormat format =
+                VertexFetchNode::fmt_32_32_32_32_float,
+             VertexFetchNode::ENumFormat num_format =
+                VertexFetchNode::nf_norm,
+             bool is_signed = false);
+
+      VertexFetchNode::EVTXDataFormat format;
+      VertexFetchNode::ENumFormat num_format;
+      bool is_signed;
+   };
+
+   /* The format is used by fetches that take it from the resource */
+   struct Buffer {
+      Data data;
+      unsigned stride;
+      Format format;
+   };
+
+   struct Image {
+      Data data;
+      unsigned width;
+      unsigned height;
+      unsigned depth;
+      /* bytes per row, 0 for tightly packed rows */
+      unsigned row_pitch;
+      Format format;
+   };
+
+   enum EFilter {
+      sf_nearest,
+      sf_linear
+   };
+
+   enum EWrap {
+      sw_repeat,
+      sw_clamp
+   };
+
+   struct Sampler {
+      EFilter filter;
+      EWrap wrap;
+   };
+
+   void bind_buffer(unsigned resource_id, const Buffer& buffer);
+   void bind_image(unsigned resource_id, const Image& image);
+   void bind_sampler(unsigned sampler_id, const Sampler& sampler);
+
+   /* Execute the fetches of a clause for the active threads */
+   void execute(const CFFetchNode& clause, Wavefront& wf) const;
+   void execute(const FetchNode& fetch, Wavefront& wf) const;
+
+   static bool supported(VertexFetchNode::EVTXDataFormat format);
+
+   /* Read the elements at the given byte offsets for the threads in
+    * mask and convert them to four channel values */
+   static void convert(const Format& format, unsigned endian_swap,
+                       const std::vector<uint8_t>& data,
+                       const Lanes& offsets, LaneMask mask,
+                       std::array<Lanes, 4>& result);
+
+private:
+   void vertex_fetch(const VertexFetchNode& fetch, Wavefront& wf) const;
+   void tex_fetch(const TexFetchNode& fetch, Wavefront& wf) const;
+   void sample(const TexFetchNode& fetch, const Image& image,
+               const Wavefront& wf, std::array<Lanes, 4>& result) const;
+   void store(const FetchNode& fetch, const std::array<Lanes, 4>& value,
+              bool int_one, Wavefront& wf) const;
+
+   std::map<unsigned, Buffer> m_buffers;
+   std::map<unsigned, Image> m_images;
+   std::map<unsigned, Sampler> m_samplers;
+};
+
+}
+
+#endif
@@ -87,6 +87,14 @@ FetchNode::FetchNode(uint64_t bc0):
       m_dst_swizzle[i] = (bc0 >> (41 + 3*i)) & 7;
 }
 
+FetchNode::FetchNode(const GPRValue& src, const GPRValue& dst,
+                     const std::vector<int>& dst_swizzle):
+   m_src(src),
+   m_dst(dst),
+   m_dst_swizzle(dst_swizzle)
+{
+}
+
 FetchNode::Pointer FetchNode::decode(uint64_t bc0, uint64_t bc1)
 {
    int opcode = bc0 & 0x1f;
@@ -107,6 +115,21 @@ FetchNode::Pointer FetchNode::decode(uint64_t bc0, uint64_t bc1)
    }
 }
 
+const GPRValue& FetchNode::src() const
+{
+   return m_src;
+}
+
+const GPRValue& FetchNode::dst() const
+{
+   return m_dst;
+}
+
+const std::vector<int>& FetchNode::dst_swizzle() const
+{
+   return m_dst_swizzle;
+}
+
 void FetchNode::encode_src(uint64_t& result) const
 {
    result |= m_src.sel();
@@ -197,6 +220,120 @@ VertexFetchNode::ms_flag_bits = {
    {1, 1ul << 20},
 };
 
+VertexFetchNode::EFetchInstr VertexFetchNode::vc_opcode() const
+{
+   return m_vc_opcode;
+}
+
+uint32_t VertexFetchNode::offset() const
+{
+   return m_offset;
+}
+
+VertexFetchNode::EVTXDataFormat VertexFetchNode::data_format() const
+{
+   return m_data_format;
+}
+
+bool VertexFetchNode::is_mega_fetch() const
+{
+   return m_is_mega_fetch;
+}
+
+uint32_t VertexFetchNode::mega_fetch_count() const
+{
+   return m_mega_fetch_count;
+}
+
+uint32_t VertexFetchNode::buffer_id() const
+{
+   return m_buffer_id;
+}
+
+VertexFetchNode::EFetchType VertexFetchNode::fetch_type() const
+{
+   return m_fetch_type;
+}
+
+FetchNode::EBufferIndexMode VertexFetchNode::buffer_index_mode() const
+{
+   return m_buffer_index_mode;
+}
+
+VertexFetchNode::ENumFormat VertexFetchNode::num_format() const
+{
+   return m_num_format;
+}
+
+VertexFetchNode::EEndianSwap VertexFetchNode::endian_swap() const
+{
+   return m_endian_swap;
+}
+
+bool VertexFetchNode::test_flag(EFlagShift f) const
+{
+   return m_flags.test(f);
+}
+
+unsigned VertexFetchNode::data_format_size(EVTXDataFormat format)
+{
+   switch (format) {
+   case fmt_8:
+   case fmt_4_4:
+   case fmt_3_3_2:
+      return 1;
+   case fmt_16:
+   case fmt_16_float:
+   case fmt_8_8:
+   case fmt_5_6_5:
+   case fmt_6_5_5:
+   case fmt_1_5_5_5:
+   case fmt_4_4_4_4:
+   case fmt_5_5_5_1:
+      return 2;
+   case fmt_8_8_8:
+      return 3;
+   case fmt_32:
+   case fmt_32_float:
+   case fmt_16_16:
+   case fmt_16_16_float:
+   case fmt_8_24:
+   case fmt_8_24_float:
+   case fmt_24_8:
+   case fmt_24_8_float:
+   case fmt_10_11_11:
+   case fmt_10_11_11_float:
+   case fmt_11_11_10:
+   case fmt_11_11_10_float:
+   case fmt_2_10_10_10:
+   case fmt_8_8_8_8:
+   case fmt_10_10_10_2:
+   case fmt_gb_gr:
+   case fmt_bg_rg:
+   case fmt_32_as_8:
+   case fmt_32_as_8_8:
+   case fmt_5_9_9_9_sharedexp:
+      return 4;
+   case fmt_16_16_16:
+   case fmt_16_16_16_float:
+      return 6;
+   case fmt_x24_8_32_float:
+   case fmt_32_32:
+   case fmt_32_32_float:
+   case fmt_16_16_16_16:
+   case fmt_16_16_16_16_float:
+      return 8;
+   case fmt_32_32_32:
+   case fmt_32_32_32_float:
+      return 12;
+   case fmt_32_32_32_32:
+   case fmt_32_32_32_32_float:
+      return 16;
+   default:
+      return 0;
+   }
+}
+
 void VertexFetchNode::print(std::ostream& os) const
 {
    static const string num_format_char[] = {"norm", "int", "scaled"};
@@ -320,6 +457,46 @@ TexFetchNode::TexFetchNode(uint64_t bc0, uint64_t bc1):
 
 }
 
+TexFetchNode::ETexInst TexFetchNode::tex_opcode() const
+{
+   return m_tex_opcode;
+}
+
+TexFetchNode::EInstMod TexFetchNode::inst_mode() const
+{
+   return m_inst_mode;
+}
+
+uint32_t TexFetchNode::resource_id() const
+{
+   return m_resource_id;
+}
+
+uint32_t TexFetchNode::sampler_id() const
+{
+   return m_sampler_id;
+}
+
+const std::vector<int>& TexFetchNode::offset() const
+{
+   return m_offset;
+}
+
+const std::vector<int>& TexFetchNode::src_swizzle() const
+{
+   return m_src_swizzle;
+}
+
+bool TexFetchNode::test_flag(ETexFlags f) const
+{
+   return m_flags.test(f);
+}
+
+bool TexFetchNode::uses_sampler() const
+{
+   return m_tex_opcode == tex_get_comp_lod || m_tex_opcode >= tex_sample;
+}
+
 void TexFetchNode::print(std::ostream& os) const
 {
    ostringstream os_help;
@@ -378,7 +555,12 @@ void TexFetchNode::print(std::ostream& os) const
 
 const char *TexFetchNode::opname_from_opcode() const
 {
-   switch (m_tex_opcode) {
+   return opname(m_tex_opcode);
+}
+
+const char *TexFetchNode::opname(ETexInst opcode)
+{
+   switch (opcode) {
    case tex_ld: return "LD";
    case tex_get_res_info: return  "GET_RES_INFO";
    case tex_get_num_samples: return  "GET_NUM_SAMPLES";
@@ -471,21 +653,88 @@ void MemoryReadNode::print(std::ostream& os) const
 }
 
 
+static std::vector<int> gds_dst_swizzle(uint64_t bc1)
+{
+   std::vector<int> result(4);
+   for (int i = 0; i < 4; ++i)
+      result[i] = (bc1 >> (3 * i)) & 7;
+   return result;
+}
+
 GDSOpNode::GDSOpNode(uint64_t bc0, uint64_t bc1):
-   FetchNode(bc0)
+   FetchNode(GPRValue((bc0 >> 11) & 0x7f, 0, false, (bc0 >> 18) & 3, false),
+             GPRValue((bc0 >> 32) & 0x7f, 0, false, (bc0 >> 39) & 3, false),
+             gds_dst_swizzle(bc1)),
+   m_src_rel_mode((bc0 >> 18) & 3),
+   m_dst_rel_mode((bc0 >> 39) & 3),
+   m_src_sel(3),
+   m_gds_op(static_cast<ESDOp>((bc0 >> 41) & 0x3f)),
+   m_src_gpr2((bc0 >> 48) & 0x7f),
+   m_uav_index_mode((bc0 >> 56) & 3),
+   m_uav_id((bc0 >> 58) & 0xf),
+   m_alloc_consume(bc0 & (1ul << 62)),
+   m_bcast_first_req(bc0 & (1ul << 63))
 {
-   DASS_UNUSED(bc1);
+   for (int i = 0; i < 3; ++i)
+      m_src_sel[i] = (bc0 >> (20 + 3 * i)) & 7;
+}
+
+ESDOp GDSOpNode::gds_op() const
+{
+   return m_gds_op;
+}
+
+const std::vector<int>& GDSOpNode::src_sel() const
+{
+   return m_src_sel;
+}
+
+int GDSOpNode::uav_id() const
+{
+   return m_uav_id;
 }
 
 uint64_t GDSOpNode::create_bytecode_byte(int i) const
 {
-   DASS_UNUSED(i);
-   return 0;
+   assert(i < 2);
+   uint64_t result = 0;
+
+   if (i == 0) {
+      result |= 2;
+      result |= 4 << 8;
+      result |= src().sel() << 11;
+      result |= m_src_rel_mode << 18;
+      for (int k = 0; k < 3; ++k)
+         result |= m_src_sel[k] << (20 + 3 * k);
+
+      result |= static_cast<uint64_t>(dst().sel()) << 32;
+      result |= static_cast<uint64_t>(m_dst_rel_mode) << 39;
+      result |= static_cast<uint64_t>(m_gds_op) << 41;
+      result |= static_cast<uint64_t>(m_src_gpr2) << 48;
+      result |= static_cast<uint64_t>(m_uav_index_mode) << 56;
+      result |= static_cast<uint64_t>(m_uav_id) << 58;
+      if (m_alloc_consume)
+         result |= 1ul << 62;
+      if (m_bcast_first_req)
+         result |= 1ul << 63;
+   } else {
+      for (int k = 0; k < 4; ++k)
+         result |= static_cast<uint64_t>(dst_swizzle()[k]) << (3 * k);
+   }
+   return result;
 }
 
 void GDSOpNode::print(std::ostream& os) const
 {
-   DASS_UNUSED(os);
+   auto o = lds_ops.find(m_gds_op);
+   os << "GDS " << (o != lds_ops.end() ? o->second.name : "UNKNOWN");
+
+   os << " R";
+   print_dst(os);
+   os << ", R" << src().sel() << ".";
+   for (auto s: m_src_sel)
+      os << Value::component_names[s];
+   os << " UAV:" << m_uav_id;
 }
 
-}
\ No newline at end of file
+}
@@ -22,7 +22,13 @@ public:
    FetchNode(uint64_t bc0);
 
    static Pointer decode(uint64_t bc0, uint64_t bc1);
+
+   const GPRValue& src() const;
+   const GPRValue& dst() const;
+   const std::vector<int>& dst_swizzle() const;
 protected:
+   FetchNode(const GPRValue& src, const GPRValue& dst,
+             const std::vector<int>& dst_swizzle);
    void set_dst_sel(const std::vector<int>& dsel);
    void encode_src(uint64_t& result) const;
    void encode_dst(uint64_t& result) const;
@@ -131,7 +137,7 @@ public:
    enum EEndianSwap {
       es_none = 0,
       es_8in16 = 1,
-      es_8in32 = 1
+      es_8in32 = 2
    };
 
    enum EFlagShift {
@@ -148,6 +154,22 @@ public:
 
    static const uint64_t vtx_mega_fetch_bit = 1ul << 19;
 
+   EFetchInstr vc_opcode() const;
+   uint32_t offset() const;
+   EVTXDataFormat data_format() const;
+   bool is_mega_fetch() const;
+   uint32_t mega_fetch_count() const;
+   uint32_t buffer_id() const;
+   EFetchType fetch_type() const;
+   EBufferIndexMode buffer_index_mode() const;
+   ENumFormat num_format() const;
+   EEndianSwap endian_swap() const;
+   bool test_flag(EFlagShift f) const;
+
+   /* Size of one element in bytes, 0 for formats that can't be
+    * used for vertex fetches */
+   static unsigned data_format_size(EVTXDataFormat format);
+
 private:
    void print(std::ostream& os) const override;
    uint64_t create_bytecode_byte(int i) const override;
@@ -219,6 +241,20 @@ public:
 
    TexFetchNode(uint64_t bc0, uint64_t bc1);
 
+   ETexInst tex_opcode() const;
+   EInstMod inst_mode() const;
+   uint32_t resource_id() const;
+   uint32_t sampler_id() const;
+   const std::vector<int>& offset() const;
+   const std::vector<int>& src_swizzle() const;
+   bool test_flag(ETexFlags f) const;
+
+   /* true if the instruction reads through a sampler, false for loads,
+    * resource queries, and gradient or offset setup */
+   bool uses_sampler() const;
+
+   static const char *opname(ETexInst opcode);
+
 private:
    uint64_t create_bytecode_byte(int i) const override;
    void print(std::ostream& os) const override;
@@ -276,6 +312,10 @@ public:
 
    GDSOpNode(uint64_t bc0, uint64_t bc1);
 
+   ESDOp gds_op() const;
+   const std::vector<int>& src_sel() const;
+   int uav_id() const;
+
 private:
    uint64_t create_bytecode_byte(int i) const override;
    void print(std::ostream& os) const override;
@@ -284,6 +324,11 @@ private:
    int m_dst_rel_mode;
    std::vector<int> m_src_sel;
    ESDOp m_gds_op;
+   int m_src_gpr2;
+   int m_uav_index_mode;
+   int m_uav_id;
+   bool m_alloc_consume;
+   bool m_bcast_first_req;
 };
 
 
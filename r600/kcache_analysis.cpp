@@ -0,0 +1,244 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/kcache_analysis.h>
+
+#include <iostream>
+#include <cassert>
+
+namespace r600 {
+
+using std::set;
+
+/* ALU clauses can hold at most 128 instruction slots */
+static const unsigned max_alu_clause_slots = 128;
+
+static bool is_flow_target_op(uint32_t opcode)
+{
+   switch (opcode) {
+   case cf_jump:
+   case cf_else:
+   case cf_loop_start:
+   case cf_loop_start_dx10:
+   case cf_loop_start_no_al:
+   case cf_loop_end:
+   case cf_loop_break:
+   case cf_loop_continue:
+   case cf_call:
+   case cf_call_fs:
+      return true;
+   default:
+      return false;
+   }
+}
+
+KCacheAnalysis::KCacheAnalysis(const disassembler& program)
+{
+   const auto& prog = program.get_program();
+
+   for (const auto& n: prog) {
+      auto native = dynamic_cast<const CFNativeNode *>(n.get());
+      if (native && is_flow_target_op(native->opcode()))
+         m_branch_targets.insert(native->address());
+   }
+
+   unsigned cf_addr = 0;
+   bool prev_is_alu = false;
+   ClauseInfo prev;
+
+   for (const auto& n: prog) {
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      if (alu) {
+         auto info = analyse_clause(cf_addr, *alu);
+         if (prev_is_alu)
+            check_pair(prev, info);
+         prev = info;
+         prev_is_alu = true;
+      } else {
+         prev_is_alu = false;
+      }
+      cf_addr += n->bytecode_size();
+   }
+}
+
+KCacheAnalysis::ClauseInfo
+KCacheAnalysis::analyse_clause(unsigned cf_addr, const CFAluNode& alu)
+{
+   ClauseInfo info{cf_addr, &alu, set<Line>(), false};
+   bool used[4][2] = {{false, false}, {false, false},
+                      {false, false}, {false, false}};
+   bool unlocked[4] = {false, false, false, false};
+
+   for (const auto& g: alu.clause()) {
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = g.slot(s);
+         if (!node)
+            continue;
+         for (unsigned i = 0; i < node->nsources(); ++i) {
+            auto v = node->get_src(i);
+            if (v->type() != Value::kconst)
+               continue;
+
+            const auto& c = static_cast<const ConstValue&>(*v);
+            unsigned kset = c.kcache_bank();
+
+            if (kset >= alu.nkcache() || alu.kcache_mode(kset) == 0) {
+               if (!unlocked[kset]) {
+                  m_unlocked_reads.push_back({cf_addr, kset});
+                  unlocked[kset] = true;
+               }
+               continue;
+            }
+
+            /* Relative reads may touch both lines of the set */
+            if (c.rel()) {
+               used[kset][0] = used[kset][1] = true;
+               info.relative = true;
+               continue;
+            }
+
+            unsigned line_ofs = c.index() >> 4;
+            used[kset][line_ofs] = true;
+
+            /* Mode 3 locks the lines relative to the loop index */
+            if (alu.kcache_mode(kset) == 3)
+               info.relative = true;
+            else
+               info.lines.insert(Line(alu.kcache_bank(kset),
+                                      alu.kcache_addr(kset) + line_ofs));
+         }
+      }
+   }
+
+   for (unsigned kset = 0; kset < alu.nkcache(); ++kset) {
+      unsigned mode = alu.kcache_mode(kset);
+      if (mode == 0)
+         continue;
+      unsigned nlines = mode == 1 ? 1 : 2;
+      for (unsigned l = 0; l < nlines; ++l) {
+         if (!used[kset][l])
+            m_unused_lines.push_back({cf_addr, kset, alu.kcache_bank(kset),
+                                      alu.kcache_addr(kset) + l});
+      }
+   }
+   return info;
+}
+
+void KCacheAnalysis::check_pair(const ClauseInfo& a, const ClauseInfo& b)
+{
+   /* The first clause must not end with a stack or loop operation, and the
+    * second one must not start with a push, otherwise the execution mask
+    * of the instructions would change when merging the clauses. */
+   unsigned op_a = a.node->opcode() >> 4;
+   unsigned op_b = b.node->opcode() >> 4;
+
+   if (op_a != cf_alu && op_a != cf_alu_push_before &&
+       op_a != cf_alu_extended)
+      return;
+
+   if (op_b == cf_alu_push_before)
+      return;
+
+   if (m_branch_targets.find(b.cf_addr) != m_branch_targets.end())
+      return;
+
+   if (a.node->count() + b.node->count() > max_alu_clause_slots)
+      return;
+
+   if (a.relative || b.relative)
+      return;
+
+   set<Line> lines(a.lines);
+   lines.insert(b.lines.begin(), b.lines.end());
+
+   ClausePair pair{a.cf_addr, b.cf_addr, sets_needed(lines), km_mergeable};
+   if (pair.sets_needed > 4)
+      pair.kind = km_kcache_limit;
+   else if (pair.sets_needed > 2)
+      pair.kind = km_mergeable_extended;
+
+   m_clause_pairs.push_back(pair);
+}
+
+unsigned KCacheAnalysis::sets_needed(const std::set<Line>& lines)
+{
+   unsigned n = 0;
+   bool have_set = false;
+   Line start;
+
+   /* Lines are sorted by buffer and index, so greedily covering the
+    * lowest line not yet locked gives the minimal number of sets */
+   for (const auto& l: lines) {
+      if (have_set && l.first == start.first && l.second <= start.second + 1)
+         continue;
+      start = l;
+      have_set = true;
+      ++n;
+   }
+   return n;
+}
+
+const std::vector<KCacheAnalysis::UnusedLine>&
+KCacheAnalysis::unused_lines() const
+{
+   return m_unused_lines;
+}
+
+const std::vector<KCacheAnalysis::UnlockedRead>&
+KCacheAnalysis::unlocked_reads() const
+{
+   return m_unlocked_reads;
+}
+
+const std::vector<KCacheAnalysis::ClausePair>&
+KCacheAnalysis::clause_pairs() const
+{
+   return m_clause_pairs;
+}
+
+void KCacheAnalysis::print(std::ostream& os) const
+{
+   for (const auto& u: m_unused_lines)
+      os << "CF " << u.cf_addr << ": KC" << u.kcache_set
+         << " locks unused line " << u.line << " of buffer " << u.bank << "\n";
+
+   for (const auto& u: m_unlocked_reads)
+      os << "CF " << u.cf_addr << ": reads from unlocked KC"
+         << u.kcache_set << "\n";
+
+   for (const auto& p: m_clause_pairs) {
+      os << "CF " << p.first_addr << " and " << p.second_addr << ": ";
+      switch (p.kind) {
+      case km_mergeable:
+         os << "mergeable";
+         break;
+      case km_mergeable_extended:
+         os << "split by kcache limit, mergeable with ALU_EXTENDED";
+         break;
+      case km_kcache_limit:
+         os << "split by kcache limit";
+         break;
+      }
+      os << " (" << p.sets_needed << " kcache sets)\n";
+   }
+}
+
+}
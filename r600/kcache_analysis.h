@@ -0,0 +1,107 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_kcache_analysis_h
+#define r600_kcache_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace r600 {
+
+/* Cross-references the constant lines that ALU clauses lock in the
+ * constant cache with the constants that the instructions of the clause
+ * actually read.
+ *
+ * A kcache set locks one or two lines of 16 constants of a constant
+ * buffer. The analysis reports locked lines that are never read, and
+ * checks for adjacent ALU clauses whether they could be merged into one
+ * clause if their kcache windows were combined.
+ */
+class KCacheAnalysis {
+public:
+   /* A constant line is identified by the constant buffer and line index */
+   using Line = std::pair<unsigned, unsigned>;
+
+   enum EMergeKind {
+      /* constants of both clauses fit into two kcache sets */
+      km_mergeable,
+      /* constants need three or four kcache sets, i.e. ALU_EXTENDED */
+      km_mergeable_extended,
+      /* constants need more kcache sets than available */
+      km_kcache_limit
+   };
+
+   struct UnusedLine {
+      unsigned cf_addr;
+      unsigned kcache_set;
+      unsigned bank;
+      unsigned line;
+   };
+
+   struct UnlockedRead {
+      unsigned cf_addr;
+      unsigned kcache_set;
+   };
+
+   struct ClausePair {
+      unsigned first_addr;
+      unsigned second_addr;
+      unsigned sets_needed;
+      EMergeKind kind;
+   };
+
+   KCacheAnalysis(const disassembler& program);
+
+   const std::vector<UnusedLine>& unused_lines() const;
+   const std::vector<UnlockedRead>& unlocked_reads() const;
+   const std::vector<ClausePair>& clause_pairs() const;
+
+   /* Number of kcache sets needed to lock the given lines, each set
+    * covers two consecutive lines of one buffer */
+   static unsigned sets_needed(const std::set<Line>& lines);
+
+   void print(std::ostream& os) const;
+
+private:
+   struct ClauseInfo {
+      unsigned cf_addr;
+      const CFAluNode *node;
+      std::set<Line> lines;
+      bool relative;
+   };
+
+   ClauseInfo analyse_clause(unsigned cf_addr, const CFAluNode& alu);
+   void check_pair(const ClauseInfo& a, const ClauseInfo& b);
+
+   std::set<unsigned> m_branch_targets;
+   std::vector<UnusedLine> m_unused_lines;
+   std::vector<UnlockedRead> m_unlocked_reads;
+   std::vector<ClausePair> m_clause_pairs;
+};
+
+}
+
+#endif
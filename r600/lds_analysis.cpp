@@ -0,0 +1,235 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/lds_analysis.h>
+
+#include <iostream>
+#include <cstdlib>
+
+namespace r600 {
+
+static const char *access_names[LDSAnalysis::ak_count] = {
+   "reads", "paired reads", "writes", "paired writes", "atomics"
+};
+
+static bool same_value(const Value& a, const Value& b)
+{
+   if (a.type() != b.type() || a.sel() != b.sel() || a.chan() != b.chan() ||
+       a.rel() != b.rel() || a.neg() != b.neg() || a.abs() != b.abs())
+      return false;
+
+   if (a.type() == Value::literal)
+      return static_cast<const LiteralValue&>(a).value() ==
+            static_cast<const LiteralValue&>(b).value();
+   return true;
+}
+
+LDSAnalysis::LDSAnalysis(const disassembler& program)
+{
+   unsigned cf_addr = 0;
+   for (const auto& n: program.get_program()) {
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      auto fetch = dynamic_cast<const CFFetchNode *>(n.get());
+      if (alu)
+         analyse_alu_clause(cf_addr, *alu);
+      else if (fetch && fetch->opcode() == cf_gds)
+         analyse_gds_clause(cf_addr, *fetch);
+      cf_addr += n->bytecode_size();
+   }
+}
+
+LDSAnalysis::EAccessKind LDSAnalysis::access_kind(ESDOp op)
+{
+   switch (op) {
+   case DS_OP_READ_RET:
+   case DS_OP_BYTE_READ_RET:
+   case DS_OP_UBYTE_READ_RET:
+   case DS_OP_SHORT_READ_RET:
+   case DS_OP_USHORT_READ_RET:
+      return ak_read;
+   case DS_OP_READ2_RET:
+   case DS_OP_READ_REL_RET:
+      return ak_paired_read;
+   case DS_OP_WRITE:
+   case DS_OP_BYTE_WRITE:
+   case DS_OP_SHORT_WRITE:
+      return ak_write;
+   case DS_OP_WRITE2:
+   case DS_OP_WRITE_REL:
+      return ak_paired_write;
+   default:
+      return ak_atomic;
+   }
+}
+
+unsigned LDSAnalysis::queue_pushes(ESDOp op)
+{
+   switch (op) {
+   case DS_OP_READ2_RET:
+   case DS_OP_READ_REL_RET:
+   case DS_OP_XCHG2_RET:
+   case DS_OP_XCHG_REL_RET:
+      return 2;
+   default:
+      return op >= DS_OP_ADD_RET ? 1 : 0;
+   }
+}
+
+void LDSAnalysis::analyse_alu_clause(unsigned cf_addr, const CFAluNode& alu)
+{
+   ClauseStats stats = {cf_addr, false, {0, 0, 0, 0, 0}, 0, 0, 0, 0};
+   bool unpaired_read = false;
+   std::vector<const AluNodeLDSIdxOP *> unpaired_writes;
+   bool has_lds = false;
+
+   for (const auto& g: alu.clause()) {
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = g.slot(s);
+         if (!node)
+            continue;
+
+         for (unsigned i = 0; i < node->nsources(); ++i) {
+            auto v = node->get_src(i);
+            if (v && v->type() == Value::cinline &&
+                (v->sel() == ALU_SRC_LDS_OQ_A_POP ||
+                 v->sel() == ALU_SRC_LDS_OQ_B_POP)) {
+               ++stats.queue_pops;
+               has_lds = true;
+            }
+         }
+
+         auto lds = dynamic_cast<const AluNodeLDSIdxOP *>(node.get());
+         if (!lds)
+            continue;
+
+         has_lds = true;
+         auto kind = access_kind(lds->lds_op());
+         ++stats.accesses[kind];
+         stats.queue_pushes += queue_pushes(lds->lds_op());
+
+         switch (kind) {
+         case ak_read:
+            if (lds->lds_op() != DS_OP_READ_RET)
+               break;
+            if (unpaired_read) {
+               ++stats.read_pair_candidates;
+               unpaired_read = false;
+            } else {
+               unpaired_read = true;
+            }
+            break;
+         case ak_write: {
+            if (lds->lds_op() != DS_OP_WRITE)
+               break;
+            auto w = unpaired_writes.begin();
+            for (; w != unpaired_writes.end(); ++w) {
+               if (same_value(*(*w)->get_src(0), *lds->get_src(0)) &&
+                   std::abs((*w)->offset() - lds->offset()) == 4)
+                  break;
+            }
+            if (w != unpaired_writes.end()) {
+               ++stats.write_pair_candidates;
+               unpaired_writes.erase(w);
+            } else {
+               unpaired_writes.push_back(lds);
+            }
+            break;
+         }
+         case ak_paired_read:
+         case ak_paired_write:
+            break;
+         default:
+            /* Atomics order the accesses around them */
+            unpaired_read = false;
+            unpaired_writes.clear();
+         }
+      }
+   }
+
+   if (has_lds)
+      m_clauses.push_back(stats);
+}
+
+void LDSAnalysis::analyse_gds_clause(unsigned cf_addr, const CFFetchNode& gds)
+{
+   ClauseStats stats = {cf_addr, true, {0, 0, 0, 0, 0}, 0, 0, 0, 0};
+
+   for (const auto& f: gds.clause()) {
+      auto op = dynamic_cast<const GDSOpNode *>(f.get());
+      if (op)
+         ++stats.accesses[access_kind(op->gds_op())];
+   }
+   m_clauses.push_back(stats);
+}
+
+const std::vector<LDSAnalysis::ClauseStats>& LDSAnalysis::clauses() const
+{
+   return m_clauses;
+}
+
+unsigned LDSAnalysis::lds_total(EAccessKind kind) const
+{
+   unsigned result = 0;
+   for (const auto& c: m_clauses)
+      if (!c.gds)
+         result += c.accesses[kind];
+   return result;
+}
+
+unsigned LDSAnalysis::gds_total(EAccessKind kind) const
+{
+   unsigned result = 0;
+   for (const auto& c: m_clauses)
+      if (c.gds)
+         result += c.accesses[kind];
+   return result;
+}
+
+void LDSAnalysis::print(std::ostream& os) const
+{
+   for (const auto& c: m_clauses) {
+      os << "CF " << c.cf_addr << (c.gds ? ": GDS" : ": LDS");
+      bool first = true;
+      for (unsigned k = 0; k < ak_count; ++k) {
+         if (!c.accesses[k])
+            continue;
+         os << (first ? " " : ", ") << c.accesses[k] << " " << access_names[k];
+         first = false;
+      }
+      os << "\n";
+
+      if (c.gds)
+         continue;
+
+      if (c.queue_pushes != c.queue_pops)
+         os << "CF " << c.cf_addr << ": " << c.queue_pushes
+            << " values pushed to the output queue but " << c.queue_pops
+            << " popped\n";
+      if (c.read_pair_candidates)
+         os << "CF " << c.cf_addr << ": " << c.read_pair_candidates
+            << " pairs of reads could use READ2_RET\n";
+      if (c.write_pair_candidates)
+         os << "CF " << c.cf_addr << ": " << c.write_pair_candidates
+            << " pairs of writes could use WRITE_REL\n";
+   }
+}
+
+}
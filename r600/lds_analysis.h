@@ -0,0 +1,87 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_lds_analysis_h
+#define r600_lds_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Summarizes the local (LDS) and global (GDS) data share accesses of a
+ * program.
+ *
+ * For each ALU clause the LDS reads, writes, and atomics are counted,
+ * together with the values pushed to the LDS output queue and the pops
+ * from it. Single reads that could be combined into READ2_RET, and
+ * single writes to the same address with offsets four bytes apart that
+ * could be combined into one WRITE_REL, are counted as pair candidates.
+ * GDS clauses are summarized by their plain and atomic operations.
+ */
+class LDSAnalysis {
+public:
+   enum EAccessKind {
+      ak_read,
+      ak_paired_read,
+      ak_write,
+      ak_paired_write,
+      ak_atomic,
+      ak_count
+   };
+
+   struct ClauseStats {
+      unsigned cf_addr;
+      bool gds;
+      unsigned accesses[ak_count];
+      unsigned queue_pushes;
+      unsigned queue_pops;
+      unsigned read_pair_candidates;
+      unsigned write_pair_candidates;
+   };
+
+   LDSAnalysis(const disassembler& program);
+
+   const std::vector<ClauseStats>& clauses() const;
+
+   /* Access totals over all LDS clauses */
+   unsigned lds_total(EAccessKind kind) const;
+   unsigned gds_total(EAccessKind kind) const;
+
+   static EAccessKind access_kind(ESDOp op);
+
+   /* Number of values the operation pushes to the LDS output queue */
+   static unsigned queue_pushes(ESDOp op);
+
+   void print(std::ostream& os) const;
+
+private:
+   void analyse_alu_clause(unsigned cf_addr, const CFAluNode& alu);
+   void analyse_gds_clause(unsigned cf_addr, const CFFetchNode& gds);
+
+   std::vector<ClauseStats> m_clauses;
+};
+
+}
+
+#endif
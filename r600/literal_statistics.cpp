@@ -0,0 +1,255 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/literal_statistics.h>
+#include <r600/wavefront.h>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+
+namespace r600 {
+
+using std::vector;
+using std::map;
+
+LiteralStatistics::LiteralStatistics()
+{
+}
+
+bool LiteralStatistics::is_inline_candidate(uint32_t value, bool is_float)
+{
+   switch (value) {
+   case 0x00000000: /* 0 and 0.0 */
+   case 0x3f800000: /* 1.0 */
+   case 0x3f000000: /* 0.5 */
+   case 0x00000001: /* 1 */
+   case 0xffffffff: /* -1 */
+      return true;
+   case 0x80000000: /* -0.0, -1.0, and -0.5 need the neg modifier */
+   case 0xbf800000:
+   case 0xbf000000:
+      return is_float;
+   default:
+      return false;
+   }
+}
+
+void LiteralStatistics::add_group(const AluGroup& group, ProgramStats& stats,
+                                  map<uint32_t, ValueStats>& values)
+{
+   int max_literal_chan = -1;
+
+   for (unsigned s = 0; s < 5; ++s) {
+      auto node = group.slot(s);
+      if (!node)
+         continue;
+
+      auto op = alu_ops.find(node->opcode());
+      bool is_float = op != alu_ops.end() && op->second.is_float;
+
+      for (unsigned i = 0; i < node->nsources(); ++i) {
+         auto v = node->get_src(i);
+         switch (v->type()) {
+         case Value::literal: {
+            auto value = static_cast<const LiteralValue&>(*v).value();
+            auto& vs = values[value];
+            ++vs.reads;
+            ++stats.literal_reads;
+            if (is_inline_candidate(value, is_float)) {
+               vs.inline_candidate = true;
+               ++stats.inline_candidates;
+            }
+            max_literal_chan = std::max(max_literal_chan,
+                                        static_cast<int>(v->chan()));
+            break;
+         }
+         case Value::lds_direct:
+            /* the LDS direct address uses both literal quadwords */
+            max_literal_chan = 3;
+            break;
+         case Value::cinline:
+            if (v->sel() >= ALU_SRC_1_DBL_L && v->sel() <= ALU_SRC_0_5) {
+               ++m_inline_values[v->sel()];
+               ++stats.inline_reads;
+            }
+            break;
+         default:
+            ;
+         }
+      }
+   }
+   stats.literal_qwords += (max_literal_chan + 2) / 2;
+}
+
+void LiteralStatistics::add_program(const disassembler& program)
+{
+   ProgramStats stats;
+   map<uint32_t, ValueStats> values;
+
+   for (const auto& n: program.get_program()) {
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      if (!alu)
+         continue;
+      for (const auto& g: alu->clause())
+         add_group(g, stats, values);
+   }
+
+   for (const auto& v: values) {
+      auto& vs = m_literal_values[v.first];
+      vs.reads += v.second.reads;
+      vs.inline_candidate |= v.second.inline_candidate;
+      ++vs.programs;
+   }
+   m_programs.push_back(stats);
+}
+
+void LiteralStatistics::merge(const LiteralStatistics& other)
+{
+   m_programs.insert(m_programs.end(), other.m_programs.begin(),
+                     other.m_programs.end());
+
+   for (const auto& v: other.m_literal_values) {
+      auto& vs = m_literal_values[v.first];
+      vs.reads += v.second.reads;
+      vs.programs += v.second.programs;
+      vs.inline_candidate |= v.second.inline_candidate;
+   }
+
+   for (const auto& v: other.m_inline_values)
+      m_inline_values[v.first] += v.second;
+}
+
+LiteralStatistics
+LiteralStatistics::collect(const vector<vector<uint64_t>>& corpus,
+                           unsigned nthreads)
+{
+   if (!nthreads)
+      nthreads = std::max(1u, std::thread::hardware_concurrency());
+   nthreads = std::min<size_t>(nthreads, std::max<size_t>(corpus.size(), 1));
+
+   /* Each worker evaluates a contiguous chunk of the corpus, so that
+    * merging the partial results keeps the order of the programs */
+   vector<LiteralStatistics> partial(nthreads);
+   vector<std::exception_ptr> errors(nthreads);
+   vector<std::thread> workers;
+
+   size_t chunk = (corpus.size() + nthreads - 1) / nthreads;
+
+   for (unsigned t = 0; t < nthreads; ++t) {
+      workers.emplace_back([&, t]() {
+         try {
+            size_t end = std::min(corpus.size(), (t + 1) * chunk);
+            for (size_t i = t * chunk; i < end; ++i)
+               partial[t].add_program(disassembler(corpus[i]));
+         } catch (...) {
+            errors[t] = std::current_exception();
+         }
+      });
+   }
+
+   for (auto& w: workers)
+      w.join();
+
+   for (auto& e: errors)
+      if (e)
+         std::rethrow_exception(e);
+
+   LiteralStatistics result;
+   for (const auto& p: partial)
+      result.merge(p);
+   return result;
+}
+
+const vector<LiteralStatistics::ProgramStats>&
+LiteralStatistics::programs() const
+{
+   return m_programs;
+}
+
+LiteralStatistics::ProgramStats LiteralStatistics::total() const
+{
+   ProgramStats sum;
+   for (const auto& p: m_programs) {
+      sum.literal_qwords += p.literal_qwords;
+      sum.literal_reads += p.literal_reads;
+      sum.inline_candidates += p.inline_candidates;
+      sum.inline_reads += p.inline_reads;
+   }
+   return sum;
+}
+
+const map<uint32_t, LiteralStatistics::ValueStats>&
+LiteralStatistics::literal_values() const
+{
+   return m_literal_values;
+}
+
+const map<unsigned, unsigned>& LiteralStatistics::inline_values() const
+{
+   return m_inline_values;
+}
+
+void LiteralStatistics::print(std::ostream& os, unsigned max_values) const
+{
+   auto sum = total();
+   os << "Programs: " << m_programs.size() << "\n"
+      << "Literal quadwords: " << sum.literal_qwords << "\n"
+      << "Literal reads: " << sum.literal_reads
+      << " (inline candidates: " << sum.inline_candidates << ")\n"
+      << "Inline constant reads: " << sum.inline_reads << "\n";
+
+   for (const auto& v: m_inline_values) {
+      auto descr = alu_src_const.find(static_cast<AluInlineConstants>(v.first));
+      std::string name = descr != alu_src_const.end() ?
+                            std::string(descr->second.descr) :
+                            "sel " + std::to_string(v.first);
+      os << "  " << std::setw(12) << std::left << name << v.second << "\n";
+   }
+
+   vector<std::pair<uint32_t, ValueStats>> sorted(m_literal_values.begin(),
+                                                  m_literal_values.end());
+   std::stable_sort(sorted.begin(), sorted.end(),
+                    [](const std::pair<uint32_t, ValueStats>& a,
+                       const std::pair<uint32_t, ValueStats>& b) {
+                       return a.second.reads > b.second.reads;
+                    });
+
+   if (sorted.size() > max_values)
+      sorted.resize(max_values);
+
+   os << "Literal values:\n";
+   for (const auto& v: sorted) {
+      os << "  0x" << std::setw(8) << std::setfill('0') << std::right
+         << std::setbase(16) << v.first << std::setfill(' ')
+         << std::setbase(10) << " (" << lane_float(v.first) << "f, "
+         << static_cast<int32_t>(v.first) << "i) reads:" << v.second.reads
+         << " programs:" << v.second.programs;
+      if (v.second.inline_candidate)
+         os << " inline";
+      os << "\n";
+   }
+}
+
+}
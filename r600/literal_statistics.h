@@ -0,0 +1,93 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_literal_statistics_h
+#define r600_literal_statistics_h
+
+#include <r600/disassembler.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+namespace r600 {
+
+/* Collects literal and inline constant usage of the ALU clauses of one or
+ * many programs.
+ *
+ * Literal reads whose value (possibly negated for float ops) is available
+ * as an inline constant (0, 1.0, 0.5, 1, -1) are counted as inline
+ * candidates, because they spend a literal slot for nothing.
+ */
+class LiteralStatistics {
+public:
+   struct ValueStats {
+      ValueStats(): reads(0), programs(0), inline_candidate(false) {}
+      unsigned reads;
+      unsigned programs;
+      bool inline_candidate;
+   };
+
+   struct ProgramStats {
+      ProgramStats(): literal_qwords(0), literal_reads(0),
+         inline_candidates(0), inline_reads(0) {}
+      unsigned literal_qwords;
+      unsigned literal_reads;
+      unsigned inline_candidates;
+      unsigned inline_reads;
+   };
+
+   LiteralStatistics();
+
+   void add_program(const disassembler& program);
+
+   /* Append the statistics of other, programs keep their order */
+   void merge(const LiteralStatistics& other);
+
+   /* Disassemble and evaluate the corpus using nthreads worker threads,
+    * zero selects the number of hardware threads */
+   static LiteralStatistics collect(const std::vector<std::vector<uint64_t>>& corpus,
+                                    unsigned nthreads = 0);
+
+   /* Whether a literal value can be replaced by an inline constant */
+   static bool is_inline_candidate(uint32_t value, bool is_float);
+
+   const std::vector<ProgramStats>& programs() const;
+   ProgramStats total() const;
+   const std::map<uint32_t, ValueStats>& literal_values() const;
+   const std::map<unsigned, unsigned>& inline_values() const;
+
+   /* Print the totals and the max_values most frequent literals */
+   void print(std::ostream& os, unsigned max_values = 20) const;
+
+private:
+   void add_group(const AluGroup& group, ProgramStats& stats,
+                  std::map<uint32_t, ValueStats>& values);
+
+   std::vector<ProgramStats> m_programs;
+   std::map<uint32_t, ValueStats> m_literal_values;
+   std::map<unsigned, unsigned> m_inline_values;
+};
+
+}
+
+#endif
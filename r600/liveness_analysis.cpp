@@ -0,0 +1,409 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/liveness_analysis.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace r600 {
+
+using RegSet = LivenessAnalysis::RegSet;
+
+/* GPRs 124-127 are clause temporaries, they don't survive the clause */
+static const unsigned first_clause_temp = 124;
+
+static RegSet clause_temps()
+{
+   RegSet result;
+   for (unsigned r = first_clause_temp * 4; r < LivenessAnalysis::nregs; ++r)
+      result.set(r);
+   return result;
+}
+
+static const RegSet temps = clause_temps();
+
+static void read_gpr(RegSet& set, unsigned sel, unsigned chan, bool rel)
+{
+   if (rel) {
+      for (unsigned s = 0; s < 128; ++s)
+         set.set(LivenessAnalysis::reg(s, chan));
+   } else if (sel < 128) {
+      set.set(LivenessAnalysis::reg(sel, chan));
+   }
+}
+
+LivenessAnalysis::LivenessAnalysis(const disassembler& program):
+   m_cfg(program),
+   m_interference(nregs),
+   m_max_live(0),
+   m_max_live_gprs(0),
+   m_max_live_cf(0)
+{
+   for (const auto& n: program.get_program())
+      m_nodes.push_back(n.get());
+
+   m_live_in.resize(m_nodes.size());
+   m_live_out.resize(m_nodes.size());
+   m_through.resize(m_nodes.size());
+
+   collect_regions();
+   do {
+      solve();
+   } while (update_through());
+   record();
+}
+
+unsigned LivenessAnalysis::reg(unsigned sel, unsigned chan)
+{
+   return sel * 4 + chan;
+}
+
+void LivenessAnalysis::collect_regions()
+{
+   for (const auto& l: m_cfg.loops())
+      m_regions.push_back({l.start_cf, l.start_cf + 1, l.end_cf + 1,
+                           l.end_cf + 1});
+
+   for (unsigned i = 0; i < m_nodes.size(); ++i) {
+      auto jump = dynamic_cast<const CFNativeNode *>(m_nodes[i]);
+      if (!jump || dynamic_cast<const CFFetchNode *>(jump) ||
+          jump->opcode() != cf_jump)
+         continue;
+
+      unsigned end = m_cfg.index_of(jump->address());
+      if (end < m_nodes.size()) {
+         auto else_node = dynamic_cast<const CFNativeNode *>(m_nodes[end]);
+         if (else_node && else_node->opcode() == cf_else)
+            end = m_cfg.index_of(else_node->address());
+      }
+      m_regions.push_back({i, i + 1, end, end});
+   }
+}
+
+void LivenessAnalysis::successors(unsigned cf_index,
+                                  std::vector<unsigned>& succ) const
+{
+   succ.clear();
+   unsigned b = m_cfg.block_of(cf_index);
+   if (cf_index + 1 < m_cfg.block(b).end) {
+      succ.push_back(cf_index + 1);
+      return;
+   }
+   for (unsigned i = 0; i < m_cfg.nsuccessors(b); ++i)
+      succ.push_back(m_cfg.block(m_cfg.successor(b, i)).first);
+}
+
+void LivenessAnalysis::solve()
+{
+   std::vector<unsigned> succ;
+   bool changed = true;
+
+   while (changed) {
+      changed = false;
+      for (unsigned i = m_nodes.size(); i-- > 0; ) {
+         RegSet out;
+         successors(i, succ);
+         for (auto s: succ)
+            out |= m_live_in[s];
+
+         RegSet in = transfer(i, out, false);
+         if (in != m_live_in[i] || out != m_live_out[i]) {
+            m_live_in[i] = in;
+            m_live_out[i] = out;
+            changed = true;
+         }
+      }
+   }
+}
+
+bool LivenessAnalysis::update_through()
+{
+   std::vector<RegSet> through(m_nodes.size());
+
+   for (const auto& r: m_regions) {
+      if (r.join >= m_nodes.size())
+         continue;
+      RegSet keep = m_live_in[r.entry] & m_live_in[r.join];
+      for (unsigned i = r.first; i < r.end && i < m_nodes.size(); ++i)
+         through[i] |= keep;
+   }
+
+   bool changed = through != m_through;
+   m_through.swap(through);
+   return changed;
+}
+
+void LivenessAnalysis::record()
+{
+   for (unsigned i = 0; i < m_nodes.size(); ++i) {
+      track_pressure(m_live_in[i], i);
+      transfer(i, m_live_out[i], true);
+   }
+}
+
+RegSet LivenessAnalysis::transfer(unsigned cf_index, RegSet live, bool record)
+{
+   const CFNode *n = m_nodes[cf_index];
+   const RegSet& through = m_through[cf_index];
+   live |= through;
+
+   if (auto alu = dynamic_cast<const CFAluNode *>(n)) {
+      live = transfer_alu(*alu, through, live, record, cf_index);
+   } else if (auto fetch = dynamic_cast<const CFFetchNode *>(n)) {
+      live = transfer_fetch(*fetch, through, live, record, cf_index);
+   } else if (auto mem = dynamic_cast<const CFMemNode *>(n)) {
+      std::vector<unsigned> chans;
+      auto exp = dynamic_cast<const CFExportNode *>(mem);
+      auto mem_exp = dynamic_cast<const CFMemExportNode *>(mem);
+      auto comp = dynamic_cast<const CFMemCompNode *>(mem);
+      for (unsigned c = 0; c < 4; ++c) {
+         if (exp && exp->sel()[c] < 4)
+            chans.push_back(exp->sel()[c]);
+         else if (mem_exp && mem_exp->sel()[c] < 4)
+            chans.push_back(mem_exp->sel()[c]);
+         else if (comp && (comp->comp_mask() & (1 << c)))
+            chans.push_back(c);
+         else if (!exp && !mem_exp && !comp)
+            chans.push_back(c);
+      }
+
+      bool rel = mem->test_flag(CFNode::rw_rel);
+      for (int i = 0; i <= mem->get_burst_count(); ++i)
+         for (auto c: chans)
+            read_gpr(live, (mem->rw_gpr() + i) & 0x7f, c, rel);
+
+      if (mem->is_indexed())
+         for (unsigned c = 0; c < 4; ++c)
+            read_gpr(live, mem->index_gpr(), c, false);
+   }
+
+   return live;
+}
+
+RegSet LivenessAnalysis::transfer_alu(const CFAluNode& alu,
+                                      const RegSet& through,
+                                      RegSet live, bool record,
+                                      unsigned cf_index)
+{
+   live &= ~temps;
+
+   const auto& clause = alu.clause();
+   for (auto g = clause.rbegin(); g != clause.rend(); ++g) {
+      RegSet reads;
+      RegSet defs;
+      RegSet kills;
+
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = g->slot(s);
+         if (!node)
+            continue;
+
+         for (unsigned i = 0; i < node->nsources(); ++i) {
+            auto v = node->get_src(i);
+            if (v && v->type() == Value::gpr)
+               read_gpr(reads, v->sel(), v->chan(), v->rel());
+         }
+
+         auto d = dynamic_cast<const AluNodeWithDst *>(node.get());
+         if (!d || !d->writes_dst() || d->dst().rel() ||
+             d->dst().sel() >= 128)
+            continue;
+
+         unsigned r = reg(d->dst().sel(), d->dst().chan());
+         defs.set(r);
+         if (d->pred_select() == AluNode::pred_sel_off)
+            kills.set(r);
+      }
+
+      if (record) {
+         define(defs, live);
+         track_pressure(live, cf_index);
+      }
+      live = (live & ~kills) | reads | through;
+   }
+
+   return live & ~temps;
+}
+
+RegSet LivenessAnalysis::transfer_fetch(const CFFetchNode& fetch,
+                                        const RegSet& through,
+                                        RegSet live, bool record,
+                                        unsigned cf_index)
+{
+   const auto& clause = fetch.clause();
+   for (auto f = clause.rbegin(); f != clause.rend(); ++f) {
+      RegSet reads;
+      RegSet defs;
+
+      const auto& dst = (*f)->dst();
+      if (!dst.rel()) {
+         for (unsigned c = 0; c < 4; ++c)
+            if ((*f)->dst_swizzle()[c] != 7)
+               defs.set(reg(dst.sel(), c));
+      }
+
+      const auto& src = (*f)->src();
+      if (auto tex = dynamic_cast<const TexFetchNode *>(f->get())) {
+         for (auto c: tex->src_swizzle())
+            if (c < 4)
+               read_gpr(reads, src.sel(), c, src.rel());
+      } else if (auto gds = dynamic_cast<const GDSOpNode *>(f->get())) {
+         for (auto c: gds->src_sel())
+            if (c < 4)
+               read_gpr(reads, src.sel(), c, src.rel());
+      } else if (dynamic_cast<const VertexFetchNode *>(f->get())) {
+         read_gpr(reads, src.sel(), src.chan(), src.rel());
+      } else {
+         for (unsigned c = 0; c < 4; ++c)
+            read_gpr(reads, src.sel(), c, src.rel());
+      }
+
+      if (record) {
+         define(defs, live);
+         track_pressure(live, cf_index);
+      }
+      live = (live & ~defs) | reads | through;
+   }
+   return live;
+}
+
+void LivenessAnalysis::define(const RegSet& defs, const RegSet& live)
+{
+   if (defs.none())
+      return;
+
+   for (unsigned d = 0; d < nregs; ++d) {
+      if (!defs.test(d))
+         continue;
+      RegSet others = live;
+      others.reset(d);
+      m_interference[d] |= others;
+      for (unsigned r = 0; r < nregs; ++r)
+         if (others.test(r))
+            m_interference[r].set(d);
+   }
+}
+
+unsigned LivenessAnalysis::count_gprs(const RegSet& set)
+{
+   unsigned result = 0;
+   for (unsigned sel = 0; sel < 128; ++sel)
+      if (set.test(reg(sel, 0)) || set.test(reg(sel, 1)) ||
+          set.test(reg(sel, 2)) || set.test(reg(sel, 3)))
+         ++result;
+   return result;
+}
+
+void LivenessAnalysis::track_pressure(const RegSet& live, unsigned cf_index)
+{
+   unsigned channels = live.count();
+   if (channels > m_max_live) {
+      m_max_live = channels;
+      m_max_live_gprs = count_gprs(live);
+      m_max_live_cf = cf_index;
+   }
+}
+
+const ControlFlowGraph& LivenessAnalysis::cfg() const
+{
+   return m_cfg;
+}
+
+const RegSet& LivenessAnalysis::live_in(unsigned cf_index) const
+{
+   assert(cf_index < m_live_in.size());
+   return m_live_in[cf_index];
+}
+
+const RegSet& LivenessAnalysis::live_out(unsigned cf_index) const
+{
+   assert(cf_index < m_live_out.size());
+   return m_live_out[cf_index];
+}
+
+const RegSet& LivenessAnalysis::interference(unsigned reg) const
+{
+   assert(reg < nregs);
+   return m_interference[reg];
+}
+
+bool LivenessAnalysis::interfere(unsigned a, unsigned b) const
+{
+   return interference(a).test(b);
+}
+
+unsigned LivenessAnalysis::max_live_channels() const
+{
+   return m_max_live;
+}
+
+unsigned LivenessAnalysis::max_live_gprs() const
+{
+   return m_max_live_gprs;
+}
+
+unsigned LivenessAnalysis::max_live_cf() const
+{
+   return m_max_live_cf;
+}
+
+void LivenessAnalysis::print_set(std::ostream& os, const RegSet& set)
+{
+   bool first = true;
+   for (unsigned sel = 0; sel < 128; ++sel) {
+      bool any = false;
+      for (unsigned c = 0; c < 4; ++c) {
+         if (!set.test(reg(sel, c)))
+            continue;
+         if (!any)
+            os << (first ? "" : " ") << "R" << sel << ".";
+         os << Value::component_names[c];
+         any = true;
+         first = false;
+      }
+   }
+   if (first)
+      os << "-";
+}
+
+void LivenessAnalysis::print(std::ostream& os) const
+{
+   for (unsigned i = 0; i < m_nodes.size(); ++i) {
+      os << "CF " << m_cfg.cf_address(i) << ": in ";
+      print_set(os, m_live_in[i]);
+      os << ", out ";
+      print_set(os, m_live_out[i]);
+      os << "\n";
+   }
+
+   unsigned edges = 0;
+   for (const auto& r: m_interference)
+      edges += r.count();
+
+   os << "max live: " << m_max_live << " channels in " << m_max_live_gprs
+      << " GPRs at CF " << (m_nodes.empty() ? 0 : m_cfg.cf_address(m_max_live_cf))
+      << "\n";
+   os << "interference: " << edges / 2 << " edges\n";
+}
+
+}
@@ -0,0 +1,116 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_liveness_analysis_h
+#define r600_liveness_analysis_h
+
+#include <r600/control_flow_graph.h>
+
+#include <bitset>
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Per channel GPR liveness over the whole program.
+ *
+ * Register sets are bitsets over the 128 GPRs times 4 channels, indexed
+ * by sel * 4 + chan. The live sets are solved over the control flow
+ * graph at the level of CF instructions, and inside of ALU and fetch
+ * clauses the clause is walked group by group to build the
+ * interference graph and find the highest register pressure.
+ *
+ * Since the threads of a wavefront may diverge, a write inside of an
+ * if/else region or a loop doesn't end the live range of a value that
+ * is live at both the entry and the join of that region: the inactive
+ * threads still need the old value. Predicated and relative writes
+ * never end a live range, and relative reads read the channel of all
+ * GPRs. The clause temporaries 124-127 are never live across clauses.
+ */
+class LivenessAnalysis {
+public:
+   static const unsigned nregs = 128 * 4;
+   using RegSet = std::bitset<nregs>;
+
+   LivenessAnalysis(const disassembler& program);
+
+   const ControlFlowGraph& cfg() const;
+
+   /* Live sets before and after each CF instruction, indexed like the
+    * program */
+   const RegSet& live_in(unsigned cf_index) const;
+   const RegSet& live_out(unsigned cf_index) const;
+
+   /* Registers that are live at a point where the given one is written
+    * or that are written while the given one is live */
+   const RegSet& interference(unsigned reg) const;
+   bool interfere(unsigned a, unsigned b) const;
+
+   unsigned max_live_channels() const;
+   unsigned max_live_gprs() const;
+   unsigned max_live_cf() const;
+
+   static unsigned reg(unsigned sel, unsigned chan);
+   static unsigned count_gprs(const RegSet& set);
+   static void print_set(std::ostream& os, const RegSet& set);
+
+   void print(std::ostream& os) const;
+
+private:
+   struct Region {
+      unsigned entry;
+      unsigned first;
+      unsigned end;
+      unsigned join;
+   };
+
+   void collect_regions();
+   void successors(unsigned cf_index, std::vector<unsigned>& succ) const;
+   void solve();
+   bool update_through();
+   void record();
+
+   RegSet transfer(unsigned cf_index, RegSet live, bool record);
+   RegSet transfer_alu(const CFAluNode& alu, const RegSet& through,
+                       RegSet live, bool record, unsigned cf_index);
+   RegSet transfer_fetch(const CFFetchNode& fetch, const RegSet& through,
+                         RegSet live, bool record, unsigned cf_index);
+
+   void define(const RegSet& defs, const RegSet& live);
+   void track_pressure(const RegSet& live, unsigned cf_index);
+
+   ControlFlowGraph m_cfg;
+   std::vector<const CFNode *> m_nodes;
+   std::vector<Region> m_regions;
+
+   std::vector<RegSet> m_live_in;
+   std::vector<RegSet> m_live_out;
+   std::vector<RegSet> m_through;
+   std::vector<RegSet> m_interference;
+
+   unsigned m_max_live;
+   unsigned m_max_live_gprs;
+   unsigned m_max_live_cf;
+};
+
+}
+
+#endif
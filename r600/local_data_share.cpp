@@ -0,0 +1,183 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/local_data_share.h>
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+namespace r600 {
+
+using std::runtime_error;
+
+const unsigned LocalDataShare::page_bytes;
+
+LocalDataShare::LocalDataShare(unsigned size):
+   m_data((size + 3) / 4, 0),
+   m_stamps((4 * m_data.size() + page_bytes - 1) / page_bytes)
+{
+}
+
+unsigned LocalDataShare::size() const
+{
+   return 4 * m_data.size();
+}
+
+uint32_t LocalDataShare::read(unsigned address) const
+{
+   unsigned i = address / 4;
+   return i < m_data.size() ? m_data[i] : 0;
+}
+
+void LocalDataShare::write(unsigned address, uint32_t value)
+{
+   write_masked(address, value, 0xffffffff);
+}
+
+void LocalDataShare::write_masked(unsigned address, uint32_t value,
+                                  uint32_t mask)
+{
+   unsigned i = address / 4;
+   if (i < m_data.size()) {
+      m_data[i] = (m_data[i] & ~mask) | (value & mask);
+      m_stamps.touch(4 * i / page_bytes);
+   }
+}
+
+void LocalDataShare::clear()
+{
+   std::fill(m_data.begin(), m_data.end(), 0);
+   m_stamps.touch_all();
+}
+
+const PageStamps& LocalDataShare::stamps() const
+{
+   return m_stamps;
+}
+
+bool LocalDataShare::supported(ESDOp op)
+{
+   switch (op) {
+   case DS_OP_WRITE_REL:
+   case DS_OP_CMP_STORE_SPF:
+   case DS_OP_XCHG_REL_RET:
+   case DS_OP_CMP_XCHG_SPF_RET:
+   case DS_OP_READ_REL_RET:
+   case DS_OP_READWRITE_RET:
+   case DS_OP_ATOMIC_ORDERED_ALLOC_RET:
+      return false;
+   default:
+      return lds_ops.find(op) != lds_ops.end();
+   }
+}
+
+void LocalDataShare::execute(ESDOp op, int offset, const Lanes * const *src,
+                             LaneMask active, Wavefront& wf)
+{
+   if (!supported(op)) {
+      std::ostringstream msg;
+      msg << "LocalDataShare: unsupported op " << op;
+      throw runtime_error(msg.str());
+   }
+
+   /* The atomics and writes up to CMP_STORE have a _RET variant that
+    * differs only in bit 5 */
+   const bool ret = op >= DS_OP_ADD_RET;
+   const ESDOp base = op < DS_OP_READ_RET ? static_cast<ESDOp>(op & ~32) : op;
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      if (!(active & (LaneMask(1) << i)))
+         continue;
+
+      const unsigned address = (src[0] ? (*src[0])[i] : 0) + offset;
+      const uint32_t b = src[1] ? (*src[1])[i] : 0;
+      const uint32_t c = src[2] ? (*src[2])[i] : 0;
+      const uint32_t old = read(address);
+      const unsigned byte_shift = 8 * (address & 3);
+      const unsigned short_shift = 8 * (address & 2);
+      uint32_t result = old;
+
+      switch (base) {
+      case DS_OP_ADD: write(address, old + b); break;
+      case DS_OP_SUB: write(address, old - b); break;
+      case DS_OP_RSUB: write(address, b - old); break;
+      case DS_OP_INC: write(address, old >= b ? 0 : old + 1); break;
+      case DS_OP_DEC:
+         write(address, (old == 0 || old > b) ? b : old - 1);
+         break;
+      case DS_OP_MIN_INT:
+         write(address, int32_t(b) < int32_t(old) ? b : old);
+         break;
+      case DS_OP_MAX_INT:
+         write(address, int32_t(b) > int32_t(old) ? b : old);
+         break;
+      case DS_OP_MIN_UINT: write(address, b < old ? b : old); break;
+      case DS_OP_MAX_UINT: write(address, b > old ? b : old); break;
+      case DS_OP_AND: write(address, old & b); break;
+      case DS_OP_OR: write(address, old | b); break;
+      case DS_OP_XOR: write(address, old ^ b); break;
+      case DS_OP_MSKOR: write(address, (old & ~b) | c); break;
+      case DS_OP_WRITE: write(address, b); break;
+      case DS_OP_WRITE2:
+         if (ret)
+            wf.lds_queue(1, i).push_back(read(address + 4));
+         write(address, b);
+         write(address + 4, c);
+         break;
+      case DS_OP_CMP_STORE:
+         if (old == b)
+            write(address, c);
+         break;
+      case DS_OP_BYTE_WRITE:
+         write_masked(address, b << byte_shift, 0xffu << byte_shift);
+         break;
+      case DS_OP_SHORT_WRITE:
+         write_masked(address, b << short_shift, 0xffffu << short_shift);
+         break;
+      case DS_OP_READ_RET:
+         break;
+      case DS_OP_READ2_RET:
+         wf.lds_queue(1, i).push_back(read(b + offset));
+         break;
+      case DS_OP_BYTE_READ_RET:
+         result = static_cast<uint32_t>(static_cast<int8_t>(old >> byte_shift));
+         break;
+      case DS_OP_UBYTE_READ_RET:
+         result = (old >> byte_shift) & 0xff;
+         break;
+      case DS_OP_SHORT_READ_RET:
+         result = static_cast<uint32_t>(static_cast<int16_t>(old >> short_shift));
+         break;
+      case DS_OP_USHORT_READ_RET:
+         result = (old >> short_shift) & 0xffff;
+         break;
+      default:
+         assert(0 && "LDS op not handled");
+      }
+
+      if (ret)
+         wf.lds_queue(0, i).push_back(result);
+   }
+}
+
+}
@@ -0,0 +1,82 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_local_data_share_h
+#define r600_local_data_share_h
+
+#include <r600/alu_defines.h>
+#include <r600/wavefront.h>
+
+#include <vector>
+
+namespace r600 {
+
+/* The local data share (LDS) of a workgroup.
+ *
+ * The LDS is a byte addressed arena that is shared by the wavefronts
+ * of a workgroup. Dword accesses ignore the two lowest address bits,
+ * short accesses the lowest bit. Reads outside the arena return zero
+ * and writes outside of it are dropped.
+ *
+ * An LDS instruction is executed for the active threads one after the
+ * other in ascending thread order, so that atomic operations on the
+ * same address always give the same results. The address is src0 plus
+ * the instruction offset in bytes. The _RET variants push the value
+ * before the operation to the output queue A of the thread, READ2_RET
+ * and XCHG2_RET push the second value to queue B.
+ */
+class LocalDataShare {
+public:
+   /* The LDS size of an Evergreen compute unit */
+   static const unsigned default_size = 32768;
+
+   LocalDataShare(unsigned size = default_size);
+
+   unsigned size() const;
+
+   uint32_t read(unsigned address) const;
+   void write(unsigned address, uint32_t value);
+
+   /* Clear the arena, e.g. before a workgroup starts */
+   void clear();
+
+   /* Bytes per page of the write stamps */
+   static const unsigned page_bytes = 1024;
+   const PageStamps& stamps() const;
+
+   static bool supported(ESDOp op);
+
+   /* Execute an LDS instruction with the sources src for the active
+    * threads of wf, throws std::runtime_error if the op is not
+    * supported */
+   void execute(ESDOp op, int offset, const Lanes * const *src,
+                LaneMask active, Wavefront& wf);
+
+private:
+   void write_masked(unsigned address, uint32_t value, uint32_t mask);
+
+   std::vector<uint32_t> m_data;
+   PageStamps m_stamps;
+};
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/rat_analysis.h>
+
+#include <iostream>
+
+namespace r600 {
+
+static bool is_partial_store(const RATAnalysis::Access& a)
+{
+   return a.kind == RATAnalysis::rk_store && a.comp_mask != 0xf;
+}
+
+RATAnalysis::RATAnalysis(const disassembler& program)
+{
+   unsigned cf_addr = 0;
+   unsigned outstanding = 0;
+
+   for (const auto& n: program.get_program()) {
+      auto rat = dynamic_cast<const CFRatNode *>(n.get());
+      auto native = dynamic_cast<const CFNativeNode *>(n.get());
+
+      if (rat) {
+         Access a = {cf_addr, rat->rat_id(), rat->rat_inst(),
+                     kind(rat->rat_inst()),
+                     rat->opcode() == cf_mem_rat_cacheless ||
+                     rat->opcode() == cf_mem_rat_combined_cacheless,
+                     rat->requests_ack(), rat->rw_gpr(), rat->comp_mask(),
+                     static_cast<unsigned>(rat->get_burst_count()) + 1};
+         m_accesses.push_back(a);
+
+         auto& s = m_rat_stats[a.rat_id];
+         switch (a.kind) {
+         case rk_store:
+            ++s.stores;
+            break;
+         case rk_atomic_return:
+            ++s.returning_atomics;
+            /* fallthrough */
+         case rk_atomic:
+            ++s.atomics;
+            break;
+         default:
+            ;
+         }
+         if (a.cacheless)
+            ++s.cacheless;
+         if (is_partial_store(a))
+            ++s.partial_masks;
+         if (a.ack)
+            ++outstanding;
+      } else if (native && native->opcode() == cf_wait_ack) {
+         m_ack_waits.push_back({cf_addr, outstanding});
+         outstanding = 0;
+      }
+      cf_addr += n->bytecode_size();
+   }
+}
+
+RATAnalysis::EKind RATAnalysis::kind(unsigned rat_inst)
+{
+   if (rat_inst == 0 || rat_inst == 32)
+      return rk_nop;
+   if (rat_inst < 4)
+      return rk_store;
+   if (rat_inst < 32)
+      return rk_atomic;
+   return rk_atomic_return;
+}
+
+const std::vector<RATAnalysis::Access>& RATAnalysis::accesses() const
+{
+   return m_accesses;
+}
+
+const std::map<unsigned, RATAnalysis::Stats>& RATAnalysis::rat_stats() const
+{
+   return m_rat_stats;
+}
+
+const std::vector<RATAnalysis::AckWait>& RATAnalysis::ack_waits() const
+{
+   return m_ack_waits;
+}
+
+RATAnalysis::Stats RATAnalysis::total() const
+{
+   Stats result = {0, 0, 0, 0, 0};
+   for (const auto& s: m_rat_stats) {
+      result.stores += s.second.stores;
+      result.atomics += s.second.atomics;
+      result.returning_atomics += s.second.returning_atomics;
+      result.cacheless += s.second.cacheless;
+      result.partial_masks += s.second.partial_masks;
+   }
+   return result;
+}
+
+void RATAnalysis::print(std::ostream& os) const
+{
+   auto w = m_ack_waits.begin();
+
+   for (const auto& a: m_accesses) {
+      for (; w != m_ack_waits.end() && w->cf_addr < a.cf_addr; ++w)
+         os << "CF " << w->cf_addr << ": WAIT_ACK for "
+            << w->outstanding << " writes\n";
+
+      os << "CF " << a.cf_addr << ": RAT" << a.rat_id << " "
+         << CFRatNode::rat_inst_string(a.rat_inst) << " R" << a.rw_gpr;
+      if (a.burst > 1)
+         os << "-R" << a.rw_gpr + a.burst - 1;
+      os << ".";
+      for (int i = 0; i < 4; ++i)
+         os << (a.comp_mask & (1 << i) ? Value::component_names[i] : '_');
+      os << (a.cacheless ? " cacheless" : " cached");
+      if (a.ack)
+         os << " ack";
+      if (is_partial_store(a))
+         os << " partial";
+      os << "\n";
+   }
+   for (; w != m_ack_waits.end(); ++w)
+      os << "CF " << w->cf_addr << ": WAIT_ACK for "
+         << w->outstanding << " writes\n";
+
+   for (const auto& s: m_rat_stats) {
+      os << "RAT" << s.first << ": " << s.second.stores << " stores, "
+         << s.second.atomics << " atomics ("
+         << s.second.returning_atomics << " returning), "
+         << s.second.cacheless << " cacheless, "
+         << s.second.partial_masks << " partial masks\n";
+   }
+
+   auto t = total();
+   os << "total: " << t.stores << " stores, " << t.atomics << " atomics, "
+      << t.cacheless << " cacheless, "
+      << m_accesses.size() - t.cacheless << " cached, "
+      << m_ack_waits.size() << " ACK waits\n";
+}
+
+}
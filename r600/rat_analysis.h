@@ -0,0 +1,95 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_rat_analysis_h
+#define r600_rat_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+namespace r600 {
+
+/* Summarizes the RAT (UAV) memory traffic of a program.
+ *
+ * Each MEM_RAT instruction is classified as store or atomic, and as
+ * cached or cacheless access. Stores with a partial component mask are
+ * counted because the write still occupies a full vec4 slot, and each
+ * WAIT_ACK is reported together with the number of acknowledged writes
+ * issued since the last wait, since it stalls the program until all of
+ * them have completed.
+ */
+class RATAnalysis {
+public:
+   enum EKind {
+      rk_nop,
+      rk_store,
+      rk_atomic,
+      rk_atomic_return
+   };
+
+   struct Access {
+      unsigned cf_addr;
+      unsigned rat_id;
+      unsigned rat_inst;
+      EKind kind;
+      bool cacheless;
+      bool ack;
+      unsigned rw_gpr;
+      unsigned comp_mask;
+      unsigned burst;
+   };
+
+   struct Stats {
+      unsigned stores;
+      unsigned atomics;
+      unsigned returning_atomics;
+      unsigned cacheless;
+      unsigned partial_masks;
+   };
+
+   struct AckWait {
+      unsigned cf_addr;
+      unsigned outstanding;
+   };
+
+   RATAnalysis(const disassembler& program);
+
+   const std::vector<Access>& accesses() const;
+   const std::map<unsigned, Stats>& rat_stats() const;
+   const std::vector<AckWait>& ack_waits() const;
+   Stats total() const;
+
+   static EKind kind(unsigned rat_inst);
+
+   void print(std::ostream& os) const;
+
+private:
+   std::vector<Access> m_accesses;
+   std::map<unsigned, Stats> m_rat_stats;
+   std::vector<AckWait> m_ack_waits;
+};
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/alu_interpreter.h>
+#include <r600/disassembler.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class AluInterpreterTest: public BytecodeTest {
+protected:
+   AluInterpreterTest();
+
+   /* Run the ALU instructions as one clause */
+   void run(const vector<uint64_t>& code,
+            std::tuple<int, int, int> kcache0 = std::make_tuple(0, 0, 0));
+
+   Wavefront wf;
+};
+
+AluInterpreterTest::AluInterpreterTest()
+{
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(0, 0)[i] = lane_bits(static_cast<float>(i));
+      wf.gpr(0, 1)[i] = lane_bits(2.0f);
+      wf.gpr(0, 2)[i] = i;
+      wf.gpr(0, 3)[i] = lane_bits(-0.25f);
+   }
+}
+
+void AluInterpreterTest::run(const vector<uint64_t>& code,
+                             std::tuple<int, int, int> kcache0)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, code.size(), kcache0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.insert(bc.end(), code.begin(), code.end());
+
+   disassembler diss(bc);
+   auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(alu);
+   AluInterpreter::run(*alu, wf);
+}
+
+TEST_F(AluInterpreterTest, FloatOpsAndForwarding)
+{
+   run({op2(op2_add, 1, 0, gpr(0, 0), gpr(0, 1), false),
+        op2(op2_mul_ieee, 1, 1, gpr(0, 0), gpr(0, 1)),
+        op2(op2_mov, 2, 0, inline_const(ALU_SRC_PV, 1), PValue(), false),
+        op3(op3_muladd, 2, 1, gpr(0, 0), gpr(0, 3),
+            inline_const(ALU_SRC_PV, 0), false),
+        op2(op2_recip_ieee, 2, 2, gpr(0, 1), PValue())});
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(lane_float(wf.gpr(1, 0)[i]), i + 2.0f);
+      EXPECT_EQ(lane_float(wf.gpr(1, 1)[i]), i * 2.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 0)[i]), i * 2.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 1)[i]), i * -0.25f + i + 2.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 2)[i]), 0.5f);
+   }
+   /* the RECIP was scheduled in the trans slot */
+   EXPECT_EQ(lane_float(wf.pv(4)[0]), 0.5f);
+}
+
+TEST_F(AluInterpreterTest, ModifiersAndConstants)
+{
+   auto constants = std::make_shared<ConstantBuffer>(4 * 32, 0);
+   (*constants)[4 * 17 + 2] = lane_bits(3.0f);
+   wf.set_constant_buffer(1, constants);
+
+   vector<uint64_t> code = {
+      op2(op2_add, 1, 0, gpr(0, 3, true, false), gpr(0, 3, false, true),
+          false, AluOpFlags(), AluNode::omod_mul_4),
+      op2(op2_mul_ieee, 1, 1, gpr(0, 0), literal(), false,
+          AluOpFlags().set(AluNode::do_clamp)),
+      op2(op2_mov, 1, 2, Value::create(129, 2, 0, 0, 0, nullptr), PValue()),
+   };
+   code.push_back(lane_bits(0.125f));
+
+   run(code, std::make_tuple(1, 1, 1));
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(lane_float(wf.gpr(1, 0)[i]), 2.0f);
+      EXPECT_EQ(lane_float(wf.gpr(1, 1)[i]), i >= 8 ? 1.0f : i * 0.125f);
+      EXPECT_EQ(lane_float(wf.gpr(1, 2)[i]), 3.0f);
+   }
+}
+
+TEST_F(AluInterpreterTest, IntegerOpsAndDot4)
+{
+   run({op2(op2_lshl_int, 1, 0, gpr(0, 2), inline_const(ALU_SRC_1_INT), false),
+        op2(op2_setgt_int, 1, 1, gpr(0, 2), inline_const(ALU_SRC_1_INT), false),
+        op3(op3_bfe_uint, 1, 2, gpr(0, 2), inline_const(ALU_SRC_1_INT),
+            inline_const(ALU_SRC_1_INT)),
+        op2(op2_dot4_ieee, 2, 0, gpr(0, 0), gpr(0, 1), false),
+        op2(op2_dot4_ieee, 2, 1, gpr(0, 1), gpr(0, 1), false),
+        op2(op2_dot4_ieee, 2, 2, inline_const(ALU_SRC_0), gpr(0, 1), false),
+        op2(op2_dot4_ieee, 2, 3, gpr(0, 3), inline_const(ALU_SRC_1))});
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(wf.gpr(1, 0)[i], 2 * i);
+      EXPECT_EQ(wf.gpr(1, 1)[i], i > 1 ? 0xffffffffu : 0u);
+      EXPECT_EQ(wf.gpr(1, 2)[i], (i >> 1) & 1);
+      for (unsigned c = 0; c < 4; ++c)
+         EXPECT_EQ(lane_float(wf.gpr(2, c)[i]), 2.0f * i + 4.0f - 0.25f);
+   }
+}
+
+TEST_F(AluInterpreterTest, PredicateAndExecMask)
+{
+   AluOpFlags pred_flags;
+   pred_flags.set(AluNode::do_update_pred);
+   pred_flags.set(AluNode::do_update_exec_mask);
+
+   run({op2(op2_pred_setgt_int, 1, 0, gpr(0, 2), literal(), true,
+            pred_flags),
+        31,
+        op2(op2_mov, 1, 1, inline_const(ALU_SRC_1_INT), PValue(), true,
+            AluOpFlags(), AluNode::omod_off, AluNode::pred_sel_one),
+        op2(op2_kille_int, 1, 2, gpr(0, 2), inline_const(ALU_SRC_0))});
+
+   EXPECT_EQ(wf.predicate(), 0xffffffff00000000ull);
+   EXPECT_EQ(wf.active(), 0xffffffff00000000ull);
+   EXPECT_EQ(wf.valid(), ~1ull);
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(wf.gpr(1, 0)[i], i > 31 ? 0u : 1u);
+      EXPECT_EQ(wf.gpr(1, 1)[i], i > 31 ? 1u : 0u);
+   }
+   EXPECT_EQ(lane_float(wf.gpr(1, 2)[0]), 1.0f);
+   EXPECT_EQ(lane_float(wf.gpr(1, 2)[1]), 0.0f);
+}
+
+TEST_F(AluInterpreterTest, UnsupportedInstruction)
+{
+   EXPECT_TRUE(AluInterpreter::supported(op2_muladd_prev) == false);
+   EXPECT_TRUE(AluInterpreter::supported(op2_add));
+   EXPECT_THROW(run({op2(op2_cube, 1, 0, gpr(0, 0), gpr(0, 1))}),
+                std::runtime_error);
+}
@@ -0,0 +1,434 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/alu_reference.h>
+#include <r600/compiled_alu_clause.h>
+#include <r600/disassembler.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+/* Runs random ALU groups through AluReference and compares the
+ * results of AluInterpreter and CompiledAluClause with and without
+ * native code against it.
+ *
+ * Each case is a clause with a single group, so the differences are
+ * reported per group. The number of cases and the seed can be set with
+ * R600_ALU_DIFF_CASES and R600_ALU_DIFF_SEED.
+ */
+class AluReferenceTest: public testing::Test {
+protected:
+   enum ETolerance {
+      /* any NaN matches any other NaN */
+      tol_nan = 1,
+      /* +0.0 matches -0.0 */
+      tol_signed_zero = 2
+   };
+
+   AluReferenceTest();
+
+   unsigned environment(const char *name, unsigned default_value) const;
+   uint32_t random_value();
+   void randomize(Wavefront& wf);
+
+   PValue random_source(bool allow_abs, Value::LiteralFlags& literals);
+   uint64_t random_instruction(EAluOp op, int chan, bool last,
+                               Value::LiteralFlags& literals,
+                               vector<unsigned>& tolerance,
+                               unsigned& pv_tolerance);
+   vector<uint64_t> random_group(std::array<unsigned, 5>& pv_tolerance,
+                                 vector<unsigned>& tolerance);
+
+   static bool same(uint32_t a, uint32_t b, unsigned tolerance);
+   static unsigned tolerance_of(EAluOp op);
+
+   void compare(const Wavefront& expect, const Wavefront& wf,
+                const std::array<unsigned, 5>& pv_tolerance,
+                const vector<unsigned>& tolerance,
+                const char *what, const disassembler& code);
+
+   std::mt19937 rng;
+   vector<EAluOp> vector_ops;
+   vector<EAluOp> trans_ops;
+   vector<float> rel_literals;
+};
+
+AluReferenceTest::AluReferenceTest():
+   rng(environment("R600_ALU_DIFF_SEED", 0x600))
+{
+   auto add_op = [this](EAluOp op) {
+      if (!AluInterpreter::supported(op))
+         return;
+      PAluNode node;
+      if (op >= op3_bfe_uint)
+         node.reset(new AluNodeOp3(op, GPRValue(0, 0, 0, 0, 0), PValue(),
+                                   PValue(), PValue(), AluOpFlags()));
+      else
+         node.reset(new AluNodeOp2(op, GPRValue(0, 0, 0, 0, 0), PValue(),
+                                   PValue(), AluOpFlags()));
+      if (node->slot_supported(AluOp::x) && node->slot_supported(AluOp::y) &&
+          node->slot_supported(AluOp::z) && node->slot_supported(AluOp::w))
+         vector_ops.push_back(op);
+      if (node->slot_supported(AluOp::t))
+         trans_ops.push_back(op);
+   };
+
+   for (int op = 0; op < 256; ++op)
+      add_op(static_cast<EAluOp>(op));
+   for (int op = 4; op < 32; ++op)
+      add_op(static_cast<EAluOp>(op << 6));
+}
+
+unsigned AluReferenceTest::environment(const char *name,
+                                       unsigned default_value) const
+{
+   const char *v = getenv(name);
+   return v ? strtoul(v, nullptr, 0) : default_value;
+}
+
+uint32_t AluReferenceTest::random_value()
+{
+   static const uint32_t special[] = {
+      0, 0x80000000, 0x3f800000, 0xbf800000, 0x3f000000, 0x7fc00000,
+      0xffc00001, 0x7f800000, 0xff800000, 0x00000001, 0x807fffff,
+      0x7f7fffff, 0x4f000000, 0xcf000000, 0x4f800000, 0xffffffff,
+      1, 2, 31, 32, 0x7fffffff, 0x00ffffff
+   };
+
+   switch (rng() % 5) {
+   case 0:
+      return special[rng() % (sizeof(special) / sizeof(special[0]))];
+   case 1:
+      return rng() % 65 - 32;
+   case 2:
+      return lane_bits(static_cast<float>(static_cast<int>(rng() % 2001)
+                                          - 1000) / 8.0f);
+   case 3:
+      return lane_bits(std::uniform_real_distribution<float>(-4.0f, 4.0f)(rng));
+   default:
+      return rng();
+   }
+}
+
+void AluReferenceTest::randomize(Wavefront& wf)
+{
+   for (unsigned r = 0; r < 16; ++r)
+      for (unsigned c = 0; c < 4; ++c)
+         for (auto& v: wf.gpr(r, c))
+            v = random_value();
+   for (unsigned s = 0; s < 5; ++s)
+      for (auto& v: wf.pv(s))
+         v = random_value();
+   for (auto& v: wf.ar())
+      v = rng() % 8 - 2;
+   wf.set_loop_index(rng() % 8);
+   wf.set_predicate((uint64_t(rng()) << 32) | rng());
+   LaneMask active = (uint64_t(rng()) << 32) | rng();
+   wf.set_active(rng() % 4 ? active | 1 : ~LaneMask(0));
+}
+
+PValue AluReferenceTest::random_source(bool allow_abs,
+                                       Value::LiteralFlags& literals)
+{
+   static const int inline_sels[] = {
+      ALU_SRC_0, ALU_SRC_1, ALU_SRC_1_INT, ALU_SRC_M_1_INT, ALU_SRC_0_5,
+      ALU_SRC_PV, ALU_SRC_PS, ALU_SRC_LOOP_IDX, ALU_SRC_MASK_LO
+   };
+
+   bool abs = allow_abs && rng() % 4 == 0;
+   bool neg = rng() % 4 == 0;
+
+   switch (rng() % 10) {
+   case 0:
+   case 1: {
+      int chan = rng() % 4;
+      literals.set(chan);
+      return Value::create(ALU_SRC_LITERAL, chan, abs, false, neg, &literals);
+   }
+   case 2: {
+      int sel = inline_sels[rng() % (sizeof(inline_sels) / sizeof(inline_sels[0]))];
+      return Value::create(sel, rng() % 4, abs, false, neg, nullptr);
+   }
+   case 3:
+      return Value::create(128 + rng() % 16, rng() % 4, abs, false, neg,
+                           nullptr);
+   case 4:
+      /* relative to AR.x or the loop index, partly out of range */
+      return Value::create(rng() % 16, rng() % 4, abs, true, neg, nullptr);
+   default:
+      return Value::create(rng() % 16, rng() % 4, abs, false, neg, nullptr);
+   }
+}
+
+unsigned AluReferenceTest::tolerance_of(EAluOp op)
+{
+   auto sem = AluInterpreter::semantics(op);
+   unsigned tolerance = sem->float_result ? tol_nan : 0;
+   /* DX10 MIN/MAX leave the order of signed zeros open */
+   if (op == op2_min_dx10 || op == op2_max_dx10)
+      tolerance |= tol_signed_zero;
+   return tolerance;
+}
+
+uint64_t AluReferenceTest::random_instruction(EAluOp op, int chan, bool last,
+                                              Value::LiteralFlags& literals,
+                                              vector<unsigned>& tolerance,
+                                              unsigned& pv_tolerance)
+{
+   static const AluNode::EPredSelect pred_sel[] = {
+      AluNode::pred_sel_off, AluNode::pred_sel_off, AluNode::pred_sel_zero,
+      AluNode::pred_sel_one
+   };
+
+   AluOpFlags flags;
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   if (rng() % 8 == 0)
+      flags.set(AluNode::do_clamp);
+   if (rng() % 2)
+      flags.set(AluNode::do_update_pred);
+   if (rng() % 4 == 0)
+      flags.set(AluNode::do_update_exec_mask);
+
+   auto index_mode = rng() % 2 ? AluNode::idx_ar_x : AluNode::idx_loop;
+   bool dst_rel = rng() % 8 == 0;
+   GPRValue dst(rng() % 16, chan, 0, dst_rel, 0);
+
+   unsigned t = tolerance_of(op);
+   pv_tolerance = t;
+   if (dst_rel) {
+      for (unsigned sel = 0; sel < Wavefront::ngprs; ++sel)
+         tolerance[4 * sel + chan] |= t;
+   } else {
+      tolerance[4 * dst.sel() + chan] |= t;
+   }
+
+   /* Only create the sources that are decoded, unused literals would
+    * break the group */
+   if (op >= op3_bfe_uint) {
+      AluNodeOp3 probe(op, dst, PValue(), PValue(), PValue(), AluOpFlags());
+      PValue src[3];
+      for (unsigned k = 0; k < probe.nsources() && k < 3; ++k)
+         src[k] = random_source(false, literals);
+      return AluNodeOp3(op, dst, src[0], src[1], src[2], flags,
+                        index_mode, AluNode::alu_vec_012,
+                        pred_sel[rng() % 4]).bytecode();
+   }
+
+   if (rng() % 8)
+      flags.set(AluNode::do_write);
+   AluNodeOp2 probe(op, dst, PValue(), PValue(), AluOpFlags());
+   PValue src0 = probe.nsources() > 0 ? random_source(true, literals) : PValue();
+   PValue src1 = probe.nsources() > 1 ? random_source(true, literals) : PValue();
+   auto omod = static_cast<AluNode::EOutputModify>(rng() % 4);
+   return AluNodeOp2(op, dst, src0, src1, flags, index_mode,
+                     AluNode::alu_vec_012, omod,
+                     pred_sel[rng() % 4]).bytecode();
+}
+
+vector<uint64_t> AluReferenceTest::random_group(std::array<unsigned, 5>& pv_tolerance,
+                                                vector<unsigned>& tolerance)
+{
+   vector<uint64_t> code;
+   Value::LiteralFlags literals;
+   pv_tolerance.fill(0);
+
+   /* pick the operations per slot first, so that the last one can be
+    * flagged */
+   vector<std::pair<EAluOp, int>> slots;
+   if (rng() % 8 == 0) {
+      /* a complete DOT4 or MAX4 */
+      EAluOp op = rng() % 4 ? (rng() % 2 ? op2_dot4 : op2_dot4_ieee) : op2_max4;
+      for (int c = 0; c < 4; ++c)
+         slots.push_back(std::make_pair(op, c));
+   } else {
+      for (int c = 0; c < 4; ++c)
+         if (rng() % 3)
+            slots.push_back(std::make_pair(vector_ops[rng() % vector_ops.size()], c));
+   }
+   if (slots.empty())
+      slots.push_back(std::make_pair(vector_ops[rng() % vector_ops.size()], 0));
+
+   /* The trans slot writes a channel that is already used */
+   bool trans = rng() % 2;
+   if (trans)
+      slots.push_back(std::make_pair(trans_ops[rng() % trans_ops.size()],
+                                     slots[rng() % slots.size()].second));
+
+   for (unsigned i = 0; i < slots.size(); ++i) {
+      bool last = i + 1 == slots.size();
+      unsigned slot = trans && last ? 4 : slots[i].second;
+      code.push_back(random_instruction(slots[i].first, slots[i].second, last,
+                                        literals, tolerance,
+                                        pv_tolerance[slot]));
+   }
+
+   for (unsigned lp = 0; lp < 2; ++lp)
+      if (literals.test(2 * lp) || literals.test(2 * lp + 1))
+         code.push_back((uint64_t(random_value()) << 32) | random_value());
+   return code;
+}
+
+bool AluReferenceTest::same(uint32_t a, uint32_t b, unsigned tolerance)
+{
+   if (a == b)
+      return true;
+   if ((tolerance & tol_nan) && std::isnan(lane_float(a)) &&
+       std::isnan(lane_float(b)))
+      return true;
+   if ((tolerance & tol_signed_zero) && !((a | b) & 0x7fffffff))
+      return true;
+   return false;
+}
+
+void AluReferenceTest::compare(const Wavefront& expect, const Wavefront& wf,
+                               const std::array<unsigned, 5>& pv_tolerance,
+                               const vector<unsigned>& tolerance,
+                               const char *what, const disassembler& code)
+{
+   EXPECT_EQ(wf.active(), expect.active()) << what << "\n" << code.as_string();
+   EXPECT_EQ(wf.valid(), expect.valid()) << what << "\n" << code.as_string();
+   EXPECT_EQ(wf.predicate(), expect.predicate()) << what << "\n" << code.as_string();
+   EXPECT_EQ(wf.ar(), expect.ar()) << what << "\n" << code.as_string();
+
+   for (unsigned s = 0; s < 5; ++s)
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         if (!same(wf.pv(s)[i], expect.pv(s)[i], pv_tolerance[s])) {
+            ADD_FAILURE() << what << ": PV" << s << " lane " << i << ": "
+                          << std::hex << wf.pv(s)[i] << " != "
+                          << expect.pv(s)[i] << "\n" << code.as_string();
+            return;
+         }
+
+   for (unsigned r = 0; r < Wavefront::ngprs; ++r)
+      for (unsigned c = 0; c < 4; ++c) {
+         if (wf.gpr(r, c) == expect.gpr(r, c))
+            continue;
+         for (unsigned i = 0; i < wavefront_size; ++i)
+            if (!same(wf.gpr(r, c)[i], expect.gpr(r, c)[i],
+                      tolerance[4 * r + c])) {
+               ADD_FAILURE() << what << ": R" << r << "." << "xyzw"[c]
+                             << " lane " << i << ": " << std::hex
+                             << wf.gpr(r, c)[i] << " != "
+                             << expect.gpr(r, c)[i] << "\n" << code.as_string();
+               return;
+            }
+      }
+}
+
+TEST_F(AluReferenceTest, ReferenceSupportsInterpreterOps)
+{
+   uint32_t src[3] = {0, 0, 0};
+   AluReference::Result r;
+   for (auto ops: {vector_ops, trans_ops})
+      for (auto op: ops)
+         EXPECT_TRUE(AluReference::evaluate(op, src, r)) << op;
+   EXPECT_FALSE(AluReference::evaluate(op2_cube, src, r));
+}
+
+TEST_F(AluReferenceTest, KnownResults)
+{
+   const uint32_t nan = 0x7fc00000;
+   const uint32_t inf = 0x7f800000;
+   AluReference::Result r;
+
+   uint32_t zero_inf[3] = {0, inf, 0};
+   ASSERT_TRUE(AluReference::evaluate(op2_mul, zero_inf, r));
+   EXPECT_EQ(r.value, 0u);
+   ASSERT_TRUE(AluReference::evaluate(op2_mul_ieee, zero_inf, r));
+   EXPECT_TRUE(std::isnan(lane_float(r.value)));
+
+   uint32_t one_nan[3] = {lane_bits(1.0f), nan, 0};
+   ASSERT_TRUE(AluReference::evaluate(op2_max, one_nan, r));
+   EXPECT_EQ(r.value, nan);
+   ASSERT_TRUE(AluReference::evaluate(op2_max_dx10, one_nan, r));
+   EXPECT_EQ(r.value, lane_bits(1.0f));
+
+   uint32_t bits[3] = {0xf0f0f0f0, 4, 8};
+   ASSERT_TRUE(AluReference::evaluate(op3_bfe_int, bits, r));
+   EXPECT_EQ(r.value, 0x0f);
+   ASSERT_TRUE(AluReference::evaluate(op3_bfe_uint, bits, r));
+   EXPECT_EQ(r.value, 0x0f);
+   bits[1] = 0;
+   ASSERT_TRUE(AluReference::evaluate(op3_bfe_int, bits, r));
+   EXPECT_EQ(r.value, 0xfffffff0);
+
+   uint32_t gt[3] = {3, 2, 0};
+   ASSERT_TRUE(AluReference::evaluate(op2_pred_setgt_int, gt, r));
+   EXPECT_EQ(r.effect, AluReference::re_predicate);
+   EXPECT_TRUE(r.condition);
+   EXPECT_EQ(r.value, 0u);
+   ASSERT_TRUE(AluReference::evaluate(op2_killgt_uint, gt, r));
+   EXPECT_EQ(r.effect, AluReference::re_kill);
+   EXPECT_EQ(r.value, lane_bits(1.0f));
+}
+
+TEST_F(AluReferenceTest, RandomGroups)
+{
+   const unsigned ncases = environment("R600_ALU_DIFF_CASES", 2000);
+
+   for (unsigned n = 0; n < ncases && !HasFailure(); ++n) {
+      auto constants = std::make_shared<ConstantBuffer>(4 * 32, 0);
+      for (auto& c: *constants)
+         c = random_value();
+      Wavefront wf;
+      wf.set_constant_buffer(1, constants);
+      randomize(wf);
+
+      std::array<unsigned, 5> pv_tolerance;
+      vector<unsigned> tolerance(4 * Wavefront::ngprs, 0);
+      auto code = random_group(pv_tolerance, tolerance);
+
+      vector<uint64_t> bc;
+      CFAluNode(cf_alu, 0, 2, code.size(), std::make_tuple(1, 1, 0))
+            .append_bytecode(bc);
+      CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+      bc.insert(bc.end(), code.begin(), code.end());
+
+      disassembler diss(bc);
+      auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+      ASSERT_TRUE(alu);
+      ASSERT_EQ(alu->clause().size(), 1u);
+
+      SCOPED_TRACE(testing::Message() << "case " << n);
+
+      Wavefront expect(wf);
+      AluReference::run(*alu, expect);
+
+      Wavefront interpreted(wf);
+      AluInterpreter::run(*alu, interpreted);
+      compare(expect, interpreted, pv_tolerance, tolerance, "interpreter",
+              diss);
+
+      Wavefront compiled(wf);
+      CompiledAluClause(*alu).run(compiled);
+      compare(expect, compiled, pv_tolerance, tolerance, "compiled",
+              diss);
+
+      Wavefront native(wf);
+      CompiledAluClause(*alu, true).run(native);
+      compare(expect, native, pv_tolerance, tolerance, "native", diss);
+   }
+}
@@ -0,0 +1,176 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/bank_swizzle.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class BankSwizzleTest: public BytecodeTest {
+protected:
+   PAluNode op2_node(EAluOp opcode, int dst_sel, int dst_chan,
+                     PValue src0, PValue src1,
+                     AluNode::EBankSwizzle swz = AluNode::alu_vec_012,
+                     bool last = false) const;
+
+   PAluNode op3_node(EAluOp opcode, int dst_sel, int dst_chan,
+                     PValue src0, PValue src1, PValue src2,
+                     AluNode::EBankSwizzle swz = AluNode::alu_vec_012,
+                     bool last = false) const;
+
+   PValue kc(int idx, int chan) const;
+
+   void decode(const vector<PAluNode>& ops, AluGroup& g) const;
+};
+
+PAluNode BankSwizzleTest::op2_node(EAluOp opcode, int dst_sel, int dst_chan,
+                                   PValue src0, PValue src1,
+                                   AluNode::EBankSwizzle swz, bool last) const
+{
+   AluOpFlags flags;
+   flags.set(AluNode::do_write);
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return PAluNode(new AluNodeOp2(opcode, GPRValue(dst_sel, dst_chan, 0, 0, 0),
+                                  src0, src1, flags, AluNode::idx_ar_x, swz));
+}
+
+PAluNode BankSwizzleTest::op3_node(EAluOp opcode, int dst_sel, int dst_chan,
+                                   PValue src0, PValue src1, PValue src2,
+                                   AluNode::EBankSwizzle swz, bool last) const
+{
+   AluOpFlags flags;
+   flags.set(AluNode::is_op3);
+   if (last)
+      flags.set(AluNode::is_last_instr);
+   return PAluNode(new AluNodeOp3(opcode, GPRValue(dst_sel, dst_chan, 0, 0, 0),
+                                  src0, src1, src2, flags,
+                                  AluNode::idx_ar_x, swz));
+}
+
+PValue BankSwizzleTest::kc(int idx, int chan) const
+{
+   return Value::create(128 + idx, chan, false, false, false, nullptr);
+}
+
+void BankSwizzleTest::decode(const vector<PAluNode>& ops, AluGroup& g) const
+{
+   vector<uint64_t> bc;
+   for (auto& op: ops)
+      bc.push_back(op->bytecode());
+   g.decode(bc, 0, bc.size());
+}
+
+TEST_F(BankSwizzleTest, LegalGroup)
+{
+   AluGroup g;
+   decode({op2_node(op2_add, 1, 0, gpr(2, 0), gpr(3, 1)),
+           op2_node(op2_add, 1, 1, gpr(2, 0), gpr(3, 1), AluNode::alu_vec_012, true)}, g);
+
+   EXPECT_TRUE(BankSwizzleCheck::check(g).legal());
+
+   BankSwizzleCheck::Swizzles swz;
+   ASSERT_TRUE(BankSwizzleCheck::best_swizzle(g, swz));
+   EXPECT_EQ(swz, BankSwizzleCheck::current(g));
+}
+
+TEST_F(BankSwizzleTest, GPRConflictAndFix)
+{
+   AluGroup g;
+   decode({op2_node(op2_add, 1, 0, gpr(2, 0), gpr(3, 1)),
+           op2_node(op2_add, 1, 1, gpr(4, 0), gpr(5, 1), AluNode::alu_vec_012, true)}, g);
+
+   auto r = BankSwizzleCheck::check(g);
+   EXPECT_EQ(r.status, BankSwizzleCheck::bs_gpr_conflict);
+   EXPECT_EQ(r.slot, 1);
+
+   BankSwizzleCheck::Swizzles swz;
+   ASSERT_TRUE(BankSwizzleCheck::best_swizzle(g, swz));
+   EXPECT_TRUE(BankSwizzleCheck::check(g, swz).legal());
+   auto cur = BankSwizzleCheck::current(g);
+   EXPECT_EQ(swz[0], cur[0]);
+   EXPECT_NE(swz[1], cur[1]);
+
+   BankSwizzleCheck::apply(g, swz);
+   EXPECT_TRUE(BankSwizzleCheck::check(g).legal());
+}
+
+TEST_F(BankSwizzleTest, ConstOveruse)
+{
+   AluGroup g;
+   decode({op2_node(op2_add, 1, 0, kc(0, 0), kc(1, 0)),
+           op2_node(op2_add, 1, 1, kc(2, 0), gpr(5, 1), AluNode::alu_vec_012, true)}, g);
+
+   auto r = BankSwizzleCheck::check(g);
+   EXPECT_EQ(r.status, BankSwizzleCheck::bs_const_overuse);
+   EXPECT_EQ(r.slot, 1);
+
+   BankSwizzleCheck::Swizzles swz;
+   EXPECT_FALSE(BankSwizzleCheck::best_swizzle(g, swz));
+}
+
+TEST_F(BankSwizzleTest, ConstPairSharesPort)
+{
+   AluGroup g;
+   decode({op2_node(op2_add, 1, 0, kc(0, 0), kc(1, 0)),
+           op2_node(op2_add, 1, 1, kc(0, 1), kc(1, 1), AluNode::alu_vec_012, true)}, g);
+
+   EXPECT_TRUE(BankSwizzleCheck::check(g).legal());
+}
+
+TEST_F(BankSwizzleTest, TransConstCycle)
+{
+   AluGroup g;
+   decode({op2_node(op2_add, 1, 0, gpr(2, 0), gpr(3, 1)),
+           op3_node(op3_muladd, 2, 0, kc(0, 0), kc(1, 0), gpr(4, 2),
+                    AluNode::sq_alu_scl_201, true)}, g);
+
+   auto r = BankSwizzleCheck::check(g);
+   EXPECT_EQ(r.status, BankSwizzleCheck::bs_trans_cycle_conflict);
+   EXPECT_EQ(r.slot, 4);
+
+   BankSwizzleCheck::Swizzles swz;
+   ASSERT_TRUE(BankSwizzleCheck::best_swizzle(g, swz));
+   EXPECT_EQ(swz[4], AluNode::sq_alu_scl_122);
+}
+
+TEST_F(BankSwizzleTest, Report)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 2).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2_node(op2_add, 1, 0, gpr(2, 0), gpr(3, 1))->bytecode());
+   bc.push_back(op2_node(op2_add, 1, 1, gpr(4, 0), gpr(5, 1),
+                         AluNode::alu_vec_012, true)->bytecode());
+
+   CFAluNode alu(bc[0]);
+   alu.disassemble_clause(bc);
+
+   std::ostringstream os;
+   EXPECT_EQ(BankSwizzleCheck::report(alu, os), 1u);
+   EXPECT_EQ(os.str(),
+             "Group 0: GPR read port conflict in slot y, fix: y:VEC_120\n"
+             "1 of 1 groups with read port conflicts\n");
+}
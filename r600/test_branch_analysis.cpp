@@ -0,0 +1,101 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/branch_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class BranchAnalysisTest: public BytecodeTest {
+protected:
+   void append_movs(vector<uint64_t>& bc, unsigned ngroups) const;
+};
+
+/* One MOV per group */
+void BranchAnalysisTest::append_movs(vector<uint64_t>& bc,
+                                     unsigned ngroups) const
+{
+   for (unsigned i = 0; i < ngroups; ++i)
+      bc.push_back(mov(i + 1, 0, gpr(0, 0)));
+}
+
+TEST_F(BranchAnalysisTest, RegionsAndPredication)
+{
+   vector<uint64_t> bc;
+   /* if-else with a fetch in the then side */
+   CFAluNode(cf_alu_push_before, 0, 12, 1).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 4, 1).append_bytecode(bc);
+   CFFetchNode(cf_tc, 0, 20, 1).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 13, 3).append_bytecode(bc);
+   CFNativeNode(cf_else, 0, 6, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_pop_after, 0, 16, 2).append_bytecode(bc);
+   /* small if without else */
+   CFAluNode(cf_alu_push_before, 0, 18, 1).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 9, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_pop_after, 0, 19, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.resize(12);
+
+   append_movs(bc, 1);
+   append_movs(bc, 3);
+   append_movs(bc, 2);
+   append_movs(bc, 1);
+   append_movs(bc, 1);
+   tex(bc, TexFetchNode::tex_sample, 1, 0);
+   tex(bc, TexFetchNode::tex_sample, 2, 0);
+
+   BranchAnalysis::Parameters params;
+   params.expensive_cost = 6;
+
+   disassembler diss(bc);
+   BranchAnalysis ba(diss, params);
+
+   ASSERT_EQ(ba.regions().size(), 2u);
+   const auto& r0 = ba.regions()[0];
+   EXPECT_EQ(r0.jump_addr, 1u);
+   EXPECT_EQ(r0.else_addr, 4);
+   EXPECT_EQ(r0.end_addr, 6u);
+   EXPECT_EQ(r0.then_side.alu_groups, 3u);
+   EXPECT_EQ(r0.then_side.fetches, 2u);
+   EXPECT_FALSE(r0.then_side.simple);
+   EXPECT_EQ(r0.else_side.alu_groups, 2u);
+   EXPECT_EQ(r0.divergent_cost(), 7u);
+   EXPECT_EQ(r0.uniform_cost(), 5u);
+
+   const auto& r1 = ba.regions()[1];
+   EXPECT_EQ(r1.else_addr, -1);
+   EXPECT_TRUE(r1.then_side.simple);
+
+   EXPECT_EQ(ba.expensive_regions(), vector<unsigned>({0}));
+   EXPECT_EQ(ba.predication_candidates(), vector<unsigned>({1}));
+
+   std::ostringstream os;
+   ba.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 1-6: then 3 ALU groups, 2 fetches, else 2 ALU groups, "
+             "cost 5 uniform, 7 divergent\n"
+             "CF 7-9: then 1 ALU groups, cost 1 uniform, 1 divergent\n"
+             "CF 1: divergent execution costs 7\n"
+             "CF 7: branch over 1 ALU groups could be predicated\n");
+}
@@ -0,0 +1,79 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/cayman_estimate.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class CaymanEstimateTest: public BytecodeTest {
+};
+
+TEST_F(CaymanEstimateTest, SlotCounts)
+{
+   EXPECT_EQ(CaymanEstimate::cayman_slots(op2_add), 1u);
+   EXPECT_EQ(CaymanEstimate::cayman_slots(op2_recip_ieee), 3u);
+   EXPECT_EQ(CaymanEstimate::cayman_slots(op2_mullo_int), 4u);
+   EXPECT_EQ(CaymanEstimate::cayman_slots(op2_int_to_flt), 1u);
+}
+
+TEST_F(CaymanEstimateTest, TransInstructions)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 9).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   /* RECIP needs x, y, and z, which are partly in use */
+   bc.push_back(op2(op2_add, 1, 0, gpr(0, 0), gpr(0, 1), false));
+   bc.push_back(op2(op2_add, 1, 1, gpr(0, 0), gpr(0, 1), false));
+   bc.push_back(op2(op2_recip_ieee, 2, 0, gpr(0, 0), gpr(0, 1)));
+
+   /* RECIP fits next to the w instruction */
+   bc.push_back(op2(op2_add, 1, 3, gpr(0, 0), gpr(0, 1), false));
+   bc.push_back(op2(op2_recip_ieee, 2, 1, gpr(0, 0), gpr(0, 1)));
+
+   /* MULLO_INT needs all four slots */
+   bc.push_back(op2(op2_add, 1, 0, gpr(0, 0), gpr(0, 1), false));
+   bc.push_back(op2(op2_mullo_int, 3, 3, gpr(0, 0), gpr(0, 1)));
+
+   /* the conversion becomes a vector instruction in y */
+   bc.push_back(op2(op2_add, 1, 0, gpr(0, 0), gpr(0, 1), false));
+   bc.push_back(op2(op2_int_to_flt, 4, 1, gpr(0, 0), gpr(0, 1)));
+
+   disassembler diss(bc);
+   CaymanEstimate est(diss);
+
+   ASSERT_EQ(est.clauses().size(), 1u);
+   EXPECT_EQ(est.clauses()[0].replicated, 3u);
+   EXPECT_EQ(est.groups(), 4u);
+   EXPECT_EQ(est.cayman_groups(), 6u);
+   EXPECT_DOUBLE_EQ(est.slowdown(), 1.5);
+
+   std::ostringstream os;
+   est.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: 4 groups, 6 on Cayman, 3 replicated trans ops\n"
+             "total: 4 groups, 6 on Cayman, slowdown 1.50\n");
+}
@@ -0,0 +1,150 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/cf_emulator.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class CFEmulatorTest: public BytecodeTest {
+protected:
+   CFEmulatorTest();
+
+   Wavefront wf;
+};
+
+CFEmulatorTest::CFEmulatorTest()
+{
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(0, 0)[i] = i;
+      wf.gpr(0, 1)[i] = i & 3;
+   }
+}
+
+TEST_F(CFEmulatorTest, IfElse)
+{
+   disassembler diss(if_else_program(31));
+   CFEmulator emu(diss, wf);
+   emu.run();
+
+   EXPECT_TRUE(emu.finished());
+   EXPECT_EQ(emu.steps(), 7u);
+   EXPECT_EQ(emu.max_stack_depth(), 1u);
+   EXPECT_TRUE(emu.stack().empty());
+   EXPECT_EQ(wf.active(), ~0ull);
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      EXPECT_EQ(wf.gpr(1, 0)[i], i > 31 ? 1u : 0xffffffffu);
+}
+
+TEST_F(CFEmulatorTest, UniformBranchIsSkipped)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu_push_before, 0, 5, 2).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 3, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_pop_after, 0, 7, 1).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 8, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(pred_setgt_int(gpr(0, 0), literal()));
+   bc.push_back(100);
+   bc.push_back(op2(op2_mov, 1, 0, inline_const(ALU_SRC_1_INT), PValue()));
+   bc.push_back(op2(op2_mov, 1, 1, inline_const(ALU_SRC_1_INT), PValue()));
+
+   disassembler diss(bc);
+   CFEmulator emu(diss, wf);
+   emu.run();
+
+   /* The JUMP pops the stack and skips the clause */
+   EXPECT_EQ(emu.steps(), 4u);
+   EXPECT_TRUE(emu.stack().empty());
+   EXPECT_EQ(wf.active(), ~0ull);
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(wf.gpr(1, 0)[i], 0u);
+      EXPECT_EQ(wf.gpr(1, 1)[i], 1u);
+   }
+}
+
+TEST_F(CFEmulatorTest, LoopWithBreak)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_loop_start_dx10, 0, 7).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 8, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_push_before, 0, 9, 1).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 5).append_bytecode(bc);
+   CFNativeNode(cf_loop_break, 0, 6).append_bytecode(bc);
+   CFNativeNode(cf_pop, 0, 6, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(op2(op2_add_int, 1, 0, gpr(1, 0), inline_const(ALU_SRC_1_INT)));
+   bc.push_back(pred_setgt_int(gpr(1, 0), gpr(0, 1)));
+
+   disassembler diss(bc);
+   CFEmulator emu(diss, wf);
+   emu.run();
+
+   EXPECT_TRUE(emu.stack().empty());
+   EXPECT_EQ(emu.max_stack_depth(), 2u);
+   EXPECT_EQ(wf.active(), ~0ull);
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      EXPECT_EQ(wf.gpr(1, 0)[i], (i & 3) + 1);
+}
+
+TEST_F(CFEmulatorTest, CountedLoopWithIndex)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_loop_start, 0, 3, 0, 0, 0, 2).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 4, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1, 0, 0, 0, 2).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2(op2_add_int, 1, 0, gpr(1, 0),
+                    inline_const(ALU_SRC_LOOP_IDX)));
+
+   CFEmulator::Parameters params;
+   /* four iterations, start at 2, increment by 3 */
+   params.loop_constants[2] = 4 | (2 << 12) | (3 << 24);
+
+   disassembler diss(bc);
+   CFEmulator emu(diss, wf, params);
+   emu.run();
+
+   EXPECT_EQ(emu.steps(), 10u);
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      EXPECT_EQ(wf.gpr(1, 0)[i], 2u + 5u + 8u + 11u);
+}
+
+TEST_F(CFEmulatorTest, EndlessLoopIsCaught)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_loop_start_dx10, 0, 2).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   CFEmulator::Parameters params;
+   params.max_steps = 100;
+
+   disassembler diss(bc);
+   CFEmulator emu(diss, wf, params);
+   EXPECT_THROW(emu.run(), std::runtime_error);
+}
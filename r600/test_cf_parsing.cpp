@@ -256,7 +256,7 @@ TEST_F(TestDisassember, AllCFOpsEOP)
        "TC_ACK                \n"
        "VC_ACK                \n"
        "JUMP_TABLE             JTS:CA ADDR:0\n"
-       "GLOBAL_WAVE_SYNC      \n"
+       "GLOBAL_WAVE_SYNC      SEMA_V V:0 SE:0 VIDX:N RIDX:N \n"
        "HALT                  \n"
           /* gap 32-63*/
        "MEM_STREAM0_BUF0       R0.____ ARR_SIZE:0 ARR_BASE:0 ES:1 BC:0\n"
@@ -0,0 +1,251 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/compiled_alu_clause.h>
+#include <r600/disassembler.h>
+#include <r600/local_data_share.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class CompiledAluClauseTest: public BytecodeTest {
+protected:
+   CompiledAluClauseTest();
+
+   /* Run the code with the interpreter and the compiled clause and
+    * compare the resulting wavefront states */
+   void compare(const vector<uint64_t>& code, bool native = false);
+
+   Wavefront wf;
+};
+
+CompiledAluClauseTest::CompiledAluClauseTest()
+{
+   auto constants = std::make_shared<ConstantBuffer>(4 * 32, 0);
+   for (unsigned i = 0; i < constants->size(); ++i)
+      (*constants)[i] = lane_bits(0.5f * i);
+   wf.set_constant_buffer(1, constants);
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(0, 0)[i] = lane_bits(static_cast<float>(i));
+      wf.gpr(0, 1)[i] = lane_bits(2.0f);
+      wf.gpr(0, 2)[i] = i;
+      wf.gpr(0, 3)[i] = lane_bits(-0.25f);
+      wf.gpr(3, 0)[i] = i & 3;
+      for (unsigned r = 4; r < 8; ++r)
+         wf.gpr(r, 1)[i] = r * 100 + i;
+   }
+
+   /* All pairs of some values that need special care. Which NaN is
+    * returned when both inputs are NaN is left to the compiler, so only
+    * one NaN is used. */
+   const uint32_t special[8] = {
+      0, 0x80000000, lane_bits(1.0f), lane_bits(-2.5f), 0x7fc00000,
+      0x7f800000, 0x00000001, 0x7f7fffff
+   };
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(9, 0)[i] = special[i & 7];
+      wf.gpr(9, 1)[i] = special[i >> 3];
+      wf.gpr(9, 2)[i] = lane_bits(0.5f * i);
+      wf.gpr(9, 3)[i] = special[(i * 5) & 7];
+   }
+}
+
+void CompiledAluClauseTest::compare(const vector<uint64_t>& code, bool native)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, code.size(), std::make_tuple(1, 1, 0))
+         .append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.insert(bc.end(), code.begin(), code.end());
+
+   disassembler diss(bc);
+   auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(alu);
+
+   Wavefront expect(wf);
+   if (wf.lds())
+      expect.set_lds(std::make_shared<LocalDataShare>(*wf.lds()));
+   AluInterpreter::run(*alu, expect);
+
+   CompiledAluClause compiled(*alu, native);
+   EXPECT_EQ(compiled.ngroups(), alu->clause().size());
+   if (native && AluJit::available()) {
+      EXPECT_EQ(compiled.nnative_groups(), compiled.ngroups());
+   }
+   compiled.run(wf);
+
+   EXPECT_EQ(wf.active(), expect.active());
+   EXPECT_EQ(wf.valid(), expect.valid());
+   EXPECT_EQ(wf.predicate(), expect.predicate());
+   EXPECT_EQ(wf.ar(), expect.ar());
+   for (unsigned s = 0; s < 5; ++s)
+      EXPECT_EQ(wf.pv(s), expect.pv(s));
+   for (unsigned r = 0; r < Wavefront::ngprs; ++r)
+      for (unsigned c = 0; c < 4; ++c)
+         EXPECT_EQ(wf.gpr(r, c), expect.gpr(r, c)) << "R" << r << "." << c;
+   for (unsigned q = 0; q < 2; ++q)
+      for (unsigned i = 0; i < wavefront_size; ++i)
+         EXPECT_EQ(wf.lds_queue(q, i), expect.lds_queue(q, i));
+   if (wf.lds()) {
+      for (unsigned a = 0; a < wf.lds()->size(); a += 4)
+         ASSERT_EQ(wf.lds()->read(a), expect.lds()->read(a)) << a;
+   }
+}
+
+TEST_F(CompiledAluClauseTest, MatchesInterpreter)
+{
+   AluOpFlags pred_flags;
+   pred_flags.set(AluNode::do_update_pred);
+   pred_flags.set(AluNode::do_update_exec_mask);
+
+   vector<uint64_t> code = {
+      op2(op2_add, 1, 0, gpr(0, 3, true, false), gpr(0, 0, false, true),
+          false, AluOpFlags(), AluNode::omod_mul_4),
+      op2(op2_mul_ieee, 1, 1, gpr(0, 0),
+          literal(0, false, true), false,
+          AluOpFlags().set(AluNode::do_clamp)),
+      op2(op2_mov, 1, 2, Value::create(130, 3, 0, 0, 0, nullptr), PValue(),
+          false),
+      op2(op2_mova_int, 1, 3, gpr(3, 0), PValue()),
+      lane_bits(0.125f),
+      op2(op2_mov, 2, 0, gpr(4, 1, false, false, true), PValue(), false),
+      op3(op3_muladd, 2, 1, gpr(0, 0), gpr(0, 3),
+          inline_const(ALU_SRC_PV, 0), false),
+      op2(op2_mov, 8, 2, inline_const(ALU_SRC_0_5), PValue(), false,
+          AluOpFlags(), AluNode::omod_off, AluNode::pred_sel_off, true),
+      op2(op2_recip_ieee, 2, 3, gpr(0, 1), PValue()),
+      op2(op2_dot4_ieee, 3, 0, gpr(0, 0), gpr(0, 1), false),
+      op2(op2_dot4_ieee, 3, 1, gpr(0, 1), gpr(0, 1), false),
+      op2(op2_dot4_ieee, 3, 2, inline_const(ALU_SRC_0), gpr(0, 1), false),
+      op2(op2_dot4_ieee, 3, 3, gpr(0, 3), inline_const(ALU_SRC_1)),
+      op2(op2_pred_setgt_int, 4, 0, gpr(0, 2), literal(), true,
+          pred_flags),
+      21,
+      op2(op2_mov, 4, 1, inline_const(ALU_SRC_PS), PValue(), true,
+          AluOpFlags(), AluNode::omod_off, AluNode::pred_sel_one),
+      op2(op2_kille_int, 4, 2, gpr(0, 2), inline_const(ALU_SRC_0))
+   };
+   compare(code);
+}
+
+TEST_F(CompiledAluClauseTest, NativeMatchesInterpreter)
+{
+   const EAluOp binary_ops[] = {
+      op2_add, op2_mul, op2_mul_ieee, op2_max, op2_min,
+      op2_sete, op2_setgt, op2_setge, op2_setne,
+      op2_sete_dx10, op2_setgt_dx10, op2_setge_dx10, op2_setne_dx10,
+      op2_add_int, op2_sub_int, op2_and_int, op2_or_int, op2_xor_int,
+      op2_sete_int, op2_setne_int, op2_setgt_int, op2_setge_int,
+      op2_setgt_uint, op2_setge_uint, op2_max_int, op2_min_int,
+      op2_max_uint, op2_min_uint
+   };
+   const EAluOp ternary_ops[] = {
+      op3_muladd, op3_muladd_m2, op3_muladd_m4, op3_muladd_d2,
+      op3_muladd_ieee
+   };
+
+   vector<uint64_t> code;
+   int dst = 20;
+   for (auto op: binary_ops) {
+      code.push_back(op2(op, dst, 0, gpr(9, 0), gpr(9, 1), false));
+      code.push_back(op2(op, dst, 1, gpr(9, 1, true), gpr(9, 2, false, true),
+                         false));
+      code.push_back(op2(op, dst, 2, gpr(9, 2), inline_const(ALU_SRC_PV, 0),
+                         false));
+      code.push_back(op2(op, dst++, 3, gpr(9, 3),
+                         Value::create(130, 1, 0, 0, 0, nullptr)));
+   }
+   for (auto op: ternary_ops) {
+      code.push_back(op3(op, dst, 0, gpr(9, 0), gpr(9, 1), gpr(9, 2), false));
+      code.push_back(op3(op, dst, 1, gpr(9, 1), gpr(9, 3), gpr(9, 0), false));
+      code.push_back(op3(op, dst++, 2, gpr(9, 2), gpr(9, 2),
+                         inline_const(ALU_SRC_1)));
+   }
+   code.push_back(op2(op2_not_int, dst, 0, gpr(9, 0), PValue(), false));
+   code.push_back(op2(op2_mov, dst++, 1, gpr(9, 1, false, true), PValue()));
+   for (int c = 0; c < 4; ++c)
+      code.push_back(op2(op2_dot4, dst, c, gpr(9, c), gpr(9, 3 - c), c == 3));
+   for (int c = 0; c < 4; ++c)
+      code.push_back(op2(op2_dot4_ieee, dst + 1, c, gpr(9, c), gpr(0, c),
+                         c == 3));
+
+   compare(code, true);
+}
+
+TEST_F(CompiledAluClauseTest, LdsMatchesInterpreter)
+{
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      wf.gpr(1, 0)[i] = 4 * (i & 15);
+   wf.set_active(0xffff00ff);
+   wf.set_lds(std::make_shared<LocalDataShare>());
+
+   vector<uint64_t> code = {
+      lds_op(DS_OP_WRITE, gpr(1, 0), gpr(0, 2), gpr(0, 0)),
+      group_barrier(),
+      lds_op(DS_OP_ADD_RET, inline_const(ALU_SRC_0),
+             inline_const(ALU_SRC_1_INT), gpr(0, 0)),
+      lds_op(DS_OP_READ2_RET, gpr(1, 0), inline_const(ALU_SRC_0), gpr(0, 0)),
+      op2(op2_add_int, 2, 0, inline_const(ALU_SRC_LDS_OQ_A_POP), gpr(0, 2)),
+      lds_op(DS_OP_XCHG_RET, gpr(1, 0), gpr(0, 2), gpr(0, 0), false, 64),
+      mov(2, 1, inline_const(ALU_SRC_LDS_OQ_B)),
+      mov(2, 2, inline_const(ALU_SRC_LDS_OQ_A_POP)),
+      mov(2, 3, inline_const(ALU_SRC_LDS_OQ_B_POP))
+   };
+   compare(code);
+
+   /* the queues still hold the values of XCHG_RET */
+   EXPECT_EQ(wf.lds_queue(0, 0).size(), 1u);
+   EXPECT_TRUE(wf.lds_queue(1, 0).empty());
+
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(lds_op(DS_OP_WRITE, gpr(1, 0), gpr(0, 2)));
+
+   disassembler diss(bc);
+   auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(alu);
+   CompiledAluClause c(*alu);
+   wf.set_lds(nullptr);
+   EXPECT_THROW(c.run(wf), std::runtime_error);
+}
+
+TEST_F(CompiledAluClauseTest, UnsupportedInstruction)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2(op2_cube, 1, 0, gpr(0, 0), gpr(0, 1)));
+
+   disassembler diss(bc);
+   auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(alu);
+   EXPECT_THROW(CompiledAluClause c(*alu), std::runtime_error);
+
+   bc.back() = lds_op(DS_OP_READ_REL_RET, gpr(0, 0));
+   disassembler lds_diss(bc);
+   alu = dynamic_cast<const CFAluNode *>(lds_diss.get_program()[0].get());
+   ASSERT_TRUE(alu);
+   EXPECT_THROW(CompiledAluClause c(*alu), std::runtime_error);
+}
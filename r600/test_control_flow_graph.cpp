@@ -0,0 +1,167 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/control_flow_graph.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class ControlFlowGraphTest: public BytecodeTest {
+protected:
+   vector<unsigned> successors(const ControlFlowGraph& cfg,
+                               unsigned b) const;
+};
+
+vector<unsigned> ControlFlowGraphTest::successors(const ControlFlowGraph& cfg,
+                                                  unsigned b) const
+{
+   vector<unsigned> result;
+   for (unsigned i = 0; i < cfg.nsuccessors(b); ++i)
+      result.push_back(cfg.successor(b, i));
+   return result;
+}
+
+TEST_F(ControlFlowGraphTest, LoopWithBreakAndElse)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 9, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_start_dx10, 0, 8).append_bytecode(bc);
+   CFAluNode(cf_alu_push_before, 0, 10, 1).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 5, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_break, 0, 7).append_bytecode(bc);
+   CFNativeNode(cf_else, 0, 7, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_pop_after, 0, 11, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 2).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+   bc.push_back(mov(2, 0, gpr(0, 0)));
+   bc.push_back(mov(3, 0, gpr(0, 0)));
+
+   disassembler diss(bc);
+   ControlFlowGraph cfg(diss);
+
+   ASSERT_EQ(cfg.nblocks(), 7u);
+   EXPECT_EQ(cfg.block(1).first, 2u);
+   EXPECT_EQ(cfg.block(1).end, 4u);
+   EXPECT_EQ(cfg.block_of(3), 1u);
+
+   EXPECT_EQ(successors(cfg, 0), vector<unsigned>({1, 6}));
+   EXPECT_EQ(successors(cfg, 2), vector<unsigned>({3, 6}));
+   EXPECT_EQ(successors(cfg, 5), vector<unsigned>({1, 6}));
+   EXPECT_EQ(cfg.nsuccessors(6), 0u);
+   EXPECT_EQ(cfg.npredecessors(6), 3u);
+
+   EXPECT_EQ(cfg.idom(0), -1);
+   EXPECT_EQ(cfg.idom(5), 3);
+   EXPECT_EQ(cfg.idom(6), 0);
+   EXPECT_TRUE(cfg.dominates(1, 4));
+   EXPECT_TRUE(cfg.dominates(3, 3));
+   EXPECT_FALSE(cfg.dominates(2, 3));
+   EXPECT_FALSE(cfg.dominates(4, 5));
+
+   ASSERT_EQ(cfg.loops().size(), 1u);
+   EXPECT_EQ(cfg.loops()[0].header, 1u);
+   EXPECT_EQ(cfg.loop_of(4), 0);
+   EXPECT_EQ(cfg.loop_of(6), -1);
+
+   std::ostringstream os;
+   cfg.print(os);
+   EXPECT_EQ(os.str(),
+             "BB0: CF 0-1 -> BB1 BB6 idom - loop depth 0\n"
+             "BB1: CF 2-3 -> BB2 BB3 idom BB0 loop depth 1\n"
+             "BB2: CF 4 -> BB3 BB6 idom BB1 loop depth 1\n"
+             "BB3: CF 5 -> BB4 BB5 idom BB1 loop depth 1\n"
+             "BB4: CF 6 -> BB5 idom BB3 loop depth 1\n"
+             "BB5: CF 7 -> BB1 BB6 idom BB3 loop depth 1\n"
+             "BB6: CF 8 -> idom BB0 loop depth 0\n"
+             "loop 0: CF 1-7 header BB1\n");
+}
+
+TEST_F(ControlFlowGraphTest, NestedLoops)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_loop_start_dx10, 0, 5).append_bytecode(bc);
+   CFNativeNode(cf_loop_start_dx10, 0, 4).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 6, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 2).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+
+   disassembler diss(bc);
+   ControlFlowGraph cfg(diss);
+
+   ASSERT_EQ(cfg.loops().size(), 2u);
+   EXPECT_EQ(cfg.loops()[1].parent, 0);
+   EXPECT_EQ(cfg.loops()[1].depth, 2u);
+   EXPECT_EQ(cfg.loop_depth(cfg.block_of(2)), 2u);
+   EXPECT_EQ(cfg.loop_depth(cfg.block_of(4)), 1u);
+}
+
+TEST_F(ControlFlowGraphTest, CallAndReturn)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_call, 0, 3).append_bytecode(bc);
+   CFNativeNode(cf_call, 0, 3).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 5).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 6, 1).append_bytecode(bc);
+   CFNativeNode(cf_return, 0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+
+   disassembler diss(bc);
+   ControlFlowGraph cfg(diss);
+
+   unsigned sub = cfg.block_of(3);
+   unsigned ret = cfg.block_of(4);
+   EXPECT_EQ(sub, ret);
+   EXPECT_EQ(successors(cfg, cfg.block_of(0)), vector<unsigned>({sub}));
+   EXPECT_EQ(successors(cfg, ret),
+             vector<unsigned>({cfg.block_of(1), cfg.block_of(2)}));
+   EXPECT_EQ(cfg.idom(cfg.block_of(1)), static_cast<int>(sub));
+}
+
+TEST_F(ControlFlowGraphTest, ReturnOnlyToOwnCallers)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_call, 0, 4).append_bytecode(bc);
+   CFNativeNode(cf_call, 0, 6).append_bytecode(bc);
+   CFNativeNode(cf_call, 0, 4).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 8).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 9, 1).append_bytecode(bc);
+   CFNativeNode(cf_return, 0).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 9, 1).append_bytecode(bc);
+   CFNativeNode(cf_return, 0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+
+   disassembler diss(bc);
+   ControlFlowGraph cfg(diss);
+
+   EXPECT_EQ(successors(cfg, cfg.block_of(5)),
+             vector<unsigned>({cfg.block_of(1), cfg.block_of(3)}));
+   EXPECT_EQ(successors(cfg, cfg.block_of(7)),
+             vector<unsigned>({cfg.block_of(2)}));
+   EXPECT_EQ(cfg.npredecessors(cfg.block_of(3)), 1u);
+}
@@ -0,0 +1,116 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/dead_write_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class DeadWriteAnalysisTest: public BytecodeTest {
+protected:
+   void append_export(vector<uint64_t>& bc) const;
+};
+
+void DeadWriteAnalysisTest::append_export(vector<uint64_t>& bc) const
+{
+   CFExportNode(cf_export_done, 0, 0, 0, 0, 0, {0, 1, 2, 3},
+                1 << CFNode::eop).append_bytecode(bc);
+}
+
+TEST_F(DeadWriteAnalysisTest, DeadWritesAndMovChains)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 6).append_bytecode(bc);
+   append_export(bc);
+
+   bc.push_back(op2(op2_mov, 1, 0, gpr(0, 0), PValue()));
+   bc.push_back(op2(op2_mov, 2, 0, gpr(0, 1), PValue()));
+   bc.push_back(op2(op2_mov, 2, 0, gpr(1, 0), PValue()));
+   bc.push_back(op2(op2_add, 0, 0, gpr(2, 0), gpr(1, 0)));
+   bc.push_back(op2(op2_mov, 124, 0, gpr(0, 3), PValue(), false));
+   bc.push_back(op2(op2_mov, 0, 1, gpr(0, 1), PValue()));
+
+   disassembler diss(bc);
+   DeadWriteAnalysis dwa(diss);
+
+   ASSERT_EQ(dwa.findings().size(), 5u);
+   EXPECT_EQ(dwa.findings()[0].kind, DeadWriteAnalysis::dw_redundant_mov);
+   EXPECT_FALSE(dwa.findings()[0].chain);
+   EXPECT_EQ(dwa.findings()[1].kind, DeadWriteAnalysis::dw_dead_write);
+   EXPECT_EQ(dwa.findings()[2].kind, DeadWriteAnalysis::dw_redundant_mov);
+   EXPECT_TRUE(dwa.findings()[2].chain);
+   EXPECT_EQ(dwa.findings()[3].kind, DeadWriteAnalysis::dw_dead_write);
+   EXPECT_EQ(dwa.findings()[4].kind, DeadWriteAnalysis::dw_identity_mov);
+   EXPECT_EQ(dwa.total_slots(), 6u);
+   EXPECT_EQ(dwa.wasted_slots(), 5u);
+
+   std::ostringstream os;
+   dwa.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0 group 0 slot x: redundant MOV R1.x\n"
+             "CF 0 group 1 slot x: dead write R2.x\n"
+             "CF 0 group 2 slot x: redundant MOV R2.x (chain)\n"
+             "CF 0 group 4 slot x: dead write T0.x\n"
+             "CF 0 group 4 slot y: identity MOV R0.y\n"
+             "5 of 6 ALU slots wasted\n");
+}
+
+TEST_F(DeadWriteAnalysisTest, ClobberedSourceAndPredicatedWrite)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 4).append_bytecode(bc);
+   append_export(bc);
+
+   bc.push_back(op2(op2_mov, 1, 0, gpr(0, 0), PValue()));
+   bc.push_back(op2(op2_mov, 0, 0, gpr(0, 1), PValue()));
+   bc.push_back(op2(op2_add, 2, 0, gpr(1, 0), gpr(0, 0)));
+   bc.push_back(op2(op2_mov, 2, 0, gpr(0, 2), PValue(), true, AluOpFlags(),
+                    AluNode::omod_off, AluNode::pred_sel_zero));
+
+   disassembler diss(bc);
+   DeadWriteAnalysis dwa(diss);
+
+   EXPECT_TRUE(dwa.findings().empty());
+   EXPECT_EQ(dwa.wasted_slots(), 0u);
+}
+
+TEST_F(DeadWriteAnalysisTest, ControlFlowKeepsWritesAlive)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu_pop_after, 0, 3, 1).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 4, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(op2(op2_add, 1, 0, gpr(0, 0), gpr(0, 1)));
+   bc.push_back(op2(op2_add, 1, 0, gpr(0, 2), gpr(0, 3)));
+
+   disassembler diss(bc);
+   DeadWriteAnalysis dwa(diss);
+
+   /* The first write survives the POP, the second one is never read */
+   ASSERT_EQ(dwa.findings().size(), 1u);
+   EXPECT_EQ(dwa.findings()[0].cf_addr, 1u);
+   EXPECT_EQ(dwa.findings()[0].kind, DeadWriteAnalysis::dw_dead_write);
+}
@@ -0,0 +1,186 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/dispatch_scheduler.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class DispatchSchedulerTest: public BytecodeTest {
+protected:
+   void gws(vector<uint64_t>& bc, EGWSOpCode op, unsigned resource,
+            unsigned value) const;
+};
+
+void DispatchSchedulerTest::gws(vector<uint64_t>& bc, EGWSOpCode op,
+                                unsigned resource, unsigned value) const
+{
+   CFGwsNode(cf_global_wave_sync, op, 0, 0, 0, 0, 0, value, resource, 0, 0)
+         .append_bytecode(bc);
+}
+
+TEST_F(DispatchSchedulerTest, ThreadIds)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2(op2_add_int, 2, 0, gpr(0, 0), gpr(1, 0)));
+   disassembler diss(bc);
+
+   /* 70 threads per workgroup give a full and a partial wavefront */
+   DispatchScheduler::Dispatch dispatch = {{3, 2, 2}, {10, 7, 1}};
+   const unsigned group_size = 70;
+   vector<int> seen(12 * group_size, 0);
+   std::mutex mutex;
+   ExecutionProfile profile;
+
+   DispatchScheduler::Parameters params;
+   params.nthreads = 4;
+   params.emulator.profile = &profile;
+   params.finish = [&](Wavefront& wf, const DispatchScheduler::WaveInfo& info) {
+      unsigned group = info.group_id[0] + 3 * (info.group_id[1] +
+                                               2 * info.group_id[2]);
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         if (!(wf.valid() & (1ull << i)))
+            continue;
+         unsigned t = info.wave * wavefront_size + i;
+         std::lock_guard<std::mutex> lock(mutex);
+         ++seen[group * group_size + t];
+         EXPECT_EQ(wf.gpr(0, 0)[i], t % 10);
+         EXPECT_EQ(wf.gpr(0, 1)[i], t / 10);
+         EXPECT_EQ(wf.gpr(0, 2)[i], 0u);
+         for (unsigned c = 0; c < 3; ++c)
+            EXPECT_EQ(wf.gpr(1, c)[i], info.group_id[c]);
+         EXPECT_EQ(wf.gpr(2, 0)[i], t % 10 + info.group_id[0]);
+      }
+   };
+
+   DispatchScheduler scheduler(diss, params);
+   scheduler.run(dispatch);
+
+   EXPECT_EQ(seen, vector<int>(seen.size(), 1));
+   EXPECT_EQ(scheduler.statistics().workgroups, 12u);
+   ASSERT_TRUE(profile.entry(0));
+   EXPECT_EQ(profile.entry(0)->count, 24u);
+   EXPECT_EQ(profile.entry(0)->lanes, 12u * group_size);
+}
+
+TEST_F(DispatchSchedulerTest, GroupBarrierOrdersLdsAccess)
+{
+   /* Each thread writes to the LDS, and after the barrier reads the
+    * value of the thread at the same lane of the other wavefront */
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 11).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2(op2_add_int, 3, 0, gpr(0, 0), gpr(0, 0)));
+   bc.push_back(op2(op2_add_int, 3, 0, gpr(3, 0), gpr(3, 0)));
+   bc.push_back(op2(op2_lshl_int, 4, 0, gpr(1, 0), literal()));
+   bc.push_back(8);
+   bc.push_back(op2(op2_add_int, 4, 0, gpr(4, 0), gpr(0, 0)));
+   bc.push_back(op2(op2_xor_int, 3, 1, gpr(3, 0), literal()));
+   bc.push_back(256);
+   bc.push_back(lds_op(DS_OP_WRITE, gpr(3, 0), gpr(4, 0)));
+   bc.push_back(group_barrier());
+   bc.push_back(lds_op(DS_OP_READ_RET, gpr(3, 1)));
+   bc.push_back(op2(op2_mov, 2, 0, inline_const(ALU_SRC_LDS_OQ_A_POP),
+                    PValue()));
+   disassembler diss(bc);
+
+   std::atomic<unsigned> errors(0);
+   std::atomic<unsigned> waves(0);
+   DispatchScheduler::Parameters params;
+   params.nthreads = 3;
+   params.finish = [&](Wavefront& wf, const DispatchScheduler::WaveInfo& info) {
+      for (unsigned i = 0; i < wavefront_size; ++i) {
+         unsigned partner = (info.wave ^ 1) * wavefront_size + i;
+         if (wf.gpr(2, 0)[i] != partner + (info.group_id[0] << 8))
+            ++errors;
+      }
+      ++waves;
+   };
+
+   DispatchScheduler scheduler(diss, params);
+   scheduler.run({{8, 1, 1}, {128, 1, 1}});
+   EXPECT_EQ(waves, 16u);
+   EXPECT_EQ(errors, 0u);
+}
+
+TEST_F(DispatchSchedulerTest, GlobalBarrierWithMoreGroupsThanWorkers)
+{
+   vector<uint64_t> bc;
+   gws(bc, cf_gws_barrier, 0, 15);
+   CFAluNode(cf_alu, 0, 3, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2(op2_mov, 2, 0, inline_const(ALU_SRC_1_INT), PValue()));
+   disassembler diss(bc);
+
+   /* No wavefront may pass the barrier before all were started */
+   std::atomic<unsigned> started(0);
+   std::atomic<unsigned> early(0);
+   DispatchScheduler::Parameters params;
+   params.nthreads = 2;
+   params.setup = [&](Wavefront&, const DispatchScheduler::WaveInfo&) {
+      ++started;
+   };
+   params.finish = [&](Wavefront& wf, const DispatchScheduler::WaveInfo&) {
+      if (started != 16 || wf.gpr(2, 0)[0] != 1)
+         ++early;
+   };
+
+   DispatchScheduler scheduler(diss, params);
+   scheduler.run({{16, 1, 1}, {64, 1, 1}});
+   EXPECT_EQ(early, 0u);
+   EXPECT_GE(scheduler.statistics().waits, 1u);
+}
+
+TEST_F(DispatchSchedulerTest, SemaphoresAndDeadlock)
+{
+   /* Every workgroup sets the counter, meets the others at the barrier,
+    * and then takes one unit of the semaphore */
+   auto program = [this](unsigned count) {
+      vector<uint64_t> bc;
+      gws(bc, cf_gws_init, 1, count);
+      gws(bc, cf_gws_barrier, 0, 7);
+      gws(bc, cf_sema_p, 1, 0);
+      CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+      return bc;
+   };
+
+   DispatchScheduler::Parameters params;
+   params.nthreads = 3;
+   DispatchScheduler::Dispatch dispatch = {{8, 1, 1}, {64, 1, 1}};
+
+   disassembler enough(program(8));
+   EXPECT_NO_THROW(DispatchScheduler(enough, params).run(dispatch));
+
+   disassembler too_few(program(7));
+   EXPECT_THROW(DispatchScheduler(too_few, params).run(dispatch),
+                std::runtime_error);
+
+   /* Without a scheduler there is nobody to wait for */
+   Wavefront wf;
+   CFEmulator emu(enough, wf);
+   EXPECT_THROW(emu.run(), std::runtime_error);
+}
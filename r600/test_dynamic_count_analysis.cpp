@@ -0,0 +1,94 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/dynamic_count_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class DynamicCountAnalysisTest: public BytecodeTest {
+};
+
+TEST_F(DynamicCountAnalysisTest, LoopAndBranchWeights)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 9, 2).append_bytecode(bc);
+   CFNativeNode(cf_loop_start, 0, 8, 0, 0, 0, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_push_before, 0, 11, 1).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 5, 1).append_bytecode(bc);
+   CFFetchNode(cf_tc, 0, 13, 1).append_bytecode(bc);
+   CFNativeNode(cf_else, 0, 7, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_pop_after, 0, 12, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 2).append_bytecode(bc);
+   CFExportNode(cf_export_done, CFMemNode::export_pixel, 1, 0, 0, 0,
+                {0, 1, 2, 3}, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(mov(1, 0, gpr(0, 0), false));
+   bc.push_back(mov(1, 1, gpr(0, 1)));
+   bc.push_back(mov(2, 0, gpr(0, 0)));
+   bc.push_back(mov(3, 0, gpr(0, 0)));
+   tex(bc, TexFetchNode::tex_sample, 4, 0);
+   tex(bc, TexFetchNode::tex_sample, 5, 0);
+
+   DynamicCountAnalysis::Parameters params;
+   params.loop_trip_counts[1] = 4;
+   params.branch_probabilities[3] = 0.25;
+
+   disassembler diss(bc);
+   DynamicCountAnalysis dc(diss, params);
+
+   EXPECT_EQ(dc.weights(),
+             vector<double>({1, 1, 4, 4, 1, 4, 3, 4, 1}));
+
+   EXPECT_EQ(dc.static_counts().alu_groups, 3);
+   EXPECT_EQ(dc.static_counts().alu_instructions, 4);
+   EXPECT_EQ(dc.dynamic_counts().alu_groups, 8);
+   EXPECT_EQ(dc.dynamic_counts().alu_instructions, 9);
+   EXPECT_EQ(dc.dynamic_counts().fetches, 2);
+   EXPECT_EQ(dc.dynamic_counts().exports, 1);
+
+   std::ostringstream os;
+   dc.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 1: loop with 4 iterations\n"
+             "ALU groups: 3 static, 8 dynamic\n"
+             "ALU instructions: 4 static, 9 dynamic\n"
+             "fetches: 2 static, 2 dynamic\n"
+             "exports: 1 static, 1 dynamic\n");
+}
+
+TEST_F(DynamicCountAnalysisTest, DefaultTripCount)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_loop_start_dx10, 0, 3).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 4, 1).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+
+   disassembler diss(bc);
+   DynamicCountAnalysis dc(diss);
+
+   EXPECT_EQ(dc.dynamic_counts().alu_instructions, 16);
+}
@@ -0,0 +1,211 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/emulator_snapshot.h>
+#include <r600/local_data_share.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class EmulatorSnapshotTest: public BytecodeTest {
+protected:
+   EmulatorSnapshotTest();
+
+   /* A fresh wavefront with the inputs of the program */
+   void init(Wavefront& wf) const;
+
+   vector<uint64_t> bc;
+   CFEmulator::Parameters params;
+};
+
+EmulatorSnapshotTest::EmulatorSnapshotTest()
+{
+   /* Four iterations of a loop that sums the loop index and adds it to
+    * the LDS, the old LDS values stay in the output queue */
+   CFNativeNode(cf_loop_start, 0, 3, 0, 0, 0, 2).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 4, 3).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1, 0, 0, 0, 2).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(op2(op2_add_int, 1, 0, gpr(1, 0),
+                    inline_const(ALU_SRC_LOOP_IDX)));
+   bc.push_back(lds_op(DS_OP_ADD, gpr(0, 0), gpr(1, 0)));
+   bc.push_back(lds_op(DS_OP_ADD_RET, gpr(0, 1), gpr(1, 0)));
+
+   params.loop_constants[2] = 4 | (2 << 12) | (3 << 24);
+}
+
+void EmulatorSnapshotTest::init(Wavefront& wf) const
+{
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(0, 0)[i] = 4 * i;
+      wf.gpr(0, 1)[i] = 4 * (i & 7) + 1024;
+   }
+   wf.set_lds(std::make_shared<LocalDataShare>(2048));
+}
+
+TEST_F(EmulatorSnapshotTest, ReplayIsDeterministic)
+{
+   disassembler diss(bc);
+   Wavefront wf;
+   init(wf);
+   CFEmulator emu(diss, wf, params);
+
+   vector<EmulatorSnapshot> snapshots;
+   snapshots.push_back(EmulatorSnapshot::take(emu, wf));
+   while (emu.step())
+      snapshots.push_back(EmulatorSnapshot::take(emu, wf, &snapshots.back()));
+   snapshots.push_back(EmulatorSnapshot::take(emu, wf, &snapshots.back()));
+   ASSERT_EQ(snapshots.size(), 11u);
+
+   /* A step changes R1 and one LDS page at most, the rest is shared */
+   for (unsigned i = 1; i < snapshots.size(); ++i)
+      EXPECT_GE(snapshots[i].shared_pages(snapshots[i - 1]),
+                Wavefront::ngprs - 1);
+
+   /* Continue from the middle of the loop on a new wavefront */
+   const auto& middle = snapshots[5];
+   EXPECT_EQ(middle.cf_state().stack.size(), 1u);
+
+   Wavefront replay_wf;
+   CFEmulator replay(diss, replay_wf, params);
+   middle.restore(replay, replay_wf);
+   EXPECT_EQ(EmulatorSnapshot::take(replay, replay_wf), middle);
+   replay.run();
+
+   auto final = EmulatorSnapshot::take(replay, replay_wf);
+   EXPECT_EQ(final, snapshots.back());
+   EXPECT_NE(final, middle);
+   EXPECT_EQ(replay_wf.gpr(1, 0)[5], 2u + 5u + 8u + 11u);
+   EXPECT_EQ(replay_wf.lds()->read(20), 2u + 7u + 15u + 26u);
+   EXPECT_EQ(replay_wf.lds_queue(0, 3).size(), 4u);
+}
+
+TEST_F(EmulatorSnapshotTest, BinaryFormat)
+{
+   disassembler diss(bc);
+   Wavefront wf;
+   init(wf);
+   CFEmulator emu(diss, wf, params);
+   for (unsigned i = 0; i < 5; ++i)
+      emu.step();
+   auto s = EmulatorSnapshot::take(emu, wf);
+
+   std::stringstream ss;
+   s.write(ss);
+   std::string data = ss.str();
+
+   /* Only the used registers and LDS pages are stored */
+   EXPECT_LT(data.size(), 16384u);
+
+   std::istringstream is(data);
+   auto r = EmulatorSnapshot::read(is);
+   EXPECT_EQ(r, s);
+
+   /* Both continue the same way */
+   Wavefront wf2;
+   CFEmulator emu2(diss, wf2, params);
+   r.restore(emu2, wf2);
+   emu.run();
+   emu2.run();
+   EXPECT_EQ(EmulatorSnapshot::take(emu2, wf2),
+             EmulatorSnapshot::take(emu, wf));
+
+   std::istringstream truncated(data.substr(0, data.size() - 3));
+   EXPECT_THROW(EmulatorSnapshot::read(truncated), std::runtime_error);
+   std::istringstream garbage("R600SNAX");
+   EXPECT_THROW(EmulatorSnapshot::read(garbage), std::runtime_error);
+}
+
+TEST_F(EmulatorSnapshotTest, WriteStamps)
+{
+   disassembler diss(bc);
+   Wavefront wf;
+   init(wf);
+   CFEmulator emu(diss, wf, params);
+
+   const Wavefront& regs = wf;
+   uint64_t stamp = wf.gpr_stamps().stamp(5);
+   EXPECT_EQ(regs.gpr(5, 0)[0], 0u);
+   EXPECT_EQ(wf.gpr_stamps().stamp(5), stamp);
+   wf.gpr(5, 0)[0] = 0;
+   EXPECT_NE(wf.gpr_stamps().stamp(5), stamp);
+
+   auto lds = wf.lds();
+   stamp = lds->stamps().stamp(0);
+   lds->write(LocalDataShare::page_bytes, 1);
+   EXPECT_EQ(lds->stamps().stamp(0), stamp);
+   lds->write(LocalDataShare::page_bytes - 4, 1);
+   EXPECT_NE(lds->stamps().stamp(0), stamp);
+
+   /* A copy writes the same register with the same stamp, but it has a
+    * different id, so the page is not taken from the snapshot of the
+    * original */
+   Wavefront copy(wf);
+   EXPECT_NE(copy.gpr_stamps().id(), wf.gpr_stamps().id());
+   wf.gpr(6, 0)[0] = 1;
+   copy.gpr(6, 0)[0] = 2;
+   EXPECT_EQ(copy.gpr_stamps().stamp(6), wf.gpr_stamps().stamp(6));
+
+   auto s = EmulatorSnapshot::take(emu, wf);
+   auto t = EmulatorSnapshot::take(emu, copy, &s);
+   EXPECT_NE(t, s);
+   EXPECT_EQ(t.shared_pages(s), Wavefront::ngprs + 1);
+
+   /* The pages that are not written are taken over */
+   EXPECT_EQ(EmulatorSnapshot::take(emu, wf, &s).shared_pages(s),
+             Wavefront::ngprs + 2);
+}
+
+class BlockingSync : public WaveSync {
+public:
+   bool group_barrier(uint32_t& ticket) override {
+      ticket = 1;
+      return false;
+   }
+   bool global_wave_sync(EGWSOpCode, unsigned, unsigned, uint32_t&) override {
+      return false;
+   }
+};
+
+TEST_F(EmulatorSnapshotTest, OnlyAtClauseBoundaries)
+{
+   vector<uint64_t> code;
+   CFAluNode(cf_alu, 0, 2, 2).append_bytecode(code);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(code);
+   code.push_back(op2(op2_mov, 1, 0, inline_const(ALU_SRC_1_INT), PValue()));
+   code.push_back(group_barrier());
+
+   BlockingSync sync;
+   CFEmulator::Parameters p;
+   p.sync = &sync;
+
+   disassembler diss(code);
+   Wavefront wf;
+   CFEmulator emu(diss, wf, p);
+   EXPECT_TRUE(emu.at_clause_boundary());
+   emu.step();
+   EXPECT_TRUE(emu.waiting());
+   EXPECT_FALSE(emu.at_clause_boundary());
+   EXPECT_THROW(EmulatorSnapshot::take(emu, wf), std::runtime_error);
+}
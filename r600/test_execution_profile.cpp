@@ -0,0 +1,180 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/cf_emulator.h>
+#include <r600/execution_profile.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class ExecutionProfileTest: public BytecodeTest {
+protected:
+   ExecutionProfileTest();
+
+   Wavefront wf;
+};
+
+ExecutionProfileTest::ExecutionProfileTest()
+{
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      wf.gpr(0, 0)[i] = i;
+}
+
+TEST_F(ExecutionProfileTest, CountsBranches)
+{
+   disassembler diss(if_else_program(47));
+   ExecutionProfile profile;
+   CFEmulator::Parameters params;
+   params.profile = &profile;
+
+   CFEmulator emu(diss, wf, params);
+   emu.run();
+   Wavefront wf2;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      wf2.gpr(0, 0)[i] = 100;
+   CFEmulator emu2(diss, wf2, params);
+   emu2.run();
+
+   /* CF instructions and ALU groups */
+   for (unsigned addr : {0u, 7u}) {
+      ASSERT_NE(profile.entry(addr), nullptr);
+      EXPECT_EQ(profile.entry(addr)->count, 2u);
+      EXPECT_EQ(profile.entry(addr)->lanes, 2u * wavefront_size);
+      EXPECT_EQ(profile.entry(addr)->histogram[8], 2u);
+   }
+
+   /* The then branch runs with 16 threads in the first run and with
+    * all threads in the second run */
+   auto then_group = profile.entry(9);
+   ASSERT_NE(then_group, nullptr);
+   EXPECT_EQ(then_group->count, 2u);
+   EXPECT_EQ(then_group->lanes, 16u + wavefront_size);
+   EXPECT_EQ(then_group->histogram[2], 1u);
+   EXPECT_EQ(then_group->histogram[8], 1u);
+
+   /* The else clause is skipped by the second run */
+   auto else_group = profile.entry(10);
+   ASSERT_NE(else_group, nullptr);
+   EXPECT_EQ(else_group->count, 1u);
+   EXPECT_EQ(else_group->lanes, 48u);
+   EXPECT_EQ(else_group->histogram[6], 1u);
+
+   EXPECT_EQ(profile.entry(8), nullptr);
+   EXPECT_EQ(profile.entry(6)->count, 2u);
+}
+
+TEST_F(ExecutionProfileTest, WriteAndRead)
+{
+   ExecutionProfile profile;
+   profile.record(0, ~0ull);
+   profile.record(0, 1);
+   profile.record(12, 0);
+
+   std::ostringstream os;
+   profile.write(os);
+   std::istringstream is(os.str());
+   auto copy = ExecutionProfile::read(is);
+
+   ASSERT_EQ(copy.entries().size(), 2u);
+   EXPECT_EQ(copy.entry(0)->count, 2u);
+   EXPECT_EQ(copy.entry(0)->lanes, 65u);
+   EXPECT_EQ(copy.entry(0)->histogram[1], 1u);
+   EXPECT_EQ(copy.entry(0)->histogram[8], 1u);
+   EXPECT_EQ(copy.entry(12)->histogram[0], 1u);
+
+   copy.merge(profile);
+   EXPECT_EQ(copy.entry(12)->count, 2u);
+
+   /* one byte per number */
+   EXPECT_EQ(os.str().size(), 8u + 2u + 2u * 12u);
+
+   std::istringstream bad_magic("R600SNAP");
+   EXPECT_THROW(ExecutionProfile::read(bad_magic), std::runtime_error);
+   std::string truncated = os.str();
+   truncated.pop_back();
+   std::istringstream bad_entry(truncated);
+   EXPECT_THROW(ExecutionProfile::read(bad_entry), std::runtime_error);
+}
+
+TEST_F(ExecutionProfileTest, AnnotatedDisassembly)
+{
+   disassembler diss(if_else_program(47));
+   ExecutionProfile profile;
+   CFEmulator::Parameters params;
+   params.profile = &profile;
+   CFEmulator emu(diss, wf, params);
+   emu.run();
+
+   std::ostringstream os;
+   profile.print_annotated(os, diss);
+   std::istringstream is(os.str());
+   vector<std::string> lines;
+   std::string line;
+   while (std::getline(is, line))
+      lines.push_back(line);
+
+   ASSERT_GE(lines.size(), 10u);
+   EXPECT_EQ(lines[0].substr(0, 18), "         1 100% | ");
+   EXPECT_NE(lines[0].find("ALU_PUSH_BEFORE"), std::string::npos);
+   /* Only the first line of each node and group gets a count */
+   EXPECT_EQ(lines[1].substr(0, 18), "                | ");
+
+   auto find_line = [&lines](const char *text) {
+      for (const auto& l: lines)
+         if (l.find(text) != std::string::npos)
+            return l;
+      return std::string();
+   };
+   EXPECT_EQ(find_line("PRED_SETGT_INT").substr(0, 18), "         1 100% | ");
+   EXPECT_EQ(find_line("R1.x, 1").substr(0, 18), "         1  25% | ");
+   EXPECT_EQ(find_line("R1.x, -1").substr(0, 18), "         1  75% | ");
+   EXPECT_EQ(find_line("NOP").substr(0, 18), "         1 100% | ");
+}
+
+TEST_F(ExecutionProfileTest, IdenticalGroupsKeepTheirCounts)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 2).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+   disassembler diss(bc);
+
+   ExecutionProfile profile;
+   profile.record(2, ~0ull);
+   profile.record(2, ~0ull);
+   profile.record(3, 1);
+
+   std::ostringstream os;
+   profile.print_annotated(os, diss);
+   std::istringstream is(os.str());
+   vector<std::string> movs;
+   std::string line;
+   while (std::getline(is, line))
+      if (line.find("MOV") != std::string::npos)
+         movs.push_back(line.substr(0, 18));
+
+   EXPECT_EQ(movs, vector<std::string>({"         2 100% | ",
+                                        "         1   1% | "}));
+}
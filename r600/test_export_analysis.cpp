@@ -0,0 +1,109 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/export_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class ExportAnalysisTest: public testing::Test {
+protected:
+   void append_export(vector<uint64_t>& bc, uint16_t opcode, uint16_t type,
+                      uint16_t gpr, uint16_t base, uint16_t burst,
+                      const vector<unsigned>& sel, bool eop = false) const;
+};
+
+void ExportAnalysisTest::append_export(vector<uint64_t>& bc, uint16_t opcode,
+                                       uint16_t type, uint16_t gpr,
+                                       uint16_t base, uint16_t burst,
+                                       const vector<unsigned>& sel,
+                                       bool eop) const
+{
+   CFExportNode(opcode, type, gpr, 0, base, burst, sel,
+                eop ? 1 << CFNode::eop : 0).append_bytecode(bc);
+}
+
+TEST_F(ExportAnalysisTest, BurstsAndBandwidth)
+{
+   vector<uint64_t> bc;
+   append_export(bc, cf_export, 2, 1, 0, 0, {0, 1, 2, 3});
+   append_export(bc, cf_export, 2, 2, 1, 0, {0, 1, 2, 3});
+   append_export(bc, cf_export, 1, 3, 60, 0, {0, 1, 4, 5});
+   append_export(bc, cf_export_done, 0, 4, 0, 0, {0, 1, 2, 7}, true);
+
+   disassembler diss(bc);
+   ExportAnalysis ea(diss);
+
+   ASSERT_EQ(ea.exports().size(), 4u);
+   EXPECT_EQ(ea.exports()[2].target, ExportAnalysis::et_pos);
+   EXPECT_EQ(ea.exports()[2].constant, 2u);
+   EXPECT_EQ(ea.exports()[3].masked, 1u);
+
+   ASSERT_EQ(ea.burst_candidates().size(), 1u);
+   EXPECT_EQ(ea.burst_candidates()[0].first_addr, 0u);
+   EXPECT_EQ(ea.burst_candidates()[0].last_addr, 1u);
+
+   EXPECT_EQ(ea.bandwidth(ExportAnalysis::et_param).bytes(), 32u);
+   EXPECT_EQ(ea.bandwidth(ExportAnalysis::et_pixel).components, 3u);
+   EXPECT_EQ(ea.total_bytes(), 60u);
+
+   std::ostringstream os;
+   ea.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: PARAM0 R1.xyzw\n"
+             "CF 1: PARAM1 R2.xyzw\n"
+             "CF 2: POS60 R3.xy01 (2 constant)\n"
+             "CF 3: PIXEL0 R4.xyz_ (1 masked)\n"
+             "CF 0-1: 2 exports could use one burst of 2 GPRs\n"
+             "PIXEL: 1 instructions, 1 vec4, 12 bytes\n"
+             "POS: 1 instructions, 1 vec4, 16 bytes\n"
+             "PARAM: 2 instructions, 2 vec4, 32 bytes\n"
+             "total: 60 bytes per invocation\n");
+}
+
+TEST_F(ExportAnalysisTest, NoBurstAcrossGapsOrLimit)
+{
+   vector<uint64_t> bc;
+   /* different swizzle */
+   append_export(bc, cf_export, 2, 1, 0, 0, {0, 1, 2, 3});
+   append_export(bc, cf_export, 2, 2, 1, 0, {0, 1, 2, 7});
+   /* GPR gap */
+   append_export(bc, cf_export, 2, 4, 2, 0, {0, 1, 2, 7});
+   /* burst count limit */
+   append_export(bc, cf_export, 2, 5, 3, 15, {0, 1, 2, 7});
+   append_export(bc, cf_export, 2, 21, 19, 0, {0, 1, 2, 7});
+   CFMemExportNode(cf_mem_export, 0, 22, 0, 3, 8, 1, {0, 1, 2, 3},
+                   1 << CFNode::eop).append_bytecode(bc);
+
+   disassembler diss(bc);
+   ExportAnalysis ea(diss);
+
+   ASSERT_EQ(ea.exports().size(), 6u);
+   EXPECT_TRUE(ea.burst_candidates().empty());
+
+   const auto& mem = ea.bandwidth(ExportAnalysis::et_memory);
+   EXPECT_EQ(mem.instructions, 1u);
+   EXPECT_EQ(mem.vec4s, 2u);
+   EXPECT_EQ(mem.bytes(), 32u);
+}
@@ -0,0 +1,282 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/cf_emulator.h>
+#include <r600/fetch_emulator.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+using V = VertexFetchNode;
+
+class FetchEmulatorTest: public BytecodeTest {
+protected:
+   FetchEmulatorTest();
+
+   void run(const vector<uint64_t>& fetches);
+
+   template <typename T>
+   static FetchEmulator::Data data(const vector<T>& values);
+
+   Wavefront wf;
+   FetchEmulator fe;
+};
+
+FetchEmulatorTest::FetchEmulatorTest()
+{
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      wf.gpr(0, 0)[i] = i;
+}
+
+template <typename T>
+FetchEmulator::Data FetchEmulatorTest::data(const vector<T>& values)
+{
+   auto d = std::make_shared<vector<uint8_t>>(values.size() * sizeof(T));
+   memcpy(d->data(), values.data(), d->size());
+   return d;
+}
+
+void FetchEmulatorTest::run(const vector<uint64_t>& fetches)
+{
+   vector<uint64_t> bc;
+   CFFetchNode(cf_vc, 0, 2, fetches.size() / 2 - 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.insert(bc.end(), fetches.begin(), fetches.end());
+
+   disassembler diss(bc);
+   auto fetch = dynamic_cast<const CFFetchNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(fetch);
+   fe.execute(*fetch, wf);
+}
+
+TEST_F(FetchEmulatorTest, VertexFormats)
+{
+   vector<float> position;
+   vector<uint32_t> color;
+   vector<uint16_t> texcoord;
+   for (unsigned i = 0; i < 60; ++i) {
+      for (unsigned c = 0; c < 4; ++c)
+         position.push_back(i + 0.25f * c);
+      color.push_back(0xff800000 | i);
+      texcoord.push_back(float_to_half(i * 0.5f));
+      texcoord.push_back(0x8000 | float_to_half(2.0f));
+   }
+   fe.bind_buffer(0, {data(position), 16, {}});
+   fe.bind_buffer(1, {data(color), 4, {}});
+   fe.bind_buffer(2, {data(texcoord), 4, {}});
+
+   vector<uint64_t> bc;
+   vtx(bc, 0, 1, 0, V::fmt_32_32_32_32_float, V::nf_scaled);
+   /* R2 = color.zyx1 */
+   vtx(bc, 1, 2, 0, V::fmt_8_8_8_8, V::nf_norm, 0xa0a);
+   /* R3 = texcoord.xy0_, W is not written */
+   vtx(bc, 2, 3, 0, V::fmt_16_16_float, V::nf_norm, 0xf08);
+   /* R4 = color.x as signed int bytes */
+   vtx(bc, 1, 4, 0, V::fmt_8_8_8_8, V::nf_int, swizzle_xyzw, true);
+   wf.gpr(3, 3).fill(77);
+   run(bc);
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      bool in_range = i < 60;
+      for (unsigned c = 0; c < 4; ++c)
+         EXPECT_EQ(lane_float(wf.gpr(1, c)[i]), in_range ? i + 0.25f * c : 0.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 0)[i]), in_range ? 128 / 255.0f : 0.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 1)[i]), 0.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 2)[i]), in_range ? i / 255.0f : 0.0f);
+      EXPECT_EQ(lane_float(wf.gpr(2, 3)[i]), 1.0f);
+      EXPECT_EQ(lane_float(wf.gpr(3, 0)[i]), in_range ? i * 0.5f : 0.0f);
+      EXPECT_EQ(lane_float(wf.gpr(3, 1)[i]), in_range ? -2.0f : 0.0f);
+      EXPECT_EQ(wf.gpr(3, 2)[i], 0u);
+      EXPECT_EQ(wf.gpr(3, 3)[i], 77u);
+      EXPECT_EQ(wf.gpr(4, 0)[i], in_range ? i : 0u);
+      EXPECT_EQ(wf.gpr(4, 2)[i], in_range ? 0xffffff80u : 0u);
+      EXPECT_EQ(wf.gpr(4, 3)[i], in_range ? 0xffffffffu : 0u);
+   }
+}
+
+TEST_F(FetchEmulatorTest, PackedFormatsAndEndianSwap)
+{
+   /* x = 1023, y = 0, z = 512, w = 1 for fmt_2_10_10_10 */
+   vector<uint32_t> packed(64, 0x3ff | (512u << 20) | (1u << 30));
+   fe.bind_buffer(0, {data(packed), 4, {}});
+   vector<uint32_t> big_endian(64, 0x78563412);
+   fe.bind_buffer(1, {data(big_endian), 4, {}});
+
+   vector<uint64_t> bc;
+   vtx(bc, 0, 1, 0, V::fmt_2_10_10_10, V::nf_norm);
+   vtx(bc, 0, 2, 0, V::fmt_2_10_10_10, V::nf_int, swizzle_xyzw, true);
+   vtx(bc, 1, 3, 0, V::fmt_32, V::nf_int, swizzle_xyzw, false, V::es_8in32);
+   vtx(bc, 1, 4, 0, V::fmt_16_16, V::nf_int, swizzle_xyzw, false, V::es_8in16);
+   run(bc);
+
+   EXPECT_EQ(lane_float(wf.gpr(1, 0)[5]), 1.0f);
+   EXPECT_EQ(lane_float(wf.gpr(1, 1)[5]), 0.0f);
+   EXPECT_EQ(lane_float(wf.gpr(1, 2)[5]), 512 / 1023.0f);
+   EXPECT_EQ(lane_float(wf.gpr(1, 3)[5]), 1 / 3.0f);
+   EXPECT_EQ(wf.gpr(2, 0)[5], 0xffffffffu);
+   EXPECT_EQ(wf.gpr(2, 2)[5], 0xfffffe00u);
+   EXPECT_EQ(wf.gpr(2, 3)[5], 1u);
+   EXPECT_EQ(wf.gpr(3, 0)[5], 0x12345678u);
+   EXPECT_EQ(wf.gpr(3, 3)[5], 1u);
+   EXPECT_EQ(wf.gpr(4, 0)[5], 0x1234u);
+   EXPECT_EQ(wf.gpr(4, 1)[5], 0x5678u);
+}
+
+TEST_F(FetchEmulatorTest, SignedNormOneBitComponent)
+{
+   /* x = 1 bit, y = 1, z = 15, w = 16 for fmt_5_5_5_1 */
+   vector<uint16_t> packed = {
+      static_cast<uint16_t>(1 | (1 << 1) | (15 << 6) | (16 << 11)),
+      static_cast<uint16_t>(0 | (1 << 1) | (15 << 6) | (16 << 11))
+   };
+   fe.bind_buffer(0, {data(packed), 2, {}});
+
+   vector<uint64_t> bc;
+   vtx(bc, 0, 1, 0, V::fmt_5_5_5_1, V::nf_norm, swizzle_xyzw, true);
+   run(bc);
+
+   EXPECT_EQ(lane_float(wf.gpr(1, 0)[0]), -1.0f);
+   EXPECT_EQ(lane_float(wf.gpr(1, 0)[1]), 0.0f);
+   for (unsigned i = 0; i < 2; ++i) {
+      EXPECT_EQ(lane_float(wf.gpr(1, 1)[i]), 1 / 15.0f);
+      EXPECT_EQ(lane_float(wf.gpr(1, 2)[i]), 1.0f);
+      EXPECT_EQ(lane_float(wf.gpr(1, 3)[i]), -1.0f);
+   }
+}
+
+TEST_F(FetchEmulatorTest, DirectReadMatchesSwappedRead)
+{
+   const struct {
+      V::EVTXDataFormat format;
+      unsigned endian_swap;
+      unsigned group;
+   } cases[] = {
+      {V::fmt_8_8_8_8, V::es_8in16, 2},
+      {V::fmt_16_16, V::es_8in16, 2},
+      {V::fmt_16_16_16_16_float, V::es_8in16, 2},
+      {V::fmt_32, V::es_8in32, 4},
+      {V::fmt_32_32_32_float, V::es_8in32, 4},
+   };
+
+   /* The last element is cut off for all formats */
+   vector<uint8_t> bytes(4 * 64 + 3);
+   for (unsigned i = 0; i < bytes.size(); ++i)
+      bytes[i] = i * 37 + 11;
+   Lanes offsets;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      offsets[i] = 4 * i;
+   LaneMask mask = 0xfffffffffffffffeull;
+
+   for (const auto& t: cases) {
+      vector<uint8_t> swapped(bytes);
+      for (unsigned i = 0; i + t.group <= swapped.size(); i += t.group)
+         std::reverse(swapped.begin() + i, swapped.begin() + i + t.group);
+
+      for (auto nf: {V::nf_norm, V::nf_int, V::nf_scaled}) {
+         FetchEmulator::Format f(t.format, nf, nf != V::nf_scaled);
+         std::array<Lanes, 4> direct;
+         std::array<Lanes, 4> packed;
+         FetchEmulator::convert(f, V::es_none, bytes, offsets, mask, direct);
+         FetchEmulator::convert(f, t.endian_swap, swapped, offsets, mask,
+                                packed);
+         for (unsigned c = 0; c < 4; ++c)
+            EXPECT_EQ(direct[c], packed[c]) << t.format << " " << c;
+      }
+   }
+}
+
+TEST_F(FetchEmulatorTest, TextureLoadAndSample)
+{
+   /* 4x2 RGBA8 image, the red channel holds 16 * x + y */
+   vector<uint32_t> texels;
+   for (unsigned y = 0; y < 2; ++y)
+      for (unsigned x = 0; x < 4; ++x)
+         texels.push_back(0xff000000 | (16 * x + y));
+   fe.bind_image(0, {data(texels), 4, 2, 1, 0, {V::fmt_8_8_8_8, V::nf_norm}});
+   fe.bind_sampler(0, {FetchEmulator::sf_nearest, FetchEmulator::sw_clamp});
+   fe.bind_sampler(1, {FetchEmulator::sf_linear, FetchEmulator::sw_repeat});
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(1, 0)[i] = i % 5;
+      wf.gpr(1, 1)[i] = i & 1;
+      wf.gpr(2, 0)[i] = lane_bits((i % 4 + 0.5f) / 4.0f);
+      wf.gpr(2, 1)[i] = lane_bits(0.75f);
+      wf.gpr(3, 0)[i] = lane_bits(1.0f);
+      wf.gpr(3, 1)[i] = lane_bits(0.5f);
+   }
+
+   vector<uint64_t> bc;
+   tex(bc, TexFetchNode::tex_ld, 4, 1);
+   tex(bc, TexFetchNode::tex_sample, 5, 2, 0, 0, true);
+   /* offset by one texel to the left */
+   tex(bc, TexFetchNode::tex_sample, 6, 2, 0, 0, true, -2);
+   tex(bc, TexFetchNode::tex_get_res_info, 7, 1);
+
+   vector<uint64_t> linear;
+   tex(linear, TexFetchNode::tex_sample, 8, 3, 0, 1, true);
+
+   run(bc);
+   run(linear);
+
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      unsigned x = i % 5;
+      uint32_t expect = x < 4 ? 16 * x + (i & 1) : 0;
+      EXPECT_EQ(lane_float(wf.gpr(4, 0)[i]), expect / 255.0f);
+      EXPECT_EQ(lane_float(wf.gpr(4, 3)[i]), x < 4 ? 1.0f : 0.0f);
+      EXPECT_EQ(lane_float(wf.gpr(5, 0)[i]), (16 * (i % 4) + 1) / 255.0f);
+      unsigned left = i % 4 ? i % 4 - 1 : 0;
+      EXPECT_EQ(lane_float(wf.gpr(6, 0)[i]), (16 * left + 1) / 255.0f);
+      EXPECT_EQ(wf.gpr(7, 0)[i], 4u);
+      EXPECT_EQ(wf.gpr(7, 1)[i], 2u);
+      EXPECT_EQ(wf.gpr(7, 2)[i], 1u);
+      /* halfway between x = 3 and x = 0 because of the repeat mode, and
+       * between the rows */
+      EXPECT_FLOAT_EQ(lane_float(wf.gpr(8, 0)[i]), 24.5f / 255.0f);
+   }
+}
+
+TEST_F(FetchEmulatorTest, CFEmulatorRunsFetchClause)
+{
+   vector<float> values;
+   for (unsigned i = 0; i < wavefront_size; ++i)
+      values.push_back(2.0f * i);
+   fe.bind_buffer(0, {data(values), 4, {}});
+
+   vector<uint64_t> bc;
+   CFFetchNode(cf_vc, 0, 2, 0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   vtx(bc, 0, 1, 0, V::fmt_32_float, V::nf_norm, 0xfe8);
+
+   disassembler diss(bc);
+   CFEmulator::Parameters params;
+   EXPECT_THROW(CFEmulator(diss, wf, params).run(), std::runtime_error);
+
+   params.fetch = &fe;
+   CFEmulator(diss, wf, params).run();
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(lane_float(wf.gpr(1, 0)[i]), 2.0f * i);
+      EXPECT_EQ(lane_float(wf.gpr(1, 1)[i]), 1.0f);
+   }
+}
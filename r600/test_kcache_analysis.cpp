@@ -0,0 +1,117 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/kcache_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+using std::make_tuple;
+
+class KCacheAnalysisTest: public BytecodeTest {
+protected:
+   PValue kc(int set, int idx) const;
+};
+
+PValue KCacheAnalysisTest::kc(int set, int idx) const
+{
+   const int base[4] = {128, 160, 256, 288};
+   return Value::create(base[set] + idx, 0, false, false, false, nullptr);
+}
+
+TEST_F(KCacheAnalysisTest, SetsNeeded)
+{
+   using Line = KCacheAnalysis::Line;
+   EXPECT_EQ(KCacheAnalysis::sets_needed({}), 0u);
+   EXPECT_EQ(KCacheAnalysis::sets_needed({Line(0, 0), Line(0, 1)}), 1u);
+   EXPECT_EQ(KCacheAnalysis::sets_needed({Line(0, 0), Line(0, 2)}), 2u);
+   EXPECT_EQ(KCacheAnalysis::sets_needed({Line(0, 1), Line(0, 2),
+                                          Line(0, 3), Line(1, 3)}), 3u);
+}
+
+TEST_F(KCacheAnalysisTest, UnusedLinesAndMerge)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 3, 1, make_tuple(0, 2, 0),
+             make_tuple(1, 1, 4)).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 4, 1, make_tuple(0, 1, 1)).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, kc(0, 3)));
+   bc.push_back(mov(1, 0, kc(0, 2)));
+
+   disassembler diss(bc);
+   KCacheAnalysis kca(diss);
+
+   ASSERT_EQ(kca.unused_lines().size(), 2u);
+   EXPECT_EQ(kca.unused_lines()[0].kcache_set, 0u);
+   EXPECT_EQ(kca.unused_lines()[0].line, 1u);
+   EXPECT_EQ(kca.unused_lines()[1].kcache_set, 1u);
+   EXPECT_EQ(kca.unused_lines()[1].bank, 1u);
+   EXPECT_EQ(kca.unused_lines()[1].line, 4u);
+
+   ASSERT_EQ(kca.clause_pairs().size(), 1u);
+   EXPECT_EQ(kca.clause_pairs()[0].kind, KCacheAnalysis::km_mergeable);
+   EXPECT_EQ(kca.clause_pairs()[0].sets_needed, 1u);
+
+   std::ostringstream os;
+   kca.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: KC0 locks unused line 1 of buffer 0\n"
+             "CF 0: KC1 locks unused line 4 of buffer 1\n"
+             "CF 0 and 1: mergeable (1 kcache sets)\n");
+}
+
+TEST_F(KCacheAnalysisTest, SplitByKCacheLimit)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 3, 2, make_tuple(0, 1, 0),
+             make_tuple(1, 1, 0)).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 5, 1, make_tuple(2, 1, 0)).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, kc(0, 0), false));
+   bc.push_back(mov(1, 1, kc(1, 0)));
+   bc.push_back(mov(1, 0, kc(0, 0)));
+
+   disassembler diss(bc);
+   KCacheAnalysis kca(diss);
+
+   EXPECT_TRUE(kca.unused_lines().empty());
+   ASSERT_EQ(kca.clause_pairs().size(), 1u);
+   EXPECT_EQ(kca.clause_pairs()[0].kind, KCacheAnalysis::km_mergeable_extended);
+   EXPECT_EQ(kca.clause_pairs()[0].sets_needed, 3u);
+}
+
+TEST_F(KCacheAnalysisTest, NoMergeAfterPop)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu_pop_after, 0, 3, 1, make_tuple(0, 1, 0)).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 4, 1, make_tuple(0, 1, 0)).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.push_back(mov(1, 0, kc(0, 0)));
+   bc.push_back(mov(1, 0, kc(0, 1)));
+
+   disassembler diss(bc);
+   KCacheAnalysis kca(diss);
+   EXPECT_TRUE(kca.clause_pairs().empty());
+}
@@ -0,0 +1,122 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/lds_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class LDSAnalysisTest: public BytecodeTest {
+protected:
+   void append_gds(vector<uint64_t>& bc, ESDOp op, int dst, int src) const;
+};
+
+/* dst.x = op(src.xyz) */
+void LDSAnalysisTest::append_gds(vector<uint64_t>& bc, ESDOp op,
+                                 int dst, int src) const
+{
+   uint64_t bc0 = 2 | (4 << 8);
+   bc0 |= static_cast<uint64_t>(src) << 11;
+   bc0 |= (0 << 20) | (1 << 23) | (2 << 26);
+   bc0 |= static_cast<uint64_t>(dst) << 32;
+   bc0 |= static_cast<uint64_t>(op) << 41;
+   bc.push_back(bc0);
+   bc.push_back(0 | (7 << 3) | (7 << 6) | (7 << 9));
+}
+
+TEST_F(LDSAnalysisTest, GDSDecodeRoundtrip)
+{
+   vector<uint64_t> bc;
+   append_gds(bc, DS_OP_ADD_RET, 2, 1);
+
+   auto node = FetchNode::decode(bc[0], bc[1]);
+   auto gds = std::dynamic_pointer_cast<GDSOpNode>(node);
+   ASSERT_TRUE(gds);
+   EXPECT_EQ(gds->gds_op(), DS_OP_ADD_RET);
+   EXPECT_EQ(gds->src().sel(), 1u);
+   EXPECT_EQ(gds->dst().sel(), 2u);
+
+   EXPECT_EQ(node->get_bytecode_byte(0), bc[0]);
+   EXPECT_EQ(node->get_bytecode_byte(1), bc[1]);
+
+   std::ostringstream os;
+   os << *node;
+   EXPECT_EQ(os.str(), "GDS DS_ADD_RET R2.x___, R1.xyz UAV:0");
+}
+
+TEST_F(LDSAnalysisTest, AccessPatterns)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 3, 8).append_bytecode(bc);
+   CFFetchNode(cf_gds, 0, 11, 1).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(lds_op(DS_OP_READ_RET, gpr(1, 0), gpr(0, 0), gpr(0, 0),
+                       true, 0));
+   bc.push_back(lds_op(DS_OP_READ_RET, gpr(1, 0), gpr(0, 0), gpr(0, 0),
+                       true, 4));
+   bc.push_back(mov(2, 0, inline_const(ALU_SRC_LDS_OQ_A_POP)));
+   bc.push_back(mov(3, 0, inline_const(ALU_SRC_LDS_OQ_A_POP)));
+   bc.push_back(lds_op(DS_OP_WRITE, gpr(1, 0), gpr(4, 0), gpr(4, 0),
+                       true, 0));
+   bc.push_back(lds_op(DS_OP_WRITE, gpr(5, 0), gpr(4, 0), gpr(4, 0),
+                       true, 4));
+   bc.push_back(lds_op(DS_OP_WRITE, gpr(1, 0), gpr(4, 0), gpr(4, 0),
+                       true, 4));
+   /* the returned value is never popped */
+   bc.push_back(lds_op(DS_OP_ADD_RET, gpr(1, 0), gpr(4, 0), gpr(4, 0),
+                       true, 8));
+
+   append_gds(bc, DS_OP_ADD_RET, 2, 1);
+   append_gds(bc, DS_OP_WRITE, 0, 1);
+
+   disassembler diss(bc);
+   LDSAnalysis la(diss);
+
+   ASSERT_EQ(la.clauses().size(), 2u);
+   const auto& c = la.clauses()[0];
+   EXPECT_EQ(c.cf_addr, 0u);
+   EXPECT_FALSE(c.gds);
+   EXPECT_EQ(c.accesses[LDSAnalysis::ak_read], 2u);
+   EXPECT_EQ(c.accesses[LDSAnalysis::ak_write], 3u);
+   EXPECT_EQ(c.accesses[LDSAnalysis::ak_atomic], 1u);
+   EXPECT_EQ(c.queue_pushes, 3u);
+   EXPECT_EQ(c.queue_pops, 2u);
+   EXPECT_EQ(c.read_pair_candidates, 1u);
+   EXPECT_EQ(c.write_pair_candidates, 1u);
+
+   EXPECT_TRUE(la.clauses()[1].gds);
+   EXPECT_EQ(la.gds_total(LDSAnalysis::ak_atomic), 1u);
+   EXPECT_EQ(la.gds_total(LDSAnalysis::ak_write), 1u);
+   EXPECT_EQ(la.lds_total(LDSAnalysis::ak_write), 3u);
+
+   std::ostringstream os;
+   la.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: LDS 2 reads, 3 writes, 1 atomics\n"
+             "CF 0: 3 values pushed to the output queue but 2 popped\n"
+             "CF 0: 1 pairs of reads could use READ2_RET\n"
+             "CF 0: 1 pairs of writes could use WRITE_REL\n"
+             "CF 1: GDS 1 writes, 1 atomics\n");
+}
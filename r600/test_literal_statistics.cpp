@@ -0,0 +1,103 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/literal_statistics.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class LiteralStatisticsTest: public BytecodeTest {
+protected:
+   vector<uint64_t> program(uint32_t literal0, uint32_t literal1) const;
+};
+
+vector<uint64_t> LiteralStatisticsTest::program(uint32_t literal0,
+                                                uint32_t literal1) const
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 3).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(op2(op2_add, 1, 0, literal(0), inline_const(ALU_SRC_1),
+                    false));
+   bc.push_back(op2(op2_add_int, 1, 1, literal(1), gpr(2, 0)));
+   bc.push_back(literal0 | static_cast<uint64_t>(literal1) << 32);
+   return bc;
+}
+
+TEST_F(LiteralStatisticsTest, InlineCandidates)
+{
+   EXPECT_TRUE(LiteralStatistics::is_inline_candidate(0x3f800000, true));
+   EXPECT_TRUE(LiteralStatistics::is_inline_candidate(0xffffffff, false));
+   EXPECT_TRUE(LiteralStatistics::is_inline_candidate(0xbf000000, true));
+   EXPECT_FALSE(LiteralStatistics::is_inline_candidate(0xbf000000, false));
+   EXPECT_FALSE(LiteralStatistics::is_inline_candidate(0x40000000, true));
+}
+
+TEST_F(LiteralStatisticsTest, SingleProgram)
+{
+   LiteralStatistics stats;
+   stats.add_program(disassembler(program(0x3f800000, 0x1234)));
+
+   ASSERT_EQ(stats.programs().size(), 1u);
+   auto p = stats.programs()[0];
+   EXPECT_EQ(p.literal_qwords, 1u);
+   EXPECT_EQ(p.literal_reads, 2u);
+   EXPECT_EQ(p.inline_candidates, 1u);
+   EXPECT_EQ(p.inline_reads, 1u);
+
+   ASSERT_EQ(stats.literal_values().size(), 2u);
+   EXPECT_TRUE(stats.literal_values().at(0x3f800000).inline_candidate);
+   EXPECT_FALSE(stats.literal_values().at(0x1234).inline_candidate);
+   EXPECT_EQ(stats.inline_values().at(ALU_SRC_1), 1u);
+}
+
+TEST_F(LiteralStatisticsTest, ParallelCorpus)
+{
+   vector<vector<uint64_t>> corpus;
+   for (uint32_t i = 0; i < 7; ++i)
+      corpus.push_back(program(0x3f800000, 0x100 + i));
+
+   auto stats = LiteralStatistics::collect(corpus, 3);
+
+   ASSERT_EQ(stats.programs().size(), 7u);
+   EXPECT_EQ(stats.total().literal_qwords, 7u);
+   EXPECT_EQ(stats.total().literal_reads, 14u);
+   EXPECT_EQ(stats.literal_values().size(), 8u);
+   EXPECT_EQ(stats.literal_values().at(0x3f800000).reads, 7u);
+   EXPECT_EQ(stats.literal_values().at(0x3f800000).programs, 7u);
+   EXPECT_EQ(stats.literal_values().at(0x102).programs, 1u);
+
+   std::ostringstream os;
+   stats.print(os, 1);
+   EXPECT_EQ(os.str(),
+             "Programs: 7\n"
+             "Literal quadwords: 7\n"
+             "Literal reads: 14 (inline candidates: 7)\n"
+             "Inline constant reads: 7\n"
+             "  1.0         7\n"
+             "Literal values:\n"
+             "  0x3f800000 (1f, 1065353216i) reads:7 programs:7 inline\n");
+}
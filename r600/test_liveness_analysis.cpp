@@ -0,0 +1,110 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/liveness_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class LivenessAnalysisTest: public BytecodeTest {
+protected:
+   void append_export(vector<uint64_t>& bc, uint16_t opcode, int gpr,
+                      const vector<unsigned>& sel, bool eop) const;
+};
+
+void LivenessAnalysisTest::append_export(vector<uint64_t>& bc,
+                                         uint16_t opcode, int gpr,
+                                         const vector<unsigned>& sel,
+                                         bool eop) const
+{
+   CFExportNode(opcode, CFMemNode::export_pixel, gpr, 0, 0, 0, sel,
+                eop ? 1 << CFNode::eop : 0).append_bytecode(bc);
+}
+
+TEST_F(LivenessAnalysisTest, LiveThroughDivergentIf)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu_push_before, 0, 5, 2).append_bytecode(bc);
+   CFNativeNode(cf_jump, 0, 3, 1).append_bytecode(bc);
+   CFAluNode(cf_alu_pop_after, 0, 7, 1).append_bytecode(bc);
+   append_export(bc, cf_export, 1, {0, 7, 7, 7}, false);
+   append_export(bc, cf_export_done, 2, {7, 1, 7, 7}, true);
+
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+   bc.push_back(mov(2, 1, gpr(0, 1)));
+   /* Threads that skip the branch still need the old R1.x */
+   bc.push_back(mov(1, 0, gpr(0, 2)));
+
+   disassembler diss(bc);
+   LivenessAnalysis la(diss);
+
+   auto r = LivenessAnalysis::reg;
+   EXPECT_TRUE(la.live_in(2).test(r(1, 0)));
+   EXPECT_FALSE(la.live_in(0).test(r(1, 0)));
+   EXPECT_TRUE(la.live_out(4).none());
+
+   EXPECT_TRUE(la.interfere(r(1, 0), r(2, 1)));
+   EXPECT_TRUE(la.interfere(r(2, 1), r(1, 0)));
+   EXPECT_TRUE(la.interfere(r(1, 0), r(0, 2)));
+   EXPECT_FALSE(la.interfere(r(1, 0), r(0, 0)));
+
+   EXPECT_EQ(la.max_live_channels(), 3u);
+   EXPECT_EQ(la.max_live_gprs(), 1u);
+
+   std::ostringstream os;
+   la.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: in R0.xyz, out R0.z R1.x R2.y\n"
+             "CF 1: in R0.z R1.x R2.y, out R0.z R1.x R2.y\n"
+             "CF 2: in R0.z R1.x R2.y, out R1.x R2.y\n"
+             "CF 3: in R1.x R2.y, out R2.y\n"
+             "CF 4: in R2.y, out -\n"
+             "max live: 3 channels in 1 GPRs at CF 0\n"
+             "interference: 4 edges\n");
+}
+
+TEST_F(LivenessAnalysisTest, LoopCarriedValue)
+{
+   vector<uint64_t> bc;
+   CFNativeNode(cf_loop_start_dx10, 0, 3).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 5, 2).append_bytecode(bc);
+   CFNativeNode(cf_loop_end, 0, 1).append_bytecode(bc);
+   append_export(bc, cf_export, 1, {0, 7, 7, 7}, false);
+   append_export(bc, cf_export_done, 3, {0, 7, 7, 7}, true);
+
+   /* R1.x is read before it is written in the next iteration, R3.x is
+    * only written in the loop */
+   bc.push_back(mov(3, 0, gpr(1, 0)));
+   bc.push_back(mov(1, 0, gpr(2, 0)));
+
+   disassembler diss(bc);
+   LivenessAnalysis la(diss);
+
+   auto r = LivenessAnalysis::reg;
+   EXPECT_TRUE(la.live_out(2).test(r(1, 0)));
+   EXPECT_TRUE(la.live_in(0).test(r(1, 0)));
+   EXPECT_TRUE(la.live_in(0).test(r(2, 0)));
+   /* live at loop entry and exit, so live throughout the loop */
+   EXPECT_TRUE(la.live_in(1).test(r(3, 0)));
+}
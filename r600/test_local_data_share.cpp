@@ -0,0 +1,205 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/bc_test.h>
+#include <r600/alu_interpreter.h>
+#include <r600/disassembler.h>
+#include <r600/local_data_share.h>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace r600;
+using std::vector;
+
+class LocalDataShareTest: public BytecodeTest {
+protected:
+   LocalDataShareTest();
+
+   void execute(ESDOp op, int offset = 0, LaneMask active = ~LaneMask(0));
+
+   /* Run an ALU clause on wf */
+   void run(const vector<uint64_t>& code);
+
+   Lanes address;
+   Lanes data0;
+   Lanes data1;
+   PLocalDataShare lds;
+   Wavefront wf;
+};
+
+LocalDataShareTest::LocalDataShareTest():
+   lds(std::make_shared<LocalDataShare>(1024))
+{
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      address[i] = 4 * i;
+      data0[i] = i + 1;
+      data1[i] = 100 + i;
+   }
+   wf.set_lds(lds);
+}
+
+void LocalDataShareTest::execute(ESDOp op, int offset, LaneMask active)
+{
+   const Lanes *src[3] = {&address, &data0, &data1};
+   lds->execute(op, offset, src, active, wf);
+}
+
+void LocalDataShareTest::run(const vector<uint64_t>& code)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, code.size()).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   bc.insert(bc.end(), code.begin(), code.end());
+
+   disassembler diss(bc);
+   auto alu = dynamic_cast<const CFAluNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(alu);
+   AluInterpreter::run(*alu, wf);
+}
+
+TEST_F(LocalDataShareTest, WriteAndRead)
+{
+   execute(DS_OP_WRITE);
+   execute(DS_OP_READ_RET, 4);
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(lds->read(4 * i), i + 1);
+      ASSERT_EQ(wf.lds_queue(0, i).size(), 1u);
+      EXPECT_EQ(wf.lds_queue(0, i)[0], i < wavefront_size - 1 ? i + 2 : 0u);
+      EXPECT_TRUE(wf.lds_queue(1, i).empty());
+   }
+
+   /* READ2 takes the second address from src1 */
+   for (auto& a: data0)
+      a = 8;
+   execute(DS_OP_READ2_RET);
+   EXPECT_EQ(wf.lds_queue(0, 3)[1], 4u);
+   EXPECT_EQ(wf.lds_queue(1, 3)[0], 3u);
+
+   /* Outside the arena */
+   EXPECT_EQ(lds->read(1024), 0u);
+   lds->write(1024, 1);
+   EXPECT_EQ(lds->read(1024), 0u);
+}
+
+TEST_F(LocalDataShareTest, AtomicsAreOrderedByThread)
+{
+   /* all threads add to the same address */
+   address.fill(16);
+   execute(DS_OP_ADD_RET);
+   uint32_t sum = 0;
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      EXPECT_EQ(wf.lds_queue(0, i)[0], sum);
+      sum += i + 1;
+   }
+   EXPECT_EQ(lds->read(16), sum);
+
+   /* only the first active thread finds the compare value */
+   data0.fill(sum);
+   execute(DS_OP_CMP_XCHG_RET, 0, ~LaneMask(0) << 3);
+   EXPECT_EQ(lds->read(16), 103u);
+   EXPECT_TRUE(wf.lds_queue(0, 0).size() == 1);
+   EXPECT_EQ(wf.lds_queue(0, 3)[1], sum);
+   EXPECT_EQ(wf.lds_queue(0, 4)[1], 103u);
+
+   lds->write(20, 5);
+   address.fill(20);
+   data0.fill(3);
+   /* 5 wraps to 0, then counts up */
+   execute(DS_OP_INC, 0, 0xf);
+   EXPECT_EQ(lds->read(20), 3u);
+   execute(DS_OP_DEC, 0, 0x3);
+   EXPECT_EQ(lds->read(20), 1u);
+   execute(DS_OP_MAX_INT, 0, 0x1);
+   data0.fill(0xfffffffe);
+   execute(DS_OP_MIN_INT, 0, 0x1);
+   EXPECT_EQ(lds->read(20), 0xfffffffeu);
+   execute(DS_OP_RSUB, 0, 0x1);
+   EXPECT_EQ(lds->read(20), 0u);
+   data0.fill(0xff00);
+   data1.fill(0x1234);
+   execute(DS_OP_MSKOR, 0, 0x1);
+   EXPECT_EQ(lds->read(20), 0x1234u);
+}
+
+TEST_F(LocalDataShareTest, SubDwordAccess)
+{
+   lds->write(0, 0x80ff7f01);
+   for (unsigned i = 0; i < 4; ++i)
+      address[i] = i;
+   execute(DS_OP_BYTE_READ_RET, 0, 0xf);
+   execute(DS_OP_UBYTE_READ_RET, 0, 0xf);
+   execute(DS_OP_SHORT_READ_RET, 0, 0xf);
+   execute(DS_OP_USHORT_READ_RET, 0, 0xf);
+
+   const uint32_t expect[4][4] = {
+      {0x01, 0x01, 0x7f01, 0x7f01},
+      {0x7f, 0x7f, 0x7f01, 0x7f01},
+      {0xffffffff, 0xff, 0xffff80ff, 0x80ff},
+      {0xffffff80, 0x80, 0xffff80ff, 0x80ff}
+   };
+   for (unsigned i = 0; i < 4; ++i)
+      EXPECT_EQ(wf.lds_queue(0, i), vector<uint32_t>(expect[i], expect[i] + 4));
+
+   data0.fill(0xabcd);
+   execute(DS_OP_BYTE_WRITE, 0, 0x2);
+   execute(DS_OP_SHORT_WRITE, 0, 0x4);
+   EXPECT_EQ(lds->read(0), 0xabcdcd01u);
+
+   EXPECT_FALSE(LocalDataShare::supported(DS_OP_READ_REL_RET));
+   EXPECT_THROW(execute(DS_OP_ATOMIC_ORDERED_ALLOC_RET), std::runtime_error);
+}
+
+TEST_F(LocalDataShareTest, OutputQueueInAluClause)
+{
+   for (unsigned i = 0; i < wavefront_size; ++i) {
+      wf.gpr(0, 0)[i] = 4 * i;
+      wf.gpr(0, 1)[i] = 10 * i;
+   }
+   wf.set_active(0xffff);
+
+   vector<uint64_t> code = {
+      lds_op(DS_OP_WRITE, gpr(0, 0), gpr(0, 1), gpr(0, 0)),
+      lds_op(DS_OP_ADD_RET, inline_const(ALU_SRC_0),
+             inline_const(ALU_SRC_1_INT), gpr(0, 0)),
+      lds_op(DS_OP_READ2_RET, gpr(0, 0), inline_const(ALU_SRC_0), gpr(0, 0)),
+      mov(1, 0, inline_const(ALU_SRC_LDS_OQ_A_POP)),
+      mov(1, 1, inline_const(ALU_SRC_LDS_OQ_A)),
+      mov(1, 2, inline_const(ALU_SRC_LDS_OQ_B_POP)),
+      mov(1, 3, inline_const(ALU_SRC_LDS_OQ_A_POP)),
+   };
+   run(code);
+
+   for (unsigned i = 0; i < 16; ++i) {
+      /* the ADD_RET of the threads before */
+      EXPECT_EQ(wf.gpr(1, 0)[i], i == 0 ? 0u : i);
+      /* address 0 was the target of the ADD_RET */
+      uint32_t written = i == 0 ? 16 : 10 * i;
+      EXPECT_EQ(wf.gpr(1, 1)[i], written);
+      EXPECT_EQ(wf.gpr(1, 2)[i], 16u);
+      EXPECT_EQ(wf.gpr(1, 3)[i], written);
+      EXPECT_TRUE(wf.lds_queue(0, i).empty());
+      EXPECT_TRUE(wf.lds_queue(1, i).empty());
+   }
+   EXPECT_EQ(lds->read(0), 16u);
+   EXPECT_EQ(lds->read(64), 0u);
+
+   wf.set_lds(nullptr);
+   EXPECT_THROW(run(code), std::runtime_error);
+}
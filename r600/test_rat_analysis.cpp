@@ -0,0 +1,90 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <r600/rat_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class RATAnalysisTest: public testing::Test {
+protected:
+   uint64_t rat(uint16_t opcode, uint16_t rat_inst, uint16_t rat_id,
+                uint16_t type, uint16_t rw_gpr, uint16_t comp_mask,
+                uint16_t burst_count) const;
+};
+
+uint64_t RATAnalysisTest::rat(uint16_t opcode, uint16_t rat_inst,
+                              uint16_t rat_id, uint16_t type,
+                              uint16_t rw_gpr, uint16_t comp_mask,
+                              uint16_t burst_count) const
+{
+   return CFRatNode(opcode, rat_inst, rat_id, 0, type, rw_gpr, 0, 0, 0,
+                    comp_mask, burst_count, 0).get_bytecode_byte(0);
+}
+
+TEST_F(RATAnalysisTest, StoresAtomicsAndAckWaits)
+{
+   vector<uint64_t> bc;
+   bc.push_back(rat(cf_mem_rat, 1, 0, 0, 1, 0xf, 0));
+   bc.push_back(rat(cf_mem_rat_cacheless, 2, 0, 0, 2, 0x3, 1));
+   bc.push_back(rat(cf_mem_rat, 39, 1, 3, 4, 0x1, 0));
+   CFNativeNode(cf_wait_ack, 0).append_bytecode(bc);
+   bc.push_back(rat(cf_mem_rat, 7, 1, 0, 5, 0x1, 0));
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   disassembler diss(bc);
+   RATAnalysis ra(diss);
+
+   ASSERT_EQ(ra.accesses().size(), 4u);
+   EXPECT_EQ(ra.accesses()[0].kind, RATAnalysis::rk_store);
+   EXPECT_TRUE(ra.accesses()[1].cacheless);
+   EXPECT_EQ(ra.accesses()[1].burst, 2u);
+   EXPECT_EQ(ra.accesses()[2].kind, RATAnalysis::rk_atomic_return);
+   EXPECT_TRUE(ra.accesses()[2].ack);
+   EXPECT_EQ(ra.accesses()[3].kind, RATAnalysis::rk_atomic);
+
+   ASSERT_EQ(ra.rat_stats().size(), 2u);
+   EXPECT_EQ(ra.rat_stats().at(0).stores, 2u);
+   EXPECT_EQ(ra.rat_stats().at(0).partial_masks, 1u);
+   EXPECT_EQ(ra.rat_stats().at(1).atomics, 2u);
+   EXPECT_EQ(ra.rat_stats().at(1).returning_atomics, 1u);
+
+   ASSERT_EQ(ra.ack_waits().size(), 1u);
+   EXPECT_EQ(ra.ack_waits()[0].cf_addr, 3u);
+   EXPECT_EQ(ra.ack_waits()[0].outstanding, 1u);
+
+   std::ostringstream os;
+   ra.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: RAT0 STORE_TYPED R1.xyzw cached\n"
+             "CF 1: RAT0 STORE_RAW R2-R3.xy__ cacheless partial\n"
+             "CF 2: RAT1 INT_ADD_RTN R4.x___ cached ack\n"
+             "CF 3: WAIT_ACK for 1 writes\n"
+             "CF 4: RAT1 INT_ADD R5.x___ cached\n"
+             "RAT0: 2 stores, 0 atomics (0 returning), 1 cacheless, "
+             "1 partial masks\n"
+             "RAT1: 0 stores, 2 atomics (1 returning), 0 cacheless, "
+             "0 partial masks\n"
+             "total: 2 stores, 2 atomics, 1 cacheless, 3 cached, "
+             "1 ACK waits\n");
+}
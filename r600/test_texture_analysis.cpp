@@ -0,0 +1,100 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/texture_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class TextureAnalysisTest: public BytecodeTest {
+};
+
+TEST_F(TextureAnalysisTest, UsageAndClauseGrouping)
+{
+   vector<uint64_t> bc;
+   CFFetchNode(cf_tc, 0, 6, 1).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 10, 1).append_bytecode(bc);
+   CFFetchNode(cf_tc, 0, 11, 0).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 13, 1).append_bytecode(bc);
+   CFFetchNode(cf_tc, 0, 14, 0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   tex(bc, TexFetchNode::tex_sample, 1, 0);
+   tex(bc, TexFetchNode::tex_sample_l, 2, 0);
+   bc.push_back(mov(3, 0, gpr(1, 0)));
+   /* independent of the ALU clause before, can join the first clause */
+   tex(bc, TexFetchNode::tex_sample, 4, 0, 1, 1);
+   bc.push_back(mov(5, 0, gpr(4, 0)));
+   /* reads R5 that is written by the ALU clause before */
+   tex(bc, TexFetchNode::tex_ld, 6, 5, 2, 3);
+
+   disassembler diss(bc);
+   TextureAnalysis ta(diss);
+
+   ASSERT_EQ(ta.usage().size(), 3u);
+   const auto& u0 = ta.usage().at({0, 0});
+   EXPECT_EQ(u0.count, 2u);
+   EXPECT_EQ(u0.variants.at(TexFetchNode::tex_sample_l), 1u);
+   EXPECT_EQ(ta.usage().at({2, -1}).count, 1u);
+
+   EXPECT_EQ(ta.tex_clauses(), 3u);
+   EXPECT_EQ(ta.tex_instructions(), 4u);
+   EXPECT_EQ(ta.single_fetch_clauses(), vector<unsigned>({2, 4}));
+
+   ASSERT_EQ(ta.clause_merges().size(), 1u);
+   EXPECT_EQ(ta.clause_merges()[0].first_addr, 0u);
+   EXPECT_EQ(ta.clause_merges()[0].second_addr, 2u);
+
+   std::ostringstream os;
+   ta.print(os);
+   EXPECT_EQ(os.str(),
+             "RID 0 SID 0: 2 fetches (SAMPLE 1, SAMPLE_L 1)\n"
+             "RID 1 SID 1: 1 fetches (SAMPLE 1)\n"
+             "RID 2 SID -: 1 fetches (LD 1)\n"
+             "3 TEX clauses, 4 TEX instructions\n"
+             "CF 2: TEX clause with a single fetch\n"
+             "CF 4: TEX clause with a single fetch\n"
+             "CF 0 and 2: TEX clauses could be merged\n");
+}
+
+TEST_F(TextureAnalysisTest, NoMergeAcrossWriteAfterRead)
+{
+   vector<uint64_t> bc;
+   CFFetchNode(cf_tc, 0, 4, 0).append_bytecode(bc);
+   CFAluNode(cf_alu, 0, 6, 1).append_bytecode(bc);
+   CFFetchNode(cf_tc, 0, 7, 0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   tex(bc, TexFetchNode::tex_sample, 1, 0);
+   /* the ALU clause reads R2.x that the second clause overwrites */
+   bc.push_back(mov(3, 0, gpr(2, 0)));
+   tex(bc, TexFetchNode::tex_sample, 2, 0);
+
+   disassembler diss(bc);
+   TextureAnalysis ta(diss);
+
+   EXPECT_TRUE(ta.clause_merges().empty());
+   EXPECT_EQ(ta.single_fetch_clauses().size(), 2u);
+}
@@ -0,0 +1,108 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/vertex_fetch_analysis.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class VertexFetchAnalysisTest: public BytecodeTest {
+};
+
+TEST_F(VertexFetchAnalysisTest, FetchDecoding)
+{
+   vector<uint64_t> bc;
+   CFFetchNode(cf_vc, 0, 2, 0).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   vtx(bc, 3, 1, 16, VertexFetchNode::fmt_32_32_float,
+       VertexFetchNode::nf_norm, swizzle_xyzw, false, 0,
+       VertexFetchNode::vertex_data, 7);
+
+   disassembler diss(bc);
+   auto fetch = dynamic_cast<const CFFetchNode *>(diss.get_program()[0].get());
+   ASSERT_TRUE(fetch);
+   ASSERT_EQ(fetch->clause().size(), 1u);
+
+   auto vtx = dynamic_cast<const VertexFetchNode *>(fetch->clause()[0].get());
+   ASSERT_TRUE(vtx);
+   EXPECT_EQ(vtx->buffer_id(), 3u);
+   EXPECT_EQ(vtx->offset(), 16u);
+   EXPECT_EQ(vtx->data_format(), VertexFetchNode::fmt_32_32_float);
+   EXPECT_TRUE(vtx->is_mega_fetch());
+   EXPECT_EQ(vtx->mega_fetch_count(), 7u);
+   EXPECT_EQ(vtx->dst().sel(), 1u);
+}
+
+TEST_F(VertexFetchAnalysisTest, BandwidthAndMegaFetchMerge)
+{
+   vector<uint64_t> bc;
+   CFFetchNode(cf_vc, 0, 2, 3).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+   vtx(bc, 0, 1, 0, VertexFetchNode::fmt_32_32_32_float,
+       VertexFetchNode::nf_norm, swizzle_xyzw, false, 0,
+       VertexFetchNode::vertex_data, 11);
+   vtx(bc, 0, 1, 12, VertexFetchNode::fmt_32_32_float,
+       VertexFetchNode::nf_norm, swizzle_xyzw, false, 0,
+       VertexFetchNode::vertex_data, 7);
+   vtx(bc, 1, 1, 0, VertexFetchNode::fmt_8_8_8_8,
+       VertexFetchNode::nf_norm, swizzle_xyzw, false, 0,
+       VertexFetchNode::instance_data, 3);
+   vtx(bc, 0, 1, 16, VertexFetchNode::fmt_32,
+       VertexFetchNode::nf_norm, swizzle_xyzw, false, 0,
+       VertexFetchNode::vertex_data, -1);
+
+   disassembler diss(bc);
+   VertexFetchAnalysis vfa(diss);
+
+   ASSERT_EQ(vfa.buffers().size(), 2u);
+   const auto& b0 = vfa.buffers().at({0, VertexFetchNode::vertex_data});
+   EXPECT_EQ(b0.fetches, 3u);
+   EXPECT_EQ(b0.used_bytes, 24u);
+   EXPECT_EQ(b0.fetched_bytes, 20u);
+
+   ASSERT_EQ(vfa.merge_candidates().size(), 1u);
+   EXPECT_EQ(vfa.merge_candidates()[0].fetches, vector<unsigned>({0, 1}));
+   EXPECT_EQ(vfa.merge_candidates()[0].bytes, 20u);
+
+   EXPECT_EQ(vfa.bytes_per_vertex(), 20u);
+   EXPECT_EQ(vfa.bytes_per_instance(), 4u);
+
+   std::ostringstream os;
+   vfa.print(os);
+   EXPECT_EQ(os.str(),
+             "buffer 0 vertex: 3 fetches, 24 bytes used, 20 bytes fetched\n"
+             "buffer 1 instance: 1 fetches, 4 bytes used, 4 bytes fetched\n"
+             "CF 0: fetches 0, 1 of buffer 0 could share one mega-fetch of 20 bytes\n"
+             "per vertex: 20 bytes, per instance: 4 bytes\n");
+}
+
+TEST_F(VertexFetchAnalysisTest, FormatSizes)
+{
+   EXPECT_EQ(VertexFetchNode::data_format_size(VertexFetchNode::fmt_8), 1u);
+   EXPECT_EQ(VertexFetchNode::data_format_size(VertexFetchNode::fmt_16_16_16_float), 6u);
+   EXPECT_EQ(VertexFetchNode::data_format_size(VertexFetchNode::fmt_2_10_10_10), 4u);
+   EXPECT_EQ(VertexFetchNode::data_format_size(VertexFetchNode::fmt_32_32_32_32_float), 16u);
+   EXPECT_EQ(VertexFetchNode::data_format_size(VertexFetchNode::fmt_bc1), 0u);
+}
@@ -0,0 +1,88 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/bc_test.h>
+#include <r600/vliw_repack.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <sstream>
+
+using namespace r600;
+using std::vector;
+
+class VLIWRepackTest: public BytecodeTest {
+};
+
+TEST_F(VLIWRepackTest, IndependentMovsAreMerged)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 6).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   bc.push_back(mov(1, 0, gpr(0, 0)));
+   bc.push_back(mov(2, 1, gpr(0, 1)));
+   bc.push_back(mov(3, 2, gpr(0, 2)));
+   bc.push_back(mov(4, 3, gpr(0, 3)));
+   bc.push_back(mov(5, 0, gpr(1, 0)));
+   bc.push_back(mov(6, 0, gpr(0, 0)));
+
+   disassembler diss(bc);
+   VLIWRepackSimulation sim(diss);
+
+   ASSERT_EQ(sim.clauses().size(), 1u);
+   const auto& c = sim.clauses()[0];
+   EXPECT_EQ(c.instructions, 6u);
+   EXPECT_EQ(c.groups, 6u);
+   ASSERT_EQ(c.schedule.size(), 2u);
+
+   /* R6.x moves into the trans slot of the first group, R5.x depends on
+    * R1.x and has to go into the next group */
+   for (unsigned s = 0; s < 5; ++s)
+      EXPECT_TRUE(c.schedule[0].slot(s));
+   EXPECT_TRUE(c.schedule[1].slot(0));
+   EXPECT_FALSE(c.schedule[1].slot(4));
+
+   std::ostringstream os;
+   sim.print(os);
+   EXPECT_EQ(os.str(),
+             "CF 0: 6 instructions in 6 groups, 2 groups after repacking\n"
+             "total: 6 groups, 2 groups after repacking\n");
+}
+
+TEST_F(VLIWRepackTest, LiteralLimitSplitsGroups)
+{
+   vector<uint64_t> bc;
+   CFAluNode(cf_alu, 0, 2, 10).append_bytecode(bc);
+   CFNativeNode(cf_nop, 1 << CFNode::eop).append_bytecode(bc);
+
+   for (unsigned i = 0; i < 5; ++i) {
+      bc.push_back(mov(1 + i, i & 3, literal(0)));
+      bc.push_back(0x100 + i);
+   }
+
+   disassembler diss(bc);
+   VLIWRepackSimulation sim(diss);
+
+   ASSERT_EQ(sim.clauses().size(), 1u);
+   EXPECT_EQ(sim.clauses()[0].instructions, 5u);
+   EXPECT_EQ(sim.groups(), 5u);
+   EXPECT_EQ(sim.repacked_groups(), 2u);
+}
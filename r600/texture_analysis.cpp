@@ -0,0 +1,224 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/texture_analysis.h>
+
+#include <iostream>
+
+namespace r600 {
+
+static unsigned gpr_key(unsigned sel, unsigned chan)
+{
+   return sel * 4 + chan;
+}
+
+static void set_all_channel(std::bitset<512>& set, unsigned chan)
+{
+   for (unsigned sel = 0; sel < 128; ++sel)
+      set.set(gpr_key(sel, chan));
+}
+
+TextureAnalysis::TextureAnalysis(const disassembler& program):
+   m_tex_clauses(0),
+   m_tex_instructions(0)
+{
+   unsigned cf_addr = 0;
+   bool have_last = false;
+   ClauseInfo last;
+   RegSet between_reads;
+   RegSet between_writes;
+
+   for (const auto& n: program.get_program()) {
+      auto fetch = dynamic_cast<const CFFetchNode *>(n.get());
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      auto native = dynamic_cast<const CFNativeNode *>(n.get());
+
+      ClauseInfo info;
+      if (fetch && fetch->opcode() == cf_tc &&
+          analyse_tex_clause(cf_addr, *fetch, info)) {
+         if (have_last &&
+             (info.reads & (last.writes | between_writes)).none() &&
+             (info.writes & (between_reads | between_writes)).none())
+            m_clause_merges.push_back({last.cf_addr, cf_addr});
+
+         last = info;
+         have_last = true;
+         between_reads.reset();
+         between_writes.reset();
+      } else if (alu) {
+         add_alu_access(*alu, between_reads, between_writes);
+      } else if (!native || native->opcode() != cf_nop) {
+         /* Only ALU clauses can be moved across */
+         have_last = false;
+      }
+      cf_addr += n->bytecode_size();
+   }
+}
+
+bool TextureAnalysis::analyse_tex_clause(unsigned cf_addr,
+                                         const CFFetchNode& clause,
+                                         ClauseInfo& info)
+{
+   info.cf_addr = cf_addr;
+   unsigned ntex = 0;
+
+   for (const auto& f: clause.clause()) {
+      auto tex = dynamic_cast<const TexFetchNode *>(f.get());
+
+      const auto& src = f->src();
+      if (src.rel()) {
+         info.reads.set();
+      } else if (tex) {
+         for (auto s: tex->src_swizzle())
+            if (s < 4)
+               info.reads.set(gpr_key(src.sel(), s));
+      } else {
+         info.reads.set(gpr_key(src.sel(), src.chan()));
+      }
+
+      const auto& dst = f->dst();
+      for (unsigned i = 0; i < 4; ++i) {
+         if (f->dst_swizzle()[i] == 7)
+            continue;
+         if (dst.rel())
+            set_all_channel(info.writes, i);
+         else
+            info.writes.set(gpr_key(dst.sel(), i));
+      }
+
+      if (!tex)
+         continue;
+
+      ++ntex;
+
+      auto op = tex->tex_opcode();
+      bool accesses_resource = tex->uses_sampler() ||
+                               op == TexFetchNode::tex_ld ||
+                               op == TexFetchNode::tex_get_res_info ||
+                               op == TexFetchNode::tex_get_num_samples;
+      if (!accesses_resource)
+         continue;
+
+      ResourceSampler rs(tex->resource_id(),
+                         tex->uses_sampler() ? static_cast<int>(tex->sampler_id()) : -1);
+      auto& u = m_usage[rs];
+      ++u.count;
+      ++u.variants[op];
+   }
+
+   if (!ntex)
+      return false;
+
+   ++m_tex_clauses;
+   m_tex_instructions += ntex;
+   if (ntex == 1)
+      m_single_fetch_clauses.push_back(cf_addr);
+   return true;
+}
+
+void TextureAnalysis::add_alu_access(const CFAluNode& alu, RegSet& reads,
+                                     RegSet& writes)
+{
+   for (const auto& g: alu.clause()) {
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = g.slot(s);
+         if (!node)
+            continue;
+
+         for (unsigned i = 0; i < node->nsources(); ++i) {
+            auto v = node->get_src(i);
+            if (!v || v->type() != Value::gpr)
+               continue;
+            if (v->rel())
+               set_all_channel(reads, v->chan());
+            else
+               reads.set(gpr_key(v->sel(), v->chan()));
+         }
+
+         auto n = dynamic_cast<const AluNodeWithDst *>(node.get());
+         if (!n || !n->writes_dst())
+            continue;
+         if (n->dst().rel())
+            set_all_channel(writes, n->dst().chan());
+         else
+            writes.set(gpr_key(n->dst().sel(), n->dst().chan()));
+      }
+   }
+}
+
+const std::map<TextureAnalysis::ResourceSampler, TextureAnalysis::Usage>&
+TextureAnalysis::usage() const
+{
+   return m_usage;
+}
+
+unsigned TextureAnalysis::tex_clauses() const
+{
+   return m_tex_clauses;
+}
+
+unsigned TextureAnalysis::tex_instructions() const
+{
+   return m_tex_instructions;
+}
+
+const std::vector<unsigned>& TextureAnalysis::single_fetch_clauses() const
+{
+   return m_single_fetch_clauses;
+}
+
+const std::vector<TextureAnalysis::ClauseMerge>&
+TextureAnalysis::clause_merges() const
+{
+   return m_clause_merges;
+}
+
+void TextureAnalysis::print(std::ostream& os) const
+{
+   for (const auto& u: m_usage) {
+      os << "RID " << u.first.first << " SID ";
+      if (u.first.second < 0)
+         os << "-";
+      else
+         os << u.first.second;
+      os << ": " << u.second.count << " fetches (";
+
+      bool first = true;
+      for (const auto& v: u.second.variants) {
+         os << (first ? "" : ", ")
+            << TexFetchNode::opname(v.first) << " " << v.second;
+         first = false;
+      }
+      os << ")\n";
+   }
+
+   os << m_tex_clauses << " TEX clauses, " << m_tex_instructions
+      << " TEX instructions\n";
+
+   for (auto addr: m_single_fetch_clauses)
+      os << "CF " << addr << ": TEX clause with a single fetch\n";
+
+   for (const auto& m: m_clause_merges)
+      os << "CF " << m.first_addr << " and " << m.second_addr
+         << ": TEX clauses could be merged\n";
+}
+
+}
@@ -0,0 +1,95 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_texture_analysis_h
+#define r600_texture_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <bitset>
+#include <iosfwd>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace r600 {
+
+/* Lists the texture resources and samplers used by a program and checks
+ * how the texture fetches are grouped into clauses.
+ *
+ * A TEX clause with a single fetch leaves nothing to hide the fetch
+ * latency behind. Two TEX clauses that are only separated by ALU
+ * clauses can be merged if the second clause neither reads a register
+ * written in between nor writes a register that is accessed in between.
+ */
+class TextureAnalysis {
+public:
+   /* Resource id and sampler id, the sampler is -1 for instructions
+    * that don't sample */
+   using ResourceSampler = std::pair<int, int>;
+
+   struct Usage {
+      unsigned count;
+      std::map<TexFetchNode::ETexInst, unsigned> variants;
+   };
+
+   struct ClauseMerge {
+      unsigned first_addr;
+      unsigned second_addr;
+   };
+
+   TextureAnalysis(const disassembler& program);
+
+   const std::map<ResourceSampler, Usage>& usage() const;
+
+   unsigned tex_clauses() const;
+   unsigned tex_instructions() const;
+
+   const std::vector<unsigned>& single_fetch_clauses() const;
+   const std::vector<ClauseMerge>& clause_merges() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   /* One bit per GPR channel */
+   using RegSet = std::bitset<128 * 4>;
+
+   struct ClauseInfo {
+      unsigned cf_addr;
+      RegSet reads;
+      RegSet writes;
+   };
+
+   bool analyse_tex_clause(unsigned cf_addr, const CFFetchNode& clause,
+                           ClauseInfo& info);
+   static void add_alu_access(const CFAluNode& alu, RegSet& reads,
+                              RegSet& writes);
+
+   std::map<ResourceSampler, Usage> m_usage;
+   unsigned m_tex_clauses;
+   unsigned m_tex_instructions;
+   std::vector<unsigned> m_single_fetch_clauses;
+   std::vector<ClauseMerge> m_clause_merges;
+};
+
+}
+
+#endif
@@ -396,7 +396,7 @@ void LiteralValue::do_print(std::ostream& os, const PrintFlags& flags) const
 
 void LiteralValue::set_literal_info(const uint64_t *literals)
 {
-   m_value.i = (literals[chan()>>1] >> (32 * chan())) & 0xffffffff;
+   m_value.i = (literals[chan() >> 1] >> (32 * (chan() & 1))) & 0xffffffff;
 }
 
 SpecialValue::SpecialValue(Type type, int value, int chan, bool abs, bool neg):
@@ -496,6 +496,16 @@ uint64_t ConstValue::sel() const
    return m_index + bank_base[m_kcache_bank];
 }
 
+uint16_t ConstValue::index() const
+{
+   return m_index;
+}
+
+uint16_t ConstValue::kcache_bank() const
+{
+   return m_kcache_bank;
+}
+
 void ConstValue::do_print(std::ostream& os) const
 {
    os << "KC" << m_kcache_bank << "[" << m_index;
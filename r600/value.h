@@ -234,6 +234,12 @@ public:
    ConstValue(uint16_t sel, uint16_t chan,
               bool abs, bool rel, bool neg);
    uint64_t sel() const override;
+
+   /* index within the two lines locked by the kcache set */
+   uint16_t index() const;
+
+   /* kcache set 0-3 of the ALU clause this value is read from */
+   uint16_t kcache_bank() const;
 private:
    void do_print(std::ostream& os) const override;
    uint16_t m_index;
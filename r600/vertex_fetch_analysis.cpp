@@ -0,0 +1,178 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/vertex_fetch_analysis.h>
+
+#include <iostream>
+#include <algorithm>
+#include <tuple>
+
+namespace r600 {
+
+/* MEGA_FETCH_COUNT has six bits */
+static const unsigned max_mega_fetch_bytes = 64;
+
+VertexFetchAnalysis::VertexFetchAnalysis(const disassembler& program)
+{
+   unsigned cf_addr = 0;
+   for (const auto& n: program.get_program()) {
+      auto fetch = dynamic_cast<const CFFetchNode *>(n.get());
+      if (fetch)
+         analyse_clause(cf_addr, *fetch);
+      cf_addr += n->bytecode_size();
+   }
+}
+
+void VertexFetchAnalysis::analyse_clause(unsigned cf_addr,
+                                         const CFFetchNode& clause)
+{
+   /* Fetches share a mega-fetch if they read the same buffer with the
+    * same index */
+   using Stream = std::tuple<unsigned, unsigned, unsigned, unsigned, bool>;
+   using Window = std::pair<unsigned, unsigned>;
+
+   std::map<Stream, Window> windows;
+   std::map<Stream, std::vector<Fetch>> mega_fetches;
+
+   unsigned index = 0;
+   for (const auto& f: clause.clause()) {
+      auto vtx = dynamic_cast<const VertexFetchNode *>(f.get());
+      if (!vtx || vtx->vc_opcode() != VertexFetchNode::vc_fetch) {
+         ++index;
+         continue;
+      }
+
+      Stream stream(vtx->buffer_id(), vtx->fetch_type(),
+                    vtx->src().sel(), vtx->src().chan(), vtx->src().rel());
+      Fetch fetch = {index++, vtx->offset(),
+                     VertexFetchNode::data_format_size(vtx->data_format()),
+                     vtx->mega_fetch_count() + 1};
+
+      auto& stats = m_buffers[BufferKey(vtx->buffer_id(), vtx->fetch_type())];
+      ++stats.fetches;
+      stats.used_bytes += fetch.size;
+
+      if (vtx->is_mega_fetch()) {
+         stats.fetched_bytes += fetch.mega_bytes;
+         windows[stream] = Window(fetch.offset, fetch.offset + fetch.mega_bytes);
+         mega_fetches[stream].push_back(fetch);
+      } else {
+         auto w = windows.find(stream);
+         if (w == windows.end() ||
+             fetch.offset < w->second.first ||
+             fetch.offset + fetch.size > w->second.second)
+            stats.fetched_bytes += fetch.size;
+      }
+   }
+
+   for (auto& m: mega_fetches)
+      find_merges(cf_addr, std::get<0>(m.first), m.second);
+}
+
+void VertexFetchAnalysis::find_merges(unsigned cf_addr, unsigned buffer_id,
+                                      std::vector<Fetch>& mega_fetches)
+{
+   std::sort(mega_fetches.begin(), mega_fetches.end(),
+             [](const Fetch& a, const Fetch& b) {return a.offset < b.offset;});
+
+   size_t i = 0;
+   while (i < mega_fetches.size()) {
+      unsigned start = mega_fetches[i].offset;
+      unsigned end = start + mega_fetches[i].size;
+      size_t k = i + 1;
+
+      while (k < mega_fetches.size()) {
+         unsigned e = std::max(end, mega_fetches[k].offset +
+                               mega_fetches[k].size);
+         if (e - start > max_mega_fetch_bytes)
+            break;
+         end = e;
+         ++k;
+      }
+
+      if (k - i > 1) {
+         MergeCandidate mc = {cf_addr, buffer_id, {}, end - start};
+         for (size_t j = i; j < k; ++j)
+            mc.fetches.push_back(mega_fetches[j].index);
+         std::sort(mc.fetches.begin(), mc.fetches.end());
+         m_merge_candidates.push_back(mc);
+      }
+      i = k;
+   }
+}
+
+const std::map<VertexFetchAnalysis::BufferKey, VertexFetchAnalysis::BufferStats>&
+VertexFetchAnalysis::buffers() const
+{
+   return m_buffers;
+}
+
+const std::vector<VertexFetchAnalysis::MergeCandidate>&
+VertexFetchAnalysis::merge_candidates() const
+{
+   return m_merge_candidates;
+}
+
+unsigned VertexFetchAnalysis::bytes_per_vertex() const
+{
+   unsigned result = 0;
+   for (const auto& b: m_buffers)
+      if (b.first.second != VertexFetchNode::instance_data)
+         result += b.second.fetched_bytes;
+   return result;
+}
+
+unsigned VertexFetchAnalysis::bytes_per_instance() const
+{
+   unsigned result = 0;
+   for (const auto& b: m_buffers)
+      if (b.first.second == VertexFetchNode::instance_data)
+         result += b.second.fetched_bytes;
+   return result;
+}
+
+void VertexFetchAnalysis::print(std::ostream& os) const
+{
+   static const char *fetch_type_names[] = {
+      "vertex", "instance", "no index", "invalid"
+   };
+
+   for (const auto& b: m_buffers) {
+      os << "buffer " << b.first.first << " "
+         << fetch_type_names[b.first.second & 3] << ": "
+         << b.second.fetches << " fetches, "
+         << b.second.used_bytes << " bytes used, "
+         << b.second.fetched_bytes << " bytes fetched\n";
+   }
+
+   for (const auto& mc: m_merge_candidates) {
+      os << "CF " << mc.cf_addr << ": fetches ";
+      for (size_t i = 0; i < mc.fetches.size(); ++i)
+         os << (i ? ", " : "") << mc.fetches[i];
+      os << " of buffer " << mc.buffer_id
+         << " could share one mega-fetch of " << mc.bytes << " bytes\n";
+   }
+
+   os << "per vertex: " << bytes_per_vertex() << " bytes, per instance: "
+      << bytes_per_instance() << " bytes\n";
+}
+
+}
@@ -0,0 +1,92 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_vertex_fetch_analysis_h
+#define r600_vertex_fetch_analysis_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace r600 {
+
+/* Estimates the memory traffic of the vertex fetches of a program.
+ *
+ * The bytes used by each fetch follow from its data format. The bytes
+ * actually read from memory follow from the mega-fetch counts: a fetch
+ * with the mega-fetch bit set reads MEGA_FETCH_COUNT + 1 bytes, and
+ * following fetches of the same buffer and index that lie in this range
+ * are served from it.
+ *
+ * Fetches of the same clause, buffer, and index that each issue their
+ * own mega-fetch although they lie within one 64 byte window are
+ * reported as merge candidates.
+ */
+class VertexFetchAnalysis {
+public:
+   /* Buffer id and fetch type */
+   using BufferKey = std::pair<unsigned, unsigned>;
+
+   struct BufferStats {
+      unsigned fetches;
+      unsigned used_bytes;
+      unsigned fetched_bytes;
+   };
+
+   struct MergeCandidate {
+      unsigned cf_addr;
+      unsigned buffer_id;
+      std::vector<unsigned> fetches;
+      unsigned bytes;
+   };
+
+   VertexFetchAnalysis(const disassembler& program);
+
+   const std::map<BufferKey, BufferStats>& buffers() const;
+   const std::vector<MergeCandidate>& merge_candidates() const;
+
+   unsigned bytes_per_vertex() const;
+   unsigned bytes_per_instance() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   struct Fetch {
+      unsigned index;
+      unsigned offset;
+      unsigned size;
+      unsigned mega_bytes;
+   };
+
+   void analyse_clause(unsigned cf_addr, const CFFetchNode& clause);
+   void find_merges(unsigned cf_addr, unsigned buffer_id,
+                    std::vector<Fetch>& mega_fetches);
+
+   std::map<BufferKey, BufferStats> m_buffers;
+   std::vector<MergeCandidate> m_merge_candidates;
+};
+
+}
+
+#endif
@@ -0,0 +1,336 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/vliw_repack.h>
+#include <r600/bank_swizzle.h>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <set>
+
+namespace r600 {
+
+namespace {
+
+const unsigned nregs = 128 * 4;
+const unsigned max_literals = 4;
+
+struct Instr {
+   PAluNode node;
+   unsigned group;
+};
+
+struct Unit {
+   std::vector<unsigned> instrs;
+   bool ordered;
+   bool multi_slot;
+};
+
+bool reads_lds_queue(const AluNode& n)
+{
+   for (unsigned i = 0; i < n.nsources(); ++i) {
+      auto v = n.get_src(i);
+      if (v && v->type() == Value::cinline &&
+          (v->sel() == ALU_SRC_LDS_OQ_A || v->sel() == ALU_SRC_LDS_OQ_B ||
+           v->sel() == ALU_SRC_LDS_OQ_A_POP ||
+           v->sel() == ALU_SRC_LDS_OQ_B_POP))
+         return true;
+   }
+   return false;
+}
+
+bool is_ordered(const AluNode& n)
+{
+   if (n.has_side_effects() || reads_lds_queue(n) ||
+       dynamic_cast<const AluNodeLDSIdxOP *>(&n))
+      return true;
+
+   auto d = dynamic_cast<const AluNodeWithDst *>(&n);
+   return d && d->writes_dst() && d->dst().rel();
+}
+
+int written_reg(const AluNode& n)
+{
+   auto d = dynamic_cast<const AluNodeWithDst *>(&n);
+   if (!d || !d->writes_dst() || d->dst().rel() || d->dst().sel() >= 128)
+      return -1;
+   return d->dst().sel() * 4 + d->dst().chan();
+}
+
+class Scheduler {
+public:
+   Scheduler(const CFAluNode& alu);
+   void run();
+
+   std::vector<AluGroup> groups;
+   unsigned ninstr;
+
+private:
+   unsigned earliest(const Unit& u) const;
+   bool try_place(const Unit& u, unsigned g);
+   void commit(const Unit& u, unsigned g);
+
+   std::vector<Instr> m_instr;
+   std::vector<Unit> m_units;
+   /* instruction index by original group and slot */
+   std::vector<std::array<int, 5>> m_orig;
+   std::vector<unsigned> m_orig_group;
+
+   std::array<int, nregs> m_last_write;
+   std::array<int, nregs> m_last_read;
+   int m_barrier;
+   int m_last_group;
+};
+
+Scheduler::Scheduler(const CFAluNode& alu):
+   ninstr(0),
+   m_barrier(-1),
+   m_last_group(-1)
+{
+   m_last_write.fill(-1);
+   m_last_read.fill(-1);
+
+   unsigned gidx = 0;
+   for (const auto& g: alu.clause()) {
+      std::array<int, 5> slots;
+      slots.fill(-1);
+      Unit multi = {{}, false, true};
+
+      for (unsigned s = 0; s < 5; ++s) {
+         auto node = g.slot(s);
+         if (!node)
+            continue;
+         slots[s] = m_instr.size();
+         m_orig_group.push_back(gidx);
+         m_instr.push_back({node, 0});
+
+         bool ordered = is_ordered(*node);
+         if (s < 4 && is_multi_slot_op(node->opcode())) {
+            multi.instrs.push_back(slots[s]);
+            multi.ordered |= ordered;
+         } else {
+            m_units.push_back({{static_cast<unsigned>(slots[s])}, ordered,
+                               false});
+         }
+      }
+      if (!multi.instrs.empty())
+         m_units.push_back(multi);
+      m_orig.push_back(slots);
+      ++gidx;
+   }
+   ninstr = m_instr.size();
+
+   /* Keep the units in the original instruction order */
+   std::stable_sort(m_units.begin(), m_units.end(),
+                    [](const Unit& a, const Unit& b) {
+                       return a.instrs[0] < b.instrs[0];
+                    });
+}
+
+void Scheduler::run()
+{
+   for (const auto& u: m_units) {
+      unsigned g = earliest(u);
+      while (!try_place(u, g))
+         ++g;
+      commit(u, g);
+   }
+}
+
+unsigned Scheduler::earliest(const Unit& u) const
+{
+   int result = m_barrier + 1;
+   if (u.ordered)
+      result = std::max(result, m_last_group);
+
+   for (auto i: u.instrs) {
+      const AluNode& n = *m_instr[i].node;
+
+      for (unsigned k = 0; k < n.nsources(); ++k) {
+         auto v = n.get_src(k);
+         if (!v)
+            continue;
+
+         if (v->type() == Value::gpr) {
+            if (v->rel()) {
+               for (unsigned sel = 0; sel < 128; ++sel)
+                  result = std::max(result,
+                                    m_last_write[sel * 4 + v->chan()] + 1);
+            } else if (v->sel() < 128) {
+               result = std::max(result,
+                                 m_last_write[v->sel() * 4 + v->chan()] + 1);
+            }
+         } else if (v->type() == Value::cinline &&
+                    (v->sel() == ALU_SRC_PV || v->sel() == ALU_SRC_PS)) {
+            unsigned og = m_orig_group[i];
+            if (og == 0)
+               continue;
+            int producer = m_orig[og - 1][v->sel() == ALU_SRC_PS ? 4 :
+                                                                   v->chan()];
+            if (producer >= 0)
+               result = std::max(result,
+                                 static_cast<int>(m_instr[producer].group) + 1);
+         }
+      }
+
+      int r = written_reg(n);
+      if (r >= 0) {
+         result = std::max(result, m_last_write[r] + 1);
+         result = std::max(result, m_last_read[r]);
+      }
+   }
+   return std::max(result, 0);
+}
+
+bool Scheduler::try_place(const Unit& u, unsigned g)
+{
+   AluGroup test = g < groups.size() ? groups[g] : AluGroup();
+
+   for (auto i: u.instrs) {
+      const auto& node = m_instr[i].node;
+      unsigned chan = node->dst_chan();
+
+      if (u.multi_slot) {
+         if (test.slot(chan))
+            return false;
+         test.set_slot(chan, node);
+      } else if (!test.slot(chan) && node->slot_supported(1 << chan)) {
+         test.set_slot(chan, node);
+      } else if (!test.slot(4) && node->slot_supported(AluOp::t)) {
+         test.set_slot(4, node);
+      } else {
+         return false;
+      }
+   }
+
+   std::set<uint32_t> literals;
+   for (unsigned s = 0; s < 5; ++s) {
+      auto node = test.slot(s);
+      if (!node)
+         continue;
+      for (unsigned k = 0; k < node->nsources(); ++k) {
+         auto v = node->get_src(k);
+         if (v && v->type() == Value::literal)
+            literals.insert(static_cast<const LiteralValue&>(*v).value());
+      }
+   }
+   if (literals.size() > max_literals)
+      return false;
+
+   BankSwizzleCheck::Swizzles swz;
+   if (!BankSwizzleCheck::best_swizzle(test, swz))
+      return false;
+
+   if (g < groups.size())
+      groups[g] = test;
+   else
+      groups.push_back(test);
+   return true;
+}
+
+void Scheduler::commit(const Unit& u, unsigned g)
+{
+   for (auto i: u.instrs) {
+      const AluNode& n = *m_instr[i].node;
+      m_instr[i].group = g;
+
+      for (unsigned k = 0; k < n.nsources(); ++k) {
+         auto v = n.get_src(k);
+         if (!v || v->type() != Value::gpr)
+            continue;
+         if (v->rel()) {
+            for (unsigned sel = 0; sel < 128; ++sel) {
+               int& r = m_last_read[sel * 4 + v->chan()];
+               r = std::max(r, static_cast<int>(g));
+            }
+         } else if (v->sel() < 128) {
+            int& r = m_last_read[v->sel() * 4 + v->chan()];
+            r = std::max(r, static_cast<int>(g));
+         }
+      }
+
+      int r = written_reg(n);
+      if (r >= 0)
+         m_last_write[r] = g;
+   }
+
+   m_last_group = std::max(m_last_group, static_cast<int>(g));
+   if (u.ordered)
+      m_barrier = g;
+}
+
+}
+
+VLIWRepackSimulation::VLIWRepackSimulation(const disassembler& program)
+{
+   unsigned cf_addr = 0;
+   for (const auto& n: program.get_program()) {
+      auto alu = dynamic_cast<const CFAluNode *>(n.get());
+      if (alu)
+         m_clauses.push_back(repack(*alu, cf_addr));
+      cf_addr += n->bytecode_size();
+   }
+}
+
+VLIWRepackSimulation::ClauseResult
+VLIWRepackSimulation::repack(const CFAluNode& alu, unsigned cf_addr)
+{
+   Scheduler s(alu);
+   s.run();
+   return {cf_addr, s.ninstr, static_cast<unsigned>(alu.clause().size()),
+           s.groups};
+}
+
+const std::vector<VLIWRepackSimulation::ClauseResult>&
+VLIWRepackSimulation::clauses() const
+{
+   return m_clauses;
+}
+
+unsigned VLIWRepackSimulation::groups() const
+{
+   unsigned result = 0;
+   for (const auto& c: m_clauses)
+      result += c.groups;
+   return result;
+}
+
+unsigned VLIWRepackSimulation::repacked_groups() const
+{
+   unsigned result = 0;
+   for (const auto& c: m_clauses)
+      result += c.schedule.size();
+   return result;
+}
+
+void VLIWRepackSimulation::print(std::ostream& os) const
+{
+   for (const auto& c: m_clauses)
+      os << "CF " << c.cf_addr << ": " << c.instructions
+         << " instructions in " << c.groups << " groups, "
+         << c.schedule.size() << " groups after repacking\n";
+
+   os << "total: " << groups() << " groups, " << repacked_groups()
+      << " groups after repacking\n";
+}
+
+}
@@ -0,0 +1,78 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_vliw_repack_h
+#define r600_vliw_repack_h
+
+#include <r600/disassembler.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace r600 {
+
+/* Simulates re-scheduling the instructions of each ALU clause into as
+ * few groups as possible.
+ *
+ * The instructions are placed in their original order into the first
+ * group that satisfies the data dependencies, has a free slot that the
+ * instruction can use, stays within the four literal values of a group,
+ * and for which a legal bank swizzle assignment exists. Instructions
+ * that occupy several slots are moved together with the other
+ * multi-slot instructions of their group.
+ *
+ * Reads from PV and PS depend on the instruction that produced the
+ * value and it is assumed that the value can be passed in a GPR when
+ * the producer no longer is in the directly preceding group. Instructions
+ * with side effects (predicate and mask updates, kills, MOVA), LDS
+ * operations, LDS queue reads and relative writes keep their order
+ * relative to all other instructions.
+ *
+ * The greedy placement gives an upper bound for the minimal number of
+ * groups that is usually tight for the clauses a compiler creates.
+ */
+class VLIWRepackSimulation {
+public:
+   struct ClauseResult {
+      unsigned cf_addr;
+      unsigned instructions;
+      unsigned groups;
+      std::vector<AluGroup> schedule;
+   };
+
+   VLIWRepackSimulation(const disassembler& program);
+
+   static ClauseResult repack(const CFAluNode& alu, unsigned cf_addr = 0);
+
+   const std::vector<ClauseResult>& clauses() const;
+
+   unsigned groups() const;
+   unsigned repacked_groups() const;
+
+   void print(std::ostream& os) const;
+
+private:
+   std::vector<ClauseResult> m_clauses;
+};
+
+}
+
+#endif
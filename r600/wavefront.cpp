@@ -0,0 +1,279 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <r600/wavefront.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace r600 {
+
+uint32_t float_to_half(float f)
+{
+   uint32_t x = lane_bits(f);
+   uint32_t sign = (x >> 16) & 0x8000;
+   uint32_t exp = (x >> 23) & 0xff;
+   uint32_t mant = x & 0x7fffff;
+
+   if (exp == 0xff)
+      return sign | 0x7c00 | (mant ? 0x200 : 0);
+
+   int e = static_cast<int>(exp) - 127 + 15;
+   if (e >= 31)
+      return sign | 0x7c00;
+
+   uint32_t h;
+   uint32_t shift;
+   if (e <= 0) {
+      if (e < -10)
+         return sign;
+      mant |= 0x800000;
+      shift = 14 - e;
+      h = mant >> shift;
+   } else {
+      shift = 13;
+      h = (static_cast<uint32_t>(e) << 10) | (mant >> shift);
+   }
+
+   /* A carry out of the mantissa correctly increments the exponent */
+   uint32_t rem = mant & ((1u << shift) - 1);
+   uint32_t half = 1u << (shift - 1);
+   if (rem > half || (rem == half && (h & 1)))
+      ++h;
+   return sign | h;
+}
+
+float half_to_float(uint32_t h)
+{
+   uint32_t sign = (h & 0x8000) << 16;
+   uint32_t exp = (h >> 10) & 0x1f;
+   uint32_t mant = h & 0x3ff;
+
+   if (exp == 0) {
+      float v = std::ldexp(static_cast<float>(mant), -24);
+      return sign ? -v : v;
+   }
+   if (exp == 31)
+      return lane_float(sign | 0x7f800000 | (mant << 13));
+   return lane_float(sign | ((exp + 112) << 23) | (mant << 13));
+}
+
+PageStamps::PageStamps(unsigned npages):
+   m_id(new_id()),
+   m_clock(0),
+   m_stamps(npages, 0)
+{
+}
+
+PageStamps::PageStamps(const PageStamps& other):
+   m_id(new_id()),
+   m_clock(other.m_clock),
+   m_stamps(other.m_stamps)
+{
+}
+
+PageStamps& PageStamps::operator = (const PageStamps& other)
+{
+   m_id = new_id();
+   m_clock = other.m_clock;
+   m_stamps = other.m_stamps;
+   return *this;
+}
+
+uint64_t PageStamps::id() const
+{
+   return m_id;
+}
+
+uint64_t PageStamps::stamp(unsigned page) const
+{
+   assert(page < m_stamps.size());
+   return m_stamps[page];
+}
+
+void PageStamps::touch(unsigned page)
+{
+   assert(page < m_stamps.size());
+   m_stamps[page] = ++m_clock;
+}
+
+void PageStamps::touch_all()
+{
+   ++m_clock;
+   std::fill(m_stamps.begin(), m_stamps.end(), m_clock);
+}
+
+uint64_t PageStamps::new_id()
+{
+   /* zero is left for storages without stamps */
+   static std::atomic<uint64_t> next(1);
+   return next++;
+}
+
+Wavefront::Wavefront(unsigned nthreads):
+   m_gpr(ngprs * 4),
+   m_gpr_stamps(ngprs),
+   m_loop_index(0),
+   m_valid(nthreads >= wavefront_size ? ~LaneMask(0) :
+                                        (LaneMask(1) << nthreads) - 1),
+   m_active(m_valid),
+   m_predicate(0)
+{
+   if (nthreads > wavefront_size)
+      throw std::invalid_argument("Wavefront: too many threads");
+
+   for (auto& r: m_gpr)
+      r.fill(0);
+   for (auto& r: m_pv)
+      r.fill(0);
+   m_ar.fill(0);
+}
+
+Lanes& Wavefront::gpr(unsigned sel, unsigned chan)
+{
+   assert(sel < ngprs && chan < 4);
+   m_gpr_stamps.touch(sel);
+   return m_gpr[4 * sel + chan];
+}
+
+const Lanes& Wavefront::gpr(unsigned sel, unsigned chan) const
+{
+   assert(sel < ngprs && chan < 4);
+   return m_gpr[4 * sel + chan];
+}
+
+const PageStamps& Wavefront::gpr_stamps() const
+{
+   return m_gpr_stamps;
+}
+
+Lanes& Wavefront::pv(unsigned slot)
+{
+   assert(slot < 5);
+   return m_pv[slot];
+}
+
+const Lanes& Wavefront::pv(unsigned slot) const
+{
+   assert(slot < 5);
+   return m_pv[slot];
+}
+
+Lanes& Wavefront::ar()
+{
+   return m_ar;
+}
+
+const Lanes& Wavefront::ar() const
+{
+   return m_ar;
+}
+
+int Wavefront::loop_index() const
+{
+   return m_loop_index;
+}
+
+void Wavefront::set_loop_index(int index)
+{
+   m_loop_index = index;
+}
+
+LaneMask Wavefront::valid() const
+{
+   return m_valid;
+}
+
+void Wavefront::set_valid(LaneMask mask)
+{
+   m_valid = mask;
+}
+
+LaneMask Wavefront::active() const
+{
+   return m_active;
+}
+
+void Wavefront::set_active(LaneMask mask)
+{
+   m_active = mask & m_valid;
+}
+
+LaneMask Wavefront::predicate() const
+{
+   return m_predicate;
+}
+
+void Wavefront::set_predicate(LaneMask mask)
+{
+   m_predicate = mask;
+}
+
+void Wavefront::kill(LaneMask mask)
+{
+   m_valid &= ~mask;
+   m_active &= ~mask;
+}
+
+void Wavefront::set_constant_buffer(unsigned id, PConstantBuffer buffer)
+{
+   if (id >= nconst_buffers)
+      throw std::invalid_argument("Wavefront: constant buffer id out of range");
+   m_const_buffers[id] = buffer;
+}
+
+uint32_t Wavefront::constant(unsigned buffer, unsigned index,
+                             unsigned chan) const
+{
+   if (buffer >= nconst_buffers || !m_const_buffers[buffer])
+      return 0;
+   const auto& cb = *m_const_buffers[buffer];
+   size_t i = 4 * size_t(index) + chan;
+   return i < cb.size() ? cb[i] : 0;
+}
+
+void Wavefront::set_lds(PLocalDataShare lds)
+{
+   m_lds = lds;
+}
+
+LocalDataShare *Wavefront::lds() const
+{
+   return m_lds.get();
+}
+
+std::vector<uint32_t>& Wavefront::lds_queue(unsigned queue, unsigned lane)
+{
+   assert(queue < 2 && lane < wavefront_size);
+   return m_lds_queues[queue * wavefront_size + lane];
+}
+
+const std::vector<uint32_t>& Wavefront::lds_queue(unsigned queue,
+                                                  unsigned lane) const
+{
+   assert(queue < 2 && lane < wavefront_size);
+   return m_lds_queues[queue * wavefront_size + lane];
+}
+
+}
@@ -0,0 +1,167 @@
+/* -*- mia-c++  -*-
+ *
+ * This file is part of R600-disass a tool to disassemble R600 byte code.
+ * Copyright (c) Genoa 2018 Gert Wollny
+ *
+ * R600-disass  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MIA; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef r600_wavefront_h
+#define r600_wavefront_h
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace r600 {
+
+/* Number of threads that execute an instruction together */
+const unsigned wavefront_size = 64;
+
+/* One bit per thread of a wavefront */
+using LaneMask = uint64_t;
+
+/* One 32 bit value per thread, the register file is stored as one such
+ * array per register channel (structure of arrays) so that an
+ * instruction can be evaluated for all threads with one loop that the
+ * compiler can vectorize. */
+using Lanes = std::array<uint32_t, wavefront_size>;
+
+/* Four 32 bit values per constant */
+using ConstantBuffer = std::vector<uint32_t>;
+using PConstantBuffer = std::shared_ptr<const ConstantBuffer>;
+
+class LocalDataShare;
+using PLocalDataShare = std::shared_ptr<LocalDataShare>;
+
+inline float lane_float(uint32_t v)
+{
+   float f;
+   memcpy(&f, &v, sizeof(f));
+   return f;
+}
+
+inline uint32_t lane_bits(float f)
+{
+   uint32_t v;
+   memcpy(&v, &f, sizeof(v));
+   return v;
+}
+
+/* IEEE half float conversion, rounds to nearest even */
+uint32_t float_to_half(float f);
+float half_to_float(uint32_t h);
+
+/* Write stamps of the pages of a storage, every write to a page gives
+ * it a new stamp. Stamps are only comparable between objects with the
+ * same id, a copy gets a new id, so a page with the same id and stamp
+ * as before was not written in between. */
+class PageStamps {
+public:
+   PageStamps(unsigned npages);
+   PageStamps(const PageStamps& other);
+   PageStamps& operator = (const PageStamps& other);
+
+   uint64_t id() const;
+   uint64_t stamp(unsigned page) const;
+
+   void touch(unsigned page);
+   void touch_all();
+
+private:
+   static uint64_t new_id();
+
+   uint64_t m_id;
+   uint64_t m_clock;
+   std::vector<uint64_t> m_stamps;
+};
+
+/* The architectural state of one wavefront as seen by the ALU */
+class Wavefront {
+public:
+   static const unsigned ngprs = 128;
+   static const unsigned nconst_buffers = 16;
+
+   Wavefront(unsigned nthreads = wavefront_size);
+
+   /* The non-const access counts as a write of the register */
+   Lanes& gpr(unsigned sel, unsigned chan);
+   const Lanes& gpr(unsigned sel, unsigned chan) const;
+
+   /* One page per register */
+   const PageStamps& gpr_stamps() const;
+
+   /* Previous vector results PV.xyzw in 0-3 and the previous scalar
+    * result PS in 4 */
+   Lanes& pv(unsigned slot);
+   const Lanes& pv(unsigned slot) const;
+
+   /* Address register written by MOVA_INT */
+   Lanes& ar();
+   const Lanes& ar() const;
+
+   int loop_index() const;
+   void set_loop_index(int index);
+
+   /* Threads that exist and were not killed */
+   LaneMask valid() const;
+   void set_valid(LaneMask mask);
+
+   /* Threads that currently execute instructions */
+   LaneMask active() const;
+   void set_active(LaneMask mask);
+
+   /* The per-thread predicate bit */
+   LaneMask predicate() const;
+   void set_predicate(LaneMask mask);
+
+   /* Remove the threads from the valid and active threads */
+   void kill(LaneMask mask);
+
+   void set_constant_buffer(unsigned id, PConstantBuffer buffer);
+
+   /* Read a constant, reads outside the bound buffer return zero */
+   uint32_t constant(unsigned buffer, unsigned index, unsigned chan) const;
+
+   /* The local data share of the workgroup, it is shared by all
+    * wavefronts of the workgroup */
+   void set_lds(PLocalDataShare lds);
+   LocalDataShare *lds() const;
+
+   /* The LDS output queues A (0) and B (1) of a thread that receive the
+    * values returned by LDS instructions */
+   std::vector<uint32_t>& lds_queue(unsigned queue, unsigned lane);
+   const std::vector<uint32_t>& lds_queue(unsigned queue, unsigned lane) const;
+
+private:
+   std::vector<Lanes> m_gpr;
+   PageStamps m_gpr_stamps;
+   std::array<Lanes, 5> m_pv;
+   Lanes m_ar;
+   int m_loop_index;
+   LaneMask m_valid;
+   LaneMask m_active;
+   LaneMask m_predicate;
+   std::array<PConstantBuffer, nconst_buffers> m_const_buffers;
+   PLocalDataShare m_lds;
+   std::array<std::vector<uint32_t>, 2 * wavefront_size> m_lds_queues;
+};
+
+}
+
+#endif